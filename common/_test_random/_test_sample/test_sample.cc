@@ -0,0 +1,58 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <vector>
+
+#include "common/random/random_source.h"
+#include "common/random/sample.h"
+#include "common/unit_test_util/unit_test_util.h"
+
+bool SampleIndexRelativeEntropyTest() {
+    e8::RandomSource source(/*seed=*/1);
+    std::vector<float> pmf{0.5f, 0.0f, 0.3f, 0.2f};
+
+    std::vector<unsigned> freqs(pmf.size());
+    for (unsigned i = 0; i < 10000; ++i) {
+        unsigned index = e8::SampleIndex(pmf, &source);
+        TEST_CONDITION(index < pmf.size());
+        ++freqs[index];
+    }
+
+    TEST_CONDITION(freqs[1] == 0);
+
+    float relative_entropy = 0.0f;
+    for (unsigned i = 0; i < pmf.size(); ++i) {
+        if (pmf[i] == 0.0f) {
+            continue;
+        }
+
+        float p_i = freqs[i] / 10000.0f;
+        relative_entropy += p_i * std::log2(p_i / pmf[i]);
+    }
+
+    TEST_CONDITION(relative_entropy < 1e-2f);
+
+    return true;
+}
+
+int main() {
+    e8::BeginTestSuite("sample");
+    e8::RunTest("SampleIndexRelativeEntropyTest", SampleIndexRelativeEntropyTest);
+    e8::EndTestSuite();
+    return 0;
+}
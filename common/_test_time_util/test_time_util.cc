@@ -16,7 +16,10 @@
  */
 
 #include <chrono>
+#include <cstdint>
 #include <thread>
+#include <unordered_set>
+#include <vector>
 
 #include "common/time_util/time_util.h"
 #include "common/unit_test_util/unit_test_util.h"
@@ -80,12 +83,63 @@ bool TimestampSecsDurationTest() {
     return true;
 }
 
+bool UniqueIdOrderTest() {
+    e8::TimestampMillis before = e8::CurrentTimestampMillis();
+
+    int64_t last_id = 0;
+    for (unsigned i = 0; i < 100000; i++) {
+        int64_t id = e8::UniqueId(/*host_id=*/7);
+        TEST_CONDITION(id > last_id);
+        last_id = id;
+    }
+
+    TEST_CONDITION(e8::UniqueIdHostId(last_id) == 7);
+
+    // Bursting 100000 IDs pushes the timestamp at most ~25ms ahead of the clock.
+    e8::TimestampMillis after = e8::CurrentTimestampMillis();
+    TEST_CONDITION(e8::UniqueIdTimestampMillis(last_id) >= before);
+    TEST_CONDITION(e8::UniqueIdTimestampMillis(last_id) <= after + 25);
+
+    return true;
+}
+
+bool UniqueIdConcurrencyTest() {
+    unsigned const kNumThreads = 4;
+    unsigned const kNumIdsPerThread = 50000;
+
+    std::vector<std::vector<int64_t>> ids(kNumThreads);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < kNumThreads; t++) {
+        threads.emplace_back([&ids, t, kNumIdsPerThread]() {
+            for (unsigned i = 0; i < kNumIdsPerThread; i++) {
+                ids[t].push_back(e8::UniqueId(/*host_id=*/e8::kUniqueIdMaxHostId));
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    std::unordered_set<int64_t> unique_ids;
+    for (auto const &thread_ids : ids) {
+        for (unsigned i = 1; i < thread_ids.size(); i++) {
+            TEST_CONDITION(thread_ids[i] > thread_ids[i - 1]);
+        }
+        unique_ids.insert(thread_ids.begin(), thread_ids.end());
+    }
+    TEST_CONDITION(unique_ids.size() == kNumThreads * kNumIdsPerThread);
+
+    return true;
+}
+
 int main() {
     e8::BeginTestSuite("time_util");
     e8::RunTest("TimestampRelativePrecisionTest", TimestampRelativePrecisionTest);
     e8::RunTest("TimestampMicrosDurationTest", TimestampMicrosDurationTest);
     e8::RunTest("TimestampMillisDurationTest", TimestampMillisDurationTest);
     e8::RunTest("TimestampSecsDurationTest", TimestampSecsDurationTest);
+    e8::RunTest("UniqueIdOrderTest", UniqueIdOrderTest);
+    e8::RunTest("UniqueIdConcurrencyTest", UniqueIdConcurrencyTest);
     e8::EndTestSuite();
     return 0;
 }
@@ -10,6 +10,7 @@ SUBDIRS = \
     _test_time_util/_test_time_util.pro \
     _test_random/_test_random_source \
     _test_random/_test_uniform_distribution \
+    _test_random/_test_sample \
     _test_thread/_test_thread_pool \
     _test_container/_test_trie_map/_test_trie_map.pro \
     _test_container/_test_lru_hash_map/_test_lru_hash_map.pro \
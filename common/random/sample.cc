@@ -15,6 +15,32 @@
  * not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "common/random/random_source.h"
 #include "common/random/sample.h"
 
-namespace e8 {} // namespace e8
+namespace e8 {
+
+unsigned SampleIndex(std::vector<float> const &discrete_distri, RandomSource *random_source) {
+    assert(!discrete_distri.empty());
+
+    double q = random_source->Draw();
+    double cdf = 0;
+
+    for (unsigned i = 0; i < discrete_distri.size(); ++i) {
+        cdf += discrete_distri[i];
+        if (q < cdf) {
+            return i;
+        }
+    }
+
+    assert(std::abs(cdf - 1.0f) < 1e-2f);
+
+    // Numerical glitch.
+    return discrete_distri.size() - 1;
+}
+
+} // namespace e8
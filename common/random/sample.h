@@ -53,6 +53,12 @@ KeyType SampleFrom(std::unordered_map<KeyType, float> const &discrete_distri,
     return last_key;
 }
 
+/**
+ * @brief SampleIndex Sample an index from the discrete distribution stored in a flat array, with
+ * the index's probability.
+ */
+unsigned SampleIndex(std::vector<float> const &discrete_distri, RandomSource *random_source);
+
 } // namespace e8
 
 #endif // SAMPLE_H
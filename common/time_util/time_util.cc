@@ -15,6 +15,9 @@
  * not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
 #include <chrono>
 #include <cstdint>
 
@@ -23,6 +26,13 @@
 namespace e8 {
 namespace {
 
+// Unix epoch (ms) of the start of the unique ID timeline. It's the same epoch TemporalId() uses.
+TimestampMillis const kUniqueIdEpochMillis = 1588490444394L;
+
+// The timestamp and sequence number parts of the last generated unique ID, i.e. the ID without
+// the host ID bits.
+std::atomic<int64_t> gLastUniqueTimestampAndSequence(0);
+
 template <typename Precision, typename Timestamp> Timestamp CurrentEpoch() {
     auto now = std::chrono::high_resolution_clock::now();
     auto casted = std::chrono::time_point_cast<Precision>(now);
@@ -50,4 +60,35 @@ int64_t TemporalId() {
     return timestamp;
 }
 
+int64_t UniqueId(unsigned host_id) {
+    assert(host_id <= kUniqueIdMaxHostId);
+
+    int64_t elapsed_millis = CurrentTimestampMillis() - kUniqueIdEpochMillis;
+    assert(elapsed_millis >= 0 && elapsed_millis < (1L << kUniqueIdTimestampBits));
+    int64_t now_timestamp_and_sequence = elapsed_millis << kUniqueIdSequenceBits;
+
+    // Takes the current time with a zero sequence number if the clock has moved forward. Otherwise,
+    // it increments the last sequence number which overflows into the timestamp part when
+    // exhausted. Either way, the result is strictly greater than the last one.
+    int64_t last = gLastUniqueTimestampAndSequence.load(std::memory_order_relaxed);
+    int64_t next;
+    do {
+        next = std::max(last + 1, now_timestamp_and_sequence);
+    } while (!gLastUniqueTimestampAndSequence.compare_exchange_weak(last, next,
+                                                                     std::memory_order_relaxed));
+
+    int64_t timestamp = next >> kUniqueIdSequenceBits;
+    int64_t sequence = next & ((1L << kUniqueIdSequenceBits) - 1);
+    return timestamp << (kUniqueIdHostIdBits + kUniqueIdSequenceBits) |
+           static_cast<int64_t>(host_id) << kUniqueIdSequenceBits | sequence;
+}
+
+TimestampMillis UniqueIdTimestampMillis(int64_t unique_id) {
+    return (unique_id >> (kUniqueIdHostIdBits + kUniqueIdSequenceBits)) + kUniqueIdEpochMillis;
+}
+
+unsigned UniqueIdHostId(int64_t unique_id) {
+    return static_cast<unsigned>(unique_id >> kUniqueIdSequenceBits) & kUniqueIdMaxHostId;
+}
+
 } // namespace e8
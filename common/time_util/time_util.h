@@ -47,6 +47,36 @@ TimestampMicros CurrentTimestampMicros();
  */
 int64_t TemporalId();
 
+// Bit layout of the IDs generated by UniqueId(), from the most significant bit: 1 unused sign bit,
+// a 41-bit millisecond timestamp, a 10-bit host ID and a 12-bit sequence number.
+static unsigned const kUniqueIdTimestampBits = 41;
+static unsigned const kUniqueIdHostIdBits = 10;
+static unsigned const kUniqueIdSequenceBits = 12;
+static unsigned const kUniqueIdMaxHostId = (1U << kUniqueIdHostIdBits) - 1;
+
+/**
+ * @brief UniqueId Snowflake-style ID. IDs generated within a process are strictly increasing and
+ * never collide, even if more than 4096 IDs are requested in one millisecond or the system clock
+ * moves backward. In both cases, the timestamp part runs ahead of the clock until the clock
+ * catches up. IDs from different hosts don't collide as long as the hosts have distinct host IDs.
+ * This function is lock-free and thread-safe.
+ *
+ * @param host_id ID of the host machine. It must not exceed kUniqueIdMaxHostId.
+ * @return Unique positive ID.
+ */
+int64_t UniqueId(unsigned host_id);
+
+/**
+ * @brief UniqueIdTimestampMillis Extracts the Unix epoch (with millisecond precision) at which the
+ * ID was generated. It's approximate if the ID was generated when the timestamp ran ahead.
+ */
+TimestampMillis UniqueIdTimestampMillis(int64_t unique_id);
+
+/**
+ * @brief UniqueIdHostId Extracts the host ID of the host machine which generated the ID.
+ */
+unsigned UniqueIdHostId(int64_t unique_id);
+
 } // namespace e8
 
 #endif // ACOMMON_TIME_H
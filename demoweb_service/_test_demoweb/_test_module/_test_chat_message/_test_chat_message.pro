@@ -77,4 +77,9 @@ unix:!macx: LIBS += -L$$OUT_PWD/../../../../message_queue/common/ -lmessage_queu
 INCLUDEPATH += $$PWD/../../../../message_queue/common
 DEPENDPATH += $$PWD/../../../../message_queue/common
 
+unix:!macx: LIBS += -L$$OUT_PWD/../../../../file_system/ -lfilesystem
+
+INCLUDEPATH += $$PWD/../../../../file_system
+DEPENDPATH += $$PWD/../../../../file_system
+
 LIBS += -lprotobuf
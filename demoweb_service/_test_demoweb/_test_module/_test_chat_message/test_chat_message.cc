@@ -52,8 +52,8 @@ bool SendAndGetChatMessageTest() {
     std::optional<e8::SendChatMessageResult> result = e8::SendChatMessage(
         *user->id.Value(), *chat_message_group->id.Value(), /*texts=*/{"message1"},
         /*media_file_formats=*/std::vector<e8::FileFormat>(),
-        /*binary_file_formats=*/std::vector<e8::FileFormat>(), env.MessageChannelPbac(),
-        env.KeyGen(), env.DemowebDatabase());
+        /*binary_file_formats=*/std::vector<e8::FileFormat>(), env.CurrentHostId(),
+        env.MessageChannelPbac(), env.KeyGen(), env.UserProfileCache(), env.DemowebDatabase());
 
     TEST_CONDITION(result.has_value());
     TEST_CONDITION(result->message.message_seq_id() != 0);
@@ -68,11 +68,13 @@ bool SendAndGetChatMessageTest() {
     e8::SendChatMessage(*user->id.Value(), *chat_message_group->id.Value(), /*texts=*/{"message2"},
                         /*media_file_formats=*/std::vector<e8::FileFormat>(),
                         /*binary_file_formats=*/std::vector<e8::FileFormat>(),
-                        env.MessageChannelPbac(), env.KeyGen(), env.DemowebDatabase());
+                        env.CurrentHostId(), env.MessageChannelPbac(), env.KeyGen(),
+                        env.UserProfileCache(), env.DemowebDatabase());
     e8::SendChatMessage(*user->id.Value(), *chat_message_group->id.Value(), /*texts=*/{"message3"},
                         /*media_file_formats=*/std::vector<e8::FileFormat>(),
                         /*binary_file_formats=*/std::vector<e8::FileFormat>(),
-                        env.MessageChannelPbac(), env.KeyGen(), env.DemowebDatabase());
+                        env.CurrentHostId(), env.MessageChannelPbac(), env.KeyGen(),
+                        env.UserProfileCache(), env.DemowebDatabase());
 
     // Fetch those messages back.
     e8::Pagination page1;
@@ -81,7 +83,8 @@ bool SendAndGetChatMessageTest() {
 
     std::vector<e8::ChatMessageEntry> page1_messages =
         e8::GetChatMessages(*user->id.Value(), *chat_message_group->id.Value(), page1,
-                            env.MessageChannelPbac(), env.KeyGen(), env.DemowebDatabase());
+                            env.MessageChannelPbac(), env.KeyGen(), env.UserProfileCache(),
+                            env.DemowebDatabase());
 
     TEST_CONDITION(page1_messages.size() == 2);
 
@@ -102,7 +105,8 @@ bool SendAndGetChatMessageTest() {
 
     std::vector<e8::ChatMessageEntry> page2_messages =
         e8::GetChatMessages(*user->id.Value(), *chat_message_group->id.Value(), page2,
-                            env.MessageChannelPbac(), env.KeyGen(), env.DemowebDatabase());
+                            env.MessageChannelPbac(), env.KeyGen(), env.UserProfileCache(),
+                            env.DemowebDatabase());
 
     TEST_CONDITION(page2_messages.size() == 1);
 
@@ -112,9 +116,69 @@ bool SendAndGetChatMessageTest() {
     return true;
 }
 
+bool SendChatMessageToPopupGroupTest() {
+    e8::DemoWebTestEnvironmentContext env;
+
+    std::optional<e8::UserEntity> member = e8::CreateUser(
+        /*security_key=*/std::string(), /*user_group_names=*/std::vector<std::string>(),
+        /*user_id=*/1L, env.CurrentHostId(), env.DemowebDatabase());
+    std::optional<e8::UserEntity> outsider = e8::CreateUser(
+        /*security_key=*/std::string(), /*user_group_names=*/std::vector<std::string>(),
+        /*user_id=*/2L, env.CurrentHostId(), env.DemowebDatabase());
+    e8::MessageChannelEntity message_channel =
+        e8::CreateMessageChannel(/*channe_name=*/std::string(), /*description=*/std::string(),
+                                 /*encrypted=*/false, /*close_group_channel=*/false,
+                                 env.CurrentHostId(), env.DemowebDatabase());
+    e8::CreateMessageChannelMembership(*message_channel.id.Value(), *member->id.Value(),
+                                       /*member_type=*/e8::MCMT_MEMBER, env.DemowebDatabase());
+    std::optional<e8::ChatMessageGroupEntity> chat_message_group = e8::CreateChatMessageGroup(
+        *member->id.Value(), *message_channel.id.Value(),
+        /*group_title=*/std::string(), /*thread_type=*/e8::CMTT_POPUP, env.CurrentHostId(),
+        env.MessageChannelPbac(), env.DemowebDatabase());
+
+    // Non-member can't send.
+    std::optional<e8::SendChatMessageResult> rejected = e8::SendChatMessage(
+        *outsider->id.Value(), *chat_message_group->id.Value(), /*texts=*/{"message1"},
+        /*media_file_formats=*/std::vector<e8::FileFormat>(),
+        /*binary_file_formats=*/std::vector<e8::FileFormat>(), env.CurrentHostId(),
+        env.MessageChannelPbac(), env.KeyGen(), env.UserProfileCache(), env.DemowebDatabase());
+    TEST_CONDITION(!rejected.has_value());
+
+    // Nor to a group which doesn't exist.
+    rejected = e8::SendChatMessage(*member->id.Value(), /*group_id=*/-1L, /*texts=*/{"message1"},
+                                   /*media_file_formats=*/std::vector<e8::FileFormat>(),
+                                   /*binary_file_formats=*/std::vector<e8::FileFormat>(),
+                                   env.CurrentHostId(), env.MessageChannelPbac(), env.KeyGen(),
+                                   env.UserProfileCache(), env.DemowebDatabase());
+    TEST_CONDITION(!rejected.has_value());
+
+    // The member's message touches the pop-up group.
+    std::optional<e8::SendChatMessageResult> result = e8::SendChatMessage(
+        *member->id.Value(), *chat_message_group->id.Value(), /*texts=*/{"message1"},
+        /*media_file_formats=*/std::vector<e8::FileFormat>(),
+        /*binary_file_formats=*/std::vector<e8::FileFormat>(), env.CurrentHostId(),
+        env.MessageChannelPbac(), env.KeyGen(), env.UserProfileCache(), env.DemowebDatabase());
+    TEST_CONDITION(result.has_value());
+    TEST_CONDITION(result->message.sender().user_id() == *member->id.Value());
+
+    std::optional<e8::ChatMessageGroupEntity> touched_group =
+        e8::FetchChatMessageGroup(*chat_message_group->id.Value(), env.DemowebDatabase());
+    TEST_CONDITION(touched_group.has_value());
+    TEST_CONDITION(*touched_group->last_interaction_at.Value() == result->message.created_at());
+
+    std::vector<e8::ChatMessageEntry> messages =
+        e8::GetChatMessages(*member->id.Value(), *chat_message_group->id.Value(),
+                            /*pagination=*/std::nullopt, env.MessageChannelPbac(), env.KeyGen(),
+                            env.UserProfileCache(), env.DemowebDatabase());
+    TEST_CONDITION(messages.size() == 1);
+
+    return true;
+}
+
 int main() {
     e8::BeginTestSuite("chat_message");
     e8::RunTest("SendAndGetChatMessageTest", SendAndGetChatMessageTest);
+    e8::RunTest("SendChatMessageToPopupGroupTest", SendChatMessageToPopupGroupTest);
     e8::EndTestSuite();
     return 0;
 }
@@ -98,20 +98,24 @@ bool GetChatMessageGroupsWithChatMessageSummaryListTest() {
     e8::ChatMessageEntity group1_message1 = e8::CreateChatMessage(
         *group1.id.Value(), *creator->id.Value(),
         /*text_entries=*/{"g1m1"},
-        /*binary_content_paths=*/std::vector<std::string>(), env.DemowebDatabase());
+        /*binary_content_paths=*/std::vector<std::string>(), env.CurrentHostId(),
+        env.DemowebDatabase());
 
     e8::ChatMessageEntity group2_message1 = e8::CreateChatMessage(
         *group2.id.Value(), *creator->id.Value(),
         /*text_entries=*/{"g2m1"},
-        /*binary_content_paths=*/std::vector<std::string>(), env.DemowebDatabase());
+        /*binary_content_paths=*/std::vector<std::string>(), env.CurrentHostId(),
+        env.DemowebDatabase());
     e8::ChatMessageEntity group2_message2 = e8::CreateChatMessage(
         *group2.id.Value(), *creator->id.Value(),
         /*text_entries=*/{"g2m2"},
-        /*binary_content_paths=*/std::vector<std::string>(), env.DemowebDatabase());
+        /*binary_content_paths=*/std::vector<std::string>(), env.CurrentHostId(),
+        env.DemowebDatabase());
     e8::ChatMessageEntity group2_message3 = e8::CreateChatMessage(
         *group2.id.Value(), *creator->id.Value(),
         /*text_entries=*/{"g2m3"},
-        /*binary_content_paths=*/std::vector<std::string>(), env.DemowebDatabase());
+        /*binary_content_paths=*/std::vector<std::string>(), env.CurrentHostId(),
+        env.DemowebDatabase());
 
     // Read the groups back out.
     e8::Pagination page1;
@@ -122,14 +126,15 @@ bool GetChatMessageGroupsWithChatMessageSummaryListTest() {
         e8::GetChatMessageGroupsWithChatMessageSummaryList(
             *creator->id.Value(), *empty_message_channel.id.Value(),
             /*max_num_messages_per_group=*/2, page1, env.MessageChannelPbac(), env.KeyGen(),
-            env.DemowebDatabase());
+            env.UserProfileCache(), env.DemowebDatabase());
 
     TEST_CONDITION(fetched_empty_page1.empty());
 
     std::vector<e8::ChatMessageThread> fetched_page1 =
         e8::GetChatMessageGroupsWithChatMessageSummaryList(
             *creator->id.Value(), *message_channel.id.Value(), /*max_num_messages_per_group=*/2,
-            page1, env.MessageChannelPbac(), env.KeyGen(), env.DemowebDatabase());
+            page1, env.MessageChannelPbac(), env.KeyGen(), env.UserProfileCache(),
+            env.DemowebDatabase());
 
     TEST_CONDITION(fetched_page1.size() == 2);
 
@@ -159,7 +164,8 @@ bool GetChatMessageGroupsWithChatMessageSummaryListTest() {
     std::vector<e8::ChatMessageThread> fetched_page2 =
         e8::GetChatMessageGroupsWithChatMessageSummaryList(
             *creator->id.Value(), *message_channel.id.Value(), /*max_num_messages_per_group=*/2,
-            page2, env.MessageChannelPbac(), env.KeyGen(), env.DemowebDatabase());
+            page2, env.MessageChannelPbac(), env.KeyGen(), env.UserProfileCache(),
+            env.DemowebDatabase());
 
     TEST_CONDITION(fetched_page2.size() == 1);
 
@@ -46,7 +46,8 @@ bool CreateAndFetchChatMessageTest() {
     e8::ChatMessageEntity chat_message = e8::CreateChatMessage(
         *group.id.Value(), *user->id.Value(),
         /*text_entries=*/std::vector<std::string>{"Hey", "Good morning."},
-        /*binary_content_paths=*/std::vector<std::string>(), env.DemowebDatabase());
+        /*binary_content_paths=*/std::vector<std::string>(), env.CurrentHostId(),
+        env.DemowebDatabase());
     std::optional<e8::ChatMessageEntity> fetched = e8::FetchChatMessage(
         std::make_tuple(*chat_message.group_id.Value(), *chat_message.message_seq_id.Value()),
         env.DemowebDatabase());
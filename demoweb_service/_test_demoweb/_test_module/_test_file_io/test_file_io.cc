@@ -0,0 +1,254 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "common/unit_test_util/unit_test_util.h"
+#include "demoweb_service/demoweb/environment/test_environment_context.h"
+#include "demoweb_service/demoweb/module/file_access_validator.h"
+#include "demoweb_service/demoweb/module/file_io.h"
+#include "demoweb_service/demoweb/module/user_profile.h"
+#include "demoweb_service/demoweb/module/user_storage.h"
+#include "file_system/file_interface.h"
+#include "proto_cc/file.pb.h"
+#include "proto_cc/identity.pb.h"
+#include "proto_cc/user_profile.pb.h"
+
+namespace {
+
+e8::ReadChunkFn ReadChunksFrom(std::vector<e8::FileChunk> const &chunks, unsigned *next) {
+    return [&chunks, next]() -> e8::FileChunk const * {
+        if (*next == chunks.size()) {
+            return nullptr;
+        }
+        return &chunks[(*next)++];
+    };
+}
+
+e8::FileChunk MakeChunk(int32_t chunk_number, std::string const &data) {
+    e8::FileChunk chunk;
+    chunk.set_chunk_number(chunk_number);
+    chunk.set_data(data);
+    return chunk;
+}
+
+} // namespace
+
+bool ResolveTokenAccessTest() {
+    e8::DemoWebTestEnvironmentContext env;
+
+    e8::Identity viewer;
+    viewer.set_user_id(123L);
+    std::string file_path = "/user/123/avatar/face.png";
+
+    e8::FileDescriptor read_write_descriptor;
+    read_write_descriptor.mutable_file_token_access()->set_access_token(e8::SignFileAccessToken(
+        viewer.user_id(), file_path, e8::FileAccessMode::FAM_READWRITE, env.KeyGen()));
+
+    // A read-write token grants both read and write access.
+    std::optional<std::string> resolved_path =
+        e8::ResolveFileAccess(viewer, read_write_descriptor, e8::FileAccessMode::FAM_WRITE,
+                              env.KeyGen(), env.DemowebDatabase());
+    TEST_CONDITION(resolved_path == file_path);
+    resolved_path = e8::ResolveFileAccess(viewer, read_write_descriptor,
+                                          e8::FileAccessMode::FAM_READ, env.KeyGen(),
+                                          env.DemowebDatabase());
+    TEST_CONDITION(resolved_path == file_path);
+
+    // A read-only token doesn't grant write access.
+    e8::FileDescriptor read_descriptor;
+    read_descriptor.mutable_file_token_access()->set_access_token(e8::SignFileAccessToken(
+        viewer.user_id(), file_path, e8::FileAccessMode::FAM_READ, env.KeyGen()));
+    resolved_path = e8::ResolveFileAccess(viewer, read_descriptor, e8::FileAccessMode::FAM_WRITE,
+                                          env.KeyGen(), env.DemowebDatabase());
+    TEST_CONDITION(!resolved_path.has_value());
+
+    // Impersonation.
+    e8::Identity impersonator;
+    impersonator.set_user_id(viewer.user_id() + 1);
+    resolved_path = e8::ResolveFileAccess(impersonator, read_write_descriptor,
+                                          e8::FileAccessMode::FAM_READ, env.KeyGen(),
+                                          env.DemowebDatabase());
+    TEST_CONDITION(!resolved_path.has_value());
+
+    // No access method.
+    resolved_path = e8::ResolveFileAccess(viewer, e8::FileDescriptor(),
+                                          e8::FileAccessMode::FAM_READ, env.KeyGen(),
+                                          env.DemowebDatabase());
+    TEST_CONDITION(!resolved_path.has_value());
+
+    return true;
+}
+
+bool DownloadOtherUsersAvatarTest() {
+    e8::DemoWebTestEnvironmentContext env;
+
+    std::optional<e8::UserEntity> owner =
+        e8::CreateUser(/*security_key=*/"", std::vector<std::string>(), /*user_id=*/std::nullopt,
+                       env.CurrentHostId(), env.DemowebDatabase());
+    TEST_CONDITION(owner.has_value());
+    e8::AvatarSetup avatar_setup =
+        e8::SetUpNewProfileAvatar(*owner, e8::FFMT_IMAGE_PNG, env.KeyGen(),
+                                  env.UserProfileCache(), env.DemowebDatabase());
+    std::string avatar_path = *avatar_setup.updated_user.avatar_path.Value();
+
+    std::vector<e8::FileChunk> chunks{MakeChunk(0, "avatar")};
+    unsigned next = 0;
+    TEST_CONDITION(e8::ReceiveFile(avatar_path, ReadChunksFrom(chunks, &next),
+                                   e8::kMaxUploadFileSize, env.FileSystem()) == e8::FTR_OK);
+
+    // Another user reads the avatar with the token from the owner's profile.
+    e8::Identity viewer;
+    viewer.set_user_id(*owner->id.Value() + 1);
+    std::vector<e8::UserPublicProfile> profiles =
+        e8::FetchPublicProfiles(viewer.user_id(), {*owner->id.Value()}, env.KeyGen(),
+                                env.UserProfileCache(), env.DemowebDatabase());
+    TEST_CONDITION(profiles.size() == 1);
+
+    e8::FileDescriptor avatar_descriptor;
+    *avatar_descriptor.mutable_file_token_access() = profiles[0].avatar_readonly_access();
+    std::optional<std::string> resolved_path =
+        e8::ResolveFileAccess(viewer, avatar_descriptor, e8::FileAccessMode::FAM_READ,
+                              env.KeyGen(), env.DemowebDatabase());
+    TEST_CONDITION(resolved_path == avatar_path);
+
+    std::string received;
+    e8::FileTransferResult result = e8::SendFile(
+        *resolved_path,
+        [&received](int32_t /*chunk_number*/, std::string_view data) {
+            received.append(data);
+            return true;
+        },
+        env.FileSystem());
+    TEST_CONDITION(result == e8::FTR_OK);
+    TEST_CONDITION(received == "avatar");
+
+    // The shared token doesn't let the viewer overwrite the avatar.
+    resolved_path = e8::ResolveFileAccess(viewer, avatar_descriptor, e8::FileAccessMode::FAM_WRITE,
+                                          env.KeyGen(), env.DemowebDatabase());
+    TEST_CONDITION(!resolved_path.has_value());
+
+    return true;
+}
+
+bool ReceiveThenSendFileTest() {
+    e8::DemoWebTestEnvironmentContext env;
+
+    std::string const large_data(e8::kFileTransferChunkSize + 3, 'a');
+    std::vector<e8::FileChunk> chunks{MakeChunk(0, "header"), MakeChunk(1, large_data),
+                                      MakeChunk(2, "trailer")};
+    unsigned next = 0;
+    e8::FileTransferResult result = e8::ReceiveFile(
+        "/user/123/avatar/face.png", ReadChunksFrom(chunks, &next), e8::kMaxUploadFileSize,
+        env.FileSystem());
+    TEST_CONDITION(result == e8::FTR_OK);
+
+    std::string received;
+    std::vector<int32_t> chunk_numbers;
+    result = e8::SendFile(
+        "/user/123/avatar/face.png",
+        [&received, &chunk_numbers](int32_t chunk_number, std::string_view data) {
+            chunk_numbers.push_back(chunk_number);
+            received.append(data);
+            return true;
+        },
+        env.FileSystem());
+    TEST_CONDITION(result == e8::FTR_OK);
+    TEST_CONDITION(received == "header" + large_data + "trailer");
+    TEST_CONDITION((chunk_numbers == std::vector<int32_t>{0, 1}));
+
+    // The reader stops the stream.
+    result = e8::SendFile(
+        "/user/123/avatar/face.png",
+        [](int32_t /*chunk_number*/, std::string_view /*data*/) { return false; },
+        env.FileSystem());
+    TEST_CONDITION(result == e8::FTR_STREAM_BROKEN);
+
+    result = e8::SendFile(
+        "/user/123/avatar/none.png",
+        [](int32_t /*chunk_number*/, std::string_view /*data*/) { return true; },
+        env.FileSystem());
+    TEST_CONDITION(result == e8::FTR_FILE_NOT_FOUND);
+
+    return true;
+}
+
+bool ReceiveOutOfOrderChunksTest() {
+    e8::DemoWebTestEnvironmentContext env;
+
+    std::vector<e8::FileChunk> chunks{MakeChunk(0, "original")};
+    unsigned next = 0;
+    e8::FileTransferResult result = e8::ReceiveFile(
+        "/user/123/avatar/face.png", ReadChunksFrom(chunks, &next), e8::kMaxUploadFileSize,
+        env.FileSystem());
+    TEST_CONDITION(result == e8::FTR_OK);
+
+    chunks = {MakeChunk(0, "new"), MakeChunk(2, "content")};
+    next = 0;
+    result = e8::ReceiveFile("/user/123/avatar/face.png", ReadChunksFrom(chunks, &next),
+                             e8::kMaxUploadFileSize, env.FileSystem());
+    TEST_CONDITION(result == e8::FTR_CHUNK_OUT_OF_ORDER);
+
+    // The failed upload leaves the original file intact.
+    std::unique_ptr<e8::FileInterface> file =
+        env.FileSystem()->OpenFile("/user/123/avatar/face.png");
+    TEST_CONDITION(file != nullptr);
+    TEST_CONDITION(file->Content() == std::string_view("original"));
+
+    return true;
+}
+
+bool ReceiveTooLargeFileTest() {
+    e8::DemoWebTestEnvironmentContext env;
+
+    std::vector<e8::FileChunk> chunks{MakeChunk(0, "original")};
+    unsigned next = 0;
+    e8::FileTransferResult result =
+        e8::ReceiveFile("/user/123/avatar/face.png", ReadChunksFrom(chunks, &next),
+                        /*max_file_size=*/8, env.FileSystem());
+    TEST_CONDITION(result == e8::FTR_OK);
+
+    chunks = {MakeChunk(0, "12345"), MakeChunk(1, "6789")};
+    next = 0;
+    result = e8::ReceiveFile("/user/123/avatar/face.png", ReadChunksFrom(chunks, &next),
+                             /*max_file_size=*/8, env.FileSystem());
+    TEST_CONDITION(result == e8::FTR_FILE_TOO_LARGE);
+
+    // The rejected upload leaves the original file intact.
+    std::unique_ptr<e8::FileInterface> file =
+        env.FileSystem()->OpenFile("/user/123/avatar/face.png");
+    TEST_CONDITION(file != nullptr);
+    TEST_CONDITION(file->Content() == std::string_view("original"));
+
+    return true;
+}
+
+int main() {
+    e8::BeginTestSuite("file_io");
+    e8::RunTest("ResolveTokenAccessTest", ResolveTokenAccessTest);
+    e8::RunTest("DownloadOtherUsersAvatarTest", DownloadOtherUsersAvatarTest);
+    e8::RunTest("ReceiveThenSendFileTest", ReceiveThenSendFileTest);
+    e8::RunTest("ReceiveOutOfOrderChunksTest", ReceiveOutOfOrderChunksTest);
+    e8::RunTest("ReceiveTooLargeFileTest", ReceiveTooLargeFileTest);
+    e8::EndTestSuite();
+    return 0;
+}
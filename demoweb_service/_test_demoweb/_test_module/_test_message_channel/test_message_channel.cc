@@ -345,7 +345,8 @@ bool ToMessageChannelOverviewsTest() {
         /*active_member_fetch_limit=*/10, std::nullopt, env.DemowebDatabase());
 
     std::vector<e8::MessageChannelOverview> overviews = e8::ToMessageChannelOverviews(
-        kCreatorId, retrieved_channels, env.KeyGen(), env.DemowebDatabase());
+        kCreatorId, retrieved_channels, env.KeyGen(), env.UserProfileCache(),
+        env.DemowebDatabase());
 
     TEST_CONDITION(overviews.size() == 1);
     TEST_CONDITION(overviews[0].channel().channel_id() == *channel_info.message_channel.id.Value());
@@ -91,27 +91,32 @@ bool SearchUserByIdAliasTest() {
     e8::UserEntity user0 = e8::CreateBaselineUser(/*security_key=*/"PASS", /*user_id=*/1L,
                                                   env.CurrentHostId(), db_conns)
                                .value();
-    e8::UpdateProfile(/*alias=*/"John Jr. A", std::nullopt, &user0, db_conns);
+    e8::UpdateProfile(/*alias=*/"John Jr. A", std::nullopt, &user0, env.UserProfileCache(),
+                      db_conns);
 
     e8::UserEntity user1 = e8::CreateBaselineUser(/*security_key=*/"PASS", /*userId=*/2L,
                                                   env.CurrentHostId(), db_conns)
                                .value();
-    e8::UpdateProfile(/*alias=*/"John Jr. A", std::nullopt, &user1, db_conns);
+    e8::UpdateProfile(/*alias=*/"John Jr. A", std::nullopt, &user1, env.UserProfileCache(),
+                      db_conns);
 
     e8::UserEntity user2 = e8::CreateBaselineUser(/*security_key=*/"PASS", /*userId=*/3L,
                                                   env.CurrentHostId(), db_conns)
                                .value();
-    e8::UpdateProfile(/*alias=*/"John Jr. B", std::nullopt, &user2, db_conns);
+    e8::UpdateProfile(/*alias=*/"John Jr. B", std::nullopt, &user2, env.UserProfileCache(),
+                      db_conns);
 
     e8::UserEntity user3 = e8::CreateBaselineUser(/*security_key=*/"PASS", /*userId=*/4L,
                                                   env.CurrentHostId(), db_conns)
                                .value();
-    e8::UpdateProfile(/*alias=*/"John Jr. C", std::nullopt, &user3, db_conns);
+    e8::UpdateProfile(/*alias=*/"John Jr. C", std::nullopt, &user3, env.UserProfileCache(),
+                      db_conns);
 
     e8::UserEntity user4 = e8::CreateBaselineUser(/*security_key=*/"PASS", /*userId=*/5L,
                                                   env.CurrentHostId(), db_conns)
                                .value();
-    e8::UpdateProfile(/*alias=*/"Stieve Jr. A", std::nullopt, &user4, db_conns);
+    e8::UpdateProfile(/*alias=*/"Stieve Jr. A", std::nullopt, &user4, env.UserProfileCache(),
+                      db_conns);
 
     e8::Pagination pagination;
     pagination.set_page_number(0);
@@ -15,11 +15,18 @@
  * not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <chrono>
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <thread>
 
 #include "common/unit_test_util/unit_test_util.h"
 #include "demoweb_service/demoweb/module/user_profile.h"
+#include "demoweb_service/demoweb/module/user_profile_cache.h"
 #include "proto_cc/file.pb.h"
+#include "proto_cc/user_profile.pb.h"
+#include "proto_cc/user_relation.pb.h"
 
 // TODO: enrich this test suite.
 
@@ -39,11 +46,99 @@ bool AllocateNewAvatarLocationWithOldPathTest() {
     return true;
 }
 
+bool UserPublicProfileCacheTest() {
+    e8::UserPublicProfileCache cache(/*capacity=*/2, /*ttl=*/std::chrono::seconds(60));
+
+    e8::UserPublicProfile profile;
+    profile.set_user_id(1L);
+    profile.mutable_alias()->set_value("alias");
+    profile.add_relations()->set_relation(e8::UserRelation::URL_CONTACT);
+    cache.Put(profile, cache.Generation());
+
+    std::optional<e8::UserPublicProfile> cached = cache.Fetch(1L);
+    TEST_CONDITION(cached.has_value());
+    TEST_CONDITION(cached->user_id() == 1L);
+    TEST_CONDITION(cached->alias().value() == "alias");
+    TEST_CONDITION(cached->relations().empty());
+    TEST_CONDITION(!cache.Fetch(2L).has_value());
+
+    cache.Invalidate(1L);
+    TEST_CONDITION(!cache.Fetch(1L).has_value());
+
+    // Capacity is bounded.
+    for (e8::UserId user_id = 1; user_id <= 3; user_id++) {
+        profile.set_user_id(user_id);
+        cache.Put(profile, cache.Generation());
+    }
+    unsigned num_cached = 0;
+    for (e8::UserId user_id = 1; user_id <= 3; user_id++) {
+        num_cached += cache.Fetch(user_id).has_value() ? 1 : 0;
+    }
+    TEST_CONDITION(num_cached == 2);
+    TEST_CONDITION(cache.Fetch(3L).has_value());
+
+    return true;
+}
+
+bool UserPublicProfileCacheExpirationTest() {
+    e8::UserPublicProfileCache cache(/*capacity=*/2, /*ttl=*/std::chrono::seconds(0));
+
+    e8::UserPublicProfile profile;
+    profile.set_user_id(1L);
+    cache.Put(profile, cache.Generation());
+
+    TEST_CONDITION(!cache.Fetch(1L).has_value());
+
+    return true;
+}
+
+bool UserPublicProfileCacheEvictionTest() {
+    e8::UserPublicProfileCache cache(/*capacity=*/2, /*ttl=*/std::chrono::seconds(60));
+
+    e8::UserPublicProfile profile;
+    for (e8::UserId user_id : {3L, 1L}) {
+        profile.set_user_id(user_id);
+        cache.Put(profile, cache.Generation());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // Only the profile cached the longest time ago is evicted, regardless of the user IDs.
+    profile.set_user_id(2L);
+    cache.Put(profile, cache.Generation());
+    TEST_CONDITION(!cache.Fetch(3L).has_value());
+    TEST_CONDITION(cache.Fetch(1L).has_value());
+    TEST_CONDITION(cache.Fetch(2L).has_value());
+
+    return true;
+}
+
+bool UserPublicProfileCacheStalePutTest() {
+    e8::UserPublicProfileCache cache(/*capacity=*/2, /*ttl=*/std::chrono::seconds(60));
+
+    e8::UserPublicProfile profile;
+    profile.set_user_id(1L);
+
+    // The profile was loaded before the user got updated.
+    uint64_t generation = cache.Generation();
+    cache.Invalidate(1L);
+    cache.Put(profile, generation);
+    TEST_CONDITION(!cache.Fetch(1L).has_value());
+
+    cache.Put(profile, cache.Generation());
+    TEST_CONDITION(cache.Fetch(1L).has_value());
+
+    return true;
+}
+
 int main() {
     e8::BeginTestSuite("user_profile");
     e8::RunTest("AllocateNewAvatarLocationTest", AllocateNewAvatarLocationTest);
     e8::RunTest("AllocateNewAvatarLocationWithOldPathTest",
                 AllocateNewAvatarLocationWithOldPathTest);
+    e8::RunTest("UserPublicProfileCacheTest", UserPublicProfileCacheTest);
+    e8::RunTest("UserPublicProfileCacheExpirationTest", UserPublicProfileCacheExpirationTest);
+    e8::RunTest("UserPublicProfileCacheEvictionTest", UserPublicProfileCacheEvictionTest);
+    e8::RunTest("UserPublicProfileCacheStalePutTest", UserPublicProfileCacheStalePutTest);
     e8::EndTestSuite();
     return 0;
 }
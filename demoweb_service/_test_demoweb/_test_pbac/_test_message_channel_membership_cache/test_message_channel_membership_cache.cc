@@ -0,0 +1,222 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <memory>
+#include <optional>
+
+#include "common/unit_test_util/unit_test_util.h"
+#include "demoweb_service/demoweb/common_entity/message_channel_entity.h"
+#include "demoweb_service/demoweb/common_entity/user_entity.h"
+#include "demoweb_service/demoweb/environment/test_environment_context.h"
+#include "demoweb_service/demoweb/module/message_channel.h"
+#include "demoweb_service/demoweb/module/message_channel_storage.h"
+#include "demoweb_service/demoweb/pbac/message_channel_membership_cache.h"
+#include "demoweb_service/demoweb/pbac/message_channel_pbac.h"
+#include "proto_cc/message_channel.pb.h"
+
+static e8::UserId const kCreatorId = 1;
+static e8::UserId const kRegularMemberId = 2;
+static e8::UserId const kNewMemberId = 3;
+
+e8::MessageChannelId CreateChannel(e8::DemoWebTestEnvironmentContext *env) {
+    e8::MessageChannelEntity channel = e8::CreateMessageChannel(
+        /*channel_name=*/"channel", /*description=*/"description", /*encrypted=*/false,
+        /*close_group_channel=*/true, env->CurrentHostId(), env->DemowebDatabase());
+
+    e8::CreateMessageChannelMembership(*channel.id.Value(), kCreatorId, e8::MCMT_ADMIN,
+                                       env->DemowebDatabase());
+    e8::CreateMessageChannelMembership(*channel.id.Value(), kRegularMemberId, e8::MCMT_MEMBER,
+                                       env->DemowebDatabase());
+
+    return *channel.id.Value();
+}
+
+bool FetchSnapshotTest() {
+    e8::DemoWebTestEnvironmentContext env;
+    e8::MessageChannelId channel_id = CreateChannel(&env);
+
+    e8::MessageChannelMembershipCache cache(/*max_num_channels=*/10, std::chrono::seconds(60),
+                                            env.DemowebDatabase());
+
+    std::shared_ptr<e8::MessageChannelAccessSnapshot const> snapshot = cache.Fetch(channel_id);
+    TEST_CONDITION(snapshot != nullptr);
+    TEST_CONDITION(snapshot->close_group_channel);
+    TEST_CONDITION(snapshot->members.size() == 2);
+    TEST_CONDITION(snapshot->num_admins == 1);
+    TEST_CONDITION(snapshot->Member(kCreatorId)->member_type == e8::MCMT_ADMIN);
+    TEST_CONDITION(snapshot->Member(kRegularMemberId)->member_type == e8::MCMT_MEMBER);
+    TEST_CONDITION(!snapshot->Member(kNewMemberId).has_value());
+
+    // Non-existing channel.
+    TEST_CONDITION(cache.Fetch(channel_id + 1000) == nullptr);
+
+    return true;
+}
+
+bool MembershipUpdateTest() {
+    e8::DemoWebTestEnvironmentContext env;
+    e8::MessageChannelId channel_id = CreateChannel(&env);
+
+    e8::MessageChannelMembershipCache cache(/*max_num_channels=*/10, std::chrono::seconds(60),
+                                            env.DemowebDatabase());
+    std::shared_ptr<e8::MessageChannelAccessSnapshot const> before = cache.Fetch(channel_id);
+
+    // Promotion.
+    cache.OnMembershipUpserted(channel_id, kRegularMemberId, e8::MCMT_ADMIN);
+    std::shared_ptr<e8::MessageChannelAccessSnapshot const> after = cache.Fetch(channel_id);
+    TEST_CONDITION(after->num_admins == 2);
+    TEST_CONDITION(after->Member(kRegularMemberId)->member_type == e8::MCMT_ADMIN);
+
+    // Snapshots handed out previously are left untouched.
+    TEST_CONDITION(before->num_admins == 1);
+
+    // New member.
+    cache.OnMembershipUpserted(channel_id, kNewMemberId, e8::MCMT_MEMBER);
+    after = cache.Fetch(channel_id);
+    TEST_CONDITION(after->members.size() == 3);
+    TEST_CONDITION(after->num_admins == 2);
+
+    // Removal.
+    cache.OnMembershipRemoved(channel_id, kCreatorId);
+    after = cache.Fetch(channel_id);
+    TEST_CONDITION(after->members.size() == 2);
+    TEST_CONDITION(after->num_admins == 1);
+    TEST_CONDITION(!after->Member(kCreatorId).has_value());
+
+    return true;
+}
+
+bool InvalidateTest() {
+    e8::DemoWebTestEnvironmentContext env;
+    e8::MessageChannelId channel_id = CreateChannel(&env);
+
+    e8::MessageChannelMembershipCache cache(/*max_num_channels=*/10, std::chrono::seconds(60),
+                                            env.DemowebDatabase());
+    TEST_CONDITION(cache.Fetch(channel_id)->members.size() == 2);
+
+    // Writes which bypass the cache are only visible after invalidation.
+    e8::CreateMessageChannelMembership(channel_id, kNewMemberId, e8::MCMT_MEMBER,
+                                       env.DemowebDatabase());
+    TEST_CONDITION(cache.Fetch(channel_id)->members.size() == 2);
+
+    cache.Invalidate(channel_id);
+    TEST_CONDITION(cache.Fetch(channel_id)->members.size() == 3);
+
+    return true;
+}
+
+bool ExpirationTest() {
+    e8::DemoWebTestEnvironmentContext env;
+    e8::MessageChannelId channel_id = CreateChannel(&env);
+
+    e8::MessageChannelMembershipCache cache(/*max_num_channels=*/10, std::chrono::seconds(0),
+                                            env.DemowebDatabase());
+    TEST_CONDITION(cache.Fetch(channel_id)->members.size() == 2);
+
+    e8::CreateMessageChannelMembership(channel_id, kNewMemberId, e8::MCMT_MEMBER,
+                                       env.DemowebDatabase());
+    TEST_CONDITION(cache.Fetch(channel_id)->members.size() == 3);
+
+    return true;
+}
+
+bool EvictionTest() {
+    e8::DemoWebTestEnvironmentContext env;
+    e8::MessageChannelId oldest_channel_id = CreateChannel(&env);
+    e8::MessageChannelId newer_channel_id = CreateChannel(&env);
+    e8::MessageChannelId newest_channel_id = CreateChannel(&env);
+
+    e8::MessageChannelMembershipCache cache(/*max_num_channels=*/2, std::chrono::seconds(60),
+                                            env.DemowebDatabase());
+    std::shared_ptr<e8::MessageChannelAccessSnapshot const> oldest = cache.Fetch(oldest_channel_id);
+    std::shared_ptr<e8::MessageChannelAccessSnapshot const> newer = cache.Fetch(newer_channel_id);
+
+    // Cache hits don't refresh the snapshot.
+    TEST_CONDITION(cache.Fetch(oldest_channel_id) == oldest);
+
+    // Only the snapshot loaded the longest time ago is evicted.
+    cache.Fetch(newest_channel_id);
+    TEST_CONDITION(cache.Fetch(newer_channel_id) == newer);
+    TEST_CONDITION(cache.Fetch(oldest_channel_id) != oldest);
+
+    return true;
+}
+
+bool CachedPbacTest() {
+    e8::DemoWebTestEnvironmentContext env;
+    e8::MessageChannelId channel_id = CreateChannel(&env);
+
+    e8::MessageChannelMembershipCache cache(/*max_num_channels=*/10, std::chrono::seconds(60),
+                                            env.DemowebDatabase());
+    e8::MessageChannelPbacImpl pbac(env.DemowebDatabase(), &cache);
+
+    TEST_CONDITION(pbac.AllowSendChatMessage(kRegularMemberId, channel_id));
+    TEST_CONDITION(!pbac.AllowSendChatMessage(kNewMemberId, channel_id));
+
+    // Can't remove the only admin.
+    TEST_CONDITION(!pbac.AllowDeleteMemberFromChannel(kCreatorId, channel_id, kCreatorId));
+
+    pbac.OnMembershipUpserted(channel_id, kNewMemberId, e8::MCMT_ADMIN);
+    TEST_CONDITION(pbac.AllowSendChatMessage(kNewMemberId, channel_id));
+    TEST_CONDITION(pbac.AllowDeleteMemberFromChannel(kCreatorId, channel_id, kCreatorId));
+
+    pbac.OnMembershipRemoved(channel_id, kRegularMemberId);
+    TEST_CONDITION(!pbac.AllowReadChatMessageGroup(kRegularMemberId, channel_id));
+
+    return true;
+}
+
+bool MemberRemovalTest() {
+    e8::DemoWebTestEnvironmentContext env;
+    e8::MessageChannelId channel_id = CreateChannel(&env);
+
+    e8::MessageChannelMembershipCache cache(/*max_num_channels=*/10, std::chrono::seconds(60),
+                                            env.DemowebDatabase());
+    e8::MessageChannelPbacImpl pbac(env.DemowebDatabase(), &cache);
+    TEST_CONDITION(pbac.AllowSendChatMessage(kRegularMemberId, channel_id));
+
+    e8::MessageChannelMembership removed;
+    removed.set_channel_id(channel_id);
+    removed.set_user_id(kRegularMemberId);
+    removed.set_member_type(e8::MCMT_MEMBER);
+
+    e8::MessageChannelMembershipDelta delta;
+    delta.to_be_removed.push_back(removed);
+    TEST_CONDITION(e8::UpdateMessageChannelMembership(kCreatorId, channel_id, delta, &pbac,
+                                                      env.DemowebDatabase()));
+
+    // The writing host revokes the access right away, without waiting for the snapshot to expire.
+    TEST_CONDITION(!pbac.AllowSendChatMessage(kRegularMemberId, channel_id));
+    TEST_CONDITION(!pbac.AllowReadChatMessageGroup(kRegularMemberId, channel_id));
+    TEST_CONDITION(!cache.Fetch(channel_id)->Member(kRegularMemberId).has_value());
+
+    return true;
+}
+
+int main() {
+    e8::BeginTestSuite("message_channel_membership_cache");
+    e8::RunTest("FetchSnapshotTest", FetchSnapshotTest);
+    e8::RunTest("MembershipUpdateTest", MembershipUpdateTest);
+    e8::RunTest("InvalidateTest", InvalidateTest);
+    e8::RunTest("ExpirationTest", ExpirationTest);
+    e8::RunTest("EvictionTest", EvictionTest);
+    e8::RunTest("CachedPbacTest", CachedPbacTest);
+    e8::RunTest("MemberRemovalTest", MemberRemovalTest);
+    e8::EndTestSuite();
+    return 0;
+}
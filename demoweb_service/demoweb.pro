@@ -9,6 +9,7 @@ SUBDIRS = \
     _test_demoweb/_test_module/_test_user_identity/_test_user_identity.pro \
     _test_demoweb/_test_module/_test_user_profile/_test_user_profile.pro \
     _test_demoweb/_test_module/_test_file_access_validator/_test_file_access_validator.pro \
+    _test_demoweb/_test_module/_test_file_io/_test_file_io.pro \
     _test_demoweb/_test_module/_test_contact_invitation/_test_contact_invitation.pro \
     _test_demoweb/_test_module/_test_contact_storage/_test_contact_storage.pro \
     _test_demoweb/_test_module/_test_search_user/_test_search_user.pro \
@@ -18,6 +19,7 @@ SUBDIRS = \
     _test_demoweb/_test_module/_test_chat_message/_test_chat_message.pro \
     _test_demoweb/_test_pbac/_test_message_channel_attributes/_test_message_channel_attributes.pro \
     _test_demoweb/_test_pbac/_test_message_channel_member_attributes/_test_message_channel_member_attributes.pro \
-    _test_demoweb/_test_pbac/_test_message_channel_pbac/_test_message_channel_pbac.pro
+    _test_demoweb/_test_pbac/_test_message_channel_pbac/_test_message_channel_pbac.pro \
+    _test_demoweb/_test_pbac/_test_message_channel_membership_cache/_test_message_channel_membership_cache.pro
 
 CONFIG += ordered
@@ -49,9 +49,11 @@ HEADERS += \
     module/system_user_group.h \
     module/user_identity.h \
     module/user_profile.h \
+    module/user_profile_cache.h \
     module/user_storage.h \
     pbac/message_channel_attributes.h \
     pbac/message_channel_member_attributes.h \
+    pbac/message_channel_membership_cache.h \
     pbac/message_channel_pbac.h \
     service/chat_message_service.h \
     service/file_service.h \
@@ -91,9 +93,11 @@ SOURCES += \
     module/search_user.cc \
     module/user_identity.cc \
     module/user_profile.cc \
+    module/user_profile_cache.cc \
     module/user_storage.cc \
     pbac/message_channel_attributes.cc \
     pbac/message_channel_member_attributes.cc \
+    pbac/message_channel_membership_cache.cc \
     pbac/message_channel_pbac.cc \
     service/chat_message_service.cc \
     service/file_service.cc \
@@ -137,6 +141,11 @@ unix:!macx: LIBS += -L$$OUT_PWD/../../message_queue/publisher/ -lpublisher
 INCLUDEPATH += $$PWD/../../message_queue/publisher
 DEPENDPATH += $$PWD/../../message_queue/publisher
 
+unix:!macx: LIBS += -L$$OUT_PWD/../../file_system/ -lfilesystem
+
+INCLUDEPATH += $$PWD/../../file_system
+DEPENDPATH += $$PWD/../../file_system
+
 LIBS += -lcrypt
 LIBS += -lcrypto++
 LIBS += -lpqxx
@@ -82,6 +82,11 @@ unix:!macx: LIBS += -L$$OUT_PWD/../../message_queue/publisher/ -lpublisher
 INCLUDEPATH += $$PWD/../../message_queue/publisher
 DEPENDPATH += $$PWD/../../message_queue/publisher
 
+unix:!macx: LIBS += -L$$OUT_PWD/../../file_system/ -lfilesystem
+
+INCLUDEPATH += $$PWD/../../file_system
+DEPENDPATH += $$PWD/../../file_system
+
 LIBS += -lpthread
 LIBS += -ldl
 LIBS += -lgrpc++ -lgrpc++_reflection
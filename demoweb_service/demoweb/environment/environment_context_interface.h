@@ -21,7 +21,9 @@
 #include <vector>
 
 #include "demoweb_service/demoweb/environment/host_id.h"
+#include "demoweb_service/demoweb/module/user_profile_cache.h"
 #include "demoweb_service/demoweb/pbac/message_channel_pbac.h"
+#include "file_system/file_system_interface.h"
 #include "keygen/key_generator_interface.h"
 #include "message_queue/publisher/publisher.h"
 #include "postgres/query_runner/connection/connection_reservoir_interface.h"
@@ -71,6 +73,16 @@ class DemoWebEnvironmentContextInterface {
      * @brief MessageChannelPbac Message channel access controller.
      */
     virtual MessageChannelPbacInterface *MessageChannelPbac() = 0;
+
+    /**
+     * @brief UserProfileCache Viewer independent user public profiles.
+     */
+    virtual UserPublicProfileCache *UserProfileCache() = 0;
+
+    /**
+     * @brief FileSystem Storage of user uploaded files.
+     */
+    virtual FileSystemInterface *FileSystem() = 0;
 };
 
 /**
@@ -16,14 +16,20 @@
  */
 
 #include <cassert>
+#include <cstdlib>
+#include <iostream>
 #include <memory>
 #include <vector>
 
+#include "common/time_util/time_util.h"
 #include "constant/demoweb_database.h"
 #include "demoweb_service/demoweb/environment/host_id.h"
+#include "demoweb_service/demoweb/module/user_profile_cache.h"
 #include "demoweb_service/demoweb/environment/prod_environment_context.h"
+#include "demoweb_service/demoweb/pbac/message_channel_membership_cache.h"
 #include "demoweb_service/demoweb/pbac/message_channel_pbac.h"
 #include "distributor/store/default_node_state_store.h"
+#include "file_system/local_file_system.h"
 #include "keygen/persistent_key_generator.h"
 #include "postgres/query_runner/connection/connection_factory.h"
 #include "postgres/query_runner/connection/pooled_connection_reservoir.h"
@@ -33,7 +39,7 @@ namespace e8 {
 
 DemoWebProductionEnvironmentContext::DemoWebProductionEnvironmentContext(
     std::string const &db_hostname, std::string const &node_state_db_path,
-    MessageQueueServicePort const message_queue_port) {
+    std::string const &file_storage_root, MessageQueueServicePort const message_queue_port) {
     InitDefaultNodeStateStoreProvider(node_state_db_path);
 
     ConnectionFactory fact(ConnectionFactory::PQ, db_hostname, kDemowebDatabaseName);
@@ -45,11 +51,27 @@ DemoWebProductionEnvironmentContext::DemoWebProductionEnvironmentContext(
     key_gen_ = std::make_unique<PersistentKeyGenerator>(db_hostname);
 
     host_id_ = ::e8::CurrentHostId();
+    if (host_id_ > kUniqueIdMaxHostId) {
+        // Unique IDs only have room for kUniqueIdHostIdBits of the host ID. Truncating it would
+        // make this host mint the same IDs as another host.
+        std::cerr << "Host ID " << host_id_ << " exceeds the maximum of " << kUniqueIdMaxHostId
+                  << std::endl;
+        std::abort();
+    }
 
     e8_message_publisher_ =
         std::make_unique<E8MessagePublisher>(DefaultNodeStateStore(), message_queue_port);
 
-    message_channel_pbac_ = std::make_unique<MessageChannelPbacImpl>(demoweb_database_.get());
+    message_channel_membership_cache_ = std::make_unique<MessageChannelMembershipCache>(
+        kMessageChannelMembershipCacheCapacity, kMessageChannelMembershipCacheTtl,
+        demoweb_database_.get());
+    message_channel_pbac_ = std::make_unique<MessageChannelPbacImpl>(
+        demoweb_database_.get(), message_channel_membership_cache_.get());
+
+    user_profile_cache_ = std::make_unique<UserPublicProfileCache>(kUserPublicProfileCacheCapacity,
+                                                                   kUserPublicProfileCacheTtl);
+
+    file_system_ = std::make_unique<LocalFileSystem>(file_storage_root);
 }
 
 DemoWebEnvironmentContextInterface::Environment
@@ -74,4 +96,10 @@ MessageChannelPbacInterface *DemoWebProductionEnvironmentContext::MessageChannel
     return message_channel_pbac_.get();
 }
 
+UserPublicProfileCache *DemoWebProductionEnvironmentContext::UserProfileCache() {
+    return user_profile_cache_.get();
+}
+
+FileSystemInterface *DemoWebProductionEnvironmentContext::FileSystem() { return file_system_.get(); }
+
 } // namespace e8
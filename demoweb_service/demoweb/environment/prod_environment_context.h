@@ -25,7 +25,10 @@
 
 #include "demoweb_service/demoweb/environment/environment_context_interface.h"
 #include "demoweb_service/demoweb/environment/host_id.h"
+#include "demoweb_service/demoweb/module/user_profile_cache.h"
+#include "demoweb_service/demoweb/pbac/message_channel_membership_cache.h"
 #include "demoweb_service/demoweb/pbac/message_channel_pbac.h"
+#include "file_system/file_system_interface.h"
 #include "keygen/key_generator_interface.h"
 #include "message_queue/common/entity.h"
 #include "message_queue/publisher/publisher.h"
@@ -41,6 +44,7 @@ class DemoWebProductionEnvironmentContext : public DemoWebEnvironmentContextInte
   public:
     DemoWebProductionEnvironmentContext(std::string const &demoweb_db_hostname,
                                         std::string const &node_state_db_path,
+                                        std::string const &file_storage_root,
                                         MessageQueueServicePort const message_queue_port);
     ~DemoWebProductionEnvironmentContext() override = default;
 
@@ -56,11 +60,18 @@ class DemoWebProductionEnvironmentContext : public DemoWebEnvironmentContextInte
 
     MessageChannelPbacInterface *MessageChannelPbac() override;
 
+    UserPublicProfileCache *UserProfileCache() override;
+
+    FileSystemInterface *FileSystem() override;
+
   private:
     std::unique_ptr<ConnectionReservoirInterface> demoweb_database_;
     std::unique_ptr<KeyGeneratorInterface> key_gen_;
     std::unique_ptr<E8MessagePublisher> e8_message_publisher_;
+    std::unique_ptr<MessageChannelMembershipCache> message_channel_membership_cache_;
     std::unique_ptr<MessageChannelPbacInterface> message_channel_pbac_;
+    std::unique_ptr<UserPublicProfileCache> user_profile_cache_;
+    std::unique_ptr<FileSystemInterface> file_system_;
     unsigned host_id_;
     int32_t padding_;
 };
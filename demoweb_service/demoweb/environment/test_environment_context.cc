@@ -15,20 +15,44 @@
  * not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <atomic>
 #include <cassert>
+#include <filesystem>
 #include <memory>
+#include <string>
+#include <unistd.h>
 #include <vector>
 
 #include "constant/demoweb_database.h"
 #include "demoweb_service/demoweb/environment/host_id.h"
+#include "demoweb_service/demoweb/module/user_profile_cache.h"
 #include "demoweb_service/demoweb/environment/test_environment_context.h"
+#include "demoweb_service/demoweb/pbac/message_channel_membership_cache.h"
 #include "demoweb_service/demoweb/pbac/message_channel_pbac.h"
+#include "file_system/local_file_system.h"
 #include "keygen/persistent_key_generator.h"
 #include "postgres/query_runner/connection/connection_factory.h"
 #include "postgres/query_runner/connection/pooled_connection_reservoir.h"
 #include "postgres/query_runner/sql_runner.h"
 
 namespace e8 {
+namespace {
+
+static char const kTestFileStorageDirName[] = "demoweb_test_file_storage";
+
+std::atomic<unsigned> gNumTestFileStorages(0);
+
+/**
+ * @brief UniqueTestFileStorageRoot A storage directory that no other test environment uses, even
+ * when test binaries run in parallel.
+ */
+std::filesystem::path UniqueTestFileStorageRoot() {
+    std::string dir_name = std::string(kTestFileStorageDirName) + "_" + std::to_string(getpid()) +
+                           "_" + std::to_string(gNumTestFileStorages.fetch_add(1));
+    return std::filesystem::temp_directory_path() / dir_name;
+}
+
+} // namespace
 
 DemoWebTestEnvironmentContext::DemoWebTestEnvironmentContext() {
     ConnectionFactory fact(ConnectionFactory::PQ, /*host_name=*/"localhost", kDemowebDatabaseName);
@@ -41,11 +65,29 @@ DemoWebTestEnvironmentContext::DemoWebTestEnvironmentContext() {
 
     key_gen_ = std::make_unique<PersistentKeyGenerator>(/*host_name=*/"localhost");
 
-    message_channel_pbac_ = std::make_unique<MessageChannelPbacImpl>(demoweb_database_.get());
+    message_channel_membership_cache_ = std::make_unique<MessageChannelMembershipCache>(
+        kMessageChannelMembershipCacheCapacity, kMessageChannelMembershipCacheTtl,
+        demoweb_database_.get());
+    message_channel_pbac_ = std::make_unique<MessageChannelPbacImpl>(
+        demoweb_database_.get(), message_channel_membership_cache_.get());
+
+    user_profile_cache_ = std::make_unique<UserPublicProfileCache>(kUserPublicProfileCacheCapacity,
+                                                                   kUserPublicProfileCacheTtl);
+
+    file_storage_root_ = UniqueTestFileStorageRoot();
+    std::filesystem::remove_all(file_storage_root_);
+    file_system_ = std::make_unique<LocalFileSystem>(file_storage_root_.string());
 
     host_id_ = 0;
 }
 
+DemoWebTestEnvironmentContext::~DemoWebTestEnvironmentContext() {
+    file_system_.reset();
+
+    std::error_code ec;
+    std::filesystem::remove_all(file_storage_root_, ec);
+}
+
 DemoWebEnvironmentContextInterface::Environment
 DemoWebTestEnvironmentContext::EnvironmentType() const {
     return DemoWebEnvironmentContextInterface::TEST;
@@ -68,4 +110,10 @@ MessageChannelPbacInterface *DemoWebTestEnvironmentContext::MessageChannelPbac()
     return message_channel_pbac_.get();
 }
 
+UserPublicProfileCache *DemoWebTestEnvironmentContext::UserProfileCache() {
+    return user_profile_cache_.get();
+}
+
+FileSystemInterface *DemoWebTestEnvironmentContext::FileSystem() { return file_system_.get(); }
+
 } // namespace e8
@@ -19,12 +19,16 @@
 #define DEMOWEB_TEST_ENVIRONMENT_CONTEXT_H
 
 #include <cstdint>
+#include <filesystem>
 #include <memory>
 #include <vector>
 
 #include "demoweb_service/demoweb/environment/environment_context_interface.h"
 #include "demoweb_service/demoweb/environment/host_id.h"
+#include "demoweb_service/demoweb/module/user_profile_cache.h"
+#include "demoweb_service/demoweb/pbac/message_channel_membership_cache.h"
 #include "demoweb_service/demoweb/pbac/message_channel_pbac.h"
+#include "file_system/file_system_interface.h"
 #include "keygen/key_generator_interface.h"
 #include "message_queue/publisher/publisher.h"
 #include "postgres/query_runner/connection/connection_reservoir_interface.h"
@@ -38,7 +42,7 @@ namespace e8 {
 class DemoWebTestEnvironmentContext : public DemoWebEnvironmentContextInterface {
   public:
     DemoWebTestEnvironmentContext();
-    ~DemoWebTestEnvironmentContext() override = default;
+    ~DemoWebTestEnvironmentContext() override;
 
     Environment EnvironmentType() const override;
 
@@ -52,10 +56,18 @@ class DemoWebTestEnvironmentContext : public DemoWebEnvironmentContextInterface
 
     MessageChannelPbacInterface *MessageChannelPbac() override;
 
+    UserPublicProfileCache *UserProfileCache() override;
+
+    FileSystemInterface *FileSystem() override;
+
   private:
     std::unique_ptr<ConnectionReservoirInterface> demoweb_database_;
     std::unique_ptr<KeyGeneratorInterface> key_gen_;
+    std::unique_ptr<MessageChannelMembershipCache> message_channel_membership_cache_;
     std::unique_ptr<MessageChannelPbacInterface> message_channel_pbac_;
+    std::unique_ptr<UserPublicProfileCache> user_profile_cache_;
+    std::unique_ptr<FileSystemInterface> file_system_;
+    std::filesystem::path file_storage_root_;
     unsigned host_id_;
     int32_t padding_;
 };
@@ -43,6 +43,7 @@ static char const kPortFlag[] = "port";
 static char const kGrpcWebProxyFlag[] = "grpc_web_proxy";
 static char const kDemowebDbHostNameFlag[] = "demoweb_db_host_name";
 static char const kNodeStateDbPathFlag[] = "node_state_db_path";
+static char const kFileStorageRootFlag[] = "file_storage_root";
 static char const kMessageQueueServicePortFlag[] = "message_queue_service_port";
 
 static int const kDefaultPort = 50051;
@@ -63,12 +64,16 @@ std::unique_ptr<e8::DemoWebProductionEnvironmentContext> BuildDemoWebEnvironment
         e8::ReadFlag(kNodeStateDbPathFlag, std::string(), e8::FromString<std::string>);
     assert(!node_state_db_path.empty());
 
+    std::string file_storage_root =
+        e8::ReadFlag(kFileStorageRootFlag, std::string(), e8::FromString<std::string>);
+    assert(!file_storage_root.empty());
+
     e8::MessageQueueServicePort message_queue_service_port = e8::ReadFlag(
         kMessageQueueServicePortFlag, e8::MessageQueueServicePort(), e8::FromString<uint32_t>);
     assert(message_queue_service_port != 0);
 
     auto context = std::make_unique<e8::DemoWebProductionEnvironmentContext>(
-        demoweb_db_host_name, node_state_db_path, message_queue_service_port);
+        demoweb_db_host_name, node_state_db_path, file_storage_root, message_queue_service_port);
 
     return context;
 }
@@ -32,7 +32,7 @@
 #include "demoweb_service/demoweb/module/chat_message_group_storage.h"
 #include "demoweb_service/demoweb/module/chat_message_storage.h"
 #include "demoweb_service/demoweb/module/user_profile.h"
-#include "demoweb_service/demoweb/module/user_storage.h"
+#include "demoweb_service/demoweb/module/user_profile_cache.h"
 #include "demoweb_service/demoweb/pbac/message_channel_pbac.h"
 #include "postgres/query_runner/connection/connection_reservoir_interface.h"
 #include "postgres/query_runner/reflection/sql_primitives.h"
@@ -44,37 +44,57 @@
 namespace e8 {
 namespace {
 
-std::vector<ChatMessageEntry>
-ToChatMessageEntries(std::vector<std::tuple<ChatMessageEntity, UserEntity>> const &entities,
-                     KeyGeneratorInterface *key_gen, ConnectionReservoirInterface *conns) {
+ChatMessageEntry ToChatMessageEntry(ChatMessageEntity const &chat_message,
+                                    UserPublicProfile const *sender_profile) {
+    ChatMessageEntry entry;
+    entry.set_thread_id(*chat_message.group_id.Value());
+    entry.set_message_seq_id(*chat_message.message_seq_id.Value());
+    if (sender_profile != nullptr) {
+        *entry.mutable_sender() = *sender_profile;
+    }
+    entry.set_created_at(*chat_message.created_at.Value());
+    *entry.mutable_texts() = {chat_message.text_entries.Value().begin(),
+                              chat_message.text_entries.Value().end()};
+    // TODO: manages media and binary file accesses.
+
+    return entry;
+}
+
+std::vector<ChatMessageEntry> ToChatMessageEntries(std::vector<ChatMessageEntity> const &entities,
+                                                   KeyGeneratorInterface *key_gen,
+                                                   UserPublicProfileCache *profile_cache,
+                                                   ConnectionReservoirInterface *conns) {
     std::unordered_set<UserId> unique_sender_ids;
-    std::vector<UserEntity> unqiue_senders;
-    for (auto const &[_, sender] : entities) {
-        auto it = unique_sender_ids.find(*sender.id.Value());
+    std::vector<UserId> sender_id_list;
+    for (auto const &chat_message : entities) {
+        UserId sender_id = *chat_message.sender_id.Value();
+        auto it = unique_sender_ids.find(sender_id);
         if (it == unique_sender_ids.end()) {
-            unique_sender_ids.insert(*sender.id.Value());
-            unqiue_senders.push_back(sender);
+            unique_sender_ids.insert(sender_id);
+            sender_id_list.push_back(sender_id);
         }
     }
 
-    std::vector<UserPublicProfile> sender_profiles =
-        BuildPublicProfiles(/*viewer_id=*/std::nullopt, unqiue_senders, key_gen, conns);
+    // Senders repeat across pages, so their profiles mostly come from the cache.
+    std::vector<UserPublicProfile> sender_profiles = FetchPublicProfiles(
+        /*viewer_id=*/std::nullopt, sender_id_list, key_gen, profile_cache, conns);
     std::unordered_map<UserId, UserPublicProfile const *> sender_profile_lookup(
         sender_profiles.size());
     for (auto const &sender_profile : sender_profiles) {
         sender_profile_lookup.insert(std::make_pair(sender_profile.user_id(), &sender_profile));
     }
 
-    std::vector<ChatMessageEntry> entries(entities.size());
-    for (unsigned i = 0; i < entries.size(); ++i) {
-        auto const &[chat_message, _] = entities[i];
-        entries[i].set_thread_id(*chat_message.group_id.Value());
-        entries[i].set_message_seq_id(*chat_message.message_seq_id.Value());
-        *entries[i].mutable_sender() = *sender_profile_lookup[*chat_message.sender_id.Value()];
-        entries[i].set_created_at(*chat_message.created_at.Value());
-        *entries[i].mutable_texts() = {chat_message.text_entries.Value().begin(),
-                                       chat_message.text_entries.Value().end()};
-        // TODO: manages media and binary file accesses.
+    std::vector<ChatMessageEntry> entries;
+    entries.reserve(entities.size());
+    for (auto const &chat_message : entities) {
+        // The sender may have been deleted since the messages were read, taking their messages
+        // with them.
+        auto sender_it = sender_profile_lookup.find(*chat_message.sender_id.Value());
+        if (sender_it == sender_profile_lookup.end()) {
+            continue;
+        }
+
+        entries.push_back(ToChatMessageEntry(chat_message, sender_it->second));
     }
 
     return entries;
@@ -82,11 +102,13 @@ ToChatMessageEntries(std::vector<std::tuple<ChatMessageEntity, UserEntity>> cons
 
 } // namespace
 
-std::optional<SendChatMessageResult> SendChatMessage(
-    UserId const sender_id, ChatMessageGroupId const group_id,
-    std::vector<std::string> const &texts, std::vector<FileFormat> const & /*media_file_formats*/,
-    std::vector<FileFormat> const & /*binary_file_formats*/, MessageChannelPbacInterface *pbac,
-    KeyGeneratorInterface *key_gen, ConnectionReservoirInterface *conns) {
+std::optional<SendChatMessageResult>
+SendChatMessage(UserId const sender_id, ChatMessageGroupId const group_id,
+                std::vector<std::string> const &texts,
+                std::vector<FileFormat> const & /*media_file_formats*/,
+                std::vector<FileFormat> const & /*binary_file_formats*/, HostId const host_id,
+                MessageChannelPbacInterface *pbac, KeyGeneratorInterface *key_gen,
+                UserPublicProfileCache *profile_cache, ConnectionReservoirInterface *conns) {
     std::optional<ChatMessageGroupEntity> group = FetchChatMessageGroup(group_id, conns);
     if (!group.has_value()) {
         return std::nullopt;
@@ -95,29 +117,23 @@ std::optional<SendChatMessageResult> SendChatMessage(
         return std::nullopt;
     }
 
-    ChatMessageEntity entity =
-        CreateChatMessage(group_id, sender_id, texts,
-                          /*binary_content_paths=*/std::vector<std::string>(), conns);
-
-    switch (*group->group_type.Value()) {
-    case CMTT_POPUP: {
-        *group->last_interaction_at.ValuePtr() = *entity.created_at.Value();
-        int64_t rows = Update(*group, TableNames::ChatMessageGroup(), /*replace=*/true, conns);
-        assert(rows == 1);
-        break;
-    }
-    case CMTT_TEMPORAL: {
-        // Do nothing.
-        break;
-    }
+    std::optional<ChatMessageEntity> entity = CreateChatMessageAndTouchGroup(
+        group_id, sender_id, texts,
+        /*binary_content_paths=*/std::vector<std::string>(), host_id, conns);
+    if (!entity.has_value()) {
+        // The group has been deleted since it was fetched.
+        return std::nullopt;
     }
 
+    // The sender's profile is usually cached as the sender has been active. The message has been
+    // stored regardless, so it is returned without the profile if the sender is gone.
+    std::vector<UserPublicProfile> sender_profiles =
+        FetchPublicProfiles(/*viewer_id=*/std::nullopt, std::vector<UserId>{sender_id}, key_gen,
+                            profile_cache, conns);
+
     SendChatMessageResult result;
-    std::optional<UserEntity> sender = FetchUser(sender_id, conns);
-    assert(sender.has_value());
-    result.message = ToChatMessageEntries(
-        std::vector<std::tuple<ChatMessageEntity, UserEntity>>{std::make_tuple(entity, *sender)},
-        key_gen, conns)[0];
+    result.message =
+        ToChatMessageEntry(*entity, sender_profiles.empty() ? nullptr : &sender_profiles[0]);
 
     return result;
 }
@@ -125,7 +141,8 @@ std::optional<SendChatMessageResult> SendChatMessage(
 std::vector<ChatMessageEntry>
 GetChatMessages(UserId const viewer_id, ChatMessageGroupId const group_id,
                 std::optional<Pagination> const &pagination, MessageChannelPbacInterface *pbac,
-                KeyGeneratorInterface *key_gen, ConnectionReservoirInterface *conns) {
+                KeyGeneratorInterface *key_gen, UserPublicProfileCache *profile_cache,
+                ConnectionReservoirInterface *conns) {
     std::optional<ChatMessageGroupEntity> group = FetchChatMessageGroup(group_id, conns);
     if (!group.has_value()) {
         return std::vector<ChatMessageEntry>();
@@ -137,9 +154,7 @@ GetChatMessages(UserId const viewer_id, ChatMessageGroupId const group_id,
     SqlQueryBuilder query;
     SqlQueryBuilder::Placeholder<SqlLong> group_id_ph;
     query.QueryPiece(TableNames::ChatMessage())
-        .QueryPiece(" cm JOIN ")
-        .QueryPiece(TableNames::AUser())
-        .QueryPiece(" sender ON sender.id = cm.sender_id WHERE cm.group_id=")
+        .QueryPiece(" cm WHERE cm.group_id=")
         .Holder(&group_id_ph)
         .QueryPiece(" ORDER BY cm.message_seq_id ASC");
 
@@ -158,10 +173,15 @@ GetChatMessages(UserId const viewer_id, ChatMessageGroupId const group_id,
 
     query.SetValueToPlaceholder(group_id_ph, std::make_shared<SqlLong>(group_id));
 
-    std::vector<std::tuple<ChatMessageEntity, UserEntity>> query_results =
-        Query<ChatMessageEntity, UserEntity>(query, {"cm", "sender"}, conns);
+    std::vector<std::tuple<ChatMessageEntity>> query_results =
+        Query<ChatMessageEntity>(query, {"cm"}, conns);
+
+    std::vector<ChatMessageEntity> chat_messages(query_results.size());
+    for (unsigned i = 0; i < query_results.size(); ++i) {
+        chat_messages[i] = std::get<0>(query_results[i]);
+    }
 
-    return ToChatMessageEntries(query_results, key_gen, conns);
+    return ToChatMessageEntries(chat_messages, key_gen, profile_cache, conns);
 }
 
 } // namespace e8
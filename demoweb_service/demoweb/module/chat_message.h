@@ -26,6 +26,7 @@
 #include "demoweb_service/demoweb/common_entity/chat_message_group_entity.h"
 #include "demoweb_service/demoweb/common_entity/user_entity.h"
 #include "demoweb_service/demoweb/environment/host_id.h"
+#include "demoweb_service/demoweb/module/user_profile_cache.h"
 #include "demoweb_service/demoweb/pbac/message_channel_pbac.h"
 #include "keygen/key_generator_interface.h"
 #include "postgres/query_runner/connection/connection_reservoir_interface.h"
@@ -48,7 +49,8 @@ struct SendChatMessageResult {
 /**
  * @brief SendChatMessage Send a chat message entry to the specified chat message group which
  * belongs to a message channel. People in that message channel will be notified and receive the
- * chat message. The sender will be checked against the access rules provided by the PBAC.
+ * chat message. The sender will be checked against the access rules provided by the PBAC in that
+ * message channel. The insertion and the group update take a single database round trip.
  *
  * TOOD: Add supports for handling binary files and media files.
  *
@@ -59,18 +61,23 @@ struct SendChatMessageResult {
  * formats, if any.
  * @param binary_file_formats Requests a list of general binary file location access of the
  * specified file formats, if any.
+ * @param host_id ID of the host machine which generates the message sequence ID.
  * @param pbac Policy based access controller for the associated message channel.
  * @param key_gen Key generator for signing the avatar path as well as file paths associated with
  * the chat message.
+ * @param profile_cache Nullable. Cached public profiles of the message senders.
  * @param conns Database connections.
  * @return The sent messages and corresponding file location accesses if the group ID is valid and
- * the sender pass the evaluation provided by the PBAC.
+ * the sender is allowed to send to it. The sender's profile is left unset in the returned message
+ * if the sender no longer exists.
  */
-std::optional<SendChatMessageResult> SendChatMessage(
-    UserId const sender_id, ChatMessageGroupId const group_id,
-    std::vector<std::string> const &texts, std::vector<FileFormat> const &media_file_formats,
-    std::vector<FileFormat> const &binary_file_formats, MessageChannelPbacInterface *pbac,
-    KeyGeneratorInterface *key_gen, ConnectionReservoirInterface *conns);
+std::optional<SendChatMessageResult>
+SendChatMessage(UserId const sender_id, ChatMessageGroupId const group_id,
+                std::vector<std::string> const &texts,
+                std::vector<FileFormat> const &media_file_formats,
+                std::vector<FileFormat> const &binary_file_formats, HostId const host_id,
+                MessageChannelPbacInterface *pbac, KeyGeneratorInterface *key_gen,
+                UserPublicProfileCache *profile_cache, ConnectionReservoirInterface *conns);
 
 /**
  * @brief GetChatMessages Get chat message entries from the specified chat message group which
@@ -83,6 +90,7 @@ std::optional<SendChatMessageResult> SendChatMessage(
  * @param pbac Policy based access controller for the associated message channel.
  * @param key_gen Key generator for signing the avatar path as well as file paths associated with
  * the chat message.
+ * @param profile_cache Nullable. Cached public profiles of the message senders.
  * @param conns Database connections.
  * @return The message entries returned based on the criteria specified by the arguments. If the
  * message group doesn't exist or the viewer doesn't have the privilege to read from the message
@@ -91,7 +99,8 @@ std::optional<SendChatMessageResult> SendChatMessage(
 std::vector<ChatMessageEntry>
 GetChatMessages(UserId const viewer_id, ChatMessageGroupId const group_id,
                 std::optional<Pagination> const &pagination, MessageChannelPbacInterface *pbac,
-                KeyGeneratorInterface *key_gen, ConnectionReservoirInterface *conns);
+                KeyGeneratorInterface *key_gen, UserPublicProfileCache *profile_cache,
+                ConnectionReservoirInterface *conns);
 
 } // namespace e8
 
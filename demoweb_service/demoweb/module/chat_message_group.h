@@ -26,6 +26,7 @@
 #include "demoweb_service/demoweb/common_entity/message_channel_entity.h"
 #include "demoweb_service/demoweb/common_entity/user_entity.h"
 #include "demoweb_service/demoweb/environment/host_id.h"
+#include "demoweb_service/demoweb/module/user_profile_cache.h"
 #include "demoweb_service/demoweb/pbac/message_channel_pbac.h"
 #include "keygen/key_generator_interface.h"
 #include "postgres/query_runner/connection/connection_reservoir_interface.h"
@@ -77,6 +78,7 @@ CreateChatMessageGroup(UserId const creator_id, MessageChannelId const channel_i
  * @param pbac Policy based access controller for the associated message channel.
  * @param key_gen Key generator for signing the avatar path as well as file paths associated with
  * the chat message.
+ * @param profile_cache Nullable. Cached public profiles of the message senders.
  * @param conns Database connections.
  * @return The chat message groups with chat message summary list.
  */
@@ -84,7 +86,7 @@ std::vector<ChatMessageThread> GetChatMessageGroupsWithChatMessageSummaryList(
     UserId const viewer_id, MessageChannelId const channel_id,
     int32_t const max_num_messages_per_group, Pagination const pagination,
     MessageChannelPbacInterface *pbac, KeyGeneratorInterface *key_gen,
-    ConnectionReservoirInterface *conns);
+    UserPublicProfileCache *profile_cache, ConnectionReservoirInterface *conns);
 
 } // namespace e8
 
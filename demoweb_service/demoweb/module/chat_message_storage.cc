@@ -17,6 +17,8 @@
 
 #include <cassert>
 #include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -29,6 +31,8 @@
 #include "demoweb_service/demoweb/environment/host_id.h"
 #include "demoweb_service/demoweb/module/chat_message_storage.h"
 #include "postgres/query_runner/connection/connection_reservoir_interface.h"
+#include "postgres/query_runner/reflection/sql_primitives.h"
+#include "postgres/query_runner/sql_query_builder.h"
 #include "postgres/query_runner/sql_runner.h"
 #include "proto_cc/chat_message.pb.h"
 
@@ -38,10 +42,10 @@ ChatMessageEntity CreateChatMessage(ChatMessageGroupId const chat_message_group_
                                     UserId const sender_id,
                                     std::vector<std::string> const &text_entries,
                                     std::vector<std::string> const &binary_content_paths,
-                                    ConnectionReservoirInterface *conns) {
+                                    HostId const host_id, ConnectionReservoirInterface *conns) {
     ChatMessageEntity chat_message;
     *chat_message.group_id.ValuePtr() = chat_message_group_id;
-    *chat_message.message_seq_id.ValuePtr() = e8::TemporalId();
+    *chat_message.message_seq_id.ValuePtr() = e8::UniqueId(host_id);
     *chat_message.sender_id.ValuePtr() = sender_id;
     *chat_message.text_entries.ValuePtr() = text_entries;
     *chat_message.binary_content_paths.ValuePtr() = binary_content_paths;
@@ -55,6 +59,90 @@ ChatMessageEntity CreateChatMessage(ChatMessageGroupId const chat_message_group_
     return chat_message;
 }
 
+std::optional<ChatMessageEntity>
+CreateChatMessageAndTouchGroup(ChatMessageGroupId const chat_message_group_id,
+                               UserId const sender_id, std::vector<std::string> const &text_entries,
+                               std::vector<std::string> const &binary_content_paths,
+                               HostId const host_id, ConnectionReservoirInterface *conns) {
+    ChatMessageEntity chat_message;
+    *chat_message.group_id.ValuePtr() = chat_message_group_id;
+    *chat_message.message_seq_id.ValuePtr() = e8::UniqueId(host_id);
+    *chat_message.sender_id.ValuePtr() = sender_id;
+    *chat_message.text_entries.ValuePtr() = text_entries;
+    *chat_message.binary_content_paths.ValuePtr() = binary_content_paths;
+    TimestampMicros timestamp = CurrentTimestampMicros();
+    *chat_message.created_at.ValuePtr() = timestamp;
+    *chat_message.last_interaction_at.ValuePtr() = timestamp;
+
+    SqlQueryBuilder query;
+    SqlQueryBuilder::Placeholder<SqlLong> group_id_ph;
+    SqlQueryBuilder::Placeholder<SqlLong> sender_id_ph;
+    SqlQueryBuilder::Placeholder<SqlInt> popup_group_type_ph;
+    SqlQueryBuilder::Placeholder<SqlLong> message_seq_id_ph;
+    SqlQueryBuilder::Placeholder<SqlStrArr> text_entries_ph;
+    SqlQueryBuilder::Placeholder<SqlStrArr> binary_content_paths_ph;
+    SqlQueryBuilder::Placeholder<SqlTimestamp> timestamp_ph;
+
+    // Resolves the group so that nothing is written if it has been deleted.
+    query.QueryPiece("WITH target_group AS (SELECT cmg.id,cmg.group_type FROM ")
+        .QueryPiece(TableNames::ChatMessageGroup())
+        .QueryPiece(" cmg WHERE cmg.id=")
+        .Holder(&group_id_ph)
+        .QueryPiece(")");
+
+    // Touches the pop-up group.
+    query.QueryPiece(", touched_group AS (UPDATE ")
+        .QueryPiece(TableNames::ChatMessageGroup())
+        .QueryPiece(" cmg SET last_interaction_at=")
+        .Holder(&timestamp_ph)
+        .QueryPiece(" FROM target_group tg WHERE cmg.id=tg.id AND tg.group_type=")
+        .Holder(&popup_group_type_ph)
+        .QueryPiece(")");
+
+    // Parameters in the select list have to be typed explicitly.
+    query.QueryPiece(" INSERT INTO ")
+        .QueryPiece(TableNames::ChatMessage())
+        .QueryPiece(" (")
+        .QueryPiece(chat_message.group_id.FieldName() + "," +
+                    chat_message.message_seq_id.FieldName() + "," +
+                    chat_message.sender_id.FieldName() + "," +
+                    chat_message.text_entries.FieldName() + "," +
+                    chat_message.binary_content_paths.FieldName() + "," +
+                    chat_message.created_at.FieldName() + "," +
+                    chat_message.last_interaction_at.FieldName())
+        .QueryPiece(") SELECT tg.id,")
+        .Holder(&message_seq_id_ph)
+        .QueryPiece("::BIGINT,")
+        .Holder(&sender_id_ph)
+        .QueryPiece("::BIGINT,")
+        .Holder(&text_entries_ph)
+        .QueryPiece("::CHARACTER VARYING[],")
+        .Holder(&binary_content_paths_ph)
+        .QueryPiece("::CHARACTER VARYING[],")
+        .Holder(&timestamp_ph)
+        .QueryPiece("::TIMESTAMP,")
+        .Holder(&timestamp_ph)
+        .QueryPiece("::TIMESTAMP FROM target_group tg");
+
+    query.SetValueToPlaceholder(group_id_ph, std::make_shared<SqlLong>(chat_message_group_id));
+    query.SetValueToPlaceholder(sender_id_ph, std::make_shared<SqlLong>(sender_id));
+    query.SetValueToPlaceholder(popup_group_type_ph, std::make_shared<SqlInt>(CMTT_POPUP));
+    query.SetValueToPlaceholder(message_seq_id_ph,
+                                std::make_shared<SqlLong>(*chat_message.message_seq_id.Value()));
+    query.SetValueToPlaceholder(text_entries_ph, std::make_shared<SqlStrArr>(text_entries));
+    query.SetValueToPlaceholder(binary_content_paths_ph,
+                                std::make_shared<SqlStrArr>(binary_content_paths));
+    query.SetValueToPlaceholder(timestamp_ph, std::make_shared<SqlTimestamp>(timestamp));
+
+    uint64_t num_rows = Exec(query, conns);
+    if (num_rows == 0) {
+        return std::nullopt;
+    }
+    assert(num_rows == 1);
+
+    return chat_message;
+}
+
 std::optional<ChatMessageEntity> FetchChatMessage(ChatMessageId const chat_message_id,
                                                   ConnectionReservoirInterface *conns) {
     SqlQueryBuilder query;
@@ -41,7 +41,20 @@ ChatMessageEntity CreateChatMessage(ChatMessageGroupId const chat_message_group_
                                     UserId const sender_id,
                                     std::vector<std::string> const &text_entries,
                                     std::vector<std::string> const &binary_content_paths,
-                                    ConnectionReservoirInterface *conns);
+                                    HostId const host_id, ConnectionReservoirInterface *conns);
+
+/**
+ * @brief CreateChatMessageAndTouchGroup Similar to the above function, but it also bumps the last
+ * interaction time of the group if it's a pop-up group. The insertion and the group update are done
+ * in a single statement. It doesn't check the sender's privilege.
+ *
+ * @return The newly created chat message, or nullopt if the group doesn't exist.
+ */
+std::optional<ChatMessageEntity>
+CreateChatMessageAndTouchGroup(ChatMessageGroupId const chat_message_group_id,
+                               UserId const sender_id, std::vector<std::string> const &text_entries,
+                               std::vector<std::string> const &binary_content_paths,
+                               HostId const host_id, ConnectionReservoirInterface *conns);
 
 /**
  * @brief FetchChatMessage Fetch a chat message by ID, if one exists.
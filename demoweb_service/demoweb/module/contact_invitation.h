@@ -22,6 +22,7 @@
 
 #include "demoweb_service/demoweb/common_entity/user_entity.h"
 #include "demoweb_service/demoweb/environment/host_id.h"
+#include "demoweb_service/demoweb/module/user_profile_cache.h"
 #include "keygen/key_generator_interface.h"
 #include "message_queue/publisher/publisher.h"
 #include "postgres/query_runner/connection/connection_reservoir_interface.h"
@@ -40,7 +41,8 @@ namespace e8 {
 bool SendInvitation(UserId inviter_id, UserId invitee_id, bool send_message_anyway,
                     HostId const host_id,
                     std::vector<MessagePublisherInterface *> const &publishers,
-                    KeyGeneratorInterface *key_gen, ConnectionReservoirInterface *conns);
+                    KeyGeneratorInterface *key_gen, UserPublicProfileCache *profile_cache,
+                    ConnectionReservoirInterface *conns);
 
 /**
  * @brief ProcessInvitation Accepts or rejects an invitation. If accepted, the invitation will be
@@ -51,7 +53,8 @@ bool SendInvitation(UserId inviter_id, UserId invitee_id, bool send_message_anyw
  */
 bool ProcessInvitation(UserId invitee_id, UserId inviter_id, bool accept, HostId const host_id,
                        std::vector<MessagePublisherInterface *> const &publishers,
-                       KeyGeneratorInterface *key_gen, ConnectionReservoirInterface *conns);
+                       KeyGeneratorInterface *key_gen, UserPublicProfileCache *profile_cache,
+                       ConnectionReservoirInterface *conns);
 
 } // namespace e8
 
@@ -39,6 +39,36 @@ namespace {
 static char const kEncrypter[] = "FileAccessSigner";
 static uint64_t const kFileSignatureValidDurationMicros = 60 * 10 * 1000 * 1000;
 
+/**
+ * @brief DecodeFileAccessToken Verifies the signature and the expiry of the access token.
+ *
+ * @return The signed file access if the token is valid.
+ */
+std::optional<SignableFileAccess> DecodeFileAccessToken(FileAccessToken const &access_token,
+                                                        KeyGeneratorInterface *key_gen) {
+    KeyGeneratorInterface::Key key_pair =
+        key_gen->KeyOf(kEncrypter, KeyGeneratorInterface::RSA_4096_BITS);
+    assert(key_pair.public_key.has_value());
+
+    std::optional<std::string> decoded_bytes =
+        DecodeSignedMessage(access_token, key_pair.public_key.value());
+    if (!decoded_bytes.has_value()) {
+        return std::nullopt;
+    }
+
+    SignableFileAccess file_access;
+    bool deserialize_status =
+        file_access.ParseFromArray(decoded_bytes.value().data(), decoded_bytes.value().size());
+    assert(deserialize_status == true);
+
+    TimestampMicros cur_timestamp = CurrentTimestampMicros();
+    if (cur_timestamp > file_access.expiry_timestamp()) {
+        return std::nullopt;
+    }
+
+    return file_access;
+}
+
 } // namespace
 
 FileAccessToken SignFileAccessToken(UserId viewer_id, std::string const &file_path,
@@ -62,31 +92,26 @@ FileAccessToken SignFileAccessToken(UserId viewer_id, std::string const &file_pa
 std::optional<std::string> ValidateFileAccessToken(UserId viewer_id, FileAccessMode access_mode,
                                                    FileAccessToken const &access_token,
                                                    KeyGeneratorInterface *key_gen) {
-    KeyGeneratorInterface::Key key_pair =
-        key_gen->KeyOf(kEncrypter, KeyGeneratorInterface::RSA_4096_BITS);
-    assert(key_pair.public_key.has_value());
-
-    std::optional<std::string> decoded_bytes =
-        DecodeSignedMessage(access_token, key_pair.public_key.value());
-    if (!decoded_bytes.has_value()) {
+    std::optional<SignableFileAccess> file_access = DecodeFileAccessToken(access_token, key_gen);
+    if (!file_access.has_value()) {
         return std::nullopt;
     }
 
-    SignableFileAccess file_access;
-    bool deserialize_status =
-        file_access.ParseFromArray(decoded_bytes.value().data(), decoded_bytes.value().size());
-    assert(deserialize_status == true);
-
-    if (file_access.viewer_id() != viewer_id || file_access.access_mode() != access_mode) {
+    if (file_access->viewer_id() != viewer_id || file_access->access_mode() != access_mode) {
         return std::nullopt;
     }
 
-    TimestampMicros cur_timestamp = CurrentTimestampMicros();
-    if (cur_timestamp > file_access.expiry_timestamp()) {
+    return file_access->file_path();
+}
+
+std::optional<std::string> ValidateSharedReadFileAccessToken(FileAccessToken const &access_token,
+                                                             KeyGeneratorInterface *key_gen) {
+    std::optional<SignableFileAccess> file_access = DecodeFileAccessToken(access_token, key_gen);
+    if (!file_access.has_value() || file_access->access_mode() != FAM_READ) {
         return std::nullopt;
     }
 
-    return file_access.file_path();
+    return file_access->file_path();
 }
 
 void AddDirectFileAccessForUserGroup(std::string const &file_path,
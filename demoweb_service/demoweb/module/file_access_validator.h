@@ -60,6 +60,18 @@ std::optional<std::string> ValidateFileAccessToken(UserId viewer_id, FileAccessM
                                                    FileAccessToken const &access_token,
                                                    KeyGeneratorInterface *key_gen);
 
+/**
+ * @brief ValidateSharedReadFileAccessToken Validate read access to a location through a FAM_READ
+ * token regardless of whom it was signed for. Read-only tokens are shared: a public profile carries
+ * read-only avatar tokens signed for the profile owner and it's served to every viewer.
+ *
+ * @param access_token The access token the viewer is holding.
+ * @param key_gen Key generator that holds the public signature verification key.
+ * @return Location of the file the token permits reading if the token can be verified.
+ */
+std::optional<std::string> ValidateSharedReadFileAccessToken(FileAccessToken const &access_token,
+                                                             KeyGeneratorInterface *key_gen);
+
 /**
  * @brief AddDirectFileAccessForUserGroup Assigns a file location to a user group which allows users
  * of that group to have the specified direct access to the file location.
@@ -15,6 +15,136 @@
  * not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "common/time_util/time_util.h"
+#include "demoweb_service/demoweb/module/file_access_validator.h"
 #include "demoweb_service/demoweb/module/file_io.h"
+#include "file_system/file_interface.h"
+#include "file_system/file_system_interface.h"
+#include "keygen/key_generator_interface.h"
+#include "postgres/query_runner/connection/connection_reservoir_interface.h"
+#include "proto_cc/file.pb.h"
+#include "proto_cc/identity.pb.h"
+
+namespace e8 {
+namespace {
+
+static char const kStagingFileSuffix[] = ".uploading.";
+
+FileTransferResult AppendChunks(FileInterface *file, ReadChunkFn const &read_chunk,
+                                uint64_t max_file_size) {
+    int32_t expected_chunk_number = 0;
+    uint64_t file_size = 0;
+    for (FileChunk const *chunk = read_chunk(); chunk != nullptr; chunk = read_chunk()) {
+        if (chunk->chunk_number() != expected_chunk_number) {
+            return FTR_CHUNK_OUT_OF_ORDER;
+        }
+        ++expected_chunk_number;
+
+        file_size += chunk->data().size();
+        if (file_size > max_file_size) {
+            return FTR_FILE_TOO_LARGE;
+        }
+
+        if (!file->Append(chunk->data().data(), chunk->data().size())) {
+            return FTR_IO_ERROR;
+        }
+    }
+
+    if (!file->Flush()) {
+        return FTR_IO_ERROR;
+    }
+    return FTR_OK;
+}
+
+} // namespace
+
+std::optional<std::string> ResolveFileAccess(Identity const &viewer,
+                                             FileDescriptor const &file_descriptor,
+                                             FileAccessMode access_mode,
+                                             KeyGeneratorInterface *key_gen,
+                                             ConnectionReservoirInterface *db_conns) {
+    switch (file_descriptor.AccessMethod_case()) {
+    case FileDescriptor::kFileTokenAccess: {
+        FileAccessToken const &access_token = file_descriptor.file_token_access().access_token();
+        std::optional<std::string> file_path;
+        if (access_mode == FAM_READ) {
+            // Read-only tokens are shared with every viewer, e.g. the avatar tokens in public
+            // profiles are signed for the profile owner.
+            file_path = ValidateSharedReadFileAccessToken(access_token, key_gen);
+        } else {
+            file_path =
+                ValidateFileAccessToken(viewer.user_id(), access_mode, access_token, key_gen);
+        }
+        if (!file_path.has_value() && access_mode != FAM_READWRITE) {
+            file_path =
+                ValidateFileAccessToken(viewer.user_id(), FAM_READWRITE, access_token, key_gen);
+        }
+        return file_path;
+    }
+    case FileDescriptor::kFileDirectAccess: {
+        std::string const &file_path = file_descriptor.file_direct_access().path();
+        if (!ValidateDirectFileAccess(viewer, file_path, access_mode, db_conns)) {
+            return std::nullopt;
+        }
+        return file_path;
+    }
+    default: {
+        return std::nullopt;
+    }
+    }
+}
+
+FileTransferResult ReceiveFile(std::string const &file_path, ReadChunkFn const &read_chunk,
+                               uint64_t max_file_size, FileSystemInterface *file_system) {
+    std::string staging_path =
+        file_path + kStagingFileSuffix + std::to_string(UniqueId(/*host_id=*/0));
+    if (!file_system->CreateFile(staging_path)) {
+        return FTR_IO_ERROR;
+    }
+
+    std::unique_ptr<FileInterface> staging_file = file_system->OpenFile(staging_path);
+    if (staging_file == nullptr) {
+        return FTR_IO_ERROR;
+    }
+
+    FileTransferResult result = AppendChunks(staging_file.get(), read_chunk, max_file_size);
+    staging_file.reset();
+
+    if (result == FTR_OK && !file_system->RenameFile(staging_path, file_path)) {
+        result = FTR_IO_ERROR;
+    }
+    if (result != FTR_OK) {
+        file_system->DeleteFile(staging_path);
+    }
+    return result;
+}
+
+FileTransferResult SendFile(std::string const &file_path, WriteChunkFn const &write_chunk,
+                            FileSystemInterface *file_system) {
+    std::unique_ptr<FileInterface> file = file_system->OpenFile(file_path);
+    if (file == nullptr) {
+        return FTR_FILE_NOT_FOUND;
+    }
+
+    std::optional<std::string_view> content = file->Content();
+    if (!content.has_value()) {
+        return FTR_IO_ERROR;
+    }
+
+    int32_t chunk_number = 0;
+    for (size_t offset = 0; offset < content->size(); offset += kFileTransferChunkSize) {
+        if (!write_chunk(chunk_number, content->substr(offset, kFileTransferChunkSize))) {
+            return FTR_STREAM_BROKEN;
+        }
+        ++chunk_number;
+    }
+    return FTR_OK;
+}
 
-namespace e8 {}
+} // namespace e8
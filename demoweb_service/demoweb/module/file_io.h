@@ -18,6 +18,98 @@
 #ifndef FILE_IO_H
 #define FILE_IO_H
 
-namespace e8 {}
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "file_system/file_system_interface.h"
+#include "keygen/key_generator_interface.h"
+#include "postgres/query_runner/connection/connection_reservoir_interface.h"
+#include "proto_cc/file.pb.h"
+#include "proto_cc/identity.pb.h"
+
+namespace e8 {
+
+// Size of the data chunks a file is streamed in. It has to stay well below the gRPC message size
+// limit.
+static unsigned const kFileTransferChunkSize = 1 << 20;
+
+// The largest file a single upload stream may write.
+static uint64_t const kMaxUploadFileSize = 64 << 20;
+
+/**
+ * @brief The FileTransferResult enum Outcome of a file transfer.
+ */
+enum FileTransferResult {
+    FTR_OK,
+    FTR_FILE_NOT_FOUND,
+    FTR_CHUNK_OUT_OF_ORDER,
+    FTR_STREAM_BROKEN,
+    FTR_FILE_TOO_LARGE,
+    FTR_IO_ERROR,
+};
+
+/**
+ * @brief ReadChunkFn Reads the next chunk of an incoming file stream. It returns nullptr when the
+ * stream ends. The returned chunk only needs to stay valid until the next call.
+ */
+using ReadChunkFn = std::function<FileChunk const *()>;
+
+/**
+ * @brief WriteChunkFn Writes a chunk of data to an outgoing file stream. It returns false if the
+ * stream can't be written anymore.
+ */
+using WriteChunkFn = std::function<bool(int32_t chunk_number, std::string_view data)>;
+
+/**
+ * @brief ResolveFileAccess Validates the viewer's access to the file referred to by the file
+ * descriptor, either through an access token or through the direct access of the viewer's user
+ * groups. An access token signed for FAM_READWRITE also grants FAM_READ and FAM_WRITE. FAM_READ
+ * tokens are accepted from any viewer, whereas the other tokens only from the viewer they were
+ * signed for.
+ *
+ * @param viewer Identity of the user who requests the access.
+ * @param file_descriptor Descriptor of the file to access.
+ * @param access_mode The access mode the viewer requests.
+ * @param key_gen Key generator that holds the token signature verification key.
+ * @param db_conns Connections to the DemoWeb database.
+ * @return Location of the file if the access is granted.
+ */
+std::optional<std::string> ResolveFileAccess(Identity const &viewer,
+                                             FileDescriptor const &file_descriptor,
+                                             FileAccessMode access_mode,
+                                             KeyGeneratorInterface *key_gen,
+                                             ConnectionReservoirInterface *db_conns);
+
+/**
+ * @brief ReceiveFile Writes the incoming chunks to the file at file_path. Chunks have to arrive in
+ * the order of their chunk numbers. The data is staged in a temporary file which only replaces
+ * file_path after the whole stream has been written, so that readers never see a partial file.
+ *
+ * @param file_path Location of the file to write.
+ * @param read_chunk Source of the incoming chunks.
+ * @param max_file_size The stream is rejected with FTR_FILE_TOO_LARGE as soon as it exceeds this
+ * many bytes.
+ * @param file_system Storage of the file.
+ * @return FTR_OK if the file has been replaced by the received content.
+ */
+FileTransferResult ReceiveFile(std::string const &file_path, ReadChunkFn const &read_chunk,
+                               uint64_t max_file_size, FileSystemInterface *file_system);
+
+/**
+ * @brief SendFile Streams the file at file_path in chunks of kFileTransferChunkSize. The chunks are
+ * views into the memory mapped file, so the content isn't copied before it's handed to the writer.
+ *
+ * @param file_path Location of the file to read.
+ * @param write_chunk Destination of the outgoing chunks.
+ * @param file_system Storage of the file.
+ * @return FTR_OK if the whole file has been written.
+ */
+FileTransferResult SendFile(std::string const &file_path, WriteChunkFn const &write_chunk,
+                            FileSystemInterface *file_system);
+
+} // namespace e8
 
 #endif // FILE_IO_H
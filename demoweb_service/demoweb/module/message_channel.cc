@@ -34,7 +34,7 @@
 #include "demoweb_service/demoweb/module/message_channel.h"
 #include "demoweb_service/demoweb/module/message_channel_storage.h"
 #include "demoweb_service/demoweb/module/user_profile.h"
-#include "demoweb_service/demoweb/module/user_storage.h"
+#include "demoweb_service/demoweb/module/user_profile_cache.h"
 #include "postgres/query_runner/connection/connection_reservoir_interface.h"
 #include "postgres/query_runner/sql_query_builder.h"
 #include "postgres/query_runner/sql_runner.h"
@@ -184,13 +184,16 @@ MessageChannelEntity CreateMessageChannel(UserId creator_id,
                                           std::vector<UserId> const &to_be_member_ids,
                                           bool const encrypted, bool const close_group_channel,
                                           HostId const host_id,
+                                          MessageChannelPbacInterface *pbac,
                                           ConnectionReservoirInterface *conns) {
     MessageChannelEntity message_channel = CreateMessageChannel(
         channel_name, description, encrypted, close_group_channel, host_id, conns);
 
     UpdateMessageChannelMembership(*message_channel.id.Value(), creator_id, MCMT_ADMIN, conns);
+    pbac->OnMembershipUpserted(*message_channel.id.Value(), creator_id, MCMT_ADMIN);
     for (UserId const user_id : to_be_member_ids) {
         UpdateMessageChannelMembership(*message_channel.id.Value(), user_id, MCMT_ADMIN, conns);
+        pbac->OnMembershipUpserted(*message_channel.id.Value(), user_id, MCMT_ADMIN);
     }
 
     return message_channel;
@@ -232,17 +235,26 @@ bool UpdateMessageChannelMembership(UserId const viewer_id, MessageChannelId con
         return false;
     }
 
-    // Apply the delta.
+    // Apply the delta and keep the access controller in sync with it.
     for (auto const &membership : delta.to_be_modified) {
         UpdateMessageChannelMembership(channel_id, membership.user_id(), membership.member_type(),
                                        conns);
+        pbac->OnMembershipUpserted(channel_id, membership.user_id(), membership.member_type());
     }
     for (auto const &membership : delta.to_be_added) {
-        all_successful &= CreateMessageChannelMembership(channel_id, membership.user_id(),
-                                                         membership.member_type(), conns);
+        bool created = CreateMessageChannelMembership(channel_id, membership.user_id(),
+                                                      membership.member_type(), conns);
+        if (created) {
+            pbac->OnMembershipUpserted(channel_id, membership.user_id(), membership.member_type());
+        }
+        all_successful &= created;
     }
     for (auto const &membership : delta.to_be_removed) {
-        all_successful &= DeleteMessageChannelMembership(channel_id, membership.user_id(), conns);
+        bool deleted = DeleteMessageChannelMembership(channel_id, membership.user_id(), conns);
+        if (deleted) {
+            pbac->OnMembershipRemoved(channel_id, membership.user_id());
+        }
+        all_successful &= deleted;
     }
 
     return all_successful;
@@ -366,7 +378,8 @@ std::vector<SearchedMessageChannel> SearchMessageChannels(
 std::vector<MessageChannelOverview>
 ToMessageChannelOverviews(UserId const viewer_id,
                           std::vector<SearchedMessageChannel> const &searched_message_channels,
-                          KeyGeneratorInterface *key_gen, ConnectionReservoirInterface *conns) {
+                          KeyGeneratorInterface *key_gen, UserPublicProfileCache *profile_cache,
+                          ConnectionReservoirInterface *conns) {
     // Construct member profiles.
     std::unordered_map<UserId, UserPublicProfile> active_member_profiles;
     std::vector<UserId> unique_active_member_ids;
@@ -381,9 +394,8 @@ ToMessageChannelOverviews(UserId const viewer_id,
         }
     }
 
-    std::vector<UserEntity> members = FetchUsers(unique_active_member_ids, conns);
     std::vector<UserPublicProfile> member_profiles =
-        BuildPublicProfiles(viewer_id, members, key_gen, conns);
+        FetchPublicProfiles(viewer_id, unique_active_member_ids, key_gen, profile_cache, conns);
     for (auto const &profile : member_profiles) {
         active_member_profiles[profile.user_id()] = profile;
     }
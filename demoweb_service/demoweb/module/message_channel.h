@@ -29,6 +29,7 @@
 #include "demoweb_service/demoweb/common_entity/message_channel_has_user_entity.h"
 #include "demoweb_service/demoweb/common_entity/user_entity.h"
 #include "demoweb_service/demoweb/environment/host_id.h"
+#include "demoweb_service/demoweb/module/user_profile_cache.h"
 #include "demoweb_service/demoweb/pbac/message_channel_pbac.h"
 #include "keygen/key_generator_interface.h"
 #include "postgres/query_runner/connection/connection_reservoir_interface.h"
@@ -41,7 +42,7 @@ namespace e8 {
  * @brief CreateMessageChannel Create a new message channel. A message channel allows communication
  * among users once they are members of. The communication can be encrypted as flagged by the
  * "encrypted" parameter. The argument close_group_channel specifies a more relaxed close group RBAC
- * policy for what the members can do.
+ * policy for what the members can do. The initial memberships are notified to the PBAC.
  */
 MessageChannelEntity CreateMessageChannel(UserId creator_id,
                                           std::optional<std::string> const &channel_name,
@@ -49,6 +50,7 @@ MessageChannelEntity CreateMessageChannel(UserId creator_id,
                                           std::vector<UserId> const &to_be_member_ids,
                                           bool const encrypted, bool const close_group_channel,
                                           HostId const host_id,
+                                          MessageChannelPbacInterface *pbac,
                                           ConnectionReservoirInterface *conns);
 
 /**
@@ -139,12 +141,14 @@ std::vector<SearchedMessageChannel> SearchMessageChannels(
 
 /**
  * @brief ToMessageChannelOverviews Converts message channel entities with user joining information
- * to message channel overview proto messages.
+ * to message channel overview proto messages. Member profiles are taken from the profile_cache when
+ * present.
  */
 std::vector<MessageChannelOverview>
 ToMessageChannelOverviews(UserId const viewer_id,
                           std::vector<SearchedMessageChannel> const &searched_message_channels,
-                          KeyGeneratorInterface *key_gen, ConnectionReservoirInterface *conns);
+                          KeyGeneratorInterface *key_gen, UserPublicProfileCache *profile_cache,
+                          ConnectionReservoirInterface *conns);
 
 struct MessageChannelMember {
     UserEntity member;
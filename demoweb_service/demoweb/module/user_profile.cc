@@ -32,6 +32,8 @@
 #include "demoweb_service/demoweb/module/file_util.h"
 #include "demoweb_service/demoweb/module/contact_storage.h"
 #include "demoweb_service/demoweb/module/user_profile.h"
+#include "demoweb_service/demoweb/module/user_profile_cache.h"
+#include "demoweb_service/demoweb/module/user_storage.h"
 #include "proto_cc/file.pb.h"
 #include "proto_cc/user_profile.pb.h"
 #include "proto_cc/user_relation.pb.h"
@@ -98,13 +100,54 @@ UserPublicProfile BuildPublicProfile(UserEntity const &user, UserRelations const
 
 } // namespace profile_internal
 
+namespace {
+
+UserPublicProfile ViewerIndependentProfile(UserEntity const &user, KeyGeneratorInterface *key_gen,
+                                           UserPublicProfileCache *profile_cache,
+                                           std::optional<uint64_t> cache_generation) {
+    if (profile_cache != nullptr) {
+        std::optional<UserPublicProfile> cached = profile_cache->Fetch(user.id.Value().value());
+        if (cached.has_value()) {
+            return *cached;
+        }
+    }
+
+    UserPublicProfile profile = profile_internal::BuildPublicProfile(user, UserRelations(), key_gen);
+    if (profile_cache != nullptr && cache_generation.has_value()) {
+        profile_cache->Put(profile, *cache_generation);
+    }
+
+    return profile;
+}
+
+void JoinUserRelations(UserId const viewer_id, std::vector<UserPublicProfile> *profiles,
+                       ConnectionReservoirInterface *db_conns) {
+    std::vector<UserId> target_user_ids;
+    for (auto const &profile : *profiles) {
+        target_user_ids.push_back(profile.user_id());
+    }
+
+    std::unordered_map<UserId, UserRelations> users_relations =
+        GetUsersRelations(viewer_id, target_user_ids, db_conns);
+
+    for (auto &profile : *profiles) {
+        UserRelations const &relations = users_relations[profile.user_id()];
+        *profile.mutable_relations() = {relations.begin(), relations.end()};
+    }
+}
+
+} // namespace
+
 bool UpdateProfile(std::optional<std::string> const &alias,
                    std::optional<std::string> const &biography, UserEntity *user,
-                   ConnectionReservoirInterface *db_conns) {
+                   UserPublicProfileCache *profile_cache, ConnectionReservoirInterface *db_conns) {
     *user->alias.ValuePtr() = alias;
     *user->biography.ValuePtr() = biography;
 
     int num_rows_updated = Update(*user, TableNames::AUser(), /*override=*/true, db_conns);
+    if (profile_cache != nullptr) {
+        profile_cache->Invalidate(user->id.Value().value());
+    }
     if (num_rows_updated == 0) {
         return false;
     }
@@ -117,36 +160,73 @@ bool UpdateProfile(std::optional<std::string> const &alias,
 std::vector<UserPublicProfile> BuildPublicProfiles(std::optional<UserId> viewer_id,
                                                    std::vector<UserEntity> const &users,
                                                    KeyGeneratorInterface *key_gen,
+                                                   UserPublicProfileCache *profile_cache,
                                                    ConnectionReservoirInterface *db_conns) {
-    std::vector<UserId> target_user_ids;
+    std::vector<UserPublicProfile> profiles;
     for (auto const &user : users) {
-        target_user_ids.push_back(user.id.Value().value());
+        // It's unknown when the caller loaded the users, so only read from the cache.
+        profiles.push_back(ViewerIndependentProfile(user, key_gen, profile_cache,
+                                                    /*cache_generation=*/std::nullopt));
     }
 
-    std::vector<UserPublicProfile> profiles;
-
     if (viewer_id.has_value()) {
-        std::unordered_map<UserId, UserRelations> users_relations =
-            GetUsersRelations(viewer_id.value(), target_user_ids, db_conns);
+        JoinUserRelations(viewer_id.value(), &profiles, db_conns);
+    }
+
+    return profiles;
+}
 
-        for (auto const &user : users) {
-            UserPublicProfile profile = profile_internal::BuildPublicProfile(
-                user, users_relations[user.id.Value().value()], key_gen);
-            profiles.push_back(profile);
+std::vector<UserPublicProfile> FetchPublicProfiles(std::optional<UserId> viewer_id,
+                                                   std::vector<UserId> const &user_ids,
+                                                   KeyGeneratorInterface *key_gen,
+                                                   UserPublicProfileCache *profile_cache,
+                                                   ConnectionReservoirInterface *db_conns) {
+    std::unordered_map<UserId, UserPublicProfile> found_profiles;
+    std::vector<UserId> missing_user_ids;
+    for (UserId const user_id : user_ids) {
+        std::optional<UserPublicProfile> cached;
+        if (profile_cache != nullptr) {
+            cached = profile_cache->Fetch(user_id);
         }
-    } else {
-        for (auto const &user : users) {
-            UserPublicProfile profile =
-                profile_internal::BuildPublicProfile(user, UserRelations(), key_gen);
-            profiles.push_back(profile);
+
+        if (cached.has_value()) {
+            found_profiles[user_id] = *cached;
+        } else {
+            missing_user_ids.push_back(user_id);
         }
     }
 
+    if (!missing_user_ids.empty()) {
+        std::optional<uint64_t> cache_generation;
+        if (profile_cache != nullptr) {
+            cache_generation = profile_cache->Generation();
+        }
+
+        std::vector<UserEntity> missing_users = FetchUsers(missing_user_ids, db_conns);
+        for (auto const &user : missing_users) {
+            found_profiles[user.id.Value().value()] =
+                ViewerIndependentProfile(user, key_gen, profile_cache, cache_generation);
+        }
+    }
+
+    std::vector<UserPublicProfile> profiles;
+    for (UserId const user_id : user_ids) {
+        auto it = found_profiles.find(user_id);
+        if (it != found_profiles.end()) {
+            profiles.push_back(it->second);
+        }
+    }
+
+    if (viewer_id.has_value()) {
+        JoinUserRelations(viewer_id.value(), &profiles, db_conns);
+    }
+
     return profiles;
 }
 
 AvatarSetup SetUpNewProfileAvatar(UserEntity const &user, FileFormat file_format,
                                   KeyGeneratorInterface *key_gen,
+                                  UserPublicProfileCache *profile_cache,
                                   ConnectionReservoirInterface *db_conns) {
     std::string location = profile_internal::AllocateNewAvatarLocation(
         user.id_str.Value().value(), file_format, user.avatar_path.Value());
@@ -160,6 +240,9 @@ AvatarSetup SetUpNewProfileAvatar(UserEntity const &user, FileFormat file_format
     *updated_user.avatar_path.ValuePtr() = location;
     uint64_t num_rows = Update(updated_user, TableNames::AUser(), /*replace=*/true, db_conns);
     assert(num_rows == 1);
+    if (profile_cache != nullptr) {
+        profile_cache->Invalidate(user.id.Value().value());
+    }
 
     // Sign an access token.
     FileAccessToken access_token = SignFileAccessToken(user.id.Value().value(), location,
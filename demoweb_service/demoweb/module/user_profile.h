@@ -24,6 +24,7 @@
 
 #include "demoweb_service/demoweb/common_entity/user_entity.h"
 #include "demoweb_service/demoweb/module/file_access_validator.h"
+#include "demoweb_service/demoweb/module/user_profile_cache.h"
 #include "proto_cc/file.pb.h"
 #include "proto_cc/user_profile.pb.h"
 #include "keygen/key_generator_interface.h"
@@ -39,13 +40,14 @@ namespace e8 {
  *
  * @param user Table entity of the user whose profile needs to be updated. The content of this
  * entity will be updated with the specified parameters after the function call.
+ * @param profile_cache Nullable. The user's cached profile will be invalidated.
  * @param db_conns Connections to the DemoWeb DB server.
  * @return If the user pointed to by the ID of the entity doesn't exist, it will return false.
  * Otherwise, it returns true.
  */
 bool UpdateProfile(std::optional<std::string> const &alias,
                    std::optional<std::string> const &biography, UserEntity *user,
-                   ConnectionReservoirInterface *db_conns);
+                   UserPublicProfileCache *profile_cache, ConnectionReservoirInterface *db_conns);
 
 /**
  * @brief BuildPublicProfiles Extract public profile info from raw database entities and generate
@@ -55,12 +57,29 @@ bool UpdateProfile(std::optional<std::string> const &alias,
  * provided, user relation will not be fetched.
  * @param users A list of user to extract public profile from.
  * @param key_gen Key generator for signing the avatar path.
+ * @param profile_cache Nullable. When present, the viewer independent part of the profiles are
+ * reused from the cache. Profiles built here aren't saved to the cache since the users may have
+ * been loaded before a concurrent update invalidated them.
  * @param db_conns Connections to the DemoWeb DB server.
  * @return The extracted public profile.
  */
 std::vector<UserPublicProfile> BuildPublicProfiles(std::optional<UserId> viewer_id,
                                                    std::vector<UserEntity> const &users,
                                                    KeyGeneratorInterface *key_gen,
+                                                   UserPublicProfileCache *profile_cache,
+                                                   ConnectionReservoirInterface *db_conns);
+
+/**
+ * @brief FetchPublicProfiles Similar to the above function, but it takes user IDs instead. Only
+ * users whose profile is missing from the cache are fetched from the database, and their profiles
+ * are saved to the cache.
+ *
+ * @return Public profiles in the order of the user_ids. Users that don't exist are skipped.
+ */
+std::vector<UserPublicProfile> FetchPublicProfiles(std::optional<UserId> viewer_id,
+                                                   std::vector<UserId> const &user_ids,
+                                                   KeyGeneratorInterface *key_gen,
+                                                   UserPublicProfileCache *profile_cache,
                                                    ConnectionReservoirInterface *db_conns);
 
 /**
@@ -79,11 +98,13 @@ struct AvatarSetup {
  * @param user User to set avatar for.
  * @param file_format The format of the new avatar file.
  * @param key_gen Key generator for signing a new avatar path.
+ * @param profile_cache Nullable. The user's cached profile will be invalidated.
  * @param db_conns Connections to the DemoWeb DB server.
  * @return See the above.
  */
 AvatarSetup SetUpNewProfileAvatar(UserEntity const &user, FileFormat file_format,
                                   KeyGeneratorInterface *key_gen,
+                                  UserPublicProfileCache *profile_cache,
                                   ConnectionReservoirInterface *db_conns);
 
 /**
@@ -0,0 +1,109 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "demoweb_service/demoweb/common_entity/user_entity.h"
+#include "demoweb_service/demoweb/module/user_profile_cache.h"
+#include "proto_cc/user_profile.pb.h"
+
+namespace e8 {
+
+UserPublicProfileCache::UserPublicProfileCache(unsigned capacity, std::chrono::seconds ttl)
+    : capacity_(capacity), ttl_(ttl) {
+    assert(capacity_ > 0);
+}
+
+UserPublicProfileCache::~UserPublicProfileCache() {}
+
+std::optional<UserPublicProfile> UserPublicProfileCache::Fetch(UserId const user_id) {
+    std::string serialized_profile;
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        auto it = profiles_.find(user_id);
+        if (it == profiles_.end()) {
+            return std::nullopt;
+        }
+
+        if (std::chrono::steady_clock::now() - it->second.cached_at >= ttl_) {
+            profiles_.erase(it);
+            return std::nullopt;
+        }
+
+        serialized_profile = it->second.serialized_profile;
+    }
+
+    UserPublicProfile profile;
+    bool parse_status = profile.ParseFromString(serialized_profile);
+    assert(parse_status == true);
+
+    return profile;
+}
+
+uint64_t UserPublicProfileCache::Generation() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return generation_;
+}
+
+void UserPublicProfileCache::Put(UserPublicProfile const &profile, uint64_t generation) {
+    UserPublicProfile viewer_independent_profile = profile;
+    viewer_independent_profile.clear_relations();
+
+    CachedProfile cached;
+    bool serialize_status =
+        viewer_independent_profile.SerializeToString(&cached.serialized_profile);
+    assert(serialize_status == true);
+    cached.cached_at = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (generation != generation_) {
+        // The user may have been updated after the profile was loaded, so don't cache.
+        return;
+    }
+
+    if (profiles_.size() >= capacity_ && profiles_.find(profile.user_id()) == profiles_.end()) {
+        // Evicts the profile cached the longest time ago, which is the closest to expiring.
+        auto oldest = std::min_element(profiles_.begin(), profiles_.end(),
+                                       [](auto const &a, auto const &b) {
+                                           return a.second.cached_at < b.second.cached_at;
+                                       });
+        profiles_.erase(oldest);
+    }
+    profiles_[profile.user_id()] = cached;
+}
+
+void UserPublicProfileCache::Invalidate(UserId const user_id) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    ++generation_;
+    profiles_.erase(user_id);
+}
+
+void UserPublicProfileCache::Clear() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    ++generation_;
+    profiles_.clear();
+}
+
+} // namespace e8
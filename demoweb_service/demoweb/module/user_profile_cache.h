@@ -0,0 +1,106 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USER_PROFILE_CACHE_H
+#define USER_PROFILE_CACHE_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "demoweb_service/demoweb/common_entity/user_entity.h"
+#include "proto_cc/user_profile.pb.h"
+
+namespace e8 {
+
+static unsigned const kUserPublicProfileCacheCapacity = 100000;
+
+// Cached profiles carry signed avatar access tokens. They must be dropped well before the tokens
+// expire.
+static std::chrono::seconds const kUserPublicProfileCacheTtl = std::chrono::minutes(5);
+
+/**
+ * @brief The UserPublicProfileCache class A bounded process-level cache of user public profiles
+ * keyed by user ID. It only stores the part of the profile which doesn't depend on the viewer, i.e.
+ * everything but the user relations. Profiles are kept serialized. This cache guarantees thread
+ * safety.
+ */
+class UserPublicProfileCache {
+  public:
+    /**
+     * @brief UserPublicProfileCache Constructs an empty cache.
+     *
+     * @param capacity The maximum number of profiles to keep in the cache.
+     * @param ttl How long a profile stays valid since it was cached.
+     */
+    UserPublicProfileCache(unsigned capacity, std::chrono::seconds ttl);
+    UserPublicProfileCache(UserPublicProfileCache const &) = delete;
+    ~UserPublicProfileCache();
+
+    /**
+     * @brief Fetch Returns the viewer independent profile of the specified user if it's cached and
+     * hasn't expired.
+     */
+    std::optional<UserPublicProfile> Fetch(UserId const user_id);
+
+    /**
+     * @brief Generation Returns the current generation of the cache. It has to be read before the
+     * profile to Put() is loaded from the database.
+     */
+    uint64_t Generation();
+
+    /**
+     * @brief Put Caches the specified profile. The user relations, if any, are stripped.
+     *
+     * @param generation The Generation() read before the profile was loaded. The profile isn't
+     * cached if an invalidation landed since then, as it may predate the change.
+     */
+    void Put(UserPublicProfile const &profile, uint64_t generation);
+
+    /**
+     * @brief Invalidate Drops the cached profile of the specified user. It has to be called
+     * whenever the user's public profile is changed.
+     */
+    void Invalidate(UserId const user_id);
+
+    /**
+     * @brief Clear Drops all the cached profiles.
+     */
+    void Clear();
+
+  private:
+    struct CachedProfile {
+        std::string serialized_profile;
+        std::chrono::steady_clock::time_point cached_at;
+    };
+
+    std::unordered_map<UserId, CachedProfile> profiles_;
+    std::mutex mutex_;
+
+    // Bumped by every invalidation so that Put() won't cache a profile which raced with an update.
+    uint64_t generation_ = 0;
+
+    unsigned capacity_;
+    std::chrono::seconds ttl_;
+};
+
+} // namespace e8
+
+#endif // USER_PROFILE_CACHE_H
@@ -0,0 +1,181 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#include "demoweb_service/demoweb/common_entity/message_channel_entity.h"
+#include "demoweb_service/demoweb/common_entity/user_entity.h"
+#include "demoweb_service/demoweb/pbac/message_channel_attributes.h"
+#include "demoweb_service/demoweb/pbac/message_channel_member_attributes.h"
+#include "demoweb_service/demoweb/pbac/message_channel_membership_cache.h"
+#include "postgres/query_runner/connection/connection_reservoir_interface.h"
+#include "proto_cc/message_channel.pb.h"
+
+namespace e8 {
+
+std::optional<MessageChannelMemberAttributes>
+MessageChannelAccessSnapshot::Member(UserId const user_id) const {
+    auto it = members.find(user_id);
+    if (it == members.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+std::shared_ptr<MessageChannelAccessSnapshot const>
+LoadMessageChannelAccessSnapshot(MessageChannelId const channel_id,
+                                 ConnectionReservoirInterface *conns) {
+    std::optional<MessageChannelAttributes> channel_attrs =
+        ExtractMessageChannelAttributes(channel_id, conns);
+    if (!channel_attrs.has_value()) {
+        return nullptr;
+    }
+
+    auto snapshot = std::make_shared<MessageChannelAccessSnapshot>();
+    snapshot->close_group_channel = *channel_attrs->close_group_channel.Value();
+    snapshot->members = ExtractMessageChannelMemberAttributes(channel_id, conns);
+    snapshot->num_admins = 0;
+    for (auto const &[_, member] : snapshot->members) {
+        snapshot->num_admins += member.member_type == MCMT_ADMIN;
+    }
+    snapshot->loaded_at = std::chrono::steady_clock::now();
+
+    return snapshot;
+}
+
+MessageChannelMembershipCache::MessageChannelMembershipCache(unsigned max_num_channels,
+                                                             std::chrono::seconds ttl,
+                                                             ConnectionReservoirInterface *conns)
+    : max_num_channels_(max_num_channels), ttl_(ttl), conns_(conns) {
+    assert(max_num_channels_ > 0);
+}
+
+MessageChannelMembershipCache::~MessageChannelMembershipCache() {}
+
+std::shared_ptr<MessageChannelAccessSnapshot const>
+MessageChannelMembershipCache::Fetch(MessageChannelId const channel_id) {
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        auto it = snapshots_.find(channel_id);
+        if (it != snapshots_.end() &&
+            std::chrono::steady_clock::now() - it->second->loaded_at < ttl_) {
+            // Cache hit.
+            return it->second;
+        }
+
+        generation = generation_;
+    }
+
+    // Query the database without holding the lock.
+    std::shared_ptr<MessageChannelAccessSnapshot const> snapshot =
+        LoadMessageChannelAccessSnapshot(channel_id, conns_);
+    if (snapshot == nullptr) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (generation != generation_) {
+        // A write landed while the snapshot was being loaded. It's unclear whether the snapshot
+        // has captured it, so don't cache.
+        return snapshot;
+    }
+
+    if (snapshots_.size() >= max_num_channels_ &&
+        snapshots_.find(channel_id) == snapshots_.end()) {
+        // Evicts the snapshot loaded the longest time ago, which is the closest to expiring.
+        auto oldest = std::min_element(snapshots_.begin(), snapshots_.end(),
+                                       [](auto const &a, auto const &b) {
+                                           return a.second->loaded_at < b.second->loaded_at;
+                                       });
+        snapshots_.erase(oldest);
+    }
+    snapshots_[channel_id] = snapshot;
+
+    return snapshot;
+}
+
+void MessageChannelMembershipCache::OnMembershipUpserted(
+    MessageChannelId const channel_id, UserId const user_id,
+    MessageChannelMemberType const member_type) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    ++generation_;
+
+    auto it = snapshots_.find(channel_id);
+    if (it == snapshots_.end()) {
+        return;
+    }
+
+    // Snapshots are shared with readers, so copy on write.
+    auto updated = std::make_shared<MessageChannelAccessSnapshot>(*it->second);
+
+    auto member_it = updated->members.find(user_id);
+    if (member_it != updated->members.end()) {
+        updated->num_admins -= member_it->second.member_type == MCMT_ADMIN;
+    }
+
+    MessageChannelMemberAttributes attrs;
+    attrs.member_type = member_type;
+    updated->members[user_id] = attrs;
+    updated->num_admins += member_type == MCMT_ADMIN;
+
+    it->second = updated;
+}
+
+void MessageChannelMembershipCache::OnMembershipRemoved(MessageChannelId const channel_id,
+                                                        UserId const user_id) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    ++generation_;
+
+    auto it = snapshots_.find(channel_id);
+    if (it == snapshots_.end()) {
+        return;
+    }
+
+    auto member_it = it->second->members.find(user_id);
+    if (member_it == it->second->members.end()) {
+        return;
+    }
+
+    auto updated = std::make_shared<MessageChannelAccessSnapshot>(*it->second);
+    updated->num_admins -= member_it->second.member_type == MCMT_ADMIN;
+    updated->members.erase(user_id);
+
+    it->second = updated;
+}
+
+void MessageChannelMembershipCache::Invalidate(MessageChannelId const channel_id) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    ++generation_;
+    snapshots_.erase(channel_id);
+}
+
+void MessageChannelMembershipCache::Clear() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    ++generation_;
+    snapshots_.clear();
+}
+
+} // namespace e8
@@ -0,0 +1,142 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MESSAGE_CHANNEL_MEMBERSHIP_CACHE_H
+#define MESSAGE_CHANNEL_MEMBERSHIP_CACHE_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#include "demoweb_service/demoweb/common_entity/message_channel_entity.h"
+#include "demoweb_service/demoweb/common_entity/user_entity.h"
+#include "demoweb_service/demoweb/pbac/message_channel_member_attributes.h"
+#include "postgres/query_runner/connection/connection_reservoir_interface.h"
+#include "proto_cc/message_channel.pb.h"
+
+namespace e8 {
+
+static unsigned const kMessageChannelMembershipCacheCapacity = 10000;
+// Bounds how long another host keeps granting access through a revoked membership.
+static std::chrono::seconds const kMessageChannelMembershipCacheTtl = std::chrono::seconds(5);
+
+/**
+ * @brief The MessageChannelAccessSnapshot struct Everything the message channel PBAC needs to know
+ * about a message channel, captured at one point in time.
+ */
+struct MessageChannelAccessSnapshot {
+    /**
+     * @brief Member Look up the attributes of the specified channel member.
+     *
+     * @return nullopt if the user isn't a member of the channel.
+     */
+    std::optional<MessageChannelMemberAttributes> Member(UserId const user_id) const;
+
+    // Whether the channel runs on the relaxed close group policy.
+    bool close_group_channel;
+
+    // Number of members whose member type is MCMT_ADMIN.
+    unsigned num_admins;
+
+    // All members of the channel.
+    std::unordered_map<UserId, MessageChannelMemberAttributes> members;
+
+    // When the snapshot was loaded from the database.
+    std::chrono::steady_clock::time_point loaded_at;
+};
+
+/**
+ * @brief LoadMessageChannelAccessSnapshot Load the access control snapshot of the specified message
+ * channel from the database.
+ *
+ * @return nullptr if the channel doesn't exist.
+ */
+std::shared_ptr<MessageChannelAccessSnapshot const>
+LoadMessageChannelAccessSnapshot(MessageChannelId const channel_id,
+                                 ConnectionReservoirInterface *conns);
+
+/**
+ * @brief The MessageChannelMembershipCache class A bounded in-memory cache of message channel
+ * access snapshots so that permission checks don't need to go to the database. Snapshots are kept
+ * up-to-date by the membership write paths through the On*() functions, which only reach the cache
+ * of the writing host. Since other hosts may write to the same channels, a snapshot is reloaded
+ * once it becomes older than the time-to-live, so the TTL should be kept short.
+ * This cache guarantees thread safety.
+ */
+class MessageChannelMembershipCache {
+  public:
+    /**
+     * @brief MessageChannelMembershipCache Constructs an empty cache.
+     *
+     * @param max_num_channels The maximum number of channel snapshots to keep in the cache.
+     * @param ttl How long a snapshot stays valid since it was loaded.
+     * @param conns Database connections to load snapshots from.
+     */
+    MessageChannelMembershipCache(unsigned max_num_channels, std::chrono::seconds ttl,
+                                  ConnectionReservoirInterface *conns);
+    MessageChannelMembershipCache(MessageChannelMembershipCache const &) = delete;
+    ~MessageChannelMembershipCache();
+
+    /**
+     * @brief Fetch Returns the access snapshot of the specified channel. It loads the snapshot from
+     * the database if it isn't present or has expired.
+     *
+     * @return nullptr if the channel doesn't exist.
+     */
+    std::shared_ptr<MessageChannelAccessSnapshot const> Fetch(MessageChannelId const channel_id);
+
+    /**
+     * @brief OnMembershipUpserted Reflects a newly created or updated membership to the cache.
+     */
+    void OnMembershipUpserted(MessageChannelId const channel_id, UserId const user_id,
+                              MessageChannelMemberType const member_type);
+
+    /**
+     * @brief OnMembershipRemoved Reflects a membership removal to the cache.
+     */
+    void OnMembershipRemoved(MessageChannelId const channel_id, UserId const user_id);
+
+    /**
+     * @brief Invalidate Drops the snapshot of the specified channel so that the next Fetch()
+     * reloads from the database.
+     */
+    void Invalidate(MessageChannelId const channel_id);
+
+    /**
+     * @brief Clear Drops all the cached snapshots.
+     */
+    void Clear();
+
+  private:
+    std::unordered_map<MessageChannelId, std::shared_ptr<MessageChannelAccessSnapshot const>>
+        snapshots_;
+    std::mutex mutex_;
+
+    // Bumped by every write so that Fetch() won't cache a snapshot which raced with a write.
+    uint64_t generation_ = 0;
+
+    unsigned max_num_channels_;
+    std::chrono::seconds ttl_;
+    ConnectionReservoirInterface *conns_;
+};
+
+} // namespace e8
+
+#endif // MESSAGE_CHANNEL_MEMBERSHIP_CACHE_H
@@ -15,6 +15,7 @@
  * not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <memory>
 #include <optional>
 #include <unordered_map>
 
@@ -22,47 +23,60 @@
 #include "demoweb_service/demoweb/common_entity/user_entity.h"
 #include "demoweb_service/demoweb/pbac/message_channel_attributes.h"
 #include "demoweb_service/demoweb/pbac/message_channel_member_attributes.h"
+#include "demoweb_service/demoweb/pbac/message_channel_membership_cache.h"
 #include "demoweb_service/demoweb/pbac/message_channel_pbac.h"
 #include "postgres/query_runner/connection/connection_reservoir_interface.h"
 #include "proto_cc/message_channel.pb.h"
 
 namespace e8 {
-namespace {
-
-unsigned AdminCount(std::unordered_map<UserId, MessageChannelMemberAttributes> const &members) {
-    unsigned num_admins = 0;
-    for (auto const &[_, member] : members) {
-        num_admins += member.member_type == MCMT_ADMIN;
-    }
-    return num_admins;
-}
-
-} // namespace
 
 MessageChannelPbacInterface::MessageChannelPbacInterface() {}
 
 MessageChannelPbacInterface::~MessageChannelPbacInterface() {}
 
-MessageChannelPbacImpl::MessageChannelPbacImpl(ConnectionReservoirInterface *conns)
-    : conns_(conns) {}
+MessageChannelPbacImpl::MessageChannelPbacImpl(ConnectionReservoirInterface *conns,
+                                               MessageChannelMembershipCache *cache)
+    : conns_(conns), cache_(cache) {}
 
 MessageChannelPbacImpl::~MessageChannelPbacImpl() {}
 
+std::shared_ptr<MessageChannelAccessSnapshot const>
+MessageChannelPbacImpl::ChannelSnapshot(MessageChannelId const channel_id) {
+    if (cache_ != nullptr) {
+        return cache_->Fetch(channel_id);
+    }
+    return LoadMessageChannelAccessSnapshot(channel_id, conns_);
+}
+
+std::optional<MessageChannelMemberAttributes>
+MessageChannelPbacImpl::MemberAttributes(MessageChannelId const channel_id, UserId const user_id) {
+    if (cache_ == nullptr) {
+        // Only a single row is needed, there is no point loading the whole channel.
+        return ExtractMessageChannelMemberAttributes(channel_id, user_id, conns_);
+    }
+
+    std::shared_ptr<MessageChannelAccessSnapshot const> snapshot = cache_->Fetch(channel_id);
+    if (snapshot == nullptr) {
+        return std::nullopt;
+    }
+    return snapshot->Member(user_id);
+}
+
 bool MessageChannelPbacImpl::AllowUpdateChannelMetadata(UserId const operator_user_id,
                                                         MessageChannelId const target_channel_id) {
-    std::optional<MessageChannelAttributes> channel_attrs =
-        ExtractMessageChannelAttributes(target_channel_id, conns_);
-    if (!channel_attrs.has_value()) {
+    std::shared_ptr<MessageChannelAccessSnapshot const> channel =
+        this->ChannelSnapshot(target_channel_id);
+    if (channel == nullptr) {
         return false;
     }
 
     std::optional<MessageChannelMemberAttributes> operator_attrs =
-        ExtractMessageChannelMemberAttributes(target_channel_id, operator_user_id, conns_);
+        channel->Member(operator_user_id);
     if (!operator_attrs.has_value()) {
         return false;
     }
 
-    if (*channel_attrs->close_group_channel.Value()) {
+    if (channel->close_group_channel) {
         return true;
     }
 
@@ -72,7 +86,7 @@ bool MessageChannelPbacImpl::AllowUpdateChannelMetadata(UserId const operator_us
 bool MessageChannelPbacImpl::AllowDeleteChannel(UserId const operator_user_id,
                                                 MessageChannelId const target_channel_id) {
     std::optional<MessageChannelMemberAttributes> operator_attrs =
-        ExtractMessageChannelMemberAttributes(target_channel_id, operator_user_id, conns_);
+        this->MemberAttributes(target_channel_id, operator_user_id);
     if (!operator_attrs.has_value()) {
         return false;
     }
@@ -84,16 +98,15 @@ bool MessageChannelPbacImpl::AllowUpdateChannelMembership(UserId const operator_
                                                           MessageChannelId const target_channel_id,
                                                           UserId const user_to_be_updated,
                                                           MessageChannelMemberType member_type) {
-    std::optional<MessageChannelAttributes> channel_attrs =
-        ExtractMessageChannelAttributes(target_channel_id, conns_);
-    if (!channel_attrs.has_value()) {
+    std::shared_ptr<MessageChannelAccessSnapshot const> channel =
+        this->ChannelSnapshot(target_channel_id);
+    if (channel == nullptr) {
         return false;
     }
 
-    std::unordered_map<UserId, MessageChannelMemberAttributes> member_attrs =
-        ExtractMessageChannelMemberAttributes(target_channel_id, conns_);
-    auto operator_attr_it = member_attrs.find(operator_user_id);
-    if (operator_attr_it == member_attrs.end()) {
+    std::optional<MessageChannelMemberAttributes> operator_attrs =
+        channel->Member(operator_user_id);
+    if (!operator_attrs.has_value()) {
         // Operator must as least be a member.
         return false;
     }
@@ -101,20 +114,20 @@ bool MessageChannelPbacImpl::AllowUpdateChannelMembership(UserId const operator_
     switch (member_type) {
     case MCMT_ADMIN: {
         // Adding a new admin or promotion.
-        return operator_attr_it->second.member_type == MCMT_ADMIN;
+        return operator_attrs->member_type == MCMT_ADMIN;
     }
 
     case MCMT_MEMBER: {
-        auto to_be_updatec_attr_it = member_attrs.find(user_to_be_updated);
+        std::optional<MessageChannelMemberAttributes> to_be_updated_attrs =
+            channel->Member(user_to_be_updated);
 
-        if (to_be_updatec_attr_it != member_attrs.end()) {
+        if (to_be_updated_attrs.has_value()) {
             // Demotion.
-            if (operator_attr_it->second.member_type != MCMT_ADMIN) {
+            if (operator_attrs->member_type != MCMT_ADMIN) {
                 return false;
             }
 
-            if (to_be_updatec_attr_it->second.member_type == MCMT_ADMIN &&
-                AdminCount(member_attrs) == 1) {
+            if (to_be_updated_attrs->member_type == MCMT_ADMIN && channel->num_admins == 1) {
                 // Can't demote the last admin in the message channel.
                 return false;
             }
@@ -122,8 +135,7 @@ bool MessageChannelPbacImpl::AllowUpdateChannelMembership(UserId const operator_
             return true;
         }
 
-        return *channel_attrs->close_group_channel.Value() ||
-               operator_attr_it->second.member_type == MCMT_ADMIN;
+        return channel->close_group_channel || operator_attrs->member_type == MCMT_ADMIN;
     }
 
     case MCMT_INVALID:
@@ -135,31 +147,35 @@ bool MessageChannelPbacImpl::AllowUpdateChannelMembership(UserId const operator_
 bool MessageChannelPbacImpl::AllowDeleteMemberFromChannel(UserId const operator_user_id,
                                                           MessageChannelId const target_channel_id,
                                                           UserId const user_to_be_removed) {
-    std::unordered_map<UserId, MessageChannelMemberAttributes> member_attrs =
-        ExtractMessageChannelMemberAttributes(target_channel_id, conns_);
-    auto operator_attr_it = member_attrs.find(operator_user_id);
-    if (operator_attr_it == member_attrs.end()) {
+    std::shared_ptr<MessageChannelAccessSnapshot const> channel =
+        this->ChannelSnapshot(target_channel_id);
+    if (channel == nullptr) {
+        return false;
+    }
+
+    std::optional<MessageChannelMemberAttributes> operator_attrs =
+        channel->Member(operator_user_id);
+    if (!operator_attrs.has_value()) {
         return false;
     }
 
-    auto to_be_removed_attr_it = member_attrs.find(user_to_be_removed);
-    if (to_be_removed_attr_it == member_attrs.end()) {
+    std::optional<MessageChannelMemberAttributes> to_be_removed_attrs =
+        channel->Member(user_to_be_removed);
+    if (!to_be_removed_attrs.has_value()) {
         return false;
     }
 
-    if (to_be_removed_attr_it->second.member_type == MCMT_ADMIN && AdminCount(member_attrs) == 1) {
+    if (to_be_removed_attrs->member_type == MCMT_ADMIN && channel->num_admins == 1) {
         // Can't remove the only admin.
         return false;
     }
 
-    return operator_user_id == user_to_be_removed ||
-           operator_attr_it->second.member_type == MCMT_ADMIN;
+    return operator_user_id == user_to_be_removed || operator_attrs->member_type == MCMT_ADMIN;
 }
 
 bool MessageChannelPbacImpl::AllowCreateChatMessageGroup(UserId const operator_user_id,
                                                          MessageChannelId const target_channel_id) {
-    return ExtractMessageChannelMemberAttributes(target_channel_id, operator_user_id, conns_)
-        .has_value();
+    return this->MemberAttributes(target_channel_id, operator_user_id).has_value();
 }
 
 bool MessageChannelPbacImpl::AllowReadChatMessageGroup(UserId const operator_user_id,
@@ -172,4 +188,19 @@ bool MessageChannelPbacImpl::AllowSendChatMessage(UserId const operator_user_id,
     return this->AllowCreateChatMessageGroup(operator_user_id, target_channel_id);
 }
 
+void MessageChannelPbacImpl::OnMembershipUpserted(MessageChannelId const channel_id,
+                                                  UserId const user_id,
+                                                  MessageChannelMemberType const member_type) {
+    if (cache_ != nullptr) {
+        cache_->OnMembershipUpserted(channel_id, user_id, member_type);
+    }
+}
+
+void MessageChannelPbacImpl::OnMembershipRemoved(MessageChannelId const channel_id,
+                                                 UserId const user_id) {
+    if (cache_ != nullptr) {
+        cache_->OnMembershipRemoved(channel_id, user_id);
+    }
+}
+
 } // namespace e8
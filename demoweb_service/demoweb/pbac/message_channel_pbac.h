@@ -1,8 +1,13 @@
 #ifndef MESSAGECHANNELPBAC_H
 #define MESSAGECHANNELPBAC_H
 
+#include <memory>
+#include <optional>
+
 #include "demoweb_service/demoweb/common_entity/message_channel_entity.h"
 #include "demoweb_service/demoweb/common_entity/user_entity.h"
+#include "demoweb_service/demoweb/pbac/message_channel_member_attributes.h"
+#include "demoweb_service/demoweb/pbac/message_channel_membership_cache.h"
 #include "postgres/query_runner/connection/connection_reservoir_interface.h"
 #include "proto_cc/message_channel.pb.h"
 
@@ -103,6 +108,19 @@ class MessageChannelPbacInterface {
      */
     virtual bool AllowSendChatMessage(UserId const operator_user_id,
                                       MessageChannelId const target_channel_id) = 0;
+
+    /**
+     * @brief OnMembershipUpserted Notifies the access controller that a membership has been
+     * created or updated in the database, so that it can refresh whatever it has memorized.
+     */
+    virtual void OnMembershipUpserted(MessageChannelId const channel_id, UserId const user_id,
+                                      MessageChannelMemberType const member_type) = 0;
+
+    /**
+     * @brief OnMembershipRemoved Notifies the access controller that a membership has been removed
+     * from the database.
+     */
+    virtual void OnMembershipRemoved(MessageChannelId const channel_id, UserId const user_id) = 0;
 };
 
 /**
@@ -110,7 +128,16 @@ class MessageChannelPbacInterface {
  */
 class MessageChannelPbacImpl : public MessageChannelPbacInterface {
   public:
-    MessageChannelPbacImpl(ConnectionReservoirInterface *conns);
+    /**
+     * @brief MessageChannelPbacImpl Constructs an access controller which extracts attributes from
+     * the database connections.
+     *
+     * @param cache When present, attributes are served from the membership cache instead of
+     * querying the database on every check. The caller must make sure all membership writes are
+     * notified through the On*() functions.
+     */
+    MessageChannelPbacImpl(ConnectionReservoirInterface *conns,
+                           MessageChannelMembershipCache *cache = nullptr);
     ~MessageChannelPbacImpl() override;
 
     bool AllowUpdateChannelMetadata(UserId const operator_user_id,
@@ -137,8 +164,20 @@ class MessageChannelPbacImpl : public MessageChannelPbacInterface {
     bool AllowSendChatMessage(UserId const operator_user_id,
                               MessageChannelId const target_channel_id) override;
 
+    void OnMembershipUpserted(MessageChannelId const channel_id, UserId const user_id,
+                              MessageChannelMemberType const member_type) override;
+
+    void OnMembershipRemoved(MessageChannelId const channel_id, UserId const user_id) override;
+
   private:
+    std::shared_ptr<MessageChannelAccessSnapshot const>
+    ChannelSnapshot(MessageChannelId const channel_id);
+
+    std::optional<MessageChannelMemberAttributes>
+    MemberAttributes(MessageChannelId const channel_id, UserId const user_id);
+
     ConnectionReservoirInterface *conns_;
+    MessageChannelMembershipCache *cache_;
 };
 
 } // namespace e8
@@ -68,7 +68,8 @@ grpc::Status ChatMessageServiceImpl::SendChatMessage(grpc::ServerContext *contex
         std::vector<std::string>(request->texts().begin(), request->texts().end()),
         IntsToEnums<FileFormat>(request->media_file_formats()),
         IntsToEnums<FileFormat>(request->binary_file_formats()),
-        DemoWebEnvironment()->MessageChannelPbac(), DemoWebEnvironment()->KeyGen(),
+        DemoWebEnvironment()->CurrentHostId(), DemoWebEnvironment()->MessageChannelPbac(),
+        DemoWebEnvironment()->KeyGen(), DemoWebEnvironment()->UserProfileCache(),
         DemoWebEnvironment()->DemowebDatabase());
     if (!result.has_value()) {
         return grpc::Status(grpc::StatusCode::PERMISSION_DENIED,
@@ -97,7 +98,7 @@ grpc::Status ChatMessageServiceImpl::GetChatMessages(grpc::ServerContext *contex
     std::vector<ChatMessageEntry> result = e8::GetChatMessages(
         identity->user_id(), request->thread_id(), request->pagination(),
         DemoWebEnvironment()->MessageChannelPbac(), DemoWebEnvironment()->KeyGen(),
-        DemoWebEnvironment()->DemowebDatabase());
+        DemoWebEnvironment()->UserProfileCache(), DemoWebEnvironment()->DemowebDatabase());
 
     *response->mutable_messages() = {result.begin(), result.end()};
 
@@ -117,7 +118,8 @@ ChatMessageServiceImpl::GetChatMessageThreads(grpc::ServerContext *context,
     std::vector<ChatMessageThread> result = GetChatMessageGroupsWithChatMessageSummaryList(
         identity->user_id(), request->channel_id(), request->limit_per_thread(),
         request->pagination(), DemoWebEnvironment()->MessageChannelPbac(),
-        DemoWebEnvironment()->KeyGen(), DemoWebEnvironment()->DemowebDatabase());
+        DemoWebEnvironment()->KeyGen(), DemoWebEnvironment()->UserProfileCache(),
+        DemoWebEnvironment()->DemowebDatabase());
 
     *response->mutable_threads() = {result.begin(), result.end()};
 
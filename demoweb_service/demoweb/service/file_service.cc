@@ -15,20 +15,112 @@
  * not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <cstdint>
 #include <grpcpp/grpcpp.h>
+#include <optional>
+#include <string>
+#include <string_view>
 
+#include "demoweb_service/demoweb/environment/environment_context_interface.h"
+#include "demoweb_service/demoweb/module/file_io.h"
+#include "demoweb_service/demoweb/service/file_service.h"
+#include "demoweb_service/demoweb/service/service_util.h"
+#include "proto_cc/file.pb.h"
+#include "proto_cc/identity.pb.h"
 #include "proto_cc/service_file.grpc.pb.h"
 #include "proto_cc/service_file.pb.h"
-#include "demoweb_service/demoweb/service/file_service.h"
 
 namespace e8 {
+namespace {
+
+grpc::Status ToStatus(FileTransferResult result) {
+    switch (result) {
+    case FTR_OK:
+        return grpc::Status::OK;
+    case FTR_FILE_NOT_FOUND:
+        return grpc::Status(grpc::StatusCode::NOT_FOUND, "File doesn't exist.");
+    case FTR_CHUNK_OUT_OF_ORDER:
+        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Chunks are out of order.");
+    case FTR_STREAM_BROKEN:
+        return grpc::Status(grpc::StatusCode::CANCELLED, "Stream was closed.");
+    case FTR_FILE_TOO_LARGE:
+        return grpc::Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "File is too large.");
+    case FTR_IO_ERROR:
+        return grpc::Status(grpc::StatusCode::INTERNAL, "Failed to access the file.");
+    }
+    return grpc::Status(grpc::StatusCode::UNKNOWN, "Unknown file transfer result.");
+}
+
+} // namespace
 
 grpc::Status FileServiceImpl::Upload(grpc::ServerContext *context,
                                      grpc::ServerReader<UploadFileRequest> *reader,
-                                     UploadFileResponse *response) {}
+                                     UploadFileResponse * /*response*/) {
+    grpc::Status status;
+    std::optional<Identity> identity = ExtractIdentityFromContext(*context, &status);
+    if (!status.ok()) {
+        return status;
+    }
+
+    UploadFileRequest request;
+    if (!reader->Read(&request)) {
+        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Missing file descriptor.");
+    }
+
+    std::optional<std::string> file_path =
+        ResolveFileAccess(identity.value(), request.file_descriptor(), FAM_WRITE,
+                          DemoWebEnvironment()->KeyGen(), DemoWebEnvironment()->DemowebDatabase());
+    if (!file_path.has_value()) {
+        return grpc::Status(grpc::StatusCode::PERMISSION_DENIED, "No write access to the file.");
+    }
+
+    // The first request may carry the first chunk already. Every following request is read into
+    // the same message so that its chunk buffer is reused.
+    bool chunk_consumed = false;
+    auto read_chunk = [&request, &chunk_consumed, reader]() -> FileChunk const * {
+        do {
+            if (chunk_consumed && !reader->Read(&request)) {
+                return nullptr;
+            }
+            chunk_consumed = true;
+        } while (!request.has_current_chunk());
+        return &request.current_chunk();
+    };
+
+    FileTransferResult result =
+        ReceiveFile(file_path.value(), read_chunk, kMaxUploadFileSize,
+                    DemoWebEnvironment()->FileSystem());
+    return ToStatus(result);
+}
 
 grpc::Status FileServiceImpl::Download(grpc::ServerContext *context,
                                        DownloadFileRequest const *request,
-                                       grpc::ServerWriter<DownloadFileResponse> *writer) {}
+                                       grpc::ServerWriter<DownloadFileResponse> *writer) {
+    grpc::Status status;
+    std::optional<Identity> identity = ExtractIdentityFromContext(*context, &status);
+    if (!status.ok()) {
+        return status;
+    }
+
+    std::optional<std::string> file_path =
+        ResolveFileAccess(identity.value(), request->file_descriptor(), FAM_READ,
+                          DemoWebEnvironment()->KeyGen(), DemoWebEnvironment()->DemowebDatabase());
+    if (!file_path.has_value()) {
+        return grpc::Status(grpc::StatusCode::PERMISSION_DENIED, "No read access to the file.");
+    }
+
+    // Protobuf owns its bytes fields, so each chunk is copied once from the mapped file into the
+    // reused response message.
+    DownloadFileResponse response;
+    auto write_chunk = [&response, writer](int32_t chunk_number, std::string_view data) {
+        response.mutable_current_chunk()->set_chunk_number(chunk_number);
+        response.mutable_current_chunk()->set_data(data.data(), data.size());
+        return writer->Write(response);
+    };
+
+    FileTransferResult result =
+        SendFile(file_path.value(), write_chunk, DemoWebEnvironment()->FileSystem());
+    return ToStatus(result);
+}
 
 } // namespace e8
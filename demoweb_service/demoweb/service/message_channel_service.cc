@@ -56,7 +56,7 @@ MessageChannelServiceImpl::CreateMessageChannel(grpc::ServerContext *context,
     MessageChannelEntity channel = ::e8::CreateMessageChannel(
         identity->user_id(), channel_title, channel_desc, to_be_member_ids, request->encrypted(),
         request->close_group_channel(), DemoWebEnvironment()->CurrentHostId(),
-        DemoWebEnvironment()->DemowebDatabase());
+        DemoWebEnvironment()->MessageChannelPbac(), DemoWebEnvironment()->DemowebDatabase());
 
     response->set_channel_id(*channel.id.Value());
 
@@ -148,6 +148,7 @@ MessageChannelServiceImpl::SearchMessageChannels(grpc::ServerContext *context,
 
     std::vector<MessageChannelOverview> results =
         ToMessageChannelOverviews(identity->user_id(), channels, DemoWebEnvironment()->KeyGen(),
+                                  DemoWebEnvironment()->UserProfileCache(),
                                   DemoWebEnvironment()->DemowebDatabase());
     *response->mutable_channels() = {results.begin(), results.end()};
 
@@ -177,6 +178,7 @@ MessageChannelServiceImpl::GetMessageChannelMembers(grpc::ServerContext *context
     }
     std::vector<UserPublicProfile> profiles =
         BuildPublicProfiles(identity->user_id(), users, DemoWebEnvironment()->KeyGen(),
+                            DemoWebEnvironment()->UserProfileCache(),
                             DemoWebEnvironment()->DemowebDatabase());
     *response->mutable_user_profiles() = {profiles.begin(), profiles.end()};
 
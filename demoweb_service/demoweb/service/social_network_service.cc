@@ -73,7 +73,8 @@ grpc::Status SocialNetworkServiceImpl::SendInvitation(grpc::ServerContext *conte
     ::e8::SendInvitation(identity.value().user_id(), request->invitee_user_id(),
                          /*send_message_anyway=*/true, DemoWebEnvironment()->CurrentHostId(),
                          DemoWebEnvironment()->ClientPushMessagePublishers(),
-                         DemoWebEnvironment()->KeyGen(), DemoWebEnvironment()->DemowebDatabase());
+                         DemoWebEnvironment()->KeyGen(), DemoWebEnvironment()->UserProfileCache(),
+                         DemoWebEnvironment()->DemowebDatabase());
 
     return grpc::Status::OK;
 }
@@ -106,7 +107,7 @@ SocialNetworkServiceImpl::SearchRelatedUserList(grpc::ServerContext *context,
                    DemoWebEnvironment()->DemowebDatabase());
     std::vector<UserPublicProfile> related_profiles = BuildPublicProfiles(
         identity.value().user_id(), related_users, DemoWebEnvironment()->KeyGen(),
-        DemoWebEnvironment()->DemowebDatabase());
+        DemoWebEnvironment()->UserProfileCache(), DemoWebEnvironment()->DemowebDatabase());
 
     *response->mutable_user_profiles() = {related_profiles.begin(), related_profiles.end()};
 
@@ -126,6 +127,7 @@ grpc::Status SocialNetworkServiceImpl::ProcessInvitation(grpc::ServerContext *co
                                DemoWebEnvironment()->CurrentHostId(),
                                DemoWebEnvironment()->ClientPushMessagePublishers(),
                                DemoWebEnvironment()->KeyGen(),
+                               DemoWebEnvironment()->UserProfileCache(),
                                DemoWebEnvironment()->DemowebDatabase())) {
         return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, "Invitation does not exist.");
     }
@@ -98,10 +98,12 @@ grpc::Status UserServiceImpl::GetPublicProfile(grpc::ServerContext *context,
     if (identity.has_value()) {
         profiles = BuildPublicProfiles(identity.value().user_id(), {user.value()},
                                        DemoWebEnvironment()->KeyGen(),
+                                       DemoWebEnvironment()->UserProfileCache(),
                                        DemoWebEnvironment()->DemowebDatabase());
     } else {
         profiles = BuildPublicProfiles(std::optional<UserId>(), {user.value()},
                                        DemoWebEnvironment()->KeyGen(),
+                                       DemoWebEnvironment()->UserProfileCache(),
                                        DemoWebEnvironment()->DemowebDatabase());
     }
     assert(profiles.size() == 1);
@@ -131,10 +133,12 @@ grpc::Status UserServiceImpl::UpdatePublicProfile(grpc::ServerContext *context,
     std::optional<std::string> biography =
         request->has_biography() ? std::optional<std::string>(request->biography().value())
                                  : std::nullopt;
-    UpdateProfile(alias, biography, &user.value(), DemoWebEnvironment()->DemowebDatabase());
+    UpdateProfile(alias, biography, &user.value(), DemoWebEnvironment()->UserProfileCache(),
+                  DemoWebEnvironment()->DemowebDatabase());
 
     std::vector<UserPublicProfile> profiles =
         BuildPublicProfiles(user_id, {user.value()}, DemoWebEnvironment()->KeyGen(),
+                            DemoWebEnvironment()->UserProfileCache(),
                             DemoWebEnvironment()->DemowebDatabase());
     assert(profiles.size() == 1);
     *response->mutable_profile() = profiles[0];
@@ -161,6 +165,7 @@ grpc::Status UserServiceImpl::Search(grpc::ServerContext *context, SearchUserReq
 
     std::vector<UserPublicProfile> profiles =
         BuildPublicProfiles(identity->user_id(), user_entities, DemoWebEnvironment()->KeyGen(),
+                            DemoWebEnvironment()->UserProfileCache(),
                             DemoWebEnvironment()->DemowebDatabase());
 
     *response->mutable_user_profiles() = {profiles.begin(), profiles.end()};
@@ -186,6 +191,7 @@ grpc::Status UserServiceImpl::PrepareNewAvatar(grpc::ServerContext *context,
 
     AvatarSetup setup =
         SetUpNewProfileAvatar(user.value(), request->file_format(), DemoWebEnvironment()->KeyGen(),
+                              DemoWebEnvironment()->UserProfileCache(),
                               DemoWebEnvironment()->DemowebDatabase());
     response->mutable_avatar_readwrite_access()->set_access_token(setup.avatar_path_access_token);
 
@@ -0,0 +1,170 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "common/unit_test_util/unit_test_util.h"
+#include "file_system/file_interface.h"
+#include "file_system/local_file_system.h"
+
+namespace {
+
+std::string TestRootDir() {
+    return (std::filesystem::temp_directory_path() / "e8_test_local_file_system").string();
+}
+
+} // namespace
+
+bool CreateAppendAndReadTest() {
+    std::filesystem::remove_all(TestRootDir());
+    e8::LocalFileSystem fs(TestRootDir());
+
+    TEST_CONDITION(fs.OpenFile("/user/1/avatar/a.png") == nullptr);
+    TEST_CONDITION(fs.CreateFile("/user/1/avatar/a.png"));
+
+    std::unique_ptr<e8::FileInterface> file = fs.OpenFile("/user/1/avatar/a.png");
+    TEST_CONDITION(file != nullptr);
+    TEST_CONDITION(file->Size() == 0);
+
+    std::optional<std::string_view> content = file->Content();
+    TEST_CONDITION(content.has_value());
+    TEST_CONDITION(content->empty());
+
+    std::string const part1 = "hello, ";
+    std::string const part2(e8::kLocalFileWriteBufferSize + 7, 'x');
+    TEST_CONDITION(file->Append(part1.data(), part1.size()));
+    TEST_CONDITION(file->Size() == static_cast<int64_t>(part1.size()));
+    TEST_CONDITION(file->Append(part2.data(), part2.size()));
+    TEST_CONDITION(file->Size() == static_cast<int64_t>(part1.size() + part2.size()));
+
+    content = file->Content();
+    TEST_CONDITION(content.has_value());
+    TEST_CONDITION(*content == part1 + part2);
+
+    // Reopening sees the flushed content.
+    file = fs.OpenFile("/user/1/avatar/a.png");
+    TEST_CONDITION(file != nullptr);
+    TEST_CONDITION(file->Size() == static_cast<int64_t>(part1.size() + part2.size()));
+
+    // Creating again truncates.
+    TEST_CONDITION(fs.CreateFile("/user/1/avatar/a.png"));
+    file = fs.OpenFile("/user/1/avatar/a.png");
+    TEST_CONDITION(file != nullptr);
+    TEST_CONDITION(file->Size() == 0);
+
+    return true;
+}
+
+bool RenameAndDeleteTest() {
+    std::filesystem::remove_all(TestRootDir());
+    e8::LocalFileSystem fs(TestRootDir());
+
+    TEST_CONDITION(fs.CreateFile("/a.part"));
+    std::unique_ptr<e8::FileInterface> file = fs.OpenFile("/a.part");
+    TEST_CONDITION(file != nullptr);
+    TEST_CONDITION(file->Append("abc", 3));
+    TEST_CONDITION(file->Flush());
+    file.reset();
+
+    TEST_CONDITION(fs.RenameFile("/a.part", "/b/a.txt"));
+    TEST_CONDITION(fs.OpenFile("/a.part") == nullptr);
+
+    file = fs.OpenFile("/b/a.txt");
+    TEST_CONDITION(file != nullptr);
+    TEST_CONDITION(file->Content() == std::string_view("abc"));
+    file.reset();
+
+    TEST_CONDITION(fs.DeleteFile("/b/a.txt"));
+    TEST_CONDITION(!fs.DeleteFile("/b/a.txt"));
+    TEST_CONDITION(fs.OpenFile("/b/a.txt") == nullptr);
+
+    return true;
+}
+
+bool RejectEscapingPathTest() {
+    std::filesystem::remove_all(TestRootDir());
+    e8::LocalFileSystem fs(TestRootDir());
+
+    TEST_CONDITION(!fs.CreateFile("/../escaped.txt"));
+    TEST_CONDITION(!fs.CreateFile("/a/../../escaped.txt"));
+    TEST_CONDITION(!fs.CreateFile("/"));
+    TEST_CONDITION(fs.OpenFile("/../" + TestRootDir()) == nullptr);
+
+    return true;
+}
+
+bool LargeFileThroughputBenchmark() {
+    std::filesystem::remove_all(TestRootDir());
+    e8::LocalFileSystem fs(TestRootDir());
+
+    unsigned const kChunkSize = 64 * 1024;
+    unsigned const kNumChunks = 4096;
+    std::vector<char> chunk(kChunkSize, 'z');
+
+    TEST_CONDITION(fs.CreateFile("/large.bin"));
+    std::unique_ptr<e8::FileInterface> file = fs.OpenFile("/large.bin");
+    TEST_CONDITION(file != nullptr);
+
+    auto write_start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < kNumChunks; ++i) {
+        TEST_CONDITION(file->Append(chunk.data(), chunk.size()));
+    }
+    TEST_CONDITION(file->Flush());
+    auto write_end = std::chrono::steady_clock::now();
+
+    auto read_start = std::chrono::steady_clock::now();
+    std::optional<std::string_view> content = file->Content();
+    TEST_CONDITION(content.has_value());
+    uint64_t checksum = 0;
+    for (char c : *content) {
+        checksum += static_cast<unsigned char>(c);
+    }
+    auto read_end = std::chrono::steady_clock::now();
+
+    uint64_t const total_bytes = static_cast<uint64_t>(kChunkSize) * kNumChunks;
+    TEST_CONDITION(content->size() == total_bytes);
+    TEST_CONDITION(checksum == static_cast<uint64_t>('z') * total_bytes);
+
+    double write_secs = std::chrono::duration<double>(write_end - write_start).count();
+    double read_secs = std::chrono::duration<double>(read_end - read_start).count();
+    double total_mib = total_bytes / (1024.0 * 1024.0);
+    std::cout << "LargeFileThroughputBenchmark: size=" << total_mib
+              << "MiB write=" << total_mib / write_secs << "MiB/s read=" << total_mib / read_secs
+              << "MiB/s" << std::endl;
+
+    file.reset();
+    std::filesystem::remove_all(TestRootDir());
+    return true;
+}
+
+int main() {
+    e8::BeginTestSuite("local_file_system");
+    e8::RunTest("CreateAppendAndReadTest", CreateAppendAndReadTest);
+    e8::RunTest("RenameAndDeleteTest", RenameAndDeleteTest);
+    e8::RunTest("RejectEscapingPathTest", RejectEscapingPathTest);
+    e8::RunTest("LargeFileThroughputBenchmark", LargeFileThroughputBenchmark);
+    e8::EndTestSuite();
+    return 0;
+}
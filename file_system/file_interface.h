@@ -18,15 +18,48 @@
 #ifndef FILE_INTERFACE_H
 #define FILE_INTERFACE_H
 
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
 namespace e8 {
 
 /**
- * @brief The FileInterface class
+ * @brief The FileInterface class An opened file handle. Writes are append-only and may be buffered
+ * until Flush() is called or the handle is destroyed.
  */
 class FileInterface {
   public:
     FileInterface() = default;
     virtual ~FileInterface() = default;
+
+    /**
+     * @brief Size Size of the file in bytes, including the bytes which are still buffered.
+     */
+    virtual int64_t Size() = 0;
+
+    /**
+     * @brief Append Appends the data to the end of the file. Implementations only hold a bounded
+     * amount of data in memory, larger writes go straight to the storage.
+     *
+     * @return true if no error occurred.
+     */
+    virtual bool Append(char const *data, int64_t size) = 0;
+
+    /**
+     * @brief Flush Writes out all the buffered data.
+     *
+     * @return true if no error occurred.
+     */
+    virtual bool Flush() = 0;
+
+    /**
+     * @brief Content A read-only view over the whole file content. The view is valid until the next
+     * call to Append(), Content() or until the handle is destroyed.
+     *
+     * @return nullopt if the content can't be read.
+     */
+    virtual std::optional<std::string_view> Content() = 0;
 };
 
 } // namespace e8
@@ -45,9 +45,24 @@ class FileSystemInterface {
      * Opens the file at the specified location.
      *
      * @param file_path Location of the file to open.
-     * @return The file handle pointing to the opened file.
+     * @return The file handle pointing to the opened file, or nullptr if the file doesn't exist.
      */
     virtual std::unique_ptr<FileInterface> OpenFile(std::string const &file_path) = 0;
+
+    /**
+     * Moves the file at from_path to to_path. It overrides the file at to_path if it has already
+     * existed. The replacement is atomic to readers of to_path.
+     *
+     * @return true if no error occurred.
+     */
+    virtual bool RenameFile(std::string const &from_path, std::string const &to_path) = 0;
+
+    /**
+     * Deletes the file at the specified location.
+     *
+     * @return true if the file existed and has been deleted.
+     */
+    virtual bool DeleteFile(std::string const &file_path) = 0;
 };
 
 } // namespace e8
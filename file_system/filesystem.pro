@@ -18,11 +18,13 @@ INCLUDEPATH += $$PWD/../
 
 SOURCES += \
     file_interface.cc \
-    file_system_interface.cc
+    file_system_interface.cc \
+    local_file_system.cc
 
 HEADERS += \
     file_interface.h \
-    file_system_interface.h
+    file_system_interface.h \
+    local_file_system.h
 
 # Default rules for deployment.
 unix {
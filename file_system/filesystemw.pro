@@ -1,5 +1,6 @@
 TEMPLATE = subdirs
 SUBDIRS = \
-    filesystem.pro
+    filesystem.pro \
+    _test_local_file_system/_test_local_file_system.pro
 
 CONFIG += ordered
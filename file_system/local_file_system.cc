@@ -0,0 +1,238 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <fcntl.h>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "file_system/file_interface.h"
+#include "file_system/local_file_system.h"
+
+namespace e8 {
+namespace {
+
+/**
+ * @brief The LocalFile class Appends go through a fixed size buffer, reads map the file into
+ * memory so that the content is served from the page cache without copying it.
+ */
+class LocalFile : public FileInterface {
+  public:
+    explicit LocalFile(int fd);
+    ~LocalFile() override;
+
+    int64_t Size() override;
+    bool Append(char const *data, int64_t size) override;
+    bool Flush() override;
+    std::optional<std::string_view> Content() override;
+
+  private:
+    bool WriteAll(char const *data, int64_t size);
+    void Unmap();
+
+    int fd_;
+    int64_t flushed_size_;
+    std::vector<char> write_buffer_;
+    void *mapped_;
+    size_t mapped_size_;
+};
+
+LocalFile::LocalFile(int fd) : fd_(fd), mapped_(nullptr), mapped_size_(0) {
+    struct stat file_stat;
+    int rc = fstat(fd_, &file_stat);
+    assert(rc == 0);
+    flushed_size_ = file_stat.st_size;
+}
+
+LocalFile::~LocalFile() {
+    this->Flush();
+    this->Unmap();
+    close(fd_);
+}
+
+int64_t LocalFile::Size() { return flushed_size_ + static_cast<int64_t>(write_buffer_.size()); }
+
+bool LocalFile::Append(char const *data, int64_t size) {
+    if (static_cast<int64_t>(write_buffer_.size()) + size <= kLocalFileWriteBufferSize) {
+        write_buffer_.insert(write_buffer_.end(), data, data + size);
+        return true;
+    }
+
+    if (!this->Flush()) {
+        return false;
+    }
+
+    if (size >= kLocalFileWriteBufferSize) {
+        // Buffering doesn't save any system call.
+        return this->WriteAll(data, size);
+    }
+
+    write_buffer_.insert(write_buffer_.end(), data, data + size);
+    return true;
+}
+
+bool LocalFile::Flush() {
+    if (write_buffer_.empty()) {
+        return true;
+    }
+
+    bool rc = this->WriteAll(write_buffer_.data(), write_buffer_.size());
+    write_buffer_.clear();
+    return rc;
+}
+
+std::optional<std::string_view> LocalFile::Content() {
+    if (!this->Flush()) {
+        return std::nullopt;
+    }
+
+    this->Unmap();
+    if (flushed_size_ == 0) {
+        // Empty files can't be mapped.
+        return std::string_view();
+    }
+
+    void *mapped = mmap(nullptr, flushed_size_, PROT_READ, MAP_SHARED, fd_, /*offset=*/0);
+    if (mapped == MAP_FAILED) {
+        return std::nullopt;
+    }
+    madvise(mapped, flushed_size_, MADV_SEQUENTIAL);
+
+    mapped_ = mapped;
+    mapped_size_ = flushed_size_;
+    return std::string_view(static_cast<char const *>(mapped_), mapped_size_);
+}
+
+bool LocalFile::WriteAll(char const *data, int64_t size) {
+    this->Unmap();
+
+    while (size > 0) {
+        ssize_t num_bytes_written = write(fd_, data, size);
+        if (num_bytes_written < 0) {
+            if (errno == EINTR) {
+                // Interrupted by a signal before anything was written.
+                continue;
+            }
+            return false;
+        }
+        data += num_bytes_written;
+        size -= num_bytes_written;
+        flushed_size_ += num_bytes_written;
+    }
+    return true;
+}
+
+void LocalFile::Unmap() {
+    if (mapped_ == nullptr) {
+        return;
+    }
+    munmap(mapped_, mapped_size_);
+    mapped_ = nullptr;
+    mapped_size_ = 0;
+}
+
+} // namespace
+
+LocalFileSystem::LocalFileSystem(std::string const &root_dir) : root_dir_(root_dir) {
+    std::error_code ec;
+    std::filesystem::create_directories(root_dir_, ec);
+    assert(std::filesystem::is_directory(root_dir_));
+}
+
+bool LocalFileSystem::CreateFile(std::string const &file_path) {
+    std::optional<std::string> local_path = this->LocalPath(file_path);
+    if (!local_path.has_value()) {
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(*local_path).parent_path(), ec);
+    if (ec) {
+        return false;
+    }
+
+    int fd = open(local_path->c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    close(fd);
+    return true;
+}
+
+std::unique_ptr<FileInterface> LocalFileSystem::OpenFile(std::string const &file_path) {
+    std::optional<std::string> local_path = this->LocalPath(file_path);
+    if (!local_path.has_value()) {
+        return nullptr;
+    }
+
+    int fd = open(local_path->c_str(), O_RDWR | O_APPEND);
+    if (fd < 0) {
+        return nullptr;
+    }
+    return std::make_unique<LocalFile>(fd);
+}
+
+bool LocalFileSystem::RenameFile(std::string const &from_path, std::string const &to_path) {
+    std::optional<std::string> local_from_path = this->LocalPath(from_path);
+    std::optional<std::string> local_to_path = this->LocalPath(to_path);
+    if (!local_from_path.has_value() || !local_to_path.has_value()) {
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(*local_to_path).parent_path(), ec);
+    if (ec) {
+        return false;
+    }
+
+    return rename(local_from_path->c_str(), local_to_path->c_str()) == 0;
+}
+
+bool LocalFileSystem::DeleteFile(std::string const &file_path) {
+    std::optional<std::string> local_path = this->LocalPath(file_path);
+    if (!local_path.has_value()) {
+        return false;
+    }
+    return unlink(local_path->c_str()) == 0;
+}
+
+std::optional<std::string> LocalFileSystem::LocalPath(std::string const &file_path) const {
+    std::filesystem::path relative_path = std::filesystem::path(file_path).relative_path();
+    if (relative_path.empty()) {
+        return std::nullopt;
+    }
+
+    bool escapes_root = std::any_of(relative_path.begin(), relative_path.end(),
+                                    [](std::filesystem::path const &part) { return part == ".."; });
+    if (escapes_root) {
+        return std::nullopt;
+    }
+
+    return (std::filesystem::path(root_dir_) / relative_path).string();
+}
+
+} // namespace e8
@@ -0,0 +1,59 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOCAL_FILE_SYSTEM_H
+#define LOCAL_FILE_SYSTEM_H
+
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "file_system/file_interface.h"
+#include "file_system/file_system_interface.h"
+
+namespace e8 {
+
+// Maximum number of bytes a local file handle buffers before writing them out.
+static unsigned const kLocalFileWriteBufferSize = 1 << 20;
+
+/**
+ * @brief The LocalFileSystem class A file system backed by a directory on the local disk. File
+ * paths are resolved relative to the root directory. Paths which contain a ".." component are
+ * rejected so that they can't escape the root.
+ */
+class LocalFileSystem : public FileSystemInterface {
+  public:
+    /**
+     * @param root_dir Directory where all the files are stored. It's created if it doesn't exist.
+     */
+    explicit LocalFileSystem(std::string const &root_dir);
+    ~LocalFileSystem() override = default;
+
+    bool CreateFile(std::string const &file_path) override;
+    std::unique_ptr<FileInterface> OpenFile(std::string const &file_path) override;
+    bool RenameFile(std::string const &from_path, std::string const &to_path) override;
+    bool DeleteFile(std::string const &file_path) override;
+
+  private:
+    std::optional<std::string> LocalPath(std::string const &file_path) const;
+
+    std::string root_dir_;
+};
+
+} // namespace e8
+
+#endif // LOCAL_FILE_SYSTEM_H
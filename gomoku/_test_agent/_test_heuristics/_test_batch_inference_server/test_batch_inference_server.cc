@@ -0,0 +1,155 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "common/unit_test_util/unit_test_util.h"
+#include "gomoku/agent/heuristics/batch_inference_server.h"
+#include "gomoku/game/board_state.h"
+
+class FakeModel : public e8::GomokuInferenceModelInterface {
+  public:
+    FakeModel(std::vector<unsigned> *batch_sizes) : batch_sizes_(batch_sizes) {}
+
+    void Infer(std::vector<e8::GomokuInferenceRequest> const &batch,
+               std::vector<e8::GomokuInferenceResult> *results) override {
+        batch_sizes_->push_back(batch.size());
+
+        for (unsigned i = 0; i < batch.size(); ++i) {
+            (*results)[i] = Expected(*batch[i].state);
+        }
+    }
+
+    static e8::GomokuInferenceResult Expected(e8::GomokuBoardState const &state) {
+        e8::GomokuInferenceResult result;
+        result.policy.push_back(state.Hash() & 0xFFFF);
+        result.policy.push_back(state.Hash() >> 48);
+        result.value = state.CurrentPlayerSide();
+        return result;
+    }
+
+  private:
+    std::vector<unsigned> *batch_sizes_;
+};
+
+bool InlineInferenceTest() {
+    std::vector<unsigned> batch_sizes;
+    e8::GomokuBatchInferenceServer server(std::make_unique<FakeModel>(&batch_sizes),
+                                          /*max_batch_size=*/1,
+                                          /*max_delay=*/std::chrono::microseconds(0));
+
+    e8::GomokuBoardState state(/*width=*/11, /*height=*/11);
+    std::future<e8::GomokuInferenceResult> result = server.Infer(state);
+
+    // The model runs on the requesting thread.
+    TEST_CONDITION(result.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    TEST_CONDITION(result.get().value == e8::PS_PLAYER_A);
+    TEST_CONDITION(server.NumBatches() == 1);
+    TEST_CONDITION(server.NumRequests() == 1);
+
+    return true;
+}
+
+bool DeadlineFlushTest() {
+    std::vector<unsigned> batch_sizes;
+    e8::GomokuBatchInferenceServer server(std::make_unique<FakeModel>(&batch_sizes),
+                                          /*max_batch_size=*/64,
+                                          /*max_delay=*/std::chrono::microseconds(1000));
+
+    e8::GomokuBoardState state(/*width=*/11, /*height=*/11);
+    std::future<e8::GomokuInferenceResult> result = server.Infer(state);
+
+    // A lone request doesn't wait for the batch to fill up.
+    TEST_CONDITION(result.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+    TEST_CONDITION(result.get().value == e8::PS_PLAYER_A);
+    TEST_CONDITION(batch_sizes.size() == 1);
+    TEST_CONDITION(batch_sizes[0] == 1);
+
+    return true;
+}
+
+bool ConcurrentBatchingTest() {
+    unsigned const kNumGames = 16;
+    unsigned const kNumMoves = 50;
+
+    std::vector<unsigned> batch_sizes;
+    e8::GomokuBatchInferenceServer server(std::make_unique<FakeModel>(&batch_sizes),
+                                          /*max_batch_size=*/8,
+                                          /*max_delay=*/std::chrono::microseconds(2000));
+
+    std::vector<std::thread> games;
+    std::vector<unsigned> num_mismatches(kNumGames, 0);
+    for (unsigned i = 0; i < kNumGames; ++i) {
+        games.emplace_back([&server, &num_mismatches, i]() {
+            e8::GomokuBoardState state(/*width=*/11, /*height=*/11);
+            for (unsigned j = 0; j < kNumMoves; ++j) {
+                e8::GomokuInferenceResult result = server.Infer(state).get();
+                e8::GomokuInferenceResult expected = FakeModel::Expected(state);
+                if (result.value != expected.value || result.policy != expected.policy) {
+                    ++num_mismatches[i];
+                }
+
+                // Plays a different game on each thread.
+                e8::GomokuActionSet actions = state.LegalActions();
+                auto it = actions.begin();
+                for (unsigned k = 0; k < (i + j) % actions.size(); ++k) {
+                    ++it;
+                }
+                state.ApplyAction(it->first, /*cached_game_result=*/std::nullopt);
+                if (state.CurrentGameResult() != e8::GR_UNDETERMINED) {
+                    break;
+                }
+            }
+        });
+    }
+    for (auto &game : games) {
+        game.join();
+    }
+
+    for (unsigned i = 0; i < kNumGames; ++i) {
+        TEST_CONDITION(num_mismatches[i] == 0);
+    }
+
+    unsigned num_requests = 0;
+    for (unsigned batch_size : batch_sizes) {
+        TEST_CONDITION(batch_size >= 1 && batch_size <= 8);
+        num_requests += batch_size;
+    }
+    TEST_CONDITION(num_requests == server.NumRequests());
+    TEST_CONDITION(batch_sizes.size() == server.NumBatches());
+
+    // Requests from different games share batches.
+    TEST_CONDITION(server.NumBatches() < server.NumRequests());
+
+    return true;
+}
+
+int main() {
+    e8::BeginTestSuite("batch_inference_server");
+    e8::RunTest("InlineInferenceTest", InlineInferenceTest);
+    e8::RunTest("DeadlineFlushTest", DeadlineFlushTest);
+    e8::RunTest("ConcurrentBatchingTest", ConcurrentBatchingTest);
+    e8::EndTestSuite();
+    return 0;
+}
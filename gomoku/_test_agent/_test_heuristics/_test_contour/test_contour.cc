@@ -16,8 +16,10 @@
  */
 
 #include <cstdint>
+#include <unordered_map>
 #include <unordered_set>
 
+#include "common/random/random_source.h"
 #include "common/unit_test_util/unit_test_util.h"
 #include "gomoku/agent/heuristics/contour.h"
 #include "gomoku/game/board_state.h"
@@ -36,6 +38,11 @@ std::unordered_set<e8::MovePosition> BruteForceContour(e8::GomokuBoardState cons
     return contour;
 }
 
+std::unordered_set<e8::MovePosition> ContourSet(e8::ContourBuilder const &contour_builder) {
+    return std::unordered_set<e8::MovePosition>(contour_builder.Contour().begin(),
+                                                contour_builder.Contour().end());
+}
+
 bool FirstContourBuilderTest() {
     e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
 
@@ -66,7 +73,8 @@ bool FirstContourBuilderTest() {
     e8::ContourBuilder contour_builder(board, /*order=*/1);
 
     auto ground_truth = BruteForceContour(board);
-    TEST_CONDITION(contour_builder.Contour() == ground_truth);
+    TEST_CONDITION(ContourSet(contour_builder) == ground_truth);
+    TEST_CONDITION(contour_builder.Contour().size() == ground_truth.size());
 
     // Incremental update test.
     board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(4, 2)),
@@ -78,7 +86,46 @@ bool FirstContourBuilderTest() {
     contour_builder.AddStone(e8::MovePosition(4, 4));
 
     ground_truth = BruteForceContour(board);
-    TEST_CONDITION(contour_builder.Contour() == ground_truth);
+    TEST_CONDITION(ContourSet(contour_builder) == ground_truth);
+    TEST_CONDITION(contour_builder.Contour().size() == ground_truth.size());
+
+    for (int8_t y = 0; y < board.Height(); ++y) {
+        for (int8_t x = 0; x < board.Width(); ++x) {
+            e8::MovePosition pos(x, y);
+            TEST_CONDITION(contour_builder.Contains(pos) ==
+                           (ground_truth.find(pos) != ground_truth.end()));
+        }
+    }
+
+    return true;
+}
+
+bool ContourSampleTest() {
+    e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
+
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(4, 6)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(5, 5)),
+                      /*cached_game_result=*/std::nullopt);
+
+    e8::ContourBuilder contour_builder(board, /*order=*/1);
+    auto ground_truth = BruteForceContour(board);
+
+    e8::RandomSource random_source(/*seed=*/17);
+    std::unordered_map<e8::MovePosition, unsigned> freqs;
+    unsigned const kNumSamples = 10000;
+    for (unsigned i = 0; i < kNumSamples; ++i) {
+        e8::MovePosition pos = contour_builder.Sample(&random_source);
+        TEST_CONDITION(ground_truth.find(pos) != ground_truth.end());
+        ++freqs[pos];
+    }
+
+    // Every contour position shows up at roughly the uniform frequency.
+    TEST_CONDITION(freqs.size() == ground_truth.size());
+    float expected_freq = static_cast<float>(kNumSamples) / ground_truth.size();
+    for (auto const &[_, freq] : freqs) {
+        TEST_CONDITION(freq > 0.8f * expected_freq && freq < 1.2f * expected_freq);
+    }
 
     return true;
 }
@@ -86,6 +133,7 @@ bool FirstContourBuilderTest() {
 int main() {
     e8::BeginTestSuite("contour");
     e8::RunTest("FirstContourBuilderTest", FirstContourBuilderTest);
+    e8::RunTest("ContourSampleTest", ContourSampleTest);
     e8::EndTestSuite();
     return 0;
 }
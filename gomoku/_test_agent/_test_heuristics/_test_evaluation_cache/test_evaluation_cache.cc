@@ -0,0 +1,183 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "common/unit_test_util/unit_test_util.h"
+#include "gomoku/agent/heuristics/batch_inference_server.h"
+#include "gomoku/agent/heuristics/evaluation_cache.h"
+#include "gomoku/game/board_state.h"
+#include "gomoku/game/board_symmetry.h"
+
+namespace {
+
+void PlayOpening(e8::GomokuBoardState *board) {
+    for (e8::MovePosition const &pos : {e8::MovePosition(/*x=*/2, /*y=*/3),
+                                        e8::MovePosition(/*x=*/7, /*y=*/1),
+                                        e8::MovePosition(/*x=*/4, /*y=*/8)}) {
+        board->ApplyAction(board->MovePositionToActionId(pos),
+                           /*cached_game_result=*/std::nullopt);
+    }
+}
+
+// A policy which tells the action IDs apart.
+std::vector<float> DistinctPolicy(e8::GomokuBoardState const &board) {
+    auto [lo, hi] = board.ActionIdRange();
+
+    std::vector<float> policy(hi - lo + 1);
+    for (unsigned i = 0; i < policy.size(); ++i) {
+        policy[i] = i;
+    }
+    return policy;
+}
+
+class CountingModel : public e8::GomokuInferenceModelInterface {
+  public:
+    CountingModel(unsigned *num_inferences) : num_inferences_(num_inferences) {}
+
+    void Infer(std::vector<e8::GomokuInferenceRequest> const &batch,
+               std::vector<e8::GomokuInferenceResult> *results) override {
+        for (unsigned i = 0; i < batch.size(); ++i) {
+            (*results)[i].policy = DistinctPolicy(*batch[i].state);
+            (*results)[i].value = 0.25f;
+        }
+        *num_inferences_ += batch.size();
+    }
+
+  private:
+    unsigned *num_inferences_;
+};
+
+} // namespace
+
+bool SymmetricLookupTest() {
+    e8::GomokuEvaluationCache cache(/*capacity=*/64);
+
+    e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
+    PlayOpening(&board);
+
+    std::vector<float> policy = DistinctPolicy(board);
+    e8::GomokuEvaluationCacheKey key = e8::GomokuEvaluationCache::KeyOf(board, /*model_version=*/1);
+    cache.Insert(key, board.Width(), board.Height(), policy, /*value=*/0.5f);
+
+    for (unsigned i = 0; i < e8::kNumBoardSymmetries; ++i) {
+        e8::BoardSymmetry symmetry = static_cast<e8::BoardSymmetry>(i);
+        e8::GomokuBoardState transformed = e8::TransformBoardState(board, symmetry);
+
+        std::vector<float> cached_policy;
+        float cached_value;
+        TEST_CONDITION(cache.Find(e8::GomokuEvaluationCache::KeyOf(transformed, 1),
+                                  transformed.Width(), transformed.Height(), &cached_policy,
+                                  &cached_value));
+        TEST_CONDITION(cached_value == 0.5f);
+
+        // The policy is given in the orientation of the looked up state.
+        std::vector<float> expected_policy(policy.size());
+        e8::TransformFlatPolicy(policy.data(), symmetry, board.Width(), board.Height(),
+                                expected_policy.data());
+        TEST_CONDITION(cached_policy == expected_policy);
+    }
+
+    // Another model's outputs are kept apart.
+    std::vector<float> cached_policy;
+    float cached_value;
+    TEST_CONDITION(!cache.Find(e8::GomokuEvaluationCache::KeyOf(board, /*model_version=*/2),
+                               board.Width(), board.Height(), &cached_policy, &cached_value));
+
+    e8::GomokuEvaluationCacheStats stats = cache.Stats();
+    TEST_CONDITION(stats.num_lookups == e8::kNumBoardSymmetries + 1);
+    TEST_CONDITION(stats.num_hits == e8::kNumBoardSymmetries);
+    TEST_CONDITION(stats.num_insertions == 1);
+    TEST_CONDITION(stats.HitRate() > 0.8f);
+
+    return true;
+}
+
+bool BoundedCapacityTest() {
+    e8::GomokuEvaluationCache cache(/*capacity=*/8);
+
+    e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
+    std::vector<float> policy = DistinctPolicy(board);
+
+    unsigned const kNumModels = 64;
+    for (unsigned i = 0; i < kNumModels; ++i) {
+        cache.Insert(e8::GomokuEvaluationCache::KeyOf(board, /*model_version=*/i), board.Width(),
+                     board.Height(), policy, /*value=*/i);
+    }
+
+    unsigned num_found = 0;
+    for (unsigned i = 0; i < kNumModels; ++i) {
+        std::vector<float> cached_policy;
+        float cached_value;
+        if (cache.Find(e8::GomokuEvaluationCache::KeyOf(board, /*model_version=*/i), board.Width(),
+                       board.Height(), &cached_policy, &cached_value)) {
+            TEST_CONDITION(cached_value == i);
+            ++num_found;
+        }
+    }
+
+    TEST_CONDITION(num_found > 0);
+    TEST_CONDITION(num_found <= 8);
+    TEST_CONDITION(cache.Stats().num_evictions == kNumModels - num_found);
+
+    return true;
+}
+
+bool CachedInferenceServerTest() {
+    e8::GomokuEvaluationCache cache(/*capacity=*/64);
+
+    unsigned num_inferences = 0;
+    e8::GomokuBatchInferenceServer server(std::make_unique<CountingModel>(&num_inferences),
+                                          /*max_batch_size=*/1,
+                                          /*max_delay=*/std::chrono::microseconds(0), &cache,
+                                          /*model_version=*/7);
+
+    e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
+    PlayOpening(&board);
+    e8::GomokuInferenceResult result = server.Infer(board).get();
+    TEST_CONDITION(num_inferences == 1);
+
+    // A mirrored position is served from the cache.
+    e8::GomokuBoardState mirrored = e8::TransformBoardState(board, e8::BS_FLIP);
+    std::future<e8::GomokuInferenceResult> cached_result = server.Infer(mirrored);
+    TEST_CONDITION(cached_result.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    TEST_CONDITION(num_inferences == 1);
+    TEST_CONDITION(server.NumRequests() == 1);
+
+    e8::GomokuInferenceResult mirrored_result = cached_result.get();
+    TEST_CONDITION(mirrored_result.value == result.value);
+    e8::GomokuActionId action_id = board.MovePositionToActionId(e8::MovePosition(/*x=*/2, /*y=*/3));
+    e8::GomokuActionId mirrored_action_id =
+        e8::TransformActionId(action_id, e8::BS_FLIP, board.Width(), board.Height());
+    TEST_CONDITION(mirrored_result.policy[mirrored_action_id] == result.policy[action_id]);
+
+    return true;
+}
+
+int main() {
+    e8::BeginTestSuite("evaluation_cache");
+    e8::RunTest("SymmetricLookupTest", SymmetricLookupTest);
+    e8::RunTest("BoundedCapacityTest", BoundedCapacityTest);
+    e8::RunTest("CachedInferenceServerTest", CachedInferenceServerTest);
+    e8::EndTestSuite();
+    return 0;
+}
@@ -21,6 +21,7 @@
 
 #include "common/unit_test_util/unit_test_util.h"
 #include "gomoku/agent/heuristics/light_rollout_evaluator.h"
+#include "gomoku/agent/search/policy.h"
 #include "gomoku/game/board_state.h"
 
 bool RewardEvaluationTest() {
@@ -114,6 +115,28 @@ bool RewardEvaluationTest2() {
     return true;
 }
 
+bool SeededRewardTest() {
+    e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/3, /*y=*/6)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/4, /*y=*/3)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/9, /*y=*/7)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.Swap2DecisionToActionId(e8::Swap2Decision::SW2D_CHOOSE_WHITE),
+                      /*cached_game_result=*/std::nullopt);
+
+    // Fresh evaluators with the same seed and number of workers play the same rollouts.
+    e8::GomokuLightRolloutEvaluator evaluator(/*num_workers=*/2, /*seed=*/7);
+    e8::GomokuLightRolloutEvaluator same_seed(/*num_workers=*/2, /*seed=*/7);
+    float reward = evaluator.EvaluateReward(board, /*parent_state_id=*/std::nullopt,
+                                            /*state_id=*/1);
+    TEST_CONDITION(same_seed.EvaluateReward(board, /*parent_state_id=*/std::nullopt,
+                                            /*state_id=*/1) == reward);
+
+    return true;
+}
+
 bool PolicyEvaluationTest() {
     e8::GomokuBoardState board(/*width=*/7, /*height=*/7);
 
@@ -138,8 +161,8 @@ bool PolicyEvaluationTest() {
                       /*cached_game_result=*/std::nullopt);
 
     e8::GomokuLightRolloutEvaluator evaluator;
-    std::unordered_map<e8::GomokuActionId, float> policy =
-        evaluator.EvaluatePolicy(board, /*parent_state_id=*/std::nullopt, /*state_id=*/2);
+    e8::GomokuPolicy policy;
+    evaluator.EvaluatePolicy(board, /*parent_state_id=*/std::nullopt, /*state_id=*/2, &policy);
 
     // Contour
     // - - - - - ? o
@@ -149,10 +172,12 @@ bool PolicyEvaluationTest() {
     // - - ? ? x ? -
     // - - - ? ? ? -
     // - - - - - - -
-    TEST_CONDITION(policy.size() == 7 * 7 - 5);
+    TEST_CONDITION(policy.NumActions() == 7 * 7 + 5);
+    TEST_CONDITION(board.LegalActions().size() == 7 * 7 - 5);
     unsigned num_zero = 0;
     unsigned num_nonzero = 0;
-    for (auto const &[action_id, p] : policy) {
+    for (auto const &[action_id, _] : board.LegalActions()) {
+        float p = policy[action_id];
         if (p == 0) {
             ++num_zero;
         } else {
@@ -171,6 +196,7 @@ int main() {
     e8::BeginTestSuite("light_rollout_evaluator");
     e8::RunTest("RewardEvaluationTest", RewardEvaluationTest);
     e8::RunTest("RewardEvaluationTest2", RewardEvaluationTest2);
+    e8::RunTest("SeededRewardTest", SeededRewardTest);
     e8::RunTest("PolicyEvaluationTest", PolicyEvaluationTest);
     e8::EndTestSuite();
     return 0;
@@ -0,0 +1,351 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/unit_test_util/unit_test_util.h"
+#include "gomoku/agent/heuristics/native_cnn.h"
+
+namespace {
+
+unsigned const kBoardSize = 11;
+unsigned const kNumActions = kBoardSize * kBoardSize + 5;
+
+e8::NativeCnnTensor RandomTensor(std::vector<unsigned> const &dims, float stddev,
+                                 std::mt19937 *random_engine) {
+    e8::NativeCnnTensor tensor;
+    tensor.dims = dims;
+
+    unsigned size = 1;
+    for (unsigned dim : dims) {
+        size *= dim;
+    }
+
+    std::normal_distribution<float> distribution(0.0f, stddev);
+    tensor.values.resize(size);
+    for (float &value : tensor.values) {
+        value = distribution(*random_engine);
+    }
+    return tensor;
+}
+
+/**
+ * @brief RandomWeights Weights shaped like cnn_shared_model.GomokuCnnSharedModel, initialized the
+ * same way as the untrained model.
+ */
+e8::NativeCnnWeights RandomWeights(unsigned seed) {
+    std::mt19937 random_engine(seed);
+
+    auto kernel = [&random_engine](unsigned kernel_size, unsigned num_inputs,
+                                   unsigned num_outputs) {
+        return RandomTensor({kernel_size, kernel_size, num_inputs, num_outputs},
+                            std::sqrt(2.0f / (kernel_size * kernel_size * num_inputs)),
+                            &random_engine);
+    };
+    auto dense = [&random_engine](unsigned num_inputs, unsigned num_outputs) {
+        return RandomTensor({num_inputs, num_outputs}, std::sqrt(2.0f / num_inputs),
+                            &random_engine);
+    };
+    auto biases = [&random_engine](unsigned size) {
+        return RandomTensor({size}, /*stddev=*/0.1f, &random_engine);
+    };
+    auto alphas = [](unsigned size) {
+        return e8::NativeCnnTensor{{size}, std::vector<float>(size, 0.25f)};
+    };
+
+    unsigned num_positions = kBoardSize * kBoardSize;
+
+    e8::NativeCnnWeights weights;
+    weights.board_width = kBoardSize;
+    weights.board_height = kBoardSize;
+    weights.tensors = {kernel(5, 10, 32),
+                       biases(32),
+                       kernel(3, 32, 64),
+                       biases(64),
+                       kernel(3, 64, 128),
+                       biases(128),
+                       alphas(32),
+                       alphas(64),
+                       alphas(128),
+                       kernel(1, 128, 4),
+                       biases(4),
+                       alphas(4),
+                       dense(num_positions * 4, kNumActions),
+                       biases(kNumActions),
+                       kernel(1, 128, 2),
+                       biases(2),
+                       alphas(2),
+                       dense(num_positions * 2, 64),
+                       biases(64),
+                       dense(64, 1),
+                       biases(1)};
+    return weights;
+}
+
+struct TestBoard {
+    std::vector<uint8_t> stones;
+    uint8_t game_phase;
+    uint8_t next_move_stone_type;
+};
+
+std::vector<TestBoard> RandomBoards(unsigned num_boards, unsigned seed) {
+    std::mt19937 random_engine(seed);
+    std::uniform_int_distribution<unsigned> cell(0, 9);
+    std::uniform_int_distribution<unsigned> game_phase(0, 4);
+    std::uniform_int_distribution<unsigned> stone_type(0, 2);
+
+    std::vector<TestBoard> boards(num_boards);
+    for (TestBoard &board : boards) {
+        board.stones.resize(kBoardSize * kBoardSize);
+        for (uint8_t &stone : board.stones) {
+            unsigned c = cell(random_engine);
+            stone = c < 2 ? c + 1 : 0;
+        }
+        board.game_phase = game_phase(random_engine);
+        board.next_move_stone_type = stone_type(random_engine);
+    }
+    return boards;
+}
+
+/**
+ * @brief ReferenceConv A direct transcription of tf.nn.conv2d with "SAME" padding, followed by
+ * PReLU when alphas are given. Activations are [width][height][channels].
+ */
+std::vector<float> ReferenceConv(std::vector<float> const &input, unsigned width,
+                                 unsigned height, e8::NativeCnnTensor const &kernel,
+                                 e8::NativeCnnTensor const &biases,
+                                 e8::NativeCnnTensor const *alphas) {
+    int kernel_size = kernel.dims[0];
+    unsigned num_inputs = kernel.dims[2];
+    unsigned num_outputs = kernel.dims[3];
+    int pad = kernel_size / 2;
+
+    std::vector<float> output(width * height * num_outputs);
+    for (int x = 0; x < static_cast<int>(width); ++x) {
+        for (int y = 0; y < static_cast<int>(height); ++y) {
+            for (unsigned co = 0; co < num_outputs; ++co) {
+                double sum = biases.values[co];
+                for (int kx = 0; kx < kernel_size; ++kx) {
+                    for (int ky = 0; ky < kernel_size; ++ky) {
+                        int ix = x + kx - pad;
+                        int iy = y + ky - pad;
+                        if (ix < 0 || iy < 0 || ix >= static_cast<int>(width) ||
+                            iy >= static_cast<int>(height)) {
+                            continue;
+                        }
+                        for (unsigned ci = 0; ci < num_inputs; ++ci) {
+                            sum += input[(ix * height + iy) * num_inputs + ci] *
+                                   kernel.values[((kx * kernel_size + ky) * num_inputs + ci) *
+                                                     num_outputs +
+                                                 co];
+                        }
+                    }
+                }
+                float linear = static_cast<float>(sum);
+                if (alphas != nullptr && linear < 0) {
+                    linear *= alphas->values[co];
+                }
+                output[(x * height + y) * num_outputs + co] = linear;
+            }
+        }
+    }
+    return output;
+}
+
+std::vector<float> ReferenceDense(std::vector<float> const &input,
+                                  e8::NativeCnnTensor const &weights,
+                                  e8::NativeCnnTensor const &biases) {
+    unsigned num_outputs = weights.dims[1];
+    std::vector<float> output(num_outputs);
+    for (unsigned o = 0; o < num_outputs; ++o) {
+        double sum = biases.values[o];
+        for (unsigned i = 0; i < input.size(); ++i) {
+            sum += input[i] * weights.values[i * num_outputs + o];
+        }
+        output[o] = static_cast<float>(sum);
+    }
+    return output;
+}
+
+void ReferenceRun(e8::NativeCnnWeights const &weights, TestBoard const &board,
+                  std::vector<float> *policy, float *value) {
+    std::vector<e8::NativeCnnTensor> const &t = weights.tensors;
+    unsigned num_positions = kBoardSize * kBoardSize;
+
+    std::vector<float> planes(num_positions * 10, 0.0f);
+    for (unsigned pos = 0; pos < num_positions; ++pos) {
+        planes[pos * 10 + 0] = board.stones[pos] == 1;
+        planes[pos * 10 + 1] = board.stones[pos] == 2;
+        planes[pos * 10 + 2 + board.game_phase] = 1;
+        planes[pos * 10 + 7 + board.next_move_stone_type] = 1;
+    }
+
+    std::vector<float> conv1 = ReferenceConv(planes, kBoardSize, kBoardSize, t[0], t[1], &t[6]);
+    std::vector<float> conv2 = ReferenceConv(conv1, kBoardSize, kBoardSize, t[2], t[3], &t[7]);
+    std::vector<float> conv3 = ReferenceConv(conv2, kBoardSize, kBoardSize, t[4], t[5], &t[8]);
+
+    std::vector<float> policy_features =
+        ReferenceConv(conv3, kBoardSize, kBoardSize, t[9], t[10], &t[11]);
+    std::vector<float> logits = ReferenceDense(policy_features, t[12], t[13]);
+    float max_logit = *std::max_element(logits.begin(), logits.end());
+    double sum = 0;
+    for (float logit : logits) {
+        sum += std::exp(logit - max_logit);
+    }
+    policy->resize(logits.size());
+    for (unsigned i = 0; i < logits.size(); ++i) {
+        (*policy)[i] = static_cast<float>(std::exp(logits[i] - max_logit) / sum);
+    }
+
+    std::vector<float> value_features =
+        ReferenceConv(conv3, kBoardSize, kBoardSize, t[14], t[15], &t[16]);
+    std::vector<float> value_summary = ReferenceDense(value_features, t[17], t[18]);
+    *value = std::tanh(ReferenceDense(value_summary, t[19], t[20])[0]);
+}
+
+float MaxAbsDiff(std::vector<float> const &a, std::vector<float> const &b) {
+    float diff = 0.0f;
+    for (unsigned i = 0; i < a.size(); ++i) {
+        diff = std::max(diff, std::abs(a[i] - b[i]));
+    }
+    return diff;
+}
+
+} // namespace
+
+bool FloatMatchesReferenceTest() {
+    e8::NativeCnnWeights weights = RandomWeights(/*seed=*/7);
+    e8::NativeCnnModel model(weights, e8::NCP_FLOAT32);
+    TEST_CONDITION(model.NumActions() == kNumActions);
+
+    for (TestBoard const &board : RandomBoards(/*num_boards=*/20, /*seed=*/11)) {
+        std::vector<float> policy(kNumActions);
+        float value;
+        model.Run(board.stones.data(), board.game_phase, board.next_move_stone_type,
+                  policy.data(), &value);
+
+        std::vector<float> expected_policy;
+        float expected_value;
+        ReferenceRun(weights, board, &expected_policy, &expected_value);
+
+        TEST_CONDITION(MaxAbsDiff(policy, expected_policy) < 1e-5f);
+        TEST_CONDITION(std::abs(value - expected_value) < 1e-4f);
+    }
+
+    return true;
+}
+
+bool Int8CloseToFloatTest() {
+    e8::NativeCnnWeights weights = RandomWeights(/*seed=*/13);
+    e8::NativeCnnModel float_model(weights, e8::NCP_FLOAT32);
+    e8::NativeCnnModel int8_model(weights, e8::NCP_INT8);
+
+    for (TestBoard const &board : RandomBoards(/*num_boards=*/20, /*seed=*/17)) {
+        std::vector<float> float_policy(kNumActions);
+        float float_value;
+        float_model.Run(board.stones.data(), board.game_phase, board.next_move_stone_type,
+                        float_policy.data(), &float_value);
+
+        std::vector<float> int8_policy(kNumActions);
+        float int8_value;
+        int8_model.Run(board.stones.data(), board.game_phase, board.next_move_stone_type,
+                       int8_policy.data(), &int8_value);
+
+        float total_variation = 0.0f;
+        for (unsigned i = 0; i < kNumActions; ++i) {
+            total_variation += std::abs(float_policy[i] - int8_policy[i]) / 2;
+        }
+        TEST_CONDITION(total_variation < 0.05f);
+        TEST_CONDITION(std::abs(float_value - int8_value) < 0.05f);
+    }
+
+    return true;
+}
+
+bool WeightFileRoundTripTest() {
+    e8::NativeCnnWeights weights = RandomWeights(/*seed=*/19);
+    std::string path = "/tmp/test_native_cnn_weights.e8nn";
+    e8::SaveNativeCnnWeights(weights, path);
+
+    e8::NativeCnnWeights loaded = e8::LoadNativeCnnWeights(path);
+    TEST_CONDITION(loaded.board_width == weights.board_width);
+    TEST_CONDITION(loaded.board_height == weights.board_height);
+    TEST_CONDITION(loaded.tensors.size() == weights.tensors.size());
+    for (unsigned i = 0; i < weights.tensors.size(); ++i) {
+        TEST_CONDITION(loaded.tensors[i].dims == weights.tensors[i].dims);
+        TEST_CONDITION(loaded.tensors[i].values == weights.tensors[i].values);
+    }
+
+    return true;
+}
+
+bool NativeCnnBenchmark() {
+    e8::NativeCnnWeights weights = RandomWeights(/*seed=*/23);
+    std::vector<TestBoard> boards = RandomBoards(/*num_boards=*/64, /*seed=*/29);
+    std::vector<float> policy(kNumActions);
+    float value;
+
+    unsigned const kNumReferenceRuns = 16;
+    auto reference_start = std::chrono::high_resolution_clock::now();
+    for (unsigned i = 0; i < kNumReferenceRuns; ++i) {
+        ReferenceRun(weights, boards[i], &policy, &value);
+    }
+    auto reference_end = std::chrono::high_resolution_clock::now();
+    double reference_secs = std::chrono::duration<double>(reference_end - reference_start).count();
+
+    std::cout << "NativeCnnBenchmark: instruction_set=" << e8::NativeCnnInstructionSet()
+              << " reference_us_per_board=" << reference_secs * 1e6 / kNumReferenceRuns
+              << std::endl;
+
+    for (e8::NativeCnnPrecision precision : {e8::NCP_FLOAT32, e8::NCP_INT8}) {
+        e8::NativeCnnModel model(weights, precision);
+
+        unsigned const kNumRuns = 2000;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (unsigned i = 0; i < kNumRuns; ++i) {
+            TestBoard const &board = boards[i % boards.size()];
+            model.Run(board.stones.data(), board.game_phase, board.next_move_stone_type,
+                      policy.data(), &value);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double secs = std::chrono::duration<double>(end - start).count();
+
+        std::cout << "NativeCnnBenchmark: precision="
+                  << (precision == e8::NCP_INT8 ? "int8" : "float32")
+                  << " us_per_board=" << secs * 1e6 / kNumRuns
+                  << " boards_per_sec=" << kNumRuns / secs << std::endl;
+    }
+
+    return true;
+}
+
+int main() {
+    e8::BeginTestSuite("native_cnn");
+    e8::RunTest("FloatMatchesReferenceTest", FloatMatchesReferenceTest);
+    e8::RunTest("Int8CloseToFloatTest", Int8CloseToFloatTest);
+    e8::RunTest("WeightFileRoundTripTest", WeightFileRoundTripTest);
+    e8::RunTest("NativeCnnBenchmark", NativeCnnBenchmark);
+    e8::EndTestSuite();
+    return 0;
+}
@@ -0,0 +1,265 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/unit_test_util/unit_test_util.h"
+#include "gomoku/agent/heuristics/batch_inference_server.h"
+#include "gomoku/agent/heuristics/native_cnn.h"
+#include "gomoku/agent/heuristics/native_zero_prior_evaluator.h"
+#include "gomoku/agent/heuristics/tf_zero_prior_evaluator.h"
+#include "gomoku/agent/heuristics/tflite_zero_prior_evaluator.h"
+#include "gomoku/agent/search/mct_search.h"
+#include "gomoku/agent/search/policy.h"
+#include "gomoku/game/board_state.h"
+
+namespace {
+
+std::string const kTfModelPath = "./gomoku/agent_classroom/tfmodel/gomoku_cnn_shared_i11";
+std::string const kTfliteModelPath =
+    "./gomoku/agent_classroom/tfmodel/gomoku_cnn_shared_i11.tflite";
+std::string const kNativeModelPath = "./gomoku/agent_classroom/tfmodel/gomoku_cnn_shared_i11.e8nn";
+
+/**
+ * @brief WriteRandomModel Writes an untrained model shaped like cnn_shared_model.
+ */
+std::string WriteRandomModel() {
+    std::mt19937 random_engine(31);
+    auto tensor = [&random_engine](std::vector<unsigned> const &dims, float stddev) {
+        e8::NativeCnnTensor tensor;
+        tensor.dims = dims;
+        unsigned size = 1;
+        for (unsigned dim : dims) {
+            size *= dim;
+        }
+        std::normal_distribution<float> distribution(0.0f, stddev);
+        for (unsigned i = 0; i < size; ++i) {
+            tensor.values.push_back(distribution(random_engine));
+        }
+        return tensor;
+    };
+
+    e8::NativeCnnWeights weights;
+    weights.board_width = 11;
+    weights.board_height = 11;
+    weights.tensors = {tensor({5, 5, 10, 32}, 0.09f),  tensor({32}, 0.1f),
+                       tensor({3, 3, 32, 64}, 0.08f),  tensor({64}, 0.1f),
+                       tensor({3, 3, 64, 128}, 0.06f), tensor({128}, 0.1f),
+                       tensor({32}, 0.1f),             tensor({64}, 0.1f),
+                       tensor({128}, 0.1f),            tensor({1, 1, 128, 4}, 0.12f),
+                       tensor({4}, 0.1f),              tensor({4}, 0.1f),
+                       tensor({484, 126}, 0.06f),      tensor({126}, 0.1f),
+                       tensor({1, 1, 128, 2}, 0.12f),  tensor({2}, 0.1f),
+                       tensor({2}, 0.1f),              tensor({242, 64}, 0.09f),
+                       tensor({64}, 0.1f),             tensor({64, 1}, 0.17f),
+                       tensor({1}, 0.1f)};
+
+    std::string path = "/tmp/test_native_zero_prior_evaluator.e8nn";
+    e8::SaveNativeCnnWeights(weights, path);
+    return path;
+}
+
+std::vector<e8::GomokuBoardState> RandomBoards(unsigned num_boards) {
+    std::mt19937 random_engine(37);
+
+    std::vector<e8::GomokuBoardState> boards;
+    for (unsigned i = 0; i < num_boards; ++i) {
+        e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
+        for (unsigned j = 0; j < 10 + i % 30 && board.CurrentGameResult() == e8::GR_UNDETERMINED;
+             ++j) {
+            e8::GomokuActionSet actions = board.LegalActions();
+            auto it = actions.begin();
+            std::advance(it, random_engine() % actions.size());
+            board.ApplyAction(it->first, /*cached_game_result=*/std::nullopt);
+        }
+        if (board.CurrentGameResult() == e8::GR_UNDETERMINED) {
+            boards.push_back(board);
+        }
+    }
+    return boards;
+}
+
+} // namespace
+
+bool EvaluatorMatchesEngineTest() {
+    std::string model_path = WriteRandomModel();
+    e8::NativeCnnModel model(e8::LoadNativeCnnWeights(model_path), e8::NCP_FLOAT32);
+    e8::GomokuNativeZeroPriorEvaluator evaluator(model_path);
+
+    e8::MctNodeId state_id = 0;
+    for (e8::GomokuBoardState const &board : RandomBoards(/*num_boards=*/10)) {
+        std::vector<uint8_t> stones(board.Width() * board.Height());
+        for (int16_t y = 0; y < board.Height(); ++y) {
+            for (int16_t x = 0; x < board.Width(); ++x) {
+                stones[y + x * board.Height()] = *board.ChessPieceStateAt(e8::MovePosition(x, y));
+            }
+        }
+
+        std::vector<float> expected_policy(model.NumActions());
+        float expected_value;
+        model.Run(stones.data(), board.CurrentGamePhase(),
+                  board.PlayerStoneType(board.CurrentPlayerSide()), expected_policy.data(),
+                  &expected_value);
+
+        float reward = evaluator.EvaluateReward(board, /*parent_state_id=*/std::nullopt, state_id);
+        TEST_CONDITION(std::abs(reward - expected_value) < 1e-6f);
+
+        e8::GomokuPolicy policy;
+        evaluator.EvaluatePolicy(board, /*parent_state_id=*/std::nullopt, state_id, &policy);
+
+        float legal_mass = 0.0f;
+        for (auto const &[action_id, _] : board.LegalActions()) {
+            legal_mass += expected_policy[action_id];
+        }
+        for (auto const &[action_id, _] : board.LegalActions()) {
+            TEST_CONDITION(std::abs(policy[action_id] - expected_policy[action_id] / legal_mass) <
+                           1e-5f);
+        }
+
+        ++state_id;
+    }
+
+    return true;
+}
+
+bool EvaluationResultPythonConsistencyTest() {
+    e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
+
+    // Same board as the tf_zero_prior_evaluator test, so that the exported weights are expected to
+    // produce the same outputs as the saved model.
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/3, /*y=*/4)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/5, /*y=*/6)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/3, /*y=*/3)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.Swap2DecisionToActionId(e8::Swap2Decision::SW2D_CHOOSE_BLACK),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/4, /*y=*/3)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/0, /*y=*/4)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/5, /*y=*/3)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/9, /*y=*/1)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/5, /*y=*/4)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/1, /*y=*/6)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/5, /*y=*/5)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/2, /*y=*/7)),
+                      /*cached_game_result=*/std::nullopt);
+
+    e8::GomokuNativeZeroPriorEvaluator evaluator(kNativeModelPath);
+
+    float reward =
+        evaluator.EvaluateReward(board, /*parent_state_id=*/std::nullopt, /*state_id=*/3);
+    TEST_CONDITION(std::abs(reward - 0.62968427f) < 1e-2f);
+
+    e8::GomokuPolicy policy;
+    evaluator.EvaluatePolicy(board, /*parent_state_id=*/std::nullopt, /*state_id=*/3, &policy);
+    e8::GomokuActionId best_action_id = e8::BestAction(policy);
+    TEST_CONDITION(best_action_id ==
+                   board.MovePositionToActionId(e8::MovePosition(/*x=*/4, /*y=*/5)));
+
+    return true;
+}
+
+bool InferenceBackendBenchmark() {
+    std::string native_model_path =
+        std::filesystem::exists(kNativeModelPath) ? kNativeModelPath : WriteRandomModel();
+
+    struct Backend {
+        std::string name;
+        std::string model_path;
+        std::function<std::unique_ptr<e8::GomokuInferenceModelInterface>()> load;
+    };
+    std::vector<Backend> backends = {
+        {"native_float32", native_model_path,
+         [&native_model_path]() {
+             return e8::LoadNativeZeroPriorModel(native_model_path, e8::NCP_FLOAT32);
+         }},
+        {"native_int8", native_model_path,
+         [&native_model_path]() {
+             return e8::LoadNativeZeroPriorModel(native_model_path, e8::NCP_INT8);
+         }},
+        {"tf", kTfModelPath, []() { return e8::LoadTfZeroPriorModel(kTfModelPath); }},
+        {"tflite", kTfliteModelPath,
+         []() { return e8::LoadTfliteZeroPriorModel(kTfliteModelPath); }},
+    };
+
+    std::vector<e8::GomokuBoardState> boards = RandomBoards(/*num_boards=*/64);
+    std::cout << "InferenceBackendBenchmark: instruction_set=" << e8::NativeCnnInstructionSet()
+              << " num_boards=" << boards.size() << std::endl;
+
+    for (Backend const &backend : backends) {
+        if (!std::filesystem::exists(backend.model_path)) {
+            std::cout << "InferenceBackendBenchmark: backend=" << backend.name
+                      << " skipped, missing " << backend.model_path << std::endl;
+            continue;
+        }
+
+        std::unique_ptr<e8::GomokuInferenceModelInterface> model = backend.load();
+
+        for (unsigned batch_size : {1U, 16U}) {
+            std::vector<e8::GomokuInferenceRequest> batch(batch_size);
+            std::vector<e8::GomokuInferenceResult> results(batch_size);
+
+            unsigned const kNumBatches = 256 / batch_size;
+            auto start = std::chrono::high_resolution_clock::now();
+            for (unsigned i = 0; i < kNumBatches; ++i) {
+                for (unsigned j = 0; j < batch_size; ++j) {
+                    batch[j].state = &boards[(i * batch_size + j) % boards.size()];
+                    batch[j].features = nullptr;
+                }
+                model->Infer(batch, &results);
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            double secs = std::chrono::duration<double>(end - start).count();
+
+            std::cout << "InferenceBackendBenchmark: backend=" << backend.name
+                      << " batch_size=" << batch_size
+                      << " us_per_batch=" << secs * 1e6 / kNumBatches
+                      << " boards_per_sec=" << kNumBatches * batch_size / secs << std::endl;
+        }
+    }
+
+    return true;
+}
+
+int main() {
+    e8::BeginTestSuite("native_zero_prior_evaluator");
+    e8::RunTest("EvaluatorMatchesEngineTest", EvaluatorMatchesEngineTest);
+    // Requires export_native_model.py to be run over gomoku_cnn_shared_i11 first.
+    // e8::RunTest("EvaluationResultPythonConsistencyTest", EvaluationResultPythonConsistencyTest);
+    e8::RunTest("InferenceBackendBenchmark", InferenceBackendBenchmark);
+    e8::EndTestSuite();
+    return 0;
+}
@@ -16,9 +16,11 @@
  */
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <iostream>
 #include <optional>
+#include <random>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -238,6 +240,242 @@ bool ShlFeatureBuilderCacheMissingParentTest() {
     return true;
 }
 
+// Plays random stones onto the board until the game ends or the board has num_stones stones.
+void PlayRandomStones(unsigned num_stones, std::mt19937 *random_engine,
+                      e8::GomokuBoardState *board) {
+    unsigned placed = 0;
+    while (placed < num_stones && board->CurrentGameResult() == e8::GR_UNDETERMINED) {
+        e8::GomokuActionSet actions = board->LegalActions();
+        auto it = actions.begin();
+        std::advance(it, (*random_engine)() % actions.size());
+
+        board->ApplyAction(it->first, /*cached_game_result=*/std::nullopt);
+        if (board->LastAction()->action.second.stone_pos.has_value()) {
+            ++placed;
+        }
+    }
+}
+
+std::vector<e8::MovePosition> EmptyPositions(e8::GomokuBoardState const &board) {
+    std::vector<e8::MovePosition> positions;
+    for (int8_t y = 0; y < board.Height(); ++y) {
+        for (int8_t x = 0; x < board.Width(); ++x) {
+            if (*board.ChessPieceStateAt(e8::MovePosition(x, y)) == e8::StoneType::ST_NONE) {
+                positions.push_back(e8::MovePosition(x, y));
+            }
+        }
+    }
+    return positions;
+}
+
+bool ShlCountsMatchReferenceTest() {
+    std::mt19937 random_engine(13);
+
+    for (unsigned game = 0; game < 200; ++game) {
+        e8::GomokuBoardState board(/*width=*/game % 2 == 0 ? 11 : 15,
+                                   /*height=*/game % 2 == 0 ? 11 : 15);
+        PlayRandomStones(/*num_stones=*/game % 60, &random_engine, &board);
+
+        std::vector<e8::MovePosition> positions = EmptyPositions(board);
+        std::vector<e8::ShlComponents> counts;
+        e8::ComputeShlCounts(e8::ShlLineGrid(board), positions, &counts);
+
+        TEST_CONDITION(counts.size() == positions.size());
+        for (unsigned i = 0; i < positions.size(); ++i) {
+            e8::ShlComponents expected = e8::ReferenceShlCounts(positions[i], board);
+            TEST_CONDITION(counts[i].primary_shl_count_black == expected.primary_shl_count_black);
+            TEST_CONDITION(counts[i].secondary_shl_count_black ==
+                           expected.secondary_shl_count_black);
+            TEST_CONDITION(counts[i].primary_shl_count_white == expected.primary_shl_count_white);
+            TEST_CONDITION(counts[i].secondary_shl_count_white ==
+                           expected.secondary_shl_count_white);
+        }
+    }
+
+    return true;
+}
+
+bool RandomIncrementalShlFeatureTest() {
+    std::mt19937 random_engine(7);
+
+    for (unsigned game = 0; game < 20; ++game) {
+        e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
+        e8::ShlFeatureBuilder features_builder(board);
+
+        while (board.CurrentGameResult() == e8::GR_UNDETERMINED) {
+            PlayRandomStones(/*num_stones=*/1, &random_engine, &board);
+            features_builder.AddStone(board);
+
+            auto feature_map = features_builder.TopKMapDense(
+                /*top_k=*/121, /*normalized=*/false, /*next_move_stone_type=*/std::nullopt);
+            auto ground_truth_feature_map = e8::ShlFeatureBuilder(board).TopKMapDense(
+                /*top_k=*/121, /*normalized=*/false, /*next_move_stone_type=*/std::nullopt);
+            TEST_CONDITION(feature_map == ground_truth_feature_map);
+        }
+    }
+
+    return true;
+}
+
+bool TopKPlanesTest() {
+    std::mt19937 random_engine(11);
+
+    for (unsigned game = 0; game < 5; ++game) {
+        e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
+        e8::ShlFeatureBuilder features_builder(board);
+
+        while (board.CurrentGameResult() == e8::GR_UNDETERMINED) {
+            PlayRandomStones(/*num_stones=*/1, &random_engine, &board);
+            features_builder.AddStone(board);
+
+            std::vector<float> dense_map = features_builder.TopKMapDense(
+                /*top_k=*/15, /*normalized=*/true, /*next_move_stone_type=*/std::nullopt);
+            std::vector<float> planes(11 * 11 * 4, -1.0f);
+            features_builder.WriteTopKPlanes(/*top_k=*/15, /*normalized=*/true,
+                                             /*next_move_stone_type=*/std::nullopt,
+                                             planes.data());
+
+            for (unsigned y = 0; y < 11; ++y) {
+                for (unsigned x = 0; x < 11; ++x) {
+                    for (unsigned i = 0; i < 4; ++i) {
+                        TEST_CONDITION(planes[(y + x * 11) * 4 + i] ==
+                                       dense_map[(x + y * 11) * 4 + i]);
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+bool ShlFeatureBuilderForkTest() {
+    std::mt19937 random_engine(13);
+
+    for (unsigned game = 0; game < 20; ++game) {
+        e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
+        PlayRandomStones(/*num_stones=*/game % 10, &random_engine, &board);
+        e8::ShlFeatureBuilder const start_builder(board);
+
+        auto original_feature_map = start_builder.TopKMapDense(
+            /*top_k=*/121, /*normalized=*/false, /*next_move_stone_type=*/std::nullopt);
+
+        // Plays out two rollouts from the same start, the way the rollout evaluator forks them.
+        unsigned num_start_actions = board.History().size();
+        e8::ShlFeatureBuilder features_builder = start_builder;
+        for (unsigned rollout = 0; rollout < 2; ++rollout) {
+            features_builder = start_builder;
+            while (board.CurrentGameResult() == e8::GR_UNDETERMINED) {
+                PlayRandomStones(/*num_stones=*/1, &random_engine, &board);
+                features_builder.AddStone(board);
+            }
+
+            TEST_CONDITION(features_builder.TopKMapDense(/*top_k=*/121, /*normalized=*/false,
+                                                         /*next_move_stone_type=*/std::nullopt) ==
+                           e8::ShlFeatureBuilder(board).TopKMapDense(
+                               /*top_k=*/121, /*normalized=*/false,
+                               /*next_move_stone_type=*/std::nullopt));
+
+            while (board.History().size() > num_start_actions) {
+                board.RetractAction();
+            }
+        }
+
+        // Forks don't touch the builder they were copied from.
+        TEST_CONDITION(start_builder.TopKMapDense(/*top_k=*/121, /*normalized=*/false,
+                                                  /*next_move_stone_type=*/std::nullopt) ==
+                       original_feature_map);
+    }
+
+    return true;
+}
+
+bool ShlCountsBenchmark() {
+    std::mt19937 random_engine(29);
+
+    std::vector<e8::GomokuBoardState> boards;
+    for (unsigned i = 0; i < 64; ++i) {
+        e8::GomokuBoardState board(/*width=*/15, /*height=*/15);
+        PlayRandomStones(/*num_stones=*/20 + i % 20, &random_engine, &board);
+        boards.push_back(board);
+    }
+
+    unsigned const kNumRounds = 20;
+    unsigned num_positions = 0;
+    float reference_checksum = 0.0f;
+    float kernel_checksum = 0.0f;
+
+    auto reference_start = std::chrono::high_resolution_clock::now();
+    for (unsigned round = 0; round < kNumRounds; ++round) {
+        for (auto const &board : boards) {
+            for (auto const &pos : EmptyPositions(board)) {
+                reference_checksum += e8::ToShlScore(e8::ReferenceShlCounts(pos, board));
+                ++num_positions;
+            }
+        }
+    }
+    auto reference_end = std::chrono::high_resolution_clock::now();
+
+    std::vector<e8::ShlComponents> counts;
+    auto kernel_start = std::chrono::high_resolution_clock::now();
+    for (unsigned round = 0; round < kNumRounds; ++round) {
+        for (auto const &board : boards) {
+            e8::ComputeShlCounts(e8::ShlLineGrid(board), EmptyPositions(board), &counts);
+            for (auto const &count : counts) {
+                kernel_checksum += e8::ToShlScore(count);
+            }
+        }
+    }
+    auto kernel_end = std::chrono::high_resolution_clock::now();
+
+    TEST_CONDITION(kernel_checksum == reference_checksum);
+
+    double reference_secs = std::chrono::duration<double>(reference_end - reference_start).count();
+    double kernel_secs = std::chrono::duration<double>(kernel_end - kernel_start).count();
+    std::cout << "ShlCountsBenchmark: reference_positions_per_sec="
+              << num_positions / reference_secs
+              << " kernel_positions_per_sec=" << num_positions / kernel_secs << std::endl;
+
+    // Incremental updates, as done by the rollouts.
+    unsigned num_stones = 0;
+    auto builder_start = std::chrono::high_resolution_clock::now();
+    for (unsigned game = 0; game < 50; ++game) {
+        e8::GomokuBoardState board(/*width=*/15, /*height=*/15);
+        e8::ShlFeatureBuilder features_builder(board);
+        while (board.CurrentGameResult() == e8::GR_UNDETERMINED) {
+            PlayRandomStones(/*num_stones=*/1, &random_engine, &board);
+            features_builder.AddStone(board);
+            ++num_stones;
+        }
+    }
+    auto builder_end = std::chrono::high_resolution_clock::now();
+
+    double builder_secs = std::chrono::duration<double>(builder_end - builder_start).count();
+    std::cout << "ShlCountsBenchmark: builder_stones_per_sec=" << num_stones / builder_secs
+              << std::endl;
+
+    // Forking a mid-game builder for a one stone rollout.
+    e8::GomokuBoardState board(/*width=*/15, /*height=*/15);
+    PlayRandomStones(/*num_stones=*/30, &random_engine, &board);
+    e8::ShlFeatureBuilder features_builder(board);
+
+    e8::GomokuBoardState rollout_board = board;
+    PlayRandomStones(/*num_stones=*/1, &random_engine, &rollout_board);
+
+    unsigned const kNumForks = 20000;
+    auto fork_start = std::chrono::high_resolution_clock::now();
+    for (unsigned i = 0; i < kNumForks; ++i) {
+        e8::ShlFeatureBuilder fork = features_builder;
+        fork.AddStone(rollout_board);
+    }
+    auto fork_end = std::chrono::high_resolution_clock::now();
+
+    double fork_secs = std::chrono::duration<double>(fork_end - fork_start).count();
+    std::cout << "ShlCountsBenchmark: forks_per_sec=" << kNumForks / fork_secs << std::endl;
+
+    return true;
+}
+
 int main() {
     e8::BeginTestSuite("shl_feature");
     e8::RunTest("EmptyBoardShlFeatureTest", EmptyBoardShlFeatureTest);
@@ -246,6 +484,11 @@ int main() {
     e8::RunTest("ShlFeatureBuilderCacheStartsFromEmptyBoardTest",
                 ShlFeatureBuilderCacheStartsFromEmptyBoardTest);
     e8::RunTest("ShlFeatureBuilderCacheMissingParentTest", ShlFeatureBuilderCacheMissingParentTest);
+    e8::RunTest("ShlCountsMatchReferenceTest", ShlCountsMatchReferenceTest);
+    e8::RunTest("RandomIncrementalShlFeatureTest", RandomIncrementalShlFeatureTest);
+    e8::RunTest("TopKPlanesTest", TopKPlanesTest);
+    e8::RunTest("ShlFeatureBuilderForkTest", ShlFeatureBuilderForkTest);
+    e8::RunTest("ShlCountsBenchmark", ShlCountsBenchmark);
     e8::EndTestSuite();
     return 0;
 }
@@ -17,11 +17,11 @@
 
 #include <cmath>
 #include <optional>
-#include <unordered_map>
 
 #include "common/unit_test_util/unit_test_util.h"
 #include "gomoku/agent/heuristics/shl_model_evaluator.h"
 #include "gomoku/agent/search/mct_search.h"
+#include "gomoku/agent/search/policy.h"
 #include "gomoku/game/board_state.h"
 
 bool PolicyPredictionPythonConsistencyTest() {
@@ -69,8 +69,8 @@ bool PolicyPredictionPythonConsistencyTest() {
     e8::GomokuShlModelEvaluator evaluator(
         /*model_path=*/"./gomoku/agent_classroom/tfmodel/gomoku_cnn_shared_with_shl_i11");
 
-    std::unordered_map<e8::GomokuActionId, float> policy =
-        evaluator.EvaluatePolicy(board, /*parent_state_id=*/std::nullopt, /*state_id=*/3);
+    e8::GomokuPolicy policy;
+    evaluator.EvaluatePolicy(board, /*parent_state_id=*/std::nullopt, /*state_id=*/3, &policy);
     e8::GomokuActionId best_action_id = e8::BestAction(policy);
     TEST_CONDITION(best_action_id ==
                    board.MovePositionToActionId(e8::MovePosition(/*x=*/2, /*y=*/3)));
@@ -0,0 +1,128 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <optional>
+
+#include "common/unit_test_util/unit_test_util.h"
+#include "gomoku/agent/heuristics/shl_rollout_evaluator.h"
+#include "gomoku/agent/search/policy.h"
+#include "gomoku/game/board_state.h"
+
+e8::GomokuBoardState PlayerAFavoredBoard() {
+    e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
+
+    // Player A (white) has an open four whereas player B (black) has scattered stones.
+    // - - - - - - - - - - -
+    // - - - - - - - - - - -
+    // - - x - - - - - - - -
+    // - - - - - - - - - - -
+    // - - - - - - - - x - -
+    // - - o o o o - - - - -
+    // - - - - - - - - - - -
+    // - - - - - - - - - - -
+    // - - - - - - - - x - -
+    // - - - - - - - - - - -
+    // x - - - - - - - - - -
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/2, /*y=*/2)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/8, /*y=*/4)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/2, /*y=*/5)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.Swap2DecisionToActionId(e8::Swap2Decision::SW2D_CHOOSE_BLACK),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/3, /*y=*/5)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/8, /*y=*/8)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/4, /*y=*/5)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/0, /*y=*/10)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/5, /*y=*/5)),
+                      /*cached_game_result=*/std::nullopt);
+
+    return board;
+}
+
+bool RewardEvaluationTest() {
+    e8::GomokuBoardState board = PlayerAFavoredBoard();
+    e8::PlayerSide player_to_move = board.CurrentPlayerSide();
+
+    e8::GomokuShlRolloutEvaluator evaluator;
+    float reward = evaluator.EvaluateReward(board, /*parent_state_id=*/std::nullopt,
+                                            /*state_id=*/1);
+    TEST_CONDITION(reward >= -1.0f && reward <= 1.0f);
+
+    if (player_to_move == e8::PlayerSide::PS_PLAYER_A) {
+        TEST_CONDITION(reward > 0.0f);
+    } else {
+        TEST_CONDITION(reward < 0.0f);
+    }
+
+    return true;
+}
+
+bool RewardIndependentOfNumWorkersTest() {
+    e8::GomokuBoardState board = PlayerAFavoredBoard();
+    board.RetractAction();
+
+    e8::GomokuShlRolloutEvaluator single_worker_evaluator(/*num_workers=*/1, /*seed=*/7);
+    e8::GomokuShlRolloutEvaluator multi_worker_evaluator(/*num_workers=*/4, /*seed=*/7);
+
+    for (unsigned i = 0; i < 5; ++i) {
+        float single_worker_reward = single_worker_evaluator.EvaluateReward(
+            board, /*parent_state_id=*/std::nullopt, /*state_id=*/1);
+        float multi_worker_reward = multi_worker_evaluator.EvaluateReward(
+            board, /*parent_state_id=*/std::nullopt, /*state_id=*/1);
+        TEST_CONDITION(single_worker_reward == multi_worker_reward);
+    }
+
+    return true;
+}
+
+bool PolicyEvaluationTest() {
+    e8::GomokuBoardState board = PlayerAFavoredBoard();
+
+    e8::GomokuShlRolloutEvaluator evaluator(/*num_workers=*/2, /*seed=*/13);
+    e8::GomokuPolicy policy;
+    evaluator.EvaluatePolicy(board, /*parent_state_id=*/std::nullopt, /*state_id=*/1, &policy);
+
+    unsigned num_nonzero = 0;
+    float total = 0.0f;
+    for (unsigned i = 0; i < policy.NumActions(); ++i) {
+        TEST_CONDITION(policy[i] >= 0.0f);
+        if (policy[i] > 0.0f) {
+            TEST_CONDITION(board.LegalActions().find(i) != board.LegalActions().end());
+            ++num_nonzero;
+        }
+        total += policy[i];
+    }
+    TEST_CONDITION(num_nonzero > 0 && num_nonzero <= 15);
+    TEST_CONDITION(total > 0.99f && total < 1.01f);
+
+    return true;
+}
+
+int main() {
+    e8::BeginTestSuite("shl_rollout_evaluator");
+    e8::RunTest("RewardEvaluationTest", RewardEvaluationTest);
+    e8::RunTest("RewardIndependentOfNumWorkersTest", RewardIndependentOfNumWorkersTest);
+    e8::RunTest("PolicyEvaluationTest", PolicyEvaluationTest);
+    e8::EndTestSuite();
+    return 0;
+}
@@ -18,11 +18,11 @@
 #include <cmath>
 #include <memory>
 #include <optional>
-#include <unordered_map>
 
 #include "common/unit_test_util/unit_test_util.h"
 #include "gomoku/agent/heuristics/tf_zero_prior_evaluator.h"
 #include "gomoku/agent/search/mct_search.h"
+#include "gomoku/agent/search/policy.h"
 #include "gomoku/game/board_state.h"
 
 bool EvaluationResultPythonConsistencyTest() {
@@ -74,8 +74,8 @@ bool EvaluationResultPythonConsistencyTest() {
         evaluator.EvaluateReward(board, /*parent_state_id=*/std::nullopt, /*state_id=*/3);
     TEST_CONDITION(std::abs(reward - 0.62968427f) < 1e-2f);
 
-    std::unordered_map<e8::GomokuActionId, float> policy =
-        evaluator.EvaluatePolicy(board, /*parent_state_id=*/std::nullopt, /*state_id=*/3);
+    e8::GomokuPolicy policy;
+    evaluator.EvaluatePolicy(board, /*parent_state_id=*/std::nullopt, /*state_id=*/3, &policy);
     e8::GomokuActionId best_action_id = e8::BestAction(policy);
     TEST_CONDITION(best_action_id ==
                    board.MovePositionToActionId(e8::MovePosition(/*x=*/4, /*y=*/5)));
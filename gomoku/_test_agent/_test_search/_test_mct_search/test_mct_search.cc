@@ -15,20 +15,56 @@
  * not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <chrono>
+#include <cstdint>
+#include <iostream>
 #include <memory>
 #include <optional>
-#include <unordered_map>
+#include <thread>
 
 #include "common/unit_test_util/unit_test_util.h"
+#include "gomoku/agent/heuristics/evaluator.h"
 #include "gomoku/agent/heuristics/light_rollout_evaluator.h"
+#include "gomoku/agent/search/mct_node.h"
 #include "gomoku/agent/search/mct_search.h"
+#include "gomoku/agent/search/policy.h"
 #include "gomoku/game/board_state.h"
 
-bool Test1() {
-    auto evaluator = std::make_shared<e8::GomokuLightRolloutEvaluator>();
-    e8::MctSearcher searcher(std::static_pointer_cast<e8::GomokuEvaluatorInterface>(evaluator),
-                             /*print_stats=*/true);
+/**
+ * @brief The SyntheticEvaluator class A thread-safe evaluator which spends a fixed amount of work
+ * per evaluation, so that the search throughput doesn't depend on the evaluator's own parallelism.
+ */
+class SyntheticEvaluator : public e8::GomokuEvaluatorInterface {
+  public:
+    float EvaluateReward(e8::GomokuBoardState const &state,
+                         std::optional<e8::MctNodeId> /*parent_state_id*/,
+                         e8::MctNodeId state_id) override {
+        uint64_t h = static_cast<uint64_t>(state_id) ^ state.LegalActions().size();
+        for (unsigned i = 0; i < 20000; ++i) {
+            h = h * 6364136223846793005ULL + 1442695040888963407ULL;
+        }
+        return static_cast<float>(h >> 40) / (1 << 24) - 0.5f;
+    }
+
+    void EvaluatePolicy(e8::GomokuBoardState const &state,
+                        std::optional<e8::MctNodeId> /*parent_state_id*/,
+                        e8::MctNodeId /*state_id*/, e8::GomokuPolicy *policy) override {
+        policy->Reset(state);
+        for (auto const &[action_id, _] : state.LegalActions()) {
+            (*policy)[action_id] = 1.0f / state.LegalActions().size();
+        }
+    }
+
+    float ExplorationFactor() const override { return 2; }
 
+    unsigned NumSimulations() const override { return 20000; }
+
+    void ClearCache() override {}
+
+    bool ThreadSafe() const override { return true; }
+};
+
+void PlayThreatOpening(e8::MctSearcher *searcher, e8::GomokuBoardState *board) {
     // - - - - - - - - - - -
     // - - - - - - - - - - -
     // - - - - - - - - - - -
@@ -40,38 +76,337 @@ bool Test1() {
     // - - - - - - - - - - -
     // - - - - - - - - - - -
     // - - - - - - - - - - -
+    e8::GomokuActionId action_id =
+        board->MovePositionToActionId(e8::MovePosition(/*x=*/3, /*y=*/6));
+    searcher->SelectAction(*board, action_id);
+    board->ApplyAction(action_id, /*cached_game_result=*/std::nullopt);
+
+    action_id = board->MovePositionToActionId(e8::MovePosition(/*x=*/4, /*y=*/3));
+    searcher->SelectAction(*board, action_id);
+    board->ApplyAction(action_id, /*cached_game_result=*/std::nullopt);
+
+    action_id = board->MovePositionToActionId(e8::MovePosition(/*x=*/9, /*y=*/7));
+    searcher->SelectAction(*board, action_id);
+    board->ApplyAction(action_id, /*cached_game_result=*/std::nullopt);
+
+    action_id = board->Swap2DecisionToActionId(e8::Swap2Decision::SW2D_CHOOSE_WHITE);
+    searcher->SelectAction(*board, action_id);
+    board->ApplyAction(action_id, /*cached_game_result=*/std::nullopt);
+
+    action_id = board->MovePositionToActionId(e8::MovePosition(/*x=*/9, /*y=*/6));
+    searcher->SelectAction(*board, action_id);
+    board->ApplyAction(action_id, /*cached_game_result=*/std::nullopt);
+}
+
+bool Test1() {
+    auto evaluator = std::make_shared<e8::GomokuLightRolloutEvaluator>();
+    e8::MctSearcher searcher(std::static_pointer_cast<e8::GomokuEvaluatorInterface>(evaluator),
+                             /*print_stats=*/true);
+
+    e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
+    PlayThreatOpening(&searcher, &board);
+
+    e8::GomokuPolicy policy;
+    searcher.SearchFrom(board, /*temperature=*/1.0f, &policy);
+
+    e8::GomokuActionId best_action = e8::BestAction(policy);
+
+    TEST_CONDITION(best_action ==
+                       board.MovePositionToActionId(e8::MovePosition(/*x=*/9, /*y=*/5)) ||
+                   best_action == board.MovePositionToActionId(e8::MovePosition(/*x=*/9,
+                                                                                /*y=*/8)));
+    searcher.SelectAction(board, best_action);
+
+    return true;
+}
+
+bool NodeArenaTest() {
+    e8::MctNodeArena arena;
+
+    e8::MctNodeIndex root = arena.Allocate(/*count=*/1);
+    TEST_CONDITION(root == 0);
+    TEST_CONDITION(arena.Block(root).first_children[e8::BlockOffset(root)] ==
+                   e8::kNullMctNodeIndex);
+
+    // Sibling groups never straddle two blocks.
+    e8::MctNodeIndex last_group = root;
+    for (unsigned i = 0; i < 2 * e8::kMctNodeBlockSize / e8::kMaxMctNodeChildren; ++i) {
+        last_group = arena.Allocate(e8::kMaxMctNodeChildren - 1);
+        TEST_CONDITION(e8::BlockOffset(last_group) + e8::kMaxMctNodeChildren - 1 <=
+                       e8::kMctNodeBlockSize);
+    }
+    TEST_CONDITION(last_group >= e8::kMctNodeBlockSize);
+    TEST_CONDITION(arena.Size() == last_group + e8::kMaxMctNodeChildren - 1);
+
+    e8::MctNodeId root_id = arena.Id(root);
+    TEST_CONDITION(root_id != 0);
+
+    // Clearing releases everything at once, while the node IDs stay unique.
+    arena.Clear();
+    TEST_CONDITION(arena.Size() == 0);
+
+    root = arena.Allocate(/*count=*/1);
+    TEST_CONDITION(root == 0);
+    TEST_CONDITION(arena.Id(root) != root_id);
+    TEST_CONDITION(arena.Block(root).num_visits[e8::BlockOffset(root)] == 0);
+
+    return true;
+}
+
+bool SubtreeReuseTest() {
+    auto evaluator = std::make_shared<SyntheticEvaluator>();
+    e8::MctSearcher searcher(std::static_pointer_cast<e8::GomokuEvaluatorInterface>(evaluator),
+                             /*print_stats=*/false);
+
     e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
-    e8::GomokuActionId action_id = board.MovePositionToActionId(e8::MovePosition(/*x=*/3, /*y=*/6));
-    searcher.SelectAction(board, action_id);
-    board.ApplyAction(action_id, /*cached_game_result=*/std::nullopt);
+    PlayThreatOpening(&searcher, &board);
 
-    action_id = board.MovePositionToActionId(e8::MovePosition(/*x=*/4, /*y=*/3));
-    searcher.SelectAction(board, action_id);
-    board.ApplyAction(action_id, /*cached_game_result=*/std::nullopt);
+    // Plays a few moves on each side to go through compaction of the surviving subtrees.
+    for (unsigned i = 0; i < 4; ++i) {
+        e8::GomokuPolicy policy;
+        searcher.SearchFrom(board, /*temperature=*/1.0f, &policy);
+        TEST_CONDITION(static_cast<int>(policy.NumActions()) == board.ActionIdRange().second + 1);
 
-    action_id = board.MovePositionToActionId(e8::MovePosition(/*x=*/9, /*y=*/7));
-    searcher.SelectAction(board, action_id);
-    board.ApplyAction(action_id, /*cached_game_result=*/std::nullopt);
+        e8::GomokuActionId best_action = e8::BestAction(policy);
+        TEST_CONDITION(board.LegalActions().find(best_action) != board.LegalActions().end());
 
-    action_id = board.Swap2DecisionToActionId(e8::Swap2Decision::SW2D_CHOOSE_WHITE);
-    searcher.SelectAction(board, action_id);
-    board.ApplyAction(action_id, /*cached_game_result=*/std::nullopt);
+        searcher.SelectAction(board, best_action);
+        board.ApplyAction(best_action, /*cached_game_result=*/std::nullopt);
+    }
 
-    action_id = board.MovePositionToActionId(e8::MovePosition(/*x=*/9, /*y=*/6));
-    searcher.SelectAction(board, action_id);
-    board.ApplyAction(action_id, /*cached_game_result=*/std::nullopt);
+    return true;
+}
+
+bool TreeParallelSearchTest() {
+    auto evaluator = std::make_shared<e8::GomokuLightRolloutEvaluator>();
+    e8::MctSearcher searcher(std::static_pointer_cast<e8::GomokuEvaluatorInterface>(evaluator),
+                             /*print_stats=*/false, /*num_workers=*/4);
+
+    e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
+    PlayThreatOpening(&searcher, &board);
+
+    // Extends both sides to an open four. White moves next and must win immediately.
+    for (e8::MovePosition const &pos :
+         {e8::MovePosition(/*x=*/3, /*y=*/1), e8::MovePosition(/*x=*/9, /*y=*/5),
+          e8::MovePosition(/*x=*/4, /*y=*/1), e8::MovePosition(/*x=*/9, /*y=*/8),
+          e8::MovePosition(/*x=*/5, /*y=*/1), e8::MovePosition(/*x=*/0, /*y=*/10),
+          e8::MovePosition(/*x=*/6, /*y=*/1)}) {
+        e8::GomokuActionId action_id = board.MovePositionToActionId(pos);
+        searcher.SelectAction(board, action_id);
+        board.ApplyAction(action_id, /*cached_game_result=*/std::nullopt);
+    }
 
-    e8::GomokuLightRolloutEvaluator eval;
-    std::unordered_map<e8::GomokuActionId, float> policy =
-        searcher.SearchFrom(board, /*temperature=*/1.0f);
+    e8::GomokuPolicy policy;
+    searcher.SearchFrom(board, /*temperature=*/1.0f, &policy);
 
     e8::GomokuActionId best_action = e8::BestAction(policy);
 
+    TEST_CONDITION(best_action ==
+                       board.MovePositionToActionId(e8::MovePosition(/*x=*/9, /*y=*/4)) ||
+                   best_action == board.MovePositionToActionId(e8::MovePosition(/*x=*/9,
+                                                                                /*y=*/9)));
+    searcher.SelectAction(board, best_action);
+    board.ApplyAction(best_action, /*cached_game_result=*/std::nullopt);
+
+    TEST_CONDITION(board.CurrentGameResult() != e8::GameResult::GR_UNDETERMINED);
+
+    return true;
+}
+
+bool LazyExpansionTest() {
+    auto evaluator = std::make_shared<e8::GomokuLightRolloutEvaluator>();
+    e8::MctSearcher searcher(std::static_pointer_cast<e8::GomokuEvaluatorInterface>(evaluator),
+                             /*print_stats=*/false, /*num_workers=*/2,
+                             /*lazy_expansion=*/true);
+
+    e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
+    PlayThreatOpening(&searcher, &board);
+
+    e8::GomokuPolicy policy;
+    searcher.SearchFrom(board, /*temperature=*/1.0f, &policy);
+
+    e8::GomokuActionId best_action = e8::BestAction(policy);
     TEST_CONDITION(best_action ==
                        board.MovePositionToActionId(e8::MovePosition(/*x=*/9, /*y=*/5)) ||
                    best_action == board.MovePositionToActionId(e8::MovePosition(/*x=*/9,
                                                                                 /*y=*/8)));
+
+    // The surviving subtree keeps its partially widened nodes through the compaction.
+    for (unsigned i = 0; i < 2; ++i) {
+        searcher.SelectAction(board, best_action);
+        board.ApplyAction(best_action, /*cached_game_result=*/std::nullopt);
+
+        searcher.SearchFrom(board, /*temperature=*/1.0f, &policy);
+        best_action = e8::BestAction(policy);
+        TEST_CONDITION(board.LegalActions().find(best_action) != board.LegalActions().end());
+    }
+
+    return true;
+}
+
+bool AnytimeSearchTest() {
+    auto evaluator = std::make_shared<SyntheticEvaluator>();
+    e8::MctSearcher searcher(std::static_pointer_cast<e8::GomokuEvaluatorInterface>(evaluator),
+                             /*print_stats=*/false, /*num_workers=*/2);
+
+    e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
+    PlayThreatOpening(&searcher, &board);
+
+    // A node budget, then resuming the search adds to the statistics.
+    e8::MctSearchBudget budget;
+    budget.num_simulations = 200;
+    searcher.Search(board, budget);
+    unsigned num_root_visits = searcher.NumRootVisits();
+    TEST_CONDITION(num_root_visits > 0 && num_root_visits <= 200);
+
+    searcher.Search(board, budget);
+    TEST_CONDITION(searcher.NumRootVisits() > num_root_visits);
+    num_root_visits = searcher.NumRootVisits();
+
+    // A wall-clock budget.
+    e8::MctSearchBudget time_budget;
+    time_budget.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(50);
+    auto start = std::chrono::steady_clock::now();
+    searcher.Search(board, time_budget);
+    TEST_CONDITION(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+    TEST_CONDITION(searcher.NumRootVisits() > num_root_visits);
+
+    e8::GomokuPolicy policy;
+    searcher.ExtractPolicy(board, /*temperature=*/1.0f, &policy);
+    e8::GomokuActionId best_action = e8::BestAction(policy);
     searcher.SelectAction(board, best_action);
+    board.ApplyAction(best_action, /*cached_game_result=*/std::nullopt);
+
+    // Ponders during the opponent's turn, then carries the subtree of the opponent's move over. The
+    // opponent plays the reply the pondering explored the most, so that its subtree isn't empty.
+    searcher.StartPondering(board);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    searcher.StopPondering();
+
+    searcher.ExtractPolicy(board, /*temperature=*/1.0f, &policy);
+    e8::GomokuActionId opponent_action = e8::BestAction(policy);
+    searcher.SelectAction(board, opponent_action);
+    board.ApplyAction(opponent_action, /*cached_game_result=*/std::nullopt);
+    TEST_CONDITION(searcher.NumRootVisits() > 0);
+
+    // Pondering which gets stopped right away leaves the searcher usable.
+    searcher.StartPondering(board);
+    searcher.StopPondering();
+    searcher.SearchFrom(board, /*temperature=*/1.0f, &policy);
+    TEST_CONDITION(board.LegalActions().find(e8::BestAction(policy)) != board.LegalActions().end());
+
+    return true;
+}
+
+bool RootSimulationCountTest() {
+    auto evaluator = std::make_shared<SyntheticEvaluator>();
+    e8::MctSearcher searcher(std::static_pointer_cast<e8::GomokuEvaluatorInterface>(evaluator),
+                             /*print_stats=*/false, /*num_workers=*/2);
+
+    e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
+    PlayThreatOpening(&searcher, &board);
+
+    // The workers' overshooting budget claims aren't counted.
+    e8::MctSearchBudget budget;
+    budget.num_simulations = 2000;
+    searcher.Search(board, budget);
+    TEST_CONDITION(searcher.NumRootSimulations() == 2000);
+
+    // The simulations which went through the selected child are carried over.
+    e8::GomokuPolicy policy;
+    searcher.ExtractPolicy(board, /*temperature=*/1.0f, &policy);
+    e8::GomokuActionId best_action = e8::BestAction(policy);
+    searcher.SelectAction(board, best_action);
+    board.ApplyAction(best_action, /*cached_game_result=*/std::nullopt);
+    unsigned const num_carried_simulations = searcher.NumRootSimulations();
+    TEST_CONDITION(num_carried_simulations > 0 && num_carried_simulations < 2000);
+
+    budget.num_simulations = 100;
+    searcher.Search(board, budget);
+    TEST_CONDITION(searcher.NumRootSimulations() == num_carried_simulations + 100);
+
+    searcher.Reset();
+    TEST_CONDITION(searcher.NumRootSimulations() == 0);
+
+    return true;
+}
+
+bool ThreatSolverSearchTest() {
+    auto evaluator = std::make_shared<SyntheticEvaluator>();
+    e8::MctSearcher searcher(std::static_pointer_cast<e8::GomokuEvaluatorInterface>(evaluator),
+                             /*print_stats=*/false);
+
+    // - - - - - - - - - - -
+    // - - - - - - - - - - -
+    // - - - - - - - - - - -
+    // - - o x x x * - - - -
+    // - - - - - - x - - - -
+    // - - - - - - x - - - -
+    //
+    // Black wins by a four at * followed by an open four in the column.
+    e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
+    auto play = [&searcher, &board](e8::GomokuActionId action_id) {
+        searcher.SelectAction(board, action_id);
+        board.ApplyAction(action_id, /*cached_game_result=*/std::nullopt);
+    };
+    play(board.MovePositionToActionId(e8::MovePosition(/*x=*/3, /*y=*/3)));
+    play(board.MovePositionToActionId(e8::MovePosition(/*x=*/4, /*y=*/3)));
+    play(board.MovePositionToActionId(e8::MovePosition(/*x=*/2, /*y=*/3)));
+    play(board.Swap2DecisionToActionId(e8::Swap2Decision::SW2D_CHOOSE_WHITE));
+    for (e8::MovePosition const &pos :
+         {e8::MovePosition(/*x=*/0, /*y=*/10), e8::MovePosition(/*x=*/5, /*y=*/3),
+          e8::MovePosition(/*x=*/10, /*y=*/10), e8::MovePosition(/*x=*/6, /*y=*/4),
+          e8::MovePosition(/*x=*/10, /*y=*/0), e8::MovePosition(/*x=*/6, /*y=*/5),
+          e8::MovePosition(/*x=*/0, /*y=*/0)}) {
+        play(board.MovePositionToActionId(pos));
+    }
+
+    // The root is proven, so a small budget finds the winning move.
+    e8::MctSearchBudget budget;
+    budget.num_simulations = 64;
+    searcher.Search(board, budget);
+
+    e8::GomokuPolicy policy;
+    searcher.ExtractPolicy(board, /*temperature=*/1.0f, &policy);
+    e8::GomokuActionId best_action = e8::BestAction(policy);
+    TEST_CONDITION(best_action == board.MovePositionToActionId(e8::MovePosition(/*x=*/6, /*y=*/3)));
+    TEST_CONDITION(policy[best_action] > 0.9f);
+
+    // White's block is forced. The other moves lose to the five at the block.
+    play(best_action);
+    searcher.Search(board, budget);
+    searcher.ExtractPolicy(board, /*temperature=*/1.0f, &policy);
+    TEST_CONDITION(board.LegalActions().find(e8::BestAction(policy)) !=
+                   board.LegalActions().end());
+
+    return true;
+}
+
+bool TreeParallelScalingBenchmark() {
+    auto evaluator = std::make_shared<SyntheticEvaluator>();
+
+    for (unsigned num_workers : {1, 2, 4, 8}) {
+        e8::MctSearcher searcher(std::static_pointer_cast<e8::GomokuEvaluatorInterface>(evaluator),
+                                 /*print_stats=*/false, num_workers);
+
+        e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
+        PlayThreatOpening(&searcher, &board);
+
+        auto start = std::chrono::steady_clock::now();
+        e8::GomokuPolicy policy;
+        searcher.SearchFrom(board, /*temperature=*/1.0f, &policy);
+        auto end = std::chrono::steady_clock::now();
+
+        float total_mass = 0.0f;
+        for (unsigned i = 0; i < policy.NumActions(); ++i) {
+            total_mass += policy[i];
+        }
+        TEST_CONDITION(total_mass > 0.99f && total_mass < 1.01f);
+
+        double secs = std::chrono::duration<double>(end - start).count();
+        std::cout << "TreeParallelScalingBenchmark: num_workers=" << num_workers
+                  << " simulations_per_sec=" << evaluator->NumSimulations() / secs << std::endl;
+    }
 
     return true;
 }
@@ -79,6 +414,14 @@ bool Test1() {
 int main() {
     e8::BeginTestSuite("mct_search");
     e8::RunTest("Test1", Test1);
+    e8::RunTest("NodeArenaTest", NodeArenaTest);
+    e8::RunTest("SubtreeReuseTest", SubtreeReuseTest);
+    e8::RunTest("TreeParallelSearchTest", TreeParallelSearchTest);
+    e8::RunTest("LazyExpansionTest", LazyExpansionTest);
+    e8::RunTest("AnytimeSearchTest", AnytimeSearchTest);
+    e8::RunTest("RootSimulationCountTest", RootSimulationCountTest);
+    e8::RunTest("ThreatSolverSearchTest", ThreatSolverSearchTest);
+    e8::RunTest("TreeParallelScalingBenchmark", TreeParallelScalingBenchmark);
     e8::EndTestSuite();
     return 0;
 }
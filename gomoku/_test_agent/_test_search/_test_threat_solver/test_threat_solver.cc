@@ -0,0 +1,230 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <optional>
+#include <vector>
+
+#include "common/unit_test_util/unit_test_util.h"
+#include "gomoku/agent/search/threat_solver.h"
+#include "gomoku/game/board_state.h"
+
+/**
+ * @brief BoardOf Places the opening stones in the order black, black, white, lets the second player
+ * choose white, then alternates white and black. There must be as many white stones as black
+ * stones when black is to move, and one less when white is to move.
+ */
+e8::GomokuBoardState BoardOf(std::vector<e8::MovePosition> const &black,
+                             std::vector<e8::MovePosition> const &white) {
+    e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
+    auto play = [&board](e8::MovePosition const &pos) {
+        board.ApplyAction(board.MovePositionToActionId(pos), /*cached_game_result=*/std::nullopt);
+    };
+
+    play(black[0]);
+    play(black[1]);
+    play(white[0]);
+    board.ApplyAction(board.Swap2DecisionToActionId(e8::Swap2Decision::SW2D_CHOOSE_WHITE),
+                      /*cached_game_result=*/std::nullopt);
+    for (unsigned i = 1; i < white.size(); ++i) {
+        play(white[i]);
+        if (i + 1 < black.size()) {
+            play(black[i + 1]);
+        }
+    }
+
+    return board;
+}
+
+bool MakeFiveTest() {
+    e8::GomokuBoardState board = BoardOf(
+        {e8::MovePosition(1, 1), e8::MovePosition(2, 1), e8::MovePosition(3, 1),
+         e8::MovePosition(4, 1)},
+        {e8::MovePosition(1, 5), e8::MovePosition(3, 5), e8::MovePosition(5, 5),
+         e8::MovePosition(7, 5)});
+    TEST_CONDITION(board.PlayerStoneType(board.CurrentPlayerSide()) == e8::ST_BLACK);
+
+    e8::ThreatSolution solution = e8::SolveThreats(board);
+    TEST_CONDITION(solution.proof == e8::TP_WIN);
+    TEST_CONDITION(solution.winning_action ==
+                       board.MovePositionToActionId(e8::MovePosition(0, 1)) ||
+                   solution.winning_action ==
+                       board.MovePositionToActionId(e8::MovePosition(5, 1)));
+
+    return true;
+}
+
+bool OverlineTest() {
+    // - - - - - - - - - - -
+    // x x x - x x - - - - -
+    //
+    // Filling the gap makes six in a row, which is a tie.
+    e8::GomokuBoardState board = BoardOf(
+        {e8::MovePosition(0, 1), e8::MovePosition(1, 1), e8::MovePosition(2, 1),
+         e8::MovePosition(4, 1), e8::MovePosition(5, 1)},
+        {e8::MovePosition(0, 9), e8::MovePosition(2, 9), e8::MovePosition(4, 9),
+         e8::MovePosition(6, 9), e8::MovePosition(8, 9)});
+    TEST_CONDITION(board.PlayerStoneType(board.CurrentPlayerSide()) == e8::ST_BLACK);
+
+    e8::ThreatSolution solution = e8::SolveThreats(board);
+    TEST_CONDITION(solution.proof == e8::TP_UNPROVEN);
+    TEST_CONDITION(!solution.winning_action.has_value());
+
+    return true;
+}
+
+bool OverlineEscapesLossTest() {
+    // White has an open four on row 5, but black ties by filling the gap on row 1.
+    e8::GomokuBoardState board = BoardOf(
+        {e8::MovePosition(0, 1), e8::MovePosition(1, 1), e8::MovePosition(2, 1),
+         e8::MovePosition(4, 1), e8::MovePosition(5, 1)},
+        {e8::MovePosition(2, 5), e8::MovePosition(3, 5), e8::MovePosition(4, 5),
+         e8::MovePosition(5, 5), e8::MovePosition(9, 9)});
+    TEST_CONDITION(board.PlayerStoneType(board.CurrentPlayerSide()) == e8::ST_BLACK);
+
+    e8::ThreatSolution solution = e8::SolveThreats(board);
+    TEST_CONDITION(solution.proof == e8::TP_UNPROVEN);
+
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(3, 1)),
+                      /*cached_game_result=*/std::nullopt);
+    TEST_CONDITION(board.CurrentGameResult() == e8::GR_TIE);
+
+    return true;
+}
+
+bool OverlineEscapesWinTest() {
+    // Black's open three would become an open four, but white ties by filling the gap on row 9.
+    e8::GomokuBoardState board = BoardOf(
+        {e8::MovePosition(4, 3), e8::MovePosition(5, 3), e8::MovePosition(6, 3),
+         e8::MovePosition(10, 0), e8::MovePosition(10, 10)},
+        {e8::MovePosition(0, 9), e8::MovePosition(1, 9), e8::MovePosition(2, 9),
+         e8::MovePosition(4, 9), e8::MovePosition(5, 9)});
+    TEST_CONDITION(board.PlayerStoneType(board.CurrentPlayerSide()) == e8::ST_BLACK);
+
+    e8::ThreatSolution solution = e8::SolveThreats(board);
+    TEST_CONDITION(solution.proof == e8::TP_UNPROVEN);
+
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(7, 3)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(3, 9)),
+                      /*cached_game_result=*/std::nullopt);
+    TEST_CONDITION(board.CurrentGameResult() == e8::GR_TIE);
+
+    return true;
+}
+
+bool OpenFourLossTest() {
+    // White has an open four and black can't make five.
+    e8::GomokuBoardState board = BoardOf(
+        {e8::MovePosition(0, 8), e8::MovePosition(0, 10), e8::MovePosition(10, 8),
+         e8::MovePosition(10, 10)},
+        {e8::MovePosition(2, 3), e8::MovePosition(3, 3), e8::MovePosition(4, 3),
+         e8::MovePosition(5, 3)});
+    TEST_CONDITION(board.PlayerStoneType(board.CurrentPlayerSide()) == e8::ST_BLACK);
+
+    e8::ThreatSolution solution = e8::SolveThreats(board);
+    TEST_CONDITION(solution.proof == e8::TP_LOSS);
+
+    return true;
+}
+
+std::vector<e8::MovePosition> FourThreeBlackStones() {
+    // - - - - - - - - - - -
+    // - - - - - - - - - - -
+    // - - - - - - - - - - -
+    // - - o x x x * - - - -
+    // - - - - - - x - - - -
+    // - - - - - - x - - - -
+    //
+    // Black fours at * and opens the column, then makes an open four after white blocks the row.
+    return {e8::MovePosition(3, 3), e8::MovePosition(4, 3), e8::MovePosition(5, 3),
+            e8::MovePosition(6, 4), e8::MovePosition(6, 5)};
+}
+
+bool VcfTest() {
+    e8::GomokuBoardState board =
+        BoardOf(FourThreeBlackStones(),
+                {e8::MovePosition(2, 3), e8::MovePosition(0, 10), e8::MovePosition(2, 10),
+                 e8::MovePosition(8, 10), e8::MovePosition(10, 0)});
+    TEST_CONDITION(board.PlayerStoneType(board.CurrentPlayerSide()) == e8::ST_BLACK);
+
+    e8::ThreatSolution solution = e8::SolveThreats(board);
+    TEST_CONDITION(solution.proof == e8::TP_WIN);
+    TEST_CONDITION(solution.winning_action ==
+                   board.MovePositionToActionId(e8::MovePosition(6, 3)));
+
+    // Follows the sequence. White's block is forced, then black has an open four.
+    board.ApplyAction(*solution.winning_action, /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(7, 3)),
+                      /*cached_game_result=*/std::nullopt);
+    solution = e8::SolveThreats(board);
+    TEST_CONDITION(solution.proof == e8::TP_WIN);
+    TEST_CONDITION(solution.winning_action ==
+                       board.MovePositionToActionId(e8::MovePosition(6, 2)) ||
+                   solution.winning_action ==
+                       board.MovePositionToActionId(e8::MovePosition(6, 6)));
+
+    // The search budget bounds the effort.
+    board.RetractAction();
+    board.RetractAction();
+    solution = e8::SolveThreats(board, /*max_nodes=*/1);
+    TEST_CONDITION(solution.proof == e8::TP_UNPROVEN);
+
+    return true;
+}
+
+bool BlockThenVcfLossTest() {
+    // Black also has a four on row 9. White has to block it, then black wins by the VCF of VcfTest.
+    std::vector<e8::MovePosition> black = FourThreeBlackStones();
+    for (int x = 2; x <= 5; ++x) {
+        black.push_back(e8::MovePosition(x, 9));
+    }
+    e8::GomokuBoardState board =
+        BoardOf(black, {e8::MovePosition(2, 3), e8::MovePosition(1, 9), e8::MovePosition(0, 0),
+                        e8::MovePosition(10, 0), e8::MovePosition(10, 10), e8::MovePosition(0, 6),
+                        e8::MovePosition(10, 5), e8::MovePosition(8, 10)});
+    TEST_CONDITION(board.PlayerStoneType(board.CurrentPlayerSide()) == e8::ST_WHITE);
+
+    e8::ThreatSolution solution = e8::SolveThreats(board);
+    TEST_CONDITION(solution.proof == e8::TP_LOSS);
+
+    return true;
+}
+
+bool UnprovenTest() {
+    e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
+    TEST_CONDITION(e8::SolveThreats(board).proof == e8::TP_UNPROVEN);
+
+    board = BoardOf({e8::MovePosition(3, 6), e8::MovePosition(9, 7)},
+                    {e8::MovePosition(4, 3), e8::MovePosition(9, 6)});
+    TEST_CONDITION(e8::SolveThreats(board).proof == e8::TP_UNPROVEN);
+
+    return true;
+}
+
+int main() {
+    e8::BeginTestSuite("threat_solver");
+    e8::RunTest("MakeFiveTest", MakeFiveTest);
+    e8::RunTest("OverlineTest", OverlineTest);
+    e8::RunTest("OverlineEscapesLossTest", OverlineEscapesLossTest);
+    e8::RunTest("OverlineEscapesWinTest", OverlineEscapesWinTest);
+    e8::RunTest("OpenFourLossTest", OpenFourLossTest);
+    e8::RunTest("VcfTest", VcfTest);
+    e8::RunTest("BlockThenVcfLossTest", BlockThenVcfLossTest);
+    e8::RunTest("UnprovenTest", UnprovenTest);
+    e8::EndTestSuite();
+    return 0;
+}
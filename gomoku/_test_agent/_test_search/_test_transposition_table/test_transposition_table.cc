@@ -0,0 +1,147 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "common/unit_test_util/unit_test_util.h"
+#include "gomoku/agent/search/transposition_table.h"
+#include "gomoku/game/board_state.h"
+
+bool FindOrInsertTest() {
+    e8::MctTranspositionTable table(/*capacity=*/64);
+
+    TEST_CONDITION(table.Find(42) == nullptr);
+
+    e8::MctTranspositionTable::Entry *entry = table.FindOrInsert(42);
+    TEST_CONDITION(entry != nullptr);
+    TEST_CONDITION(table.Find(42) == entry);
+    TEST_CONDITION(table.FindOrInsert(42) == entry);
+    TEST_CONDITION(table.Size() == 1);
+
+    // The zero hash is a valid state.
+    TEST_CONDITION(table.FindOrInsert(0) != nullptr);
+    TEST_CONDITION(table.Find(0) != nullptr);
+    TEST_CONDITION(table.Size() == 2);
+
+    table.Clear();
+    TEST_CONDITION(table.Size() == 0);
+    TEST_CONDITION(table.Find(42) == nullptr);
+
+    return true;
+}
+
+bool FullTableTest() {
+    e8::MctTranspositionTable table(/*capacity=*/16);
+
+    unsigned num_inserted = 0;
+    for (uint64_t hash = 1; hash <= 64; ++hash) {
+        if (table.FindOrInsert(hash * 0x9E3779B97F4A7C15ULL) != nullptr) {
+            ++num_inserted;
+        }
+    }
+
+    TEST_CONDITION(num_inserted <= table.Capacity());
+    TEST_CONDITION(table.Size() == num_inserted);
+
+    return true;
+}
+
+bool StatisticsTest() {
+    e8::MctTranspositionTable table(/*capacity=*/64);
+    e8::MctTranspositionTable::Entry *entry = table.FindOrInsert(7);
+
+    auto [num_visits, summed_reward] = e8::MctTranspositionTable::Visits(*entry);
+    TEST_CONDITION(num_visits == 0);
+    TEST_CONDITION(summed_reward == 0.0f);
+    TEST_CONDITION(!e8::MctTranspositionTable::Reward(*entry).has_value());
+
+    e8::MctTranspositionTable::AddVisit(1.0f, entry);
+    e8::MctTranspositionTable::AddVisit(-0.5f, entry);
+    std::tie(num_visits, summed_reward) = e8::MctTranspositionTable::Visits(*entry);
+    TEST_CONDITION(num_visits == 2);
+    TEST_CONDITION(summed_reward == 0.5f);
+
+    e8::MctTranspositionTable::SetReward(-0.25f, entry);
+    TEST_CONDITION(e8::MctTranspositionTable::Reward(*entry) == -0.25f);
+
+    return true;
+}
+
+bool ConcurrentVisitTest() {
+    e8::MctTranspositionTable table(/*capacity=*/1024);
+
+    unsigned const kNumThreads = 4;
+    unsigned const kNumVisits = 10000;
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < kNumThreads; ++i) {
+        threads.emplace_back([&table]() {
+            for (unsigned j = 0; j < kNumVisits; ++j) {
+                e8::MctTranspositionTable::Entry *entry = table.FindOrInsert(j % 16 + 1);
+                e8::MctTranspositionTable::AddVisit(1.0f, entry);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    TEST_CONDITION(table.Size() == 16);
+
+    uint32_t total_visits = 0;
+    for (uint64_t hash = 1; hash <= 16; ++hash) {
+        auto [num_visits, summed_reward] = e8::MctTranspositionTable::Visits(*table.Find(hash));
+        TEST_CONDITION(summed_reward == num_visits);
+        total_visits += num_visits;
+    }
+    TEST_CONDITION(total_visits == kNumThreads * kNumVisits);
+
+    return true;
+}
+
+bool TranspositionTest() {
+    e8::MctTranspositionTable table(/*capacity=*/64);
+
+    e8::GomokuBoardState a(/*width=*/11, /*height=*/11);
+    for (e8::MovePosition const &move : {e8::MovePosition(3, 3), e8::MovePosition(5, 5),
+                                         e8::MovePosition(4, 4)}) {
+        a.ApplyAction(a.MovePositionToActionId(move), /*cached_game_result=*/std::nullopt);
+    }
+
+    e8::GomokuBoardState b(/*width=*/11, /*height=*/11);
+    for (e8::MovePosition const &move : {e8::MovePosition(5, 5), e8::MovePosition(3, 3),
+                                         e8::MovePosition(4, 4)}) {
+        b.ApplyAction(b.MovePositionToActionId(move), /*cached_game_result=*/std::nullopt);
+    }
+
+    TEST_CONDITION(table.FindOrInsert(a.Hash()) == table.Find(b.Hash()));
+
+    return true;
+}
+
+int main() {
+    e8::BeginTestSuite("transposition_table");
+    e8::RunTest("FindOrInsertTest", FindOrInsertTest);
+    e8::RunTest("FullTableTest", FullTableTest);
+    e8::RunTest("StatisticsTest", StatisticsTest);
+    e8::RunTest("ConcurrentVisitTest", ConcurrentVisitTest);
+    e8::RunTest("TranspositionTest", TranspositionTest);
+    e8::EndTestSuite();
+    return 0;
+}
@@ -15,8 +15,12 @@
  * not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <chrono>
+#include <cstdint>
+#include <iostream>
 #include <optional>
-#include <unordered_map>
+#include <random>
+#include <vector>
 
 #include "common/unit_test_util/unit_test_util.h"
 #include "gomoku/game/board_state.h"
@@ -448,6 +452,181 @@ bool HistoryRecordTest() {
     return true;
 }
 
+bool BitboardLegalActionsTest() {
+    e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
+    TEST_CONDITION(board.LegalActions().size() == 11 * 11);
+    TEST_CONDITION(board.LegalActions().begin()->first == 0);
+
+    e8::GomokuActionId action_id =
+        board.MovePositionToActionId(e8::MovePosition(/*x=*/10, /*y=*/3));
+    board.ApplyAction(action_id, /*cached_game_result=*/std::nullopt);
+    TEST_CONDITION(board.LegalActions().size() == 11 * 11 - 1);
+    TEST_CONDITION(board.LegalActions().find(action_id) == board.LegalActions().end());
+    TEST_CONDITION(board.StonePlane(e8::StoneType::ST_BLACK).Count() == 1);
+    TEST_CONDITION(board.StonePlane(e8::StoneType::ST_BLACK).Test(10 + 3 * 12));
+    TEST_CONDITION(board.StonePlane(e8::StoneType::ST_WHITE).Empty());
+
+    // Actions are iterated in ascending ID order and decoded from the IDs.
+    e8::GomokuActionId last_action_id = -1;
+    unsigned num_actions = 0;
+    for (auto const &[legal_action_id, action] : board.LegalActions()) {
+        TEST_CONDITION(legal_action_id > last_action_id);
+        TEST_CONDITION(action.stone_pos.has_value());
+        TEST_CONDITION(board.MovePositionToActionId(*action.stone_pos) == legal_action_id);
+        last_action_id = legal_action_id;
+        ++num_actions;
+    }
+    TEST_CONDITION(num_actions == 11 * 11 - 1);
+
+    board.RetractAction();
+    TEST_CONDITION(board.LegalActions().size() == 11 * 11);
+    TEST_CONDITION(board.StonePlane(e8::StoneType::ST_BLACK).Empty());
+
+    return true;
+}
+
+bool LineDoesNotWrapAroundRowsTest() {
+    e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
+
+    // Opening stones which don't form any line.
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/5, /*y=*/8)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/5, /*y=*/9)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/7, /*y=*/8)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.Swap2DecisionToActionId(e8::Swap2Decision::SW2D_CHOOSE_WHITE),
+                      /*cached_game_result=*/std::nullopt);
+
+    // Black gets (8, 0), (9, 0), (10, 0), (0, 1), (1, 1) which would be a five if rows wrapped.
+    int8_t const black_xs[] = {8, 9, 10, 0, 1};
+    int8_t const black_ys[] = {0, 0, 0, 1, 1};
+    for (unsigned i = 0; i < 5; ++i) {
+        TEST_CONDITION(board.PlayerStoneType(board.CurrentPlayerSide()) ==
+                       e8::StoneType::ST_WHITE);
+        e8::GameResult game_result = board.ApplyAction(
+            board.MovePositionToActionId(e8::MovePosition(/*x=*/2 * i, /*y=*/10)),
+            /*cached_game_result=*/std::nullopt);
+        TEST_CONDITION(game_result == e8::GameResult::GR_UNDETERMINED);
+
+        game_result = board.ApplyAction(
+            board.MovePositionToActionId(e8::MovePosition(black_xs[i], black_ys[i])),
+            /*cached_game_result=*/std::nullopt);
+        TEST_CONDITION(game_result == e8::GameResult::GR_UNDETERMINED);
+    }
+
+    return true;
+}
+
+bool ZobristHashTest() {
+    e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
+    uint64_t const initial_hash = board.Hash();
+
+    auto play = [](std::vector<e8::MovePosition> const &moves, e8::GomokuBoardState *board) {
+        board->ApplyAction(board->MovePositionToActionId(moves[0]), std::nullopt);
+        board->ApplyAction(board->MovePositionToActionId(moves[1]), std::nullopt);
+        board->ApplyAction(board->MovePositionToActionId(moves[2]), std::nullopt);
+        board->ApplyAction(board->Swap2DecisionToActionId(e8::SW2D_CHOOSE_BLACK), std::nullopt);
+        for (unsigned i = 3; i < moves.size(); ++i) {
+            board->ApplyAction(board->MovePositionToActionId(moves[i]), std::nullopt);
+        }
+    };
+
+    // Transposes the moves of the same stone type.
+    play({e8::MovePosition(1, 1), e8::MovePosition(2, 2), e8::MovePosition(3, 3),
+          e8::MovePosition(5, 5), e8::MovePosition(6, 6), e8::MovePosition(7, 7)},
+         &board);
+    e8::GomokuBoardState transposed(/*width=*/11, /*height=*/11);
+    play({e8::MovePosition(1, 1), e8::MovePosition(2, 2), e8::MovePosition(3, 3),
+          e8::MovePosition(7, 7), e8::MovePosition(6, 6), e8::MovePosition(5, 5)},
+         &transposed);
+    TEST_CONDITION(board.Hash() == transposed.Hash());
+
+    // Same stones, but a different player to move.
+    e8::GomokuBoardState swapped(/*width=*/11, /*height=*/11);
+    play({e8::MovePosition(1, 1), e8::MovePosition(2, 2), e8::MovePosition(3, 3),
+          e8::MovePosition(5, 5), e8::MovePosition(6, 6)},
+         &swapped);
+    uint64_t const hash_before_move = swapped.Hash();
+    swapped.ApplyAction(swapped.MovePositionToActionId(e8::MovePosition(7, 7)), std::nullopt);
+    TEST_CONDITION(swapped.Hash() != hash_before_move);
+    TEST_CONDITION(swapped.Hash() == board.Hash());
+
+    // Retracting restores the hash.
+    swapped.RetractAction();
+    TEST_CONDITION(swapped.Hash() == hash_before_move);
+    while (swapped.RetractAction().has_value()) {
+    }
+    TEST_CONDITION(swapped.Hash() == initial_hash);
+
+    e8::GomokuBoardState copy = board;
+    TEST_CONDITION(copy.Hash() == board.Hash());
+
+    return true;
+}
+
+bool BoardPlaneTest() {
+    e8::GomokuBoardState board(/*width=*/11, /*height=*/9);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/10, /*y=*/0)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/0, /*y=*/8)),
+                      /*cached_game_result=*/std::nullopt);
+    board.ApplyAction(board.MovePositionToActionId(e8::MovePosition(/*x=*/3, /*y=*/5)),
+                      /*cached_game_result=*/std::nullopt);
+
+    std::vector<uint8_t> plane(11 * 9, 0xff);
+    board.WriteBoardPlane(plane.data());
+    for (int8_t x = 0; x < 11; ++x) {
+        for (int8_t y = 0; y < 9; ++y) {
+            TEST_CONDITION(plane[y + x * 9] == *board.ChessPieceStateAt(e8::MovePosition(x, y)));
+        }
+    }
+    TEST_CONDITION(plane[0 + 10 * 9] == e8::StoneType::ST_BLACK);
+    TEST_CONDITION(plane[8 + 0 * 9] == e8::StoneType::ST_BLACK);
+    TEST_CONDITION(plane[5 + 3 * 9] == e8::StoneType::ST_WHITE);
+
+    return true;
+}
+
+bool ApplyAndRetractThroughputBenchmark() {
+    unsigned const kNumGames = 20000;
+
+    e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
+    std::mt19937 random_engine(/*seed=*/13);
+    std::uniform_int_distribution<int> action_id_dist(board.ActionIdRange().first,
+                                                      board.ActionIdRange().second);
+
+    uint64_t num_moves = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < kNumGames; ++i) {
+        while (board.CurrentGameResult() == e8::GameResult::GR_UNDETERMINED) {
+            e8::GomokuActionSet const &actions = board.LegalActions();
+
+            // Samples an action by rejection so that the benchmark isn't dominated by iterating
+            // through the legal actions.
+            e8::GomokuActionId action_id;
+            do {
+                action_id = action_id_dist(random_engine);
+            } while (actions.find(action_id) == actions.end());
+
+            board.ApplyAction(action_id, /*cached_game_result=*/std::nullopt);
+            ++num_moves;
+        }
+        while (board.RetractAction().has_value()) {
+            ++num_moves;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    TEST_CONDITION(board.LegalActions().size() == 11 * 11);
+
+    double secs = std::chrono::duration<double>(end - start).count();
+    std::cout << "ApplyAndRetractThroughputBenchmark: moves=" << num_moves
+              << " moves_per_sec=" << num_moves / secs << std::endl;
+
+    return true;
+}
+
 int main() {
     e8::BeginTestSuite("board_state");
     e8::RunTest("BasicGameStateTest", BasicGameStateTest);
@@ -455,6 +634,11 @@ int main() {
     e8::RunTest("GameResultTest", GameResultTest);
     e8::RunTest("GameResultTest2", GameResultTest2);
     e8::RunTest("HistoryRecordTest", HistoryRecordTest);
+    e8::RunTest("BitboardLegalActionsTest", BitboardLegalActionsTest);
+    e8::RunTest("LineDoesNotWrapAroundRowsTest", LineDoesNotWrapAroundRowsTest);
+    e8::RunTest("ZobristHashTest", ZobristHashTest);
+    e8::RunTest("BoardPlaneTest", BoardPlaneTest);
+    e8::RunTest("ApplyAndRetractThroughputBenchmark", ApplyAndRetractThroughputBenchmark);
     e8::EndTestSuite();
     return 0;
 }
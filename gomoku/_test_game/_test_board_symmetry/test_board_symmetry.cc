@@ -0,0 +1,194 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "common/unit_test_util/unit_test_util.h"
+#include "gomoku/game/board_state.h"
+#include "gomoku/game/board_symmetry.h"
+
+namespace {
+
+void PlayOpening(e8::GomokuBoardState *board) {
+    for (e8::MovePosition const &pos : {e8::MovePosition(/*x=*/3, /*y=*/6),
+                                        e8::MovePosition(/*x=*/4, /*y=*/3),
+                                        e8::MovePosition(/*x=*/9, /*y=*/7)}) {
+        board->ApplyAction(board->MovePositionToActionId(pos),
+                           /*cached_game_result=*/std::nullopt);
+    }
+    board->ApplyAction(board->Swap2DecisionToActionId(e8::Swap2Decision::SW2D_CHOOSE_WHITE),
+                       /*cached_game_result=*/std::nullopt);
+    board->ApplyAction(board->MovePositionToActionId(e8::MovePosition(/*x=*/9, /*y=*/6)),
+                       /*cached_game_result=*/std::nullopt);
+}
+
+} // namespace
+
+bool TransformMovePositionTest() {
+    // Rotates counterclockwise when printed with x as the row, like numpy.rot90().
+    e8::MovePosition pos =
+        e8::TransformMovePosition(e8::MovePosition(/*x=*/1, /*y=*/0), e8::BS_ROTATE_90,
+                                  /*width=*/5, /*height=*/5);
+    TEST_CONDITION(pos == e8::MovePosition(/*x=*/4, /*y=*/1));
+
+    pos = e8::TransformMovePosition(e8::MovePosition(/*x=*/1, /*y=*/0), e8::BS_FLIP,
+                                    /*width=*/5, /*height=*/5);
+    TEST_CONDITION(pos == e8::MovePosition(/*x=*/3, /*y=*/0));
+
+    for (unsigned i = 0; i < e8::kNumBoardSymmetries; ++i) {
+        e8::BoardSymmetry symmetry = static_cast<e8::BoardSymmetry>(i);
+        e8::BoardSymmetry inverse = e8::InverseSymmetry(symmetry);
+
+        std::vector<bool> covered(5 * 5, false);
+        for (int8_t y = 0; y < 5; ++y) {
+            for (int8_t x = 0; x < 5; ++x) {
+                e8::MovePosition transformed =
+                    e8::TransformMovePosition(e8::MovePosition(x, y), symmetry, 5, 5);
+                TEST_CONDITION(transformed.x >= 0 && transformed.x < 5);
+                TEST_CONDITION(transformed.y >= 0 && transformed.y < 5);
+                covered[transformed.x + transformed.y * 5] = true;
+
+                TEST_CONDITION(e8::TransformMovePosition(transformed, inverse, 5, 5) ==
+                               e8::MovePosition(x, y));
+            }
+        }
+
+        // Each symmetry is a permutation of the cells.
+        for (bool c : covered) {
+            TEST_CONDITION(c);
+        }
+    }
+
+    // Non-square boards only have the symmetries which keep the axes.
+    TEST_CONDITION(e8::SymmetryApplies(e8::BS_ROTATE_180, /*width=*/5, /*height=*/4));
+    TEST_CONDITION(e8::SymmetryApplies(e8::BS_FLIP, /*width=*/5, /*height=*/4));
+    TEST_CONDITION(!e8::SymmetryApplies(e8::BS_ROTATE_90, /*width=*/5, /*height=*/4));
+    TEST_CONDITION(e8::TransformMovePosition(e8::MovePosition(/*x=*/0, /*y=*/1),
+                                             e8::BS_ROTATE_180, 5, 4) ==
+                   e8::MovePosition(/*x=*/4, /*y=*/2));
+
+    return true;
+}
+
+bool TransformBoardStateTest() {
+    e8::GomokuBoardState board(/*width=*/11, /*height=*/11);
+    PlayOpening(&board);
+
+    uint64_t canonical_hash;
+    e8::CanonicalSymmetry(board, &canonical_hash);
+
+    for (unsigned i = 0; i < e8::kNumBoardSymmetries; ++i) {
+        e8::BoardSymmetry symmetry = static_cast<e8::BoardSymmetry>(i);
+        e8::GomokuBoardState transformed = e8::TransformBoardState(board, symmetry);
+
+        TEST_CONDITION(transformed.CurrentGamePhase() == board.CurrentGamePhase());
+        TEST_CONDITION(transformed.CurrentPlayerSide() == board.CurrentPlayerSide());
+        TEST_CONDITION(transformed.History().size() == board.History().size());
+
+        for (int8_t y = 0; y < 11; ++y) {
+            for (int8_t x = 0; x < 11; ++x) {
+                e8::MovePosition pos =
+                    e8::TransformMovePosition(e8::MovePosition(x, y), symmetry, 11, 11);
+                TEST_CONDITION(*transformed.ChessPieceStateAt(pos) ==
+                               *board.ChessPieceStateAt(e8::MovePosition(x, y)));
+            }
+        }
+
+        // The symmetric hash is computed without transforming the board.
+        TEST_CONDITION(e8::SymmetricHash(board, symmetry) ==
+                       e8::SymmetricHash(transformed, e8::BS_IDENTITY));
+
+        // All the orientations share one canonical form.
+        uint64_t transformed_canonical_hash;
+        e8::BoardSymmetry to_canonical =
+            e8::CanonicalSymmetry(transformed, &transformed_canonical_hash);
+        TEST_CONDITION(transformed_canonical_hash == canonical_hash);
+        TEST_CONDITION(e8::SymmetricHash(transformed, to_canonical) == canonical_hash);
+    }
+
+    // Different positions have different canonical hashes.
+    e8::GomokuBoardState other(/*width=*/11, /*height=*/11);
+    PlayOpening(&other);
+    other.RetractAction();
+    other.ApplyAction(other.MovePositionToActionId(e8::MovePosition(/*x=*/9, /*y=*/5)),
+                      /*cached_game_result=*/std::nullopt);
+
+    uint64_t other_canonical_hash;
+    e8::CanonicalSymmetry(other, &other_canonical_hash);
+    TEST_CONDITION(other_canonical_hash != canonical_hash);
+
+    return true;
+}
+
+bool TransformPlanesTest() {
+    int16_t const width = 7;
+    int16_t const height = 7;
+
+    std::vector<float> shl_map(width * height * 4);
+    for (unsigned i = 0; i < shl_map.size(); ++i) {
+        shl_map[i] = i;
+    }
+
+    std::vector<float> policy(width * height + 5, 0.0f);
+    policy[2 + 3 * width] = 0.5f;
+    policy[width * height + 1] = 0.5f;
+
+    for (unsigned i = 0; i < e8::kNumBoardSymmetries; ++i) {
+        e8::BoardSymmetry symmetry = static_cast<e8::BoardSymmetry>(i);
+
+        std::vector<float> transformed_map(shl_map.size());
+        e8::TransformCellPlanes(shl_map.data(), /*num_channels=*/4, symmetry, width, height,
+                                transformed_map.data());
+
+        e8::MovePosition pos =
+            e8::TransformMovePosition(e8::MovePosition(/*x=*/5, /*y=*/1), symmetry, width, height);
+        for (unsigned c = 0; c < 4; ++c) {
+            TEST_CONDITION(transformed_map[(pos.x + pos.y * width) * 4 + c] ==
+                           shl_map[(5 + 1 * width) * 4 + c]);
+        }
+
+        std::vector<float> restored_map(shl_map.size());
+        e8::TransformCellPlanes(transformed_map.data(), /*num_channels=*/4,
+                                e8::InverseSymmetry(symmetry), width, height,
+                                restored_map.data());
+        TEST_CONDITION(restored_map == shl_map);
+
+        std::vector<float> transformed_policy(policy.size());
+        e8::TransformFlatPolicy(policy.data(), symmetry, width, height,
+                                transformed_policy.data());
+
+        e8::GomokuActionId action_id =
+            e8::TransformActionId(2 + 3 * width, symmetry, width, height);
+        TEST_CONDITION(transformed_policy[action_id] == 0.5f);
+        TEST_CONDITION(transformed_policy[width * height + 1] == 0.5f);
+        TEST_CONDITION(e8::TransformActionId(width * height + 1, symmetry, width, height) ==
+                       width * height + 1);
+    }
+
+    return true;
+}
+
+int main() {
+    e8::BeginTestSuite("board_symmetry");
+    e8::RunTest("TransformMovePositionTest", TransformMovePositionTest);
+    e8::RunTest("TransformBoardStateTest", TransformBoardStateTest);
+    e8::RunTest("TransformPlanesTest", TransformPlanesTest);
+    e8::EndTestSuite();
+    return 0;
+}
@@ -44,9 +44,42 @@ bool ScheduleAndFetchGameTest() {
     return true;
 }
 
+bool ManyGamesOnFewWorkersTest() {
+    e8::GameInstanceContainer container(/*num_workers=*/2);
+    TEST_CONDITION(container.NumWorkers() == 2);
+
+    e8::GameInstanceContainer::ScheduleId schedule_id =
+        e8::AllocateGameInstanceContainerScheduleId();
+
+    unsigned const kNumGames = 8;
+    for (unsigned i = 0; i < kNumGames; ++i) {
+        auto game = std::make_unique<e8::GomokuGame>(e8::DefaultMockPlayerA(),
+                                                     e8::DefaultMockPlayerB());
+        container.ScheduleToRun(schedule_id, std::move(game));
+    }
+
+    TEST_CONDITION(container.ScheduledGame(schedule_id) != nullptr);
+
+    for (unsigned i = 0; i < 100 && container.ScheduledGame(schedule_id) != nullptr; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    TEST_CONDITION(container.ScheduledGame(schedule_id) == nullptr);
+
+    e8::GameInstanceContainerStats stats = container.Stats();
+    TEST_CONDITION(stats.num_games_ended == kNumGames);
+    TEST_CONDITION(stats.num_actions_applied > 0);
+    TEST_CONDITION(stats.num_actions_applied % kNumGames == 0);
+    TEST_CONDITION(stats.num_scheduled_games == 0);
+    TEST_CONDITION(stats.GamesPerHour() > 0.0f);
+    TEST_CONDITION(stats.PositionsPerSecond() > 0.0f);
+
+    return true;
+}
+
 int main() {
     e8::BeginTestSuite("game_instance_container");
     e8::RunTest("ScheduleAndFetchGameTest", ScheduleAndFetchGameTest);
+    e8::RunTest("ManyGamesOnFewWorkersTest", ManyGamesOnFewWorkersTest);
     e8::EndTestSuite();
     return 0;
 }
@@ -0,0 +1,171 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "common/unit_test_util/unit_test_util.h"
+#include "gomoku/game/board_state.h"
+#include "gomoku/logging/self_play_record_store.h"
+
+namespace {
+
+e8::SelfPlayRecord MakeRecord(e8::GameId game_id, e8::GameStepNumber step_number,
+                              e8::GameStepNumber num_game_steps) {
+    e8::SelfPlayRecord record;
+    record.game_id = game_id;
+    record.step_number = step_number;
+    record.num_game_steps = num_game_steps;
+    record.action_id = step_number * 3;
+    record.action_performer = step_number % 2 == 0 ? e8::PS_PLAYER_A : e8::PS_PLAYER_B;
+    record.action_stone_type = e8::ST_BLACK;
+    record.game_phase = e8::GP_STANDARD_GOMOKU;
+    record.value = step_number % 2 == 0 ? 1.0f : -1.0f;
+
+    record.board_width = 7;
+    record.board_height = 7;
+    record.board.resize(7 * 7);
+    for (unsigned i = 0; i < record.board.size(); ++i) {
+        record.board[i] = (i + step_number) % 3;
+    }
+
+    record.policy.resize(7 * 7 + 5);
+    record.policy[record.action_id] = 1.0f;
+
+    record.shl_map.resize(7 * 7 * 4, static_cast<float>(game_id));
+    record.top_shl_features.resize(60, static_cast<float>(step_number));
+
+    return record;
+}
+
+std::string TestDirectory() {
+    std::filesystem::path directory =
+        std::filesystem::temp_directory_path() / "e8_test_self_play_record_store";
+    std::filesystem::remove_all(directory);
+    return directory.string();
+}
+
+} // namespace
+
+bool WriteReadTest() {
+    std::string directory = TestDirectory();
+
+    {
+        e8::SelfPlayRecordWriter writer(directory, "selfplay", /*records_per_shard=*/100);
+
+        std::vector<e8::SelfPlayRecord> game;
+        for (unsigned i = 0; i < 9; ++i) {
+            game.push_back(MakeRecord(/*game_id=*/42, /*step_number=*/i, /*num_game_steps=*/9));
+        }
+        writer.AppendGame(game);
+    }
+
+    std::vector<std::string> shards = e8::ListSelfPlayShards(directory, "selfplay");
+    TEST_CONDITION(shards.size() == 1);
+
+    e8::SelfPlayShardReader reader(shards[0]);
+    TEST_CONDITION(reader.NumRecords() == 9);
+    TEST_CONDITION(reader.Header().board_width == 7);
+    TEST_CONDITION(reader.Header().board_height == 7);
+    TEST_CONDITION(reader.Header().policy_size == 7 * 7 + 5);
+
+    // Random access.
+    for (unsigned i : {8, 0, 5}) {
+        e8::SelfPlayRecord expected = MakeRecord(/*game_id=*/42, i, /*num_game_steps=*/9);
+        e8::SelfPlayRecordView view = reader.Record(i);
+
+        TEST_CONDITION(view.head->game_id == 42);
+        TEST_CONDITION(view.head->step_number == i);
+        TEST_CONDITION(view.head->num_game_steps == 9);
+        TEST_CONDITION(view.head->action_id == expected.action_id);
+        TEST_CONDITION(view.head->action_performer == expected.action_performer);
+        TEST_CONDITION(view.head->game_phase == e8::GP_STANDARD_GOMOKU);
+        TEST_CONDITION(view.head->value == expected.value);
+        TEST_CONDITION(std::vector<uint8_t>(view.board, view.board + 7 * 7) == expected.board);
+        TEST_CONDITION(std::vector<float>(view.policy, view.policy + 7 * 7 + 5) ==
+                       expected.policy);
+        TEST_CONDITION(std::vector<float>(view.shl_map, view.shl_map + 7 * 7 * 4) ==
+                       expected.shl_map);
+        TEST_CONDITION(std::vector<float>(view.top_shl_features, view.top_shl_features + 60) ==
+                       expected.top_shl_features);
+    }
+
+    std::filesystem::remove_all(directory);
+
+    return true;
+}
+
+bool ShardRotationTest() {
+    std::string directory = TestDirectory();
+
+    {
+        e8::SelfPlayRecordWriter writer(directory, "selfplay", /*records_per_shard=*/10);
+        for (unsigned game_id = 1; game_id <= 5; ++game_id) {
+            std::vector<e8::SelfPlayRecord> game;
+            for (unsigned i = 0; i < 6; ++i) {
+                game.push_back(MakeRecord(game_id, /*step_number=*/i, /*num_game_steps=*/6));
+            }
+            writer.AppendGame(game);
+        }
+    }
+
+    // A later writer continues with new shards.
+    {
+        e8::SelfPlayRecordWriter writer(directory, "selfplay", /*records_per_shard=*/10);
+        writer.AppendGame({MakeRecord(/*game_id=*/6, /*step_number=*/0, /*num_game_steps=*/1)});
+    }
+
+    // Shards under another prefix are not listed.
+    {
+        e8::SelfPlayRecordWriter writer(directory, "other", /*records_per_shard=*/10);
+        writer.AppendGame({MakeRecord(/*game_id=*/7, /*step_number=*/0, /*num_game_steps=*/1)});
+    }
+
+    std::vector<std::string> shards = e8::ListSelfPlayShards(directory, "selfplay");
+    TEST_CONDITION(shards.size() == 4);
+
+    // Games are never split, so each full shard holds two games.
+    std::vector<uint64_t> expected_num_records{12, 12, 6, 1};
+    e8::GameId expected_game_id = 1;
+    for (unsigned i = 0; i < shards.size(); ++i) {
+        e8::SelfPlayShardReader reader(shards[i]);
+        TEST_CONDITION(reader.NumRecords() == expected_num_records[i]);
+
+        for (uint64_t j = 0; j < reader.NumRecords(); ++j) {
+            e8::SelfPlayRecordView view = reader.Record(j);
+            if (j > 0 && view.head->step_number == 0) {
+                ++expected_game_id;
+            }
+            TEST_CONDITION(view.head->game_id == expected_game_id);
+        }
+        ++expected_game_id;
+    }
+
+    std::filesystem::remove_all(directory);
+
+    return true;
+}
+
+int main() {
+    e8::BeginTestSuite("self_play_record_store");
+    e8::RunTest("WriteReadTest", WriteReadTest);
+    e8::RunTest("ShardRotationTest", ShardRotationTest);
+    e8::EndTestSuite();
+    return 0;
+}
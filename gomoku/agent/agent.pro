@@ -15,9 +15,13 @@ DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs depr
 INCLUDEPATH += $$PWD/../../
 
 SOURCES += \
+    heuristics/batch_inference_server.cc \
     heuristics/contour.cc \
+    heuristics/evaluation_cache.cc \
     heuristics/evaluator.cc \
     heuristics/light_rollout_evaluator.cc \
+    heuristics/native_cnn.cc \
+    heuristics/native_zero_prior_evaluator.cc \
     heuristics/shl_feature.cc \
     heuristics/shl_model_evaluator.cc \
     heuristics/shl_rollout_evaluator.cc \
@@ -25,12 +29,19 @@ SOURCES += \
     heuristics/tflite_zero_prior_evaluator.cc \
     mcts_agent_player.cc \
     search/mct_node.cc \
-    search/mct_search.cc
+    search/mct_search.cc \
+    search/policy.cc \
+    search/threat_solver.cc \
+    search/transposition_table.cc
 
 HEADERS += \
+    heuristics/batch_inference_server.h \
     heuristics/contour.h \
+    heuristics/evaluation_cache.h \
     heuristics/evaluator.h \
     heuristics/light_rollout_evaluator.h \
+    heuristics/native_cnn.h \
+    heuristics/native_zero_prior_evaluator.h \
     heuristics/shl_feature.h \
     heuristics/shl_model_evaluator.h \
     heuristics/shl_rollout_evaluator.h \
@@ -38,7 +49,10 @@ HEADERS += \
     heuristics/tflite_zero_prior_evaluator.h \
     mcts_agent_player.h \
     search/mct_node.h \
-    search/mct_search.h
+    search/mct_search.h \
+    search/policy.h \
+    search/threat_solver.h \
+    search/transposition_table.h
 
 # Default rules for deployment.
 unix {
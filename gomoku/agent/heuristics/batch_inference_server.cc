@@ -0,0 +1,221 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "gomoku/agent/heuristics/batch_inference_server.h"
+#include "gomoku/agent/heuristics/evaluation_cache.h"
+#include "gomoku/game/board_state.h"
+
+namespace e8 {
+namespace {
+
+struct PendingRequest {
+    GomokuInferenceRequest request;
+    std::promise<GomokuInferenceResult> result;
+    std::chrono::steady_clock::time_point submitted_at;
+
+    // Where the result goes in the evaluation cache, if there is one.
+    std::optional<GomokuEvaluationCacheKey> cache_key;
+};
+
+} // namespace
+
+struct GomokuBatchInferenceServer::GomokuBatchInferenceServerInternal {
+    GomokuBatchInferenceServerInternal(std::unique_ptr<GomokuInferenceModelInterface> &&model,
+                                       unsigned max_batch_size,
+                                       std::chrono::microseconds max_delay,
+                                       GomokuEvaluationCache *cache, uint64_t model_version);
+    ~GomokuBatchInferenceServerInternal();
+
+    void RunBatch(std::vector<PendingRequest> *batch);
+    void Dispatch();
+
+    std::unique_ptr<GomokuInferenceModelInterface> model;
+    unsigned const max_batch_size;
+    std::chrono::microseconds const max_delay;
+    GomokuEvaluationCache *const cache;
+    uint64_t const model_version;
+
+    std::mutex model_lock;
+    std::vector<GomokuInferenceRequest> model_inputs;
+    std::vector<GomokuInferenceResult> model_outputs;
+
+    std::mutex queue_lock;
+    std::condition_variable queue_changed;
+    std::deque<PendingRequest> queue;
+    bool stopping = false;
+
+    std::atomic<uint64_t> num_batches;
+    std::atomic<uint64_t> num_requests;
+
+    std::thread dispatcher;
+};
+
+GomokuBatchInferenceServer::GomokuBatchInferenceServerInternal::GomokuBatchInferenceServerInternal(
+    std::unique_ptr<GomokuInferenceModelInterface> &&model, unsigned max_batch_size,
+    std::chrono::microseconds max_delay, GomokuEvaluationCache *cache, uint64_t model_version)
+    : model(std::move(model)), max_batch_size(max_batch_size), max_delay(max_delay), cache(cache),
+      model_version(model_version), num_batches(0), num_requests(0) {
+    assert(max_batch_size > 0);
+    if (max_batch_size > 1) {
+        dispatcher = std::thread(&GomokuBatchInferenceServerInternal::Dispatch, this);
+    }
+}
+
+GomokuBatchInferenceServer::GomokuBatchInferenceServerInternal::
+    ~GomokuBatchInferenceServerInternal() {
+    if (dispatcher.joinable()) {
+        {
+            std::lock_guard<std::mutex> guard(queue_lock);
+            stopping = true;
+        }
+        queue_changed.notify_all();
+        dispatcher.join();
+    }
+    assert(queue.empty());
+}
+
+void GomokuBatchInferenceServer::GomokuBatchInferenceServerInternal::RunBatch(
+    std::vector<PendingRequest> *batch) {
+    std::lock_guard<std::mutex> guard(model_lock);
+
+    model_inputs.clear();
+    for (PendingRequest const &pending : *batch) {
+        model_inputs.push_back(pending.request);
+    }
+
+    model_outputs.resize(batch->size());
+    model->Infer(model_inputs, &model_outputs);
+
+    for (unsigned i = 0; i < batch->size(); ++i) {
+        PendingRequest &pending = (*batch)[i];
+        if (pending.cache_key.has_value()) {
+            cache->Insert(*pending.cache_key, pending.request.state->Width(),
+                          pending.request.state->Height(), model_outputs[i].policy,
+                          model_outputs[i].value);
+        }
+        pending.result.set_value(std::move(model_outputs[i]));
+    }
+
+    num_batches.fetch_add(1, std::memory_order_relaxed);
+    num_requests.fetch_add(batch->size(), std::memory_order_relaxed);
+}
+
+void GomokuBatchInferenceServer::GomokuBatchInferenceServerInternal::Dispatch() {
+    std::vector<PendingRequest> batch;
+    batch.reserve(max_batch_size);
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> guard(queue_lock);
+            queue_changed.wait(guard, [this] { return stopping || !queue.empty(); });
+            if (queue.empty()) {
+                // Stopping with nothing left to serve.
+                return;
+            }
+
+            // Waits for the batch to fill up, but no longer than the oldest request can wait.
+            queue_changed.wait_until(guard, queue.front().submitted_at + max_delay, [this] {
+                return stopping || queue.size() >= max_batch_size;
+            });
+
+            unsigned batch_size = std::min<unsigned>(queue.size(), max_batch_size);
+            for (unsigned i = 0; i < batch_size; ++i) {
+                batch.push_back(std::move(queue.front()));
+                queue.pop_front();
+            }
+        }
+
+        this->RunBatch(&batch);
+        batch.clear();
+    }
+}
+
+GomokuBatchInferenceServer::GomokuBatchInferenceServer(
+    std::unique_ptr<GomokuInferenceModelInterface> &&model, unsigned max_batch_size,
+    std::chrono::microseconds max_delay, GomokuEvaluationCache *cache, uint64_t model_version)
+    : pimpl_(std::make_unique<GomokuBatchInferenceServerInternal>(
+          std::move(model), max_batch_size, max_delay, cache, model_version)) {}
+
+GomokuBatchInferenceServer::~GomokuBatchInferenceServer() {}
+
+std::future<GomokuInferenceResult>
+GomokuBatchInferenceServer::Infer(GomokuBoardState const &state,
+                                  std::vector<float> const *features) {
+    PendingRequest pending;
+    pending.request.state = &state;
+    pending.request.features = features;
+    std::future<GomokuInferenceResult> result = pending.result.get_future();
+
+    if (pimpl_->cache != nullptr) {
+        pending.cache_key = GomokuEvaluationCache::KeyOf(state, pimpl_->model_version);
+
+        GomokuInferenceResult cached;
+        if (pimpl_->cache->Find(*pending.cache_key, state.Width(), state.Height(), &cached.policy,
+                                &cached.value)) {
+            pending.result.set_value(std::move(cached));
+            return result;
+        }
+    }
+
+    if (!pimpl_->dispatcher.joinable()) {
+        // Nothing to batch with.
+        std::vector<PendingRequest> batch;
+        batch.push_back(std::move(pending));
+        pimpl_->RunBatch(&batch);
+        return result;
+    }
+
+    pending.submitted_at = std::chrono::steady_clock::now();
+    bool wake_dispatcher;
+    {
+        std::lock_guard<std::mutex> guard(pimpl_->queue_lock);
+        pimpl_->queue.push_back(std::move(pending));
+
+        // The dispatcher is either waiting for the first request or for the batch to fill up.
+        wake_dispatcher =
+            pimpl_->queue.size() == 1 || pimpl_->queue.size() >= pimpl_->max_batch_size;
+    }
+    if (wake_dispatcher) {
+        pimpl_->queue_changed.notify_one();
+    }
+
+    return result;
+}
+
+uint64_t GomokuBatchInferenceServer::NumBatches() const {
+    return pimpl_->num_batches.load(std::memory_order_relaxed);
+}
+
+uint64_t GomokuBatchInferenceServer::NumRequests() const {
+    return pimpl_->num_requests.load(std::memory_order_relaxed);
+}
+
+} // namespace e8
@@ -0,0 +1,119 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BATCH_INFERENCE_SERVER_H
+#define BATCH_INFERENCE_SERVER_H
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include "gomoku/agent/heuristics/evaluation_cache.h"
+#include "gomoku/game/board_state.h"
+
+namespace e8 {
+
+/**
+ * @brief The GomokuInferenceRequest struct A board state to run inference on, along with the
+ * model-specific features precomputed by the caller, if any.
+ */
+struct GomokuInferenceRequest {
+    GomokuBoardState const *state;
+    std::vector<float> const *features;
+};
+
+/**
+ * @brief The GomokuInferenceResult struct The raw model output for one board state.
+ */
+struct GomokuInferenceResult {
+    // Model output over the whole action ID range. It isn't masked nor normalized over the legal
+    // actions.
+    std::vector<float> policy;
+
+    // Reward estimation in the perspective of the current player.
+    float value;
+};
+
+/**
+ * @brief The GomokuInferenceModelInterface class A model which can run inference on a batch of
+ * board states at a time.
+ */
+class GomokuInferenceModelInterface {
+  public:
+    GomokuInferenceModelInterface() = default;
+    virtual ~GomokuInferenceModelInterface() = default;
+
+    /**
+     * @brief Infer Runs inference on the batch of requests and writes one result per request, in
+     * the same order. It's never called concurrently.
+     */
+    virtual void Infer(std::vector<GomokuInferenceRequest> const &batch,
+                       std::vector<GomokuInferenceResult> *results) = 0;
+};
+
+/**
+ * @brief The GomokuBatchInferenceServer class Collects inference requests from many searches and
+ * games into batches so that the model is called with fewer, larger tensors. A batch is flushed
+ * when it reaches the maximum batch size, or when its oldest request has waited for the maximum
+ * delay. Requests can be answered from an evaluation cache without reaching the model.
+ */
+class GomokuBatchInferenceServer {
+  public:
+    /**
+     * @brief GomokuBatchInferenceServer Constructs a server over the model.
+     *
+     * @param max_batch_size The largest batch the model accepts. A server with max_batch_size 1
+     * runs the model directly on the requesting thread.
+     * @param max_delay How long a request can wait for the batch to fill up.
+     * @param cache Optional cache the model outputs are looked up from and stored to. It may be
+     * shared with other servers.
+     * @param model_version Tells the outputs of this model apart from the others in the cache.
+     */
+    GomokuBatchInferenceServer(std::unique_ptr<GomokuInferenceModelInterface> &&model,
+                               unsigned max_batch_size, std::chrono::microseconds max_delay,
+                               GomokuEvaluationCache *cache = nullptr, uint64_t model_version = 0);
+    GomokuBatchInferenceServer(GomokuBatchInferenceServer const &) = delete;
+    GomokuBatchInferenceServer(GomokuBatchInferenceServer &&) = delete;
+    ~GomokuBatchInferenceServer();
+
+    /**
+     * @brief Infer Queues the request for the next batch. The state and the features must stay
+     * alive until the returned future is ready.
+     */
+    std::future<GomokuInferenceResult> Infer(GomokuBoardState const &state,
+                                             std::vector<float> const *features = nullptr);
+
+    /**
+     * @brief NumBatches The number of times the model has been called.
+     */
+    uint64_t NumBatches() const;
+
+    /**
+     * @brief NumRequests The number of requests the model has served. Cache hits aren't counted.
+     */
+    uint64_t NumRequests() const;
+
+  private:
+    struct GomokuBatchInferenceServerInternal;
+    std::unique_ptr<GomokuBatchInferenceServerInternal> pimpl_;
+};
+
+} // namespace e8
+
+#endif // BATCH_INFERENCE_SERVER_H
@@ -19,9 +19,9 @@
 #include <cassert>
 #include <cstdint>
 #include <optional>
-#include <unordered_set>
 #include <vector>
 
+#include "common/random/random_source.h"
 #include "gomoku/agent/heuristics/contour.h"
 #include "gomoku/game/board_state.h"
 
@@ -62,8 +62,11 @@ bool IsDoubleContour(int8_t x, int8_t y, GomokuBoardState const &board) {
 }
 
 ContourBuilder::ContourBuilder(GomokuBoardState const &board, int8_t order)
-    : blacklist_(board.Width() * board.Height()), width_(board.Width()), height_(board.Height()),
+    : contour_index_(board.Width() * board.Height(), -1),
+      blacklist_(board.Width() * board.Height()), width_(board.Width()), height_(board.Height()),
       order_(order) {
+    contour_.reserve(board.Width() * board.Height());
+
     for (GomokuActionRecord const &action_record : board.History()) {
         std::optional<MovePosition> pos = action_record.action.second.stone_pos;
 
@@ -74,7 +77,9 @@ ContourBuilder::ContourBuilder(GomokuBoardState const &board, int8_t order)
 }
 
 void ContourBuilder::AddStone(MovePosition const &stone_pos) {
-    contour_.erase(stone_pos);
+    if (this->Contains(stone_pos)) {
+        this->RemoveFromContour(stone_pos);
+    }
     blacklist_[stone_pos.x + stone_pos.y * width_] = true;
 
     int8_t min_x = std::max(0, stone_pos.x - order_);
@@ -87,19 +92,48 @@ void ContourBuilder::AddStone(MovePosition const &stone_pos) {
         for (int8_t shifted_x = min_x; shifted_x <= max_x; ++shifted_x) {
             if (!blacklist_[shifted_x + shifted_y * width_]) {
                 blacklist_[shifted_x + shifted_y * width_] = true;
-                contour_.insert(MovePosition(shifted_x, shifted_y));
+                contour_index_[shifted_x + shifted_y * width_] = contour_.size();
+                contour_.push_back(MovePosition(shifted_x, shifted_y));
             }
         }
     }
 }
 
-std::unordered_set<MovePosition> const &ContourBuilder::Contour() const { return contour_; }
+std::vector<MovePosition> const &ContourBuilder::Contour() const { return contour_; }
+
+bool ContourBuilder::Contains(MovePosition const &pos) const {
+    return contour_index_[pos.x + pos.y * width_] >= 0;
+}
+
+MovePosition ContourBuilder::Sample(RandomSource *random_source) const {
+    assert(!contour_.empty());
+
+    unsigned index = random_source->Draw() * contour_.size();
+    if (index >= contour_.size()) {
+        // Numerical glitch.
+        index = contour_.size() - 1;
+    }
+
+    return contour_[index];
+}
+
+void ContourBuilder::RemoveFromContour(MovePosition const &pos) {
+    // Swaps the last position into the hole.
+    int index = contour_index_[pos.x + pos.y * width_];
+    MovePosition const &last = contour_.back();
+    contour_index_[last.x + last.y * width_] = index;
+    contour_[index] = last;
+
+    contour_index_[pos.x + pos.y * width_] = -1;
+    contour_.pop_back();
+}
 
 ContourBuilder &ContourBuilder::operator=(ContourBuilder const &rhs) {
     assert(width_ == rhs.width_);
     assert(height_ == rhs.height_);
     assert(order_ == rhs.order_);
     contour_ = rhs.contour_;
+    contour_index_ = rhs.contour_index_;
     blacklist_ = rhs.blacklist_;
     return *this;
 }
@@ -19,9 +19,9 @@
 #define CONTOUR_H
 
 #include <cstdint>
-#include <unordered_set>
 #include <vector>
 
+#include "common/random/random_source.h"
 #include "gomoku/game/board_state.h"
 
 namespace e8 {
@@ -40,7 +40,8 @@ bool IsDoubleContour(int8_t x, int8_t y, GomokuBoardState const &board);
 
 /**
  * @brief The ContourBuilder class A data structure that helps construct arbitrary orders of contour
- * efficient.
+ * efficient. The contour is kept as a dense array, plus an index into it for every board position,
+ * so that membership tests, removals and uniform sampling all take constant time.
  */
 class ContourBuilder {
   public:
@@ -57,9 +58,20 @@ class ContourBuilder {
     void AddStone(MovePosition const &stone_pos);
 
     /**
-     * @brief Contour Returns the current contour.
+     * @brief Contour Returns the current contour, in no particular order.
      */
-    std::unordered_set<MovePosition> const &Contour() const;
+    std::vector<MovePosition> const &Contour() const;
+
+    /**
+     * @brief Contains Checks if the position is in the current contour.
+     */
+    bool Contains(MovePosition const &pos) const;
+
+    /**
+     * @brief Sample Draws a position from the current contour uniformly. The contour must not be
+     * empty.
+     */
+    MovePosition Sample(RandomSource *random_source) const;
 
     /**
      * @brief operator = Assignment operator. The rvalue must have the same width, height and order.
@@ -68,7 +80,13 @@ class ContourBuilder {
     ContourBuilder &operator=(ContourBuilder const &rhs);
 
   private:
-    std::unordered_set<MovePosition> contour_;
+    void RemoveFromContour(MovePosition const &pos);
+
+    std::vector<MovePosition> contour_;
+
+    // Index of each board position in contour_, or -1 if the position isn't in the contour.
+    std::vector<int> contour_index_;
+
     std::vector<bool> blacklist_;
     int8_t const width_;
     int8_t const height_;
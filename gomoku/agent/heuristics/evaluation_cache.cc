@@ -0,0 +1,216 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "gomoku/agent/heuristics/evaluation_cache.h"
+#include "gomoku/game/board_state.h"
+#include "gomoku/game/board_symmetry.h"
+
+namespace e8 {
+namespace {
+
+// Number of entries a key can be placed at.
+unsigned const kNumWays = 4;
+
+// Sets are guarded by a fixed number of locks, which is plenty for the number of search workers.
+unsigned const kNumLockStripes = 64;
+
+// About 70MB of 11x11 policies.
+unsigned const kDefaultCacheCapacity = 1 << 17;
+
+std::mutex gCachePtrLock;
+std::unique_ptr<GomokuEvaluationCache> gEvaluationCache;
+
+struct CacheEntry {
+    bool occupied = false;
+    uint64_t canonical_hash;
+    uint64_t model_version;
+
+    // Tick of the last access, for the LRU eviction.
+    uint64_t last_used;
+
+    // In the canonical orientation.
+    std::vector<float> policy;
+    float value;
+};
+
+uint64_t MixKey(uint64_t canonical_hash, uint64_t model_version) {
+    uint64_t x = canonical_hash ^ (model_version * 0x9E3779B97F4A7C15ULL);
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    return x;
+}
+
+unsigned ActionIdRangeSize(int16_t width, int16_t height) { return width * height + 3 + 2; }
+
+} // namespace
+
+struct GomokuEvaluationCache::GomokuEvaluationCacheInternal {
+    GomokuEvaluationCacheInternal(unsigned capacity);
+
+    unsigned SetOf(GomokuEvaluationCacheKey const &key) const;
+    std::mutex *LockOf(unsigned set);
+
+    unsigned const num_sets;
+    std::vector<CacheEntry> entries;
+    std::vector<std::mutex> locks;
+
+    std::atomic<uint64_t> clock;
+    std::atomic<uint64_t> num_lookups;
+    std::atomic<uint64_t> num_hits;
+    std::atomic<uint64_t> num_insertions;
+    std::atomic<uint64_t> num_evictions;
+};
+
+GomokuEvaluationCache::GomokuEvaluationCacheInternal::GomokuEvaluationCacheInternal(
+    unsigned capacity)
+    : num_sets(std::max(1U, capacity / kNumWays)), entries(num_sets * kNumWays),
+      locks(kNumLockStripes), clock(0), num_lookups(0), num_hits(0), num_insertions(0),
+      num_evictions(0) {}
+
+unsigned GomokuEvaluationCache::GomokuEvaluationCacheInternal::SetOf(
+    GomokuEvaluationCacheKey const &key) const {
+    return MixKey(key.canonical_hash, key.model_version) % num_sets;
+}
+
+std::mutex *GomokuEvaluationCache::GomokuEvaluationCacheInternal::LockOf(unsigned set) {
+    return &locks[set % kNumLockStripes];
+}
+
+float GomokuEvaluationCacheStats::HitRate() const {
+    if (num_lookups == 0) {
+        return 0.0f;
+    }
+    return static_cast<float>(num_hits) / num_lookups;
+}
+
+GomokuEvaluationCache::GomokuEvaluationCache(unsigned capacity)
+    : pimpl_(std::make_unique<GomokuEvaluationCacheInternal>(capacity)) {}
+
+GomokuEvaluationCache::~GomokuEvaluationCache() {}
+
+GomokuEvaluationCacheKey GomokuEvaluationCache::KeyOf(GomokuBoardState const &state,
+                                                      uint64_t model_version) {
+    GomokuEvaluationCacheKey key;
+    key.to_canonical = CanonicalSymmetry(state, &key.canonical_hash);
+    key.model_version = model_version;
+    return key;
+}
+
+bool GomokuEvaluationCache::Find(GomokuEvaluationCacheKey const &key, int16_t width,
+                                 int16_t height, std::vector<float> *policy, float *value) {
+    pimpl_->num_lookups.fetch_add(1, std::memory_order_relaxed);
+
+    unsigned set = pimpl_->SetOf(key);
+    std::lock_guard<std::mutex> guard(*pimpl_->LockOf(set));
+
+    for (unsigned i = set * kNumWays; i < (set + 1) * kNumWays; ++i) {
+        CacheEntry &entry = pimpl_->entries[i];
+        if (!entry.occupied || entry.canonical_hash != key.canonical_hash ||
+            entry.model_version != key.model_version) {
+            continue;
+        }
+
+        assert(entry.policy.size() == ActionIdRangeSize(width, height));
+        entry.last_used = pimpl_->clock.fetch_add(1, std::memory_order_relaxed);
+
+        policy->resize(entry.policy.size());
+        TransformFlatPolicy(entry.policy.data(), InverseSymmetry(key.to_canonical), width, height,
+                            policy->data());
+        *value = entry.value;
+
+        pimpl_->num_hits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    return false;
+}
+
+void GomokuEvaluationCache::Insert(GomokuEvaluationCacheKey const &key, int16_t width,
+                                   int16_t height, std::vector<float> const &policy, float value) {
+    assert(policy.size() == ActionIdRangeSize(width, height));
+
+    std::vector<float> canonical_policy(policy.size());
+    TransformFlatPolicy(policy.data(), key.to_canonical, width, height, canonical_policy.data());
+
+    unsigned set = pimpl_->SetOf(key);
+    std::lock_guard<std::mutex> guard(*pimpl_->LockOf(set));
+
+    // Prefers the entry of the same key, then an empty entry, then the least recently used one.
+    CacheEntry *victim = nullptr;
+    for (unsigned i = set * kNumWays; i < (set + 1) * kNumWays; ++i) {
+        CacheEntry &entry = pimpl_->entries[i];
+        if (entry.occupied && entry.canonical_hash == key.canonical_hash &&
+            entry.model_version == key.model_version) {
+            victim = &entry;
+            break;
+        }
+        if (victim == nullptr || (victim->occupied && !entry.occupied) ||
+            (victim->occupied && entry.occupied && entry.last_used < victim->last_used)) {
+            victim = &entry;
+        }
+    }
+
+    if (victim->occupied && (victim->canonical_hash != key.canonical_hash ||
+                             victim->model_version != key.model_version)) {
+        pimpl_->num_evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    victim->occupied = true;
+    victim->canonical_hash = key.canonical_hash;
+    victim->model_version = key.model_version;
+    victim->last_used = pimpl_->clock.fetch_add(1, std::memory_order_relaxed);
+    victim->policy = std::move(canonical_policy);
+    victim->value = value;
+
+    pimpl_->num_insertions.fetch_add(1, std::memory_order_relaxed);
+}
+
+GomokuEvaluationCacheStats GomokuEvaluationCache::Stats() const {
+    GomokuEvaluationCacheStats stats;
+    stats.num_lookups = pimpl_->num_lookups.load(std::memory_order_relaxed);
+    stats.num_hits = pimpl_->num_hits.load(std::memory_order_relaxed);
+    stats.num_insertions = pimpl_->num_insertions.load(std::memory_order_relaxed);
+    stats.num_evictions = pimpl_->num_evictions.load(std::memory_order_relaxed);
+    return stats;
+}
+
+uint64_t ModelVersionOf(std::string const &model_path) {
+    return std::hash<std::string>()(model_path);
+}
+
+GomokuEvaluationCache *DefaultGomokuEvaluationCache() {
+    gCachePtrLock.lock();
+    if (gEvaluationCache == nullptr) {
+        gEvaluationCache = std::make_unique<GomokuEvaluationCache>(kDefaultCacheCapacity);
+    }
+    gCachePtrLock.unlock();
+
+    return gEvaluationCache.get();
+}
+
+} // namespace e8
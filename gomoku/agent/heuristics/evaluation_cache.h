@@ -0,0 +1,117 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EVALUATION_CACHE_H
+#define EVALUATION_CACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gomoku/game/board_state.h"
+#include "gomoku/game/board_symmetry.h"
+
+namespace e8 {
+
+/**
+ * @brief The GomokuEvaluationCacheKey struct Identifies a position up to the board symmetries,
+ * along with the model which evaluates it.
+ */
+struct GomokuEvaluationCacheKey {
+    // Hash of the canonical orientation of the position, see CanonicalSymmetry().
+    uint64_t canonical_hash;
+
+    // Maps the position to its canonical orientation.
+    BoardSymmetry to_canonical;
+
+    uint64_t model_version;
+};
+
+/**
+ * @brief The GomokuEvaluationCacheStats struct Usage of the cache since its construction.
+ */
+struct GomokuEvaluationCacheStats {
+    uint64_t num_lookups;
+    uint64_t num_hits;
+    uint64_t num_insertions;
+    uint64_t num_evictions;
+
+    float HitRate() const;
+};
+
+/**
+ * @brief The GomokuEvaluationCache class A bounded, thread-safe cache of the model outputs, see
+ * GomokuInferenceResult, keyed by position rather than by search node. It thus outlives searches
+ * and games: transpositions, symmetric positions and positions revisited by the next move's search
+ * are evaluated only once per model. It's set associative, and evicts the least recently used
+ * entry of a set.
+ */
+class GomokuEvaluationCache {
+  public:
+    /**
+     * @brief GomokuEvaluationCache Constructs an empty cache which holds at most capacity entries.
+     */
+    explicit GomokuEvaluationCache(unsigned capacity);
+    GomokuEvaluationCache(GomokuEvaluationCache const &) = delete;
+    GomokuEvaluationCache(GomokuEvaluationCache &&) = delete;
+    ~GomokuEvaluationCache();
+
+    /**
+     * @brief KeyOf Computes the key of the state under the model.
+     */
+    static GomokuEvaluationCacheKey KeyOf(GomokuBoardState const &state, uint64_t model_version);
+
+    /**
+     * @brief Find Looks up the evaluation of the state the key was computed from. The policy is
+     * returned in the orientation of that state.
+     *
+     * @return Whether there is a cached evaluation.
+     */
+    bool Find(GomokuEvaluationCacheKey const &key, int16_t width, int16_t height,
+              std::vector<float> *policy, float *value);
+
+    /**
+     * @brief Insert Caches the evaluation of the state the key was computed from. The policy is in
+     * the orientation of that state, and covers the whole action ID range.
+     */
+    void Insert(GomokuEvaluationCacheKey const &key, int16_t width, int16_t height,
+                std::vector<float> const &policy, float value);
+
+    /**
+     * @brief Stats Returns the hit rate and the other usage statistics.
+     */
+    GomokuEvaluationCacheStats Stats() const;
+
+  private:
+    struct GomokuEvaluationCacheInternal;
+    std::unique_ptr<GomokuEvaluationCacheInternal> pimpl_;
+};
+
+/**
+ * @brief ModelVersionOf Derives a model version from the path the model is loaded from.
+ */
+uint64_t ModelVersionOf(std::string const &model_path);
+
+/**
+ * @brief DefaultGomokuEvaluationCache Returns a pointer to the process wide evaluation cache.
+ */
+GomokuEvaluationCache *DefaultGomokuEvaluationCache();
+
+} // namespace e8
+
+#endif // EVALUATION_CACHE_H
@@ -17,4 +17,8 @@
 
 #include "gomoku/agent/heuristics/evaluator.h"
 
-namespace e8 {} // namespace e8
+namespace e8 {
+
+bool GomokuEvaluatorInterface::ThreadSafe() const { return false; }
+
+} // namespace e8
@@ -20,9 +20,9 @@
 
 #include <cstdint>
 #include <optional>
-#include <unordered_map>
 
 #include "gomoku/agent/search/mct_node.h"
+#include "gomoku/agent/search/policy.h"
 #include "gomoku/game/board_state.h"
 
 namespace e8 {
@@ -56,10 +56,12 @@ class GomokuEvaluatorInterface {
      * save computation by implementing incremental operations. The function should not depend on
      * this field for correct resuult.
      * @param state_id Different states are guaranteed to have different state_id.
+     * @param policy Caller supplied buffer which receives the policy. It's reset to the action IDs
+     * of the state, so illegal actions are left with a zero probability.
      */
-    virtual std::unordered_map<GomokuActionId, float>
-    EvaluatePolicy(GomokuBoardState const &state, std::optional<MctNodeId> parent_state_id,
-                   MctNodeId state_id) = 0;
+    virtual void EvaluatePolicy(GomokuBoardState const &state,
+                                std::optional<MctNodeId> parent_state_id, MctNodeId state_id,
+                                GomokuPolicy *policy) = 0;
 
     /**
      * @brief ExplorationFactor How exaggerated the upper confidence bound should it be for this
@@ -74,9 +76,16 @@ class GomokuEvaluatorInterface {
     virtual unsigned NumSimulations() const = 0;
 
     /**
-     * @brief ClearCache Clears any cached information.
+     * @brief ClearCache Clears any cached information which is only valid within one search. The
+     * model outputs in a GomokuEvaluationCache are kept.
      */
     virtual void ClearCache() = 0;
+
+    /**
+     * @brief ThreadSafe Whether EvaluateReward() and EvaluatePolicy() may be called concurrently
+     * from multiple search workers. When it returns false, the searcher serializes the calls.
+     */
+    virtual bool ThreadSafe() const;
 };
 
 } // namespace e8
@@ -15,27 +15,31 @@
  * not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cmath>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <thread>
 #include <unordered_map>
-#include <unordered_set>
+#include <vector>
 
 #include "common/random/random_distribution.h"
 #include "common/random/random_source.h"
-#include "common/random/uniform_distribution.h"
 #include "common/thread/thread_pool.h"
 #include "gomoku/agent/heuristics/evaluator.h"
 #include "gomoku/agent/heuristics/light_rollout_evaluator.h"
 #include "gomoku/agent/search/mct_node.h"
+#include "gomoku/agent/search/policy.h"
 #include "gomoku/game/board_state.h"
 
 namespace e8 {
 namespace {
 
+unsigned const kDefaultSeed = 13;
 unsigned const kNumValueSamples = 512;
 unsigned const kMaxSimulationSteps = 11;
 float const kRewardDiscount = 0.8f;
@@ -43,7 +47,7 @@ float const kRewardDiscount = 0.8f;
 class RolloutData : public TaskStorageInterface {
   public:
     RolloutData(GomokuBoardState const &board, ContourBuilder const &contour,
-                unsigned const num_samples, unsigned const job_idx);
+                unsigned const num_samples, unsigned const seed);
 
     bool SampleNext();
     float AccumulatedRewardFor(PlayerSide const stone_type) const;
@@ -63,8 +67,8 @@ class RolloutData : public TaskStorageInterface {
 };
 
 RolloutData::RolloutData(GomokuBoardState const &board, ContourBuilder const &contour_builder,
-                         unsigned const num_samples, unsigned const job_idx)
-    : board_(board), original_copy_(contour_builder), random_source_(31 * (job_idx + 47128)),
+                         unsigned const num_samples, unsigned const seed)
+    : board_(board), original_copy_(contour_builder), random_source_(seed),
       contour_builder_(contour_builder), reward_({0, 0}), num_samples_(num_samples) {
     max_sim_steps_ = kMaxSimulationSteps;
 }
@@ -78,29 +82,6 @@ void RolloutData::Reset() {
     }
 }
 
-MovePosition SelectRandomMoveFromContour(std::unordered_set<MovePosition> const &contour,
-                                         RandomSource *random_source) {
-    assert(!contour.empty());
-
-    std::vector<int> selector = DrawUniformInts(/*lower_bound=*/0, /*upper_bound=*/contour.size(),
-                                                /*num_instances=*/1, random_source);
-    assert(selector.size() == 1);
-
-    int i = 0;
-    MovePosition selected_move(/*x=*/-1, /*y=*/-1);
-    for (auto const &pos : contour) {
-        if (i == selector[0]) {
-            selected_move = pos;
-            break;
-        }
-        ++i;
-    }
-
-    assert(selected_move.x != -1 && selected_move.y != -1);
-
-    return selected_move;
-}
-
 bool RolloutData::SampleNext() {
     ++num_steps_;
 
@@ -109,8 +90,7 @@ bool RolloutData::SampleNext() {
         return false;
     }
 
-    MovePosition selected_move =
-        SelectRandomMoveFromContour(contour_builder_.Contour(), &random_source_);
+    MovePosition selected_move = contour_builder_.Sample(&random_source_);
     assert(selected_move.x >= 0 && selected_move.x < board_.Width());
     assert(selected_move.y >= 0 && selected_move.y < board_.Height());
     contour_builder_.AddStone(selected_move);
@@ -170,22 +150,41 @@ bool RolloutTask::DropResourceOnCompletion() const { return false; }
 
 struct GomokuLightRolloutEvaluator::GomokuLightRolloutEvaluatorInternal {
     ThreadPool thread_pool;
+    unsigned const seed;
     RandomSource random_source;
     std::unordered_map<MctNodeId, std::shared_ptr<ContourBuilder>> contour_cache;
 
-    GomokuLightRolloutEvaluatorInternal();
+    // Guards the random source and the contour cache.
+    std::mutex cache_lock;
+
+    // Held by the search worker which currently owns the thread pool.
+    std::mutex thread_pool_lock;
+
+    GomokuLightRolloutEvaluatorInternal(unsigned num_workers, unsigned seed);
 
-    std::unordered_map<MctNodeId, std::shared_ptr<ContourBuilder>>::const_iterator
-    FetchContour(MctNodeId const state_id, GomokuBoardState const &state);
+    /**
+     * @brief RolloutSeed Seed of the job_idx-th rollout job of an evaluation.
+     */
+    unsigned RolloutSeed(unsigned job_idx) const;
+
+    std::shared_ptr<ContourBuilder> FetchContour(MctNodeId const state_id,
+                                                 GomokuBoardState const &state);
 };
 
 GomokuLightRolloutEvaluator::GomokuLightRolloutEvaluatorInternal::
-    GomokuLightRolloutEvaluatorInternal()
-    : random_source(13) {}
+    GomokuLightRolloutEvaluatorInternal(unsigned num_workers, unsigned seed)
+    : thread_pool(std::max(1U, num_workers)), seed(seed), random_source(seed) {}
+
+unsigned GomokuLightRolloutEvaluator::GomokuLightRolloutEvaluatorInternal::RolloutSeed(
+    unsigned job_idx) const {
+    return seed + 31 * (job_idx + 47128);
+}
 
-std::unordered_map<MctNodeId, std::shared_ptr<ContourBuilder>>::const_iterator
+std::shared_ptr<ContourBuilder>
 GomokuLightRolloutEvaluator::GomokuLightRolloutEvaluatorInternal::FetchContour(
     MctNodeId const state_id, GomokuBoardState const &state) {
+    std::lock_guard<std::mutex> guard(cache_lock);
+
     auto contour_cache_it = contour_cache.find(state_id);
     if (contour_cache_it == contour_cache.end()) {
         contour_cache_it = contour_cache
@@ -194,11 +193,14 @@ GomokuLightRolloutEvaluator::GomokuLightRolloutEvaluatorInternal::FetchContour(
                                .first;
     }
 
-    return contour_cache_it;
+    return contour_cache_it->second;
 }
 
 GomokuLightRolloutEvaluator::GomokuLightRolloutEvaluator()
-    : pimpl_(std::make_unique<GomokuLightRolloutEvaluatorInternal>()) {}
+    : GomokuLightRolloutEvaluator(std::thread::hardware_concurrency(), kDefaultSeed) {}
+
+GomokuLightRolloutEvaluator::GomokuLightRolloutEvaluator(unsigned num_workers, unsigned seed)
+    : pimpl_(std::make_unique<GomokuLightRolloutEvaluatorInternal>(num_workers, seed)) {}
 
 GomokuLightRolloutEvaluator::~GomokuLightRolloutEvaluator() {}
 
@@ -218,21 +220,37 @@ float GomokuLightRolloutEvaluator::EvaluateReward(GomokuBoardState const &state,
     case GP_STANDARD_GOMOKU: {
         auto task = std::make_shared<RolloutTask>();
 
-        auto contour_cache_it = pimpl_->FetchContour(state_id, state);
+        std::shared_ptr<ContourBuilder> contour = pimpl_->FetchContour(state_id, state);
+
+        std::vector<std::unique_ptr<TaskStorageInterface>> rollouts;
+        std::unique_lock<std::mutex> thread_pool_guard(pimpl_->thread_pool_lock,
+                                                       std::try_to_lock);
+        if (thread_pool_guard.owns_lock()) {
+            unsigned const num_parallelism = pimpl_->thread_pool.NumWorkers();
+            for (unsigned job_idx = 0; job_idx < num_parallelism; ++job_idx) {
+                auto rollout_data = std::make_unique<RolloutData>(
+                    state, *contour, kNumValueSamples / num_parallelism,
+                    pimpl_->RolloutSeed(job_idx));
+                pimpl_->thread_pool.Schedule(task, std::move(rollout_data));
+            }
+
+            for (unsigned i = 0; i < num_parallelism; ++i) {
+                rollouts.push_back(pimpl_->thread_pool.WaitForNextCompleted());
+            }
 
-        unsigned const num_parallelism = pimpl_->thread_pool.NumWorkers();
-        // unsigned const num_parallelism = 1;
-        for (unsigned job_idx = 0; job_idx < num_parallelism; ++job_idx) {
+            thread_pool_guard.unlock();
+        } else {
+            // Another search worker is using the thread pool. Rolls out on the calling thread
+            // instead of waiting for it.
             auto rollout_data = std::make_unique<RolloutData>(
-                state, *contour_cache_it->second, kNumValueSamples / num_parallelism, job_idx);
-            pimpl_->thread_pool.Schedule(task, std::move(rollout_data));
+                state, *contour, kNumValueSamples, pimpl_->RolloutSeed(/*job_idx=*/0));
+            task->Run(rollout_data.get());
+            rollouts.push_back(std::move(rollout_data));
         }
 
         float reward_diff = 0.0f;
         float total_reward = 0.0f;
-        for (unsigned i = 0; i < num_parallelism; ++i) {
-            std::unique_ptr<TaskStorageInterface> rollout_data =
-                pimpl_->thread_pool.WaitForNextCompleted();
+        for (auto const &rollout_data : rollouts) {
             float wins = static_cast<RolloutData *>(rollout_data.get())
                              ->AccumulatedRewardFor(state.CurrentPlayerSide());
             float losses = static_cast<RolloutData *>(rollout_data.get())
@@ -259,48 +277,49 @@ float GomokuLightRolloutEvaluator::EvaluateReward(GomokuBoardState const &state,
     return value;
 }
 
-std::unordered_map<GomokuActionId, float>
-GomokuLightRolloutEvaluator::EvaluatePolicy(GomokuBoardState const &state,
-                                            std::optional<MctNodeId> /*parent_state_id*/,
-                                            MctNodeId state_id) {
-    std::unordered_map<GomokuActionId, float> policy;
+void GomokuLightRolloutEvaluator::EvaluatePolicy(GomokuBoardState const &state,
+                                                 std::optional<MctNodeId> /*parent_state_id*/,
+                                                 MctNodeId state_id, GomokuPolicy *policy) {
+    policy->Reset(state);
 
     switch (state.CurrentGamePhase()) {
     case GP_PLACE_3_STONES:
     case GP_SWAP2_DECISION:
     case GP_SWAP2_PLACE_2_STONES:
     case GP_STONE_TYPE_DECISION: {
-        std::vector<float> random_pmf =
-            RandomPmf(state.LegalActions().size(), &pimpl_->random_source);
+        std::vector<float> random_pmf;
+        {
+            std::lock_guard<std::mutex> guard(pimpl_->cache_lock);
+            random_pmf = RandomPmf(state.LegalActions().size(), &pimpl_->random_source);
+        }
         unsigned selector = 0;
         for (auto const &[action_id, _] : state.LegalActions()) {
-            policy[action_id] = random_pmf[selector++];
+            (*policy)[action_id] = random_pmf[selector++];
         }
         break;
     }
     case GP_STANDARD_GOMOKU: {
-        auto contour_cache_it = pimpl_->FetchContour(state_id, state);
-
-        float uniform = 1.0f / contour_cache_it->second->Contour().size();
-        for (auto const &[action_id, action] : state.LegalActions()) {
-            if (contour_cache_it->second->Contour().find(*action.stone_pos) !=
-                contour_cache_it->second->Contour().end()) {
-                policy[action_id] = uniform;
-            } else {
-                policy[action_id] = 0.0f;
-            }
+        std::shared_ptr<ContourBuilder> contour = pimpl_->FetchContour(state_id, state);
+
+        // The contour only holds empty positions, and the rest of the legal actions stay at zero.
+        float uniform = 1.0f / contour->Contour().size();
+        for (MovePosition const &pos : contour->Contour()) {
+            (*policy)[state.MovePositionToActionId(pos)] = uniform;
         }
         break;
     }
     }
-
-    return policy;
 }
 
 float GomokuLightRolloutEvaluator::ExplorationFactor() const { return 2; }
 
 unsigned GomokuLightRolloutEvaluator::NumSimulations() const { return 6000; }
 
-void GomokuLightRolloutEvaluator::ClearCache() { pimpl_->contour_cache.clear(); }
+void GomokuLightRolloutEvaluator::ClearCache() {
+    std::lock_guard<std::mutex> guard(pimpl_->cache_lock);
+    pimpl_->contour_cache.clear();
+}
+
+bool GomokuLightRolloutEvaluator::ThreadSafe() const { return true; }
 
 } // namespace e8
@@ -20,13 +20,13 @@
 
 #include <memory>
 #include <optional>
-#include <unordered_map>
 #include <unordered_set>
 
 #include "common/thread/thread_pool.h"
 #include "gomoku/agent/heuristics/contour.h"
 #include "gomoku/agent/heuristics/evaluator.h"
 #include "gomoku/agent/search/mct_node.h"
+#include "gomoku/agent/search/policy.h"
 #include "gomoku/game/board_state.h"
 
 namespace e8 {
@@ -37,15 +37,23 @@ namespace e8 {
  */
 class GomokuLightRolloutEvaluator : public GomokuEvaluatorInterface {
   public:
+    /**
+     * @brief GomokuLightRolloutEvaluator Rolls out with one worker per hardware thread.
+     */
     GomokuLightRolloutEvaluator();
+
+    /**
+     * @brief GomokuLightRolloutEvaluator Rolls out with num_workers workers. The rewards and
+     * policies are reproducible for a given seed and number of workers.
+     */
+    GomokuLightRolloutEvaluator(unsigned num_workers, unsigned seed);
     ~GomokuLightRolloutEvaluator() override;
 
     float EvaluateReward(GomokuBoardState const &state, std::optional<MctNodeId> parent_state_id,
                          MctNodeId state_id) override;
 
-    std::unordered_map<GomokuActionId, float>
-    EvaluatePolicy(GomokuBoardState const &state, std::optional<MctNodeId> parent_state_id,
-                   MctNodeId state_id) override;
+    void EvaluatePolicy(GomokuBoardState const &state, std::optional<MctNodeId> parent_state_id,
+                        MctNodeId state_id, GomokuPolicy *policy) override;
 
     float ExplorationFactor() const override;
 
@@ -53,6 +61,8 @@ class GomokuLightRolloutEvaluator : public GomokuEvaluatorInterface {
 
     void ClearCache() override;
 
+    bool ThreadSafe() const override;
+
   private:
     struct GomokuLightRolloutEvaluatorInternal;
     std::unique_ptr<GomokuLightRolloutEvaluatorInternal> pimpl_;
@@ -0,0 +1,768 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include "gomoku/agent/heuristics/native_cnn.h"
+
+namespace e8 {
+namespace {
+
+char const kWeightFileMagic[4] = {'E', '8', 'N', 'N'};
+uint32_t const kWeightFileVersion = 1;
+
+// Tensor indices in NativeCnnWeights, see cnn_shared_model.TrainableVariables().
+enum WeightIndex {
+    WI_CONV_KERNEL1,
+    WI_CONV_BIASES1,
+    WI_CONV_KERNEL2,
+    WI_CONV_BIASES2,
+    WI_CONV_KERNEL3,
+    WI_CONV_BIASES3,
+    WI_PRELU1,
+    WI_PRELU2,
+    WI_PRELU3,
+    WI_POLICY_CONV_KERNEL,
+    WI_POLICY_CONV_BIASES,
+    WI_POLICY_PRELU,
+    WI_POLICY_WEIGHTS,
+    WI_POLICY_BIASES,
+    WI_VALUE_CONV_KERNEL,
+    WI_VALUE_CONV_BIASES,
+    WI_VALUE_PRELU,
+    WI_VALUE_WEIGHTS1,
+    WI_VALUE_BIASES1,
+    WI_VALUE_WEIGHTS2,
+    WI_VALUE_BIASES2,
+    WI_NUM_TENSORS,
+};
+
+// Black stone, white stone, 5 game phases and 3 next move stone types.
+unsigned const kNumInputPlanes = 2 + 5 + 3;
+
+#if defined(__AVX512F__)
+
+unsigned const kLanes = 16;
+char const *kInstructionSet = "avx512";
+
+using FloatVec = __m512;
+
+inline FloatVec LoadF(float const *p) { return _mm512_loadu_ps(p); }
+inline void StoreF(float *p, FloatVec v) { _mm512_storeu_ps(p, v); }
+inline FloatVec BroadcastF(float x) { return _mm512_set1_ps(x); }
+inline FloatVec MulAddF(FloatVec a, FloatVec b, FloatVec c) { return _mm512_fmadd_ps(a, b, c); }
+inline FloatVec PReluF(FloatVec x, FloatVec alpha) {
+    __mmask16 negative = _mm512_cmp_ps_mask(x, _mm512_setzero_ps(), _CMP_LT_OQ);
+    return _mm512_mask_mul_ps(x, negative, x, alpha);
+}
+
+#elif defined(__AVX2__) && defined(__FMA__)
+
+unsigned const kLanes = 8;
+char const *kInstructionSet = "avx2";
+
+using FloatVec = __m256;
+
+inline FloatVec LoadF(float const *p) { return _mm256_loadu_ps(p); }
+inline void StoreF(float *p, FloatVec v) { _mm256_storeu_ps(p, v); }
+inline FloatVec BroadcastF(float x) { return _mm256_set1_ps(x); }
+inline FloatVec MulAddF(FloatVec a, FloatVec b, FloatVec c) { return _mm256_fmadd_ps(a, b, c); }
+inline FloatVec PReluF(FloatVec x, FloatVec alpha) {
+    FloatVec zero = _mm256_setzero_ps();
+    return _mm256_fmadd_ps(alpha, _mm256_min_ps(x, zero), _mm256_max_ps(x, zero));
+}
+
+#else
+
+unsigned const kLanes = 1;
+char const *kInstructionSet = "scalar";
+
+using FloatVec = float;
+
+inline FloatVec LoadF(float const *p) { return *p; }
+inline void StoreF(float *p, FloatVec v) { *p = v; }
+inline FloatVec BroadcastF(float x) { return x; }
+inline FloatVec MulAddF(FloatVec a, FloatVec b, FloatVec c) { return a * b + c; }
+inline FloatVec PReluF(FloatVec x, FloatVec alpha) { return x > 0 ? x : alpha * x; }
+
+#endif
+
+// The int8 kernels multiply pairs of adjacent input channels at once. A PairVec holds either an
+// input channel pair broadcasted over all lanes or one weight pair per output channel, widened to
+// int16. An Int32Vec holds one accumulator per output channel. Output channel strides are padded to
+// kLanes, which is always a multiple of kPairLanes.
+#if defined(__AVX512BW__)
+
+unsigned const kPairLanes = 16;
+
+using PairVec = __m512i;
+using Int32Vec = __m512i;
+
+inline Int32Vec ZeroI() { return _mm512_setzero_si512(); }
+inline PairVec BroadcastPair(int16_t const *p) {
+    int32_t pair;
+    std::memcpy(&pair, p, sizeof(pair));
+    return _mm512_set1_epi32(pair);
+}
+inline PairVec LoadWeightPairs(int8_t const *p) {
+    return _mm512_cvtepi8_epi16(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(p)));
+}
+inline Int32Vec MulAddPairs(PairVec a, PairVec w, Int32Vec acc) {
+#if defined(__AVX512VNNI__)
+    return _mm512_dpwssd_epi32(acc, a, w);
+#else
+    return _mm512_add_epi32(acc, _mm512_madd_epi16(a, w));
+#endif
+}
+inline void StoreI(int32_t *p, Int32Vec v) { _mm512_storeu_si512(p, v); }
+
+#elif defined(__AVX2__)
+
+unsigned const kPairLanes = 8;
+
+using PairVec = __m256i;
+using Int32Vec = __m256i;
+
+inline Int32Vec ZeroI() { return _mm256_setzero_si256(); }
+inline PairVec BroadcastPair(int16_t const *p) {
+    int32_t pair;
+    std::memcpy(&pair, p, sizeof(pair));
+    return _mm256_set1_epi32(pair);
+}
+inline PairVec LoadWeightPairs(int8_t const *p) {
+    return _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<__m128i const *>(p)));
+}
+inline Int32Vec MulAddPairs(PairVec a, PairVec w, Int32Vec acc) {
+#if defined(__AVXVNNI__)
+    return _mm256_dpwssd_avx_epi32(acc, a, w);
+#else
+    return _mm256_add_epi32(acc, _mm256_madd_epi16(a, w));
+#endif
+}
+inline void StoreI(int32_t *p, Int32Vec v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+}
+
+#else
+
+unsigned const kPairLanes = 1;
+
+struct PairVec {
+    int32_t lo;
+    int32_t hi;
+};
+using Int32Vec = int32_t;
+
+inline Int32Vec ZeroI() { return 0; }
+inline PairVec BroadcastPair(int16_t const *p) { return PairVec{p[0], p[1]}; }
+inline PairVec LoadWeightPairs(int8_t const *p) { return PairVec{p[0], p[1]}; }
+inline Int32Vec MulAddPairs(PairVec a, PairVec w, Int32Vec acc) {
+    return acc + a.lo * w.lo + a.hi * w.hi;
+}
+inline void StoreI(int32_t *p, Int32Vec v) { *p = v; }
+
+#endif
+
+unsigned RoundUp(unsigned n, unsigned multiple) { return (n + multiple - 1) / multiple * multiple; }
+
+/**
+ * @brief PaddedChannels Channel strides are padded to whole vectors so that the kernels never
+ * need a tail loop. They are kept even so that the int8 kernels can consume channels in pairs.
+ */
+unsigned PaddedChannels(unsigned num_channels) {
+    return RoundUp(num_channels, std::max(kLanes, 2U));
+}
+
+/**
+ * @brief The ConvLayer struct A "SAME" padded, stride 1 convolution followed by PReLU. Dense
+ * layers are represented as 1x1 convolutions over a 1x1 board, and a layer without activation has
+ * all its PReLU slopes set to 1.
+ */
+struct ConvLayer {
+    unsigned kernel_size;
+    unsigned input_stride;
+    unsigned num_outputs;
+    unsigned output_stride;
+
+    // [kernel_size*kernel_size][input_stride][output_stride]
+    std::vector<float> kernel;
+    std::vector<float> biases;
+    std::vector<float> alphas;
+
+    // Only built for NCP_INT8. [kernel_size*kernel_size][input_stride/2][output_stride][2]
+    std::vector<int8_t> quantized_kernel;
+    std::vector<float> kernel_scales;
+};
+
+ConvLayer PackConvLayer(NativeCnnTensor const &kernel, NativeCnnTensor const &biases,
+                        NativeCnnTensor const *alphas, unsigned input_stride) {
+    assert(kernel.dims.size() == 4 || kernel.dims.size() == 2);
+
+    // Dense weights are [num_inputs, num_outputs].
+    unsigned kernel_size = kernel.dims.size() == 4 ? kernel.dims[0] : 1;
+    unsigned num_inputs = kernel.dims[kernel.dims.size() - 2];
+    unsigned num_outputs = kernel.dims[kernel.dims.size() - 1];
+    assert(kernel.dims.size() == 2 || kernel.dims[1] == kernel_size);
+    assert(num_inputs <= input_stride);
+    assert(biases.values.size() == num_outputs);
+    assert(alphas == nullptr || alphas->values.size() == num_outputs);
+
+    ConvLayer layer;
+    layer.kernel_size = kernel_size;
+    layer.input_stride = input_stride;
+    layer.num_outputs = num_outputs;
+    layer.output_stride = PaddedChannels(num_outputs);
+
+    unsigned num_taps = kernel_size * kernel_size;
+    layer.kernel.resize(num_taps * input_stride * layer.output_stride, 0.0f);
+    for (unsigned tap = 0; tap < num_taps; ++tap) {
+        for (unsigned ci = 0; ci < num_inputs; ++ci) {
+            for (unsigned co = 0; co < num_outputs; ++co) {
+                layer.kernel[(tap * input_stride + ci) * layer.output_stride + co] =
+                    kernel.values[(tap * num_inputs + ci) * num_outputs + co];
+            }
+        }
+    }
+
+    layer.biases.resize(layer.output_stride, 0.0f);
+    std::copy(biases.values.begin(), biases.values.end(), layer.biases.begin());
+
+    layer.alphas.resize(layer.output_stride, 1.0f);
+    if (alphas != nullptr) {
+        std::copy(alphas->values.begin(), alphas->values.end(), layer.alphas.begin());
+    }
+
+    return layer;
+}
+
+/**
+ * @brief QuantizeConvLayer Symmetric per output channel quantization of the kernel.
+ */
+void QuantizeConvLayer(ConvLayer *layer) {
+    assert(layer->input_stride % 2 == 0);
+
+    unsigned num_taps = layer->kernel_size * layer->kernel_size;
+    layer->kernel_scales.resize(layer->output_stride);
+    for (unsigned co = 0; co < layer->output_stride; ++co) {
+        float max_magnitude = 0.0f;
+        for (unsigned i = 0; i < num_taps * layer->input_stride; ++i) {
+            max_magnitude =
+                std::max(max_magnitude, std::abs(layer->kernel[i * layer->output_stride + co]));
+        }
+        layer->kernel_scales[co] = max_magnitude > 0.0f ? max_magnitude / 127.0f : 1.0f;
+    }
+
+    layer->quantized_kernel.resize(layer->kernel.size());
+    for (unsigned tap = 0; tap < num_taps; ++tap) {
+        for (unsigned ci = 0; ci < layer->input_stride; ++ci) {
+            for (unsigned co = 0; co < layer->output_stride; ++co) {
+                float w =
+                    layer->kernel[(tap * layer->input_stride + ci) * layer->output_stride + co];
+                unsigned pair_offset =
+                    ((tap * layer->input_stride / 2 + ci / 2) * layer->output_stride + co) * 2;
+                layer->quantized_kernel[pair_offset + ci % 2] =
+                    static_cast<int8_t>(std::lrint(w / layer->kernel_scales[co]));
+            }
+        }
+    }
+}
+
+/**
+ * @brief The Grid struct Layout of an activation buffer: positions are stored x-major with a zero
+ * border around the board, so that convolutions don't need bounds checks. Every position holds a
+ * channel stride worth of activations.
+ */
+struct Grid {
+    int Index(int x, int y) const {
+        return (x + static_cast<int>(border)) * static_cast<int>(height + 2 * border) + y +
+               static_cast<int>(border);
+    }
+
+    unsigned NumCells() const { return (width + 2 * border) * (height + 2 * border); }
+
+    unsigned width;
+    unsigned height;
+    unsigned border;
+};
+
+// A tile computes kTilePositions consecutive positions along y at once, so that every weight vector
+// loaded is reused that many times. kTileVecs bounds the number of output channel vectors per tile
+// by the number of vector registers.
+#if defined(__AVX512F__)
+unsigned const kTilePositions = 4;
+unsigned const kTileVecs = 4;
+#elif defined(__AVX2__) && defined(__FMA__)
+unsigned const kTilePositions = 4;
+unsigned const kTileVecs = 2;
+#else
+// Scalar lanes. A single position with enough of them lets the compiler vectorize across output
+// channels instead.
+unsigned const kTilePositions = 1;
+unsigned const kTileVecs = 8;
+#endif
+
+/**
+ * @brief ConvolveTile Computes kNumVecs vectors of output channels starting from co_begin, for the
+ * kNumPositions positions starting from (x, y). The accumulators stay in registers for the whole
+ * receptive field.
+ */
+template <unsigned kNumPositions, unsigned kNumVecs>
+void ConvolveTile(ConvLayer const &layer, Grid const &in_grid, float const *input,
+                  Grid const &out_grid, int x, int y, unsigned co_begin, float *output) {
+    int pad = static_cast<int>(layer.kernel_size) / 2;
+
+    FloatVec acc[kNumPositions][kNumVecs];
+    for (unsigned v = 0; v < kNumVecs; ++v) {
+        FloatVec bias = LoadF(layer.biases.data() + co_begin + v * kLanes);
+        for (unsigned p = 0; p < kNumPositions; ++p) {
+            acc[p][v] = bias;
+        }
+    }
+
+    for (int kx = 0; kx < static_cast<int>(layer.kernel_size); ++kx) {
+        for (int ky = 0; ky < static_cast<int>(layer.kernel_size); ++ky) {
+            float const *in =
+                input + in_grid.Index(x + kx - pad, y + ky - pad) * layer.input_stride;
+            float const *w = layer.kernel.data() +
+                             (kx * layer.kernel_size + ky) * layer.input_stride *
+                                 layer.output_stride +
+                             co_begin;
+
+            for (unsigned ci = 0; ci < layer.input_stride; ++ci) {
+                FloatVec a[kNumPositions];
+                for (unsigned p = 0; p < kNumPositions; ++p) {
+                    a[p] = BroadcastF(in[p * layer.input_stride + ci]);
+                }
+                for (unsigned v = 0; v < kNumVecs; ++v) {
+                    FloatVec wv = LoadF(w + v * kLanes);
+                    for (unsigned p = 0; p < kNumPositions; ++p) {
+                        acc[p][v] = MulAddF(a[p], wv, acc[p][v]);
+                    }
+                }
+                w += layer.output_stride;
+            }
+        }
+    }
+
+    for (unsigned v = 0; v < kNumVecs; ++v) {
+        FloatVec alpha = LoadF(layer.alphas.data() + co_begin + v * kLanes);
+        for (unsigned p = 0; p < kNumPositions; ++p) {
+            float *out = output + out_grid.Index(x, y + p) * layer.output_stride + co_begin;
+            StoreF(out + v * kLanes, PReluF(acc[p][v], alpha));
+        }
+    }
+}
+
+template <unsigned kNumVecs>
+void ConvolveChannels(ConvLayer const &layer, Grid const &in_grid, float const *input,
+                      Grid const &out_grid, unsigned co_begin, float *output) {
+    for (int x = 0; x < static_cast<int>(in_grid.width); ++x) {
+        int y = 0;
+        for (; y + static_cast<int>(kTilePositions) <= static_cast<int>(in_grid.height);
+             y += kTilePositions) {
+            ConvolveTile<kTilePositions, kNumVecs>(layer, in_grid, input, out_grid, x, y,
+                                                   co_begin, output);
+        }
+        for (; y < static_cast<int>(in_grid.height); ++y) {
+            ConvolveTile<1, kNumVecs>(layer, in_grid, input, out_grid, x, y, co_begin, output);
+        }
+    }
+}
+
+void Convolve(ConvLayer const &layer, Grid const &in_grid, float const *input,
+              Grid const &out_grid, float *output) {
+    assert(in_grid.border >= layer.kernel_size / 2);
+    assert(in_grid.width == out_grid.width && in_grid.height == out_grid.height);
+
+    unsigned co = 0;
+    for (; co + kTileVecs * kLanes <= layer.output_stride; co += kTileVecs * kLanes) {
+        ConvolveChannels<kTileVecs>(layer, in_grid, input, out_grid, co, output);
+    }
+    for (; co < layer.output_stride; co += kLanes) {
+        ConvolveChannels<1>(layer, in_grid, input, out_grid, co, output);
+    }
+}
+
+/**
+ * @brief QuantizeActivations Symmetric per tensor quantization. Returns the scale.
+ */
+float QuantizeActivations(float const *activations, unsigned size, int16_t *quantized) {
+    float max_magnitude = 0.0f;
+    for (unsigned i = 0; i < size; ++i) {
+        max_magnitude = std::max(max_magnitude, std::abs(activations[i]));
+    }
+    float scale = max_magnitude > 0.0f ? max_magnitude / 127.0f : 1.0f;
+
+    // Rounds half away from zero rather than with std::lrint(), which isn't vectorized.
+    float inv_scale = 1.0f / scale;
+    for (unsigned i = 0; i < size; ++i) {
+        float q = activations[i] * inv_scale;
+        quantized[i] = static_cast<int16_t>(q >= 0.0f ? q + 0.5f : q - 0.5f);
+    }
+    return scale;
+}
+
+/**
+ * @brief ConvolveTileInt8 The int8 counterpart of ConvolveTile(). Accumulators are rescaled to
+ * float before the bias and the activation are applied.
+ */
+template <unsigned kNumPositions, unsigned kNumVecs>
+void ConvolveTileInt8(ConvLayer const &layer, Grid const &in_grid, int16_t const *input,
+                      float input_scale, Grid const &out_grid, int x, int y, unsigned co_begin,
+                      float *output) {
+    int pad = static_cast<int>(layer.kernel_size) / 2;
+    unsigned num_input_pairs = layer.input_stride / 2;
+
+    Int32Vec acc[kNumPositions][kNumVecs];
+    for (unsigned p = 0; p < kNumPositions; ++p) {
+        for (unsigned v = 0; v < kNumVecs; ++v) {
+            acc[p][v] = ZeroI();
+        }
+    }
+
+    for (int kx = 0; kx < static_cast<int>(layer.kernel_size); ++kx) {
+        for (int ky = 0; ky < static_cast<int>(layer.kernel_size); ++ky) {
+            int16_t const *in =
+                input + in_grid.Index(x + kx - pad, y + ky - pad) * layer.input_stride;
+            int8_t const *w =
+                layer.quantized_kernel.data() +
+                ((kx * layer.kernel_size + ky) * num_input_pairs * layer.output_stride + co_begin) *
+                    2;
+
+            for (unsigned cp = 0; cp < num_input_pairs; ++cp) {
+                PairVec a[kNumPositions];
+                for (unsigned p = 0; p < kNumPositions; ++p) {
+                    a[p] = BroadcastPair(in + p * layer.input_stride + 2 * cp);
+                }
+                for (unsigned v = 0; v < kNumVecs; ++v) {
+                    PairVec wv = LoadWeightPairs(w + 2 * v * kPairLanes);
+                    for (unsigned p = 0; p < kNumPositions; ++p) {
+                        acc[p][v] = MulAddPairs(a[p], wv, acc[p][v]);
+                    }
+                }
+                w += 2 * layer.output_stride;
+            }
+        }
+    }
+
+    for (unsigned p = 0; p < kNumPositions; ++p) {
+        int32_t sums[kNumVecs * kPairLanes];
+        for (unsigned v = 0; v < kNumVecs; ++v) {
+            StoreI(sums + v * kPairLanes, acc[p][v]);
+        }
+
+        float *out = output + out_grid.Index(x, y + p) * layer.output_stride + co_begin;
+        for (unsigned i = 0; i < kNumVecs * kPairLanes; ++i) {
+            unsigned co = co_begin + i;
+            float linear =
+                static_cast<float>(sums[i]) * input_scale * layer.kernel_scales[co] +
+                layer.biases[co];
+            out[i] = linear > 0.0f ? linear : layer.alphas[co] * linear;
+        }
+    }
+}
+
+template <unsigned kNumVecs>
+void ConvolveChannelsInt8(ConvLayer const &layer, Grid const &in_grid, int16_t const *input,
+                          float input_scale, Grid const &out_grid, unsigned co_begin,
+                          float *output) {
+    for (int x = 0; x < static_cast<int>(in_grid.width); ++x) {
+        int y = 0;
+        for (; y + static_cast<int>(kTilePositions) <= static_cast<int>(in_grid.height);
+             y += kTilePositions) {
+            ConvolveTileInt8<kTilePositions, kNumVecs>(layer, in_grid, input, input_scale,
+                                                       out_grid, x, y, co_begin, output);
+        }
+        for (; y < static_cast<int>(in_grid.height); ++y) {
+            ConvolveTileInt8<1, kNumVecs>(layer, in_grid, input, input_scale, out_grid, x, y,
+                                          co_begin, output);
+        }
+    }
+}
+
+void ConvolveInt8(ConvLayer const &layer, Grid const &in_grid, int16_t const *input,
+                  float input_scale, Grid const &out_grid, float *output) {
+    assert(in_grid.border >= layer.kernel_size / 2);
+    assert(in_grid.width == out_grid.width && in_grid.height == out_grid.height);
+
+    unsigned co = 0;
+    for (; co + kTileVecs * kPairLanes <= layer.output_stride; co += kTileVecs * kPairLanes) {
+        ConvolveChannelsInt8<kTileVecs>(layer, in_grid, input, input_scale, out_grid, co,
+                                        output);
+    }
+    for (; co < layer.output_stride; co += kPairLanes) {
+        ConvolveChannelsInt8<1>(layer, in_grid, input, input_scale, out_grid, co, output);
+    }
+}
+
+/**
+ * @brief Flatten Packs the first num_channels channels of every position into a dense vector,
+ * dropping the channel padding. The result is zero padded to input_stride.
+ */
+void Flatten(float const *input, unsigned num_positions, unsigned channel_stride,
+             unsigned num_channels, unsigned input_stride, float *output) {
+    for (unsigned pos = 0; pos < num_positions; ++pos) {
+        std::copy(input + pos * channel_stride, input + pos * channel_stride + num_channels,
+                  output + pos * num_channels);
+    }
+    std::fill(output + num_positions * num_channels, output + input_stride, 0.0f);
+}
+
+} // namespace
+
+NativeCnnWeights LoadNativeCnnWeights(std::string const &path) {
+    std::ifstream file(path, std::ios::binary);
+    assert(file.is_open());
+
+    auto read_u32 = [&file]() {
+        uint32_t value;
+        file.read(reinterpret_cast<char *>(&value), sizeof(value));
+        assert(file.good());
+        return value;
+    };
+
+    char magic[sizeof(kWeightFileMagic)];
+    file.read(magic, sizeof(magic));
+    assert(std::memcmp(magic, kWeightFileMagic, sizeof(magic)) == 0);
+    uint32_t version = read_u32();
+    assert(version == kWeightFileVersion);
+
+    NativeCnnWeights weights;
+    weights.board_width = read_u32();
+    weights.board_height = read_u32();
+
+    weights.tensors.resize(read_u32());
+    for (NativeCnnTensor &tensor : weights.tensors) {
+        tensor.dims.resize(read_u32());
+
+        unsigned size = 1;
+        for (unsigned &dim : tensor.dims) {
+            dim = read_u32();
+            size *= dim;
+        }
+
+        tensor.values.resize(size);
+        file.read(reinterpret_cast<char *>(tensor.values.data()), size * sizeof(float));
+        assert(file.good());
+    }
+
+    return weights;
+}
+
+void SaveNativeCnnWeights(NativeCnnWeights const &weights, std::string const &path) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    assert(file.is_open());
+
+    auto write_u32 = [&file](uint32_t value) {
+        file.write(reinterpret_cast<char const *>(&value), sizeof(value));
+    };
+
+    file.write(kWeightFileMagic, sizeof(kWeightFileMagic));
+    write_u32(kWeightFileVersion);
+    write_u32(weights.board_width);
+    write_u32(weights.board_height);
+
+    write_u32(weights.tensors.size());
+    for (NativeCnnTensor const &tensor : weights.tensors) {
+        write_u32(tensor.dims.size());
+        for (unsigned dim : tensor.dims) {
+            write_u32(dim);
+        }
+        file.write(reinterpret_cast<char const *>(tensor.values.data()),
+                   tensor.values.size() * sizeof(float));
+    }
+
+    assert(file.good());
+}
+
+struct NativeCnnModel::NativeCnnModelInternal {
+    NativeCnnModelInternal(NativeCnnWeights const &weights, NativeCnnPrecision precision);
+
+    unsigned width;
+    unsigned height;
+    NativeCnnPrecision precision;
+
+    // The tower reads bordered activations, whereas the heads write compact ones which are
+    // flattened for the dense layers.
+    Grid tower_grid;
+    Grid head_grid;
+    Grid dense_grid;
+
+    std::vector<ConvLayer> tower;
+
+    ConvLayer policy_conv;
+    ConvLayer policy_dense;
+
+    ConvLayer value_conv;
+    ConvLayer value_dense1;
+    ConvLayer value_dense2;
+
+    // Scratch buffers, reused by every Run(). Every tower layer has its own output buffer, so that
+    // the zero border is never overwritten.
+    std::vector<std::vector<float>> activations;
+    std::vector<int16_t> quantized_activations;
+    std::vector<float> head_features;
+    std::vector<float> flattened;
+    std::vector<float> dense_outputs[2];
+};
+
+NativeCnnModel::NativeCnnModelInternal::NativeCnnModelInternal(NativeCnnWeights const &weights,
+                                                               NativeCnnPrecision precision)
+    : width(weights.board_width), height(weights.board_height), precision(precision),
+      tower_grid{width, height, /*border=*/0}, head_grid{width, height, /*border=*/0},
+      dense_grid{/*width=*/1, /*height=*/1, /*border=*/0} {
+    assert(weights.tensors.size() == WI_NUM_TENSORS);
+    std::vector<NativeCnnTensor> const &t = weights.tensors;
+
+    tower.push_back(PackConvLayer(t[WI_CONV_KERNEL1], t[WI_CONV_BIASES1], &t[WI_PRELU1],
+                                  /*input_stride=*/kNumInputPlanes));
+    tower.push_back(PackConvLayer(t[WI_CONV_KERNEL2], t[WI_CONV_BIASES2], &t[WI_PRELU2],
+                                  tower.back().output_stride));
+    tower.push_back(PackConvLayer(t[WI_CONV_KERNEL3], t[WI_CONV_BIASES3], &t[WI_PRELU3],
+                                  tower.back().output_stride));
+    if (precision == NCP_INT8) {
+        for (ConvLayer &layer : tower) {
+            QuantizeConvLayer(&layer);
+        }
+    }
+
+    unsigned num_positions = width * height;
+    unsigned tower_stride = tower.back().output_stride;
+
+    policy_conv = PackConvLayer(t[WI_POLICY_CONV_KERNEL], t[WI_POLICY_CONV_BIASES],
+                                &t[WI_POLICY_PRELU], tower_stride);
+    policy_dense =
+        PackConvLayer(t[WI_POLICY_WEIGHTS], t[WI_POLICY_BIASES], /*alphas=*/nullptr,
+                      PaddedChannels(num_positions * policy_conv.num_outputs));
+
+    value_conv = PackConvLayer(t[WI_VALUE_CONV_KERNEL], t[WI_VALUE_CONV_BIASES],
+                               &t[WI_VALUE_PRELU], tower_stride);
+    value_dense1 = PackConvLayer(t[WI_VALUE_WEIGHTS1], t[WI_VALUE_BIASES1], /*alphas=*/nullptr,
+                                 PaddedChannels(num_positions * value_conv.num_outputs));
+    value_dense2 = PackConvLayer(t[WI_VALUE_WEIGHTS2], t[WI_VALUE_BIASES2], /*alphas=*/nullptr,
+                                 value_dense1.output_stride);
+    assert(value_dense2.num_outputs == 1);
+
+    unsigned max_stride = kNumInputPlanes;
+    for (ConvLayer const &layer : tower) {
+        tower_grid.border = std::max(tower_grid.border, layer.kernel_size / 2);
+        max_stride = std::max(max_stride, layer.output_stride);
+    }
+
+    activations.emplace_back(tower_grid.NumCells() * kNumInputPlanes, 0.0f);
+    for (ConvLayer const &layer : tower) {
+        activations.emplace_back(tower_grid.NumCells() * layer.output_stride, 0.0f);
+    }
+    quantized_activations.resize(tower_grid.NumCells() * max_stride);
+    head_features.resize(num_positions *
+                         std::max(policy_conv.output_stride, value_conv.output_stride));
+    flattened.resize(std::max(policy_dense.input_stride, value_dense1.input_stride));
+    dense_outputs[0].resize(std::max(policy_dense.output_stride, value_dense1.output_stride));
+    dense_outputs[1].resize(value_dense2.output_stride);
+}
+
+NativeCnnModel::NativeCnnModel(NativeCnnWeights const &weights, NativeCnnPrecision precision)
+    : pimpl_(std::make_unique<NativeCnnModelInternal>(weights, precision)) {}
+
+NativeCnnModel::~NativeCnnModel() {}
+
+void NativeCnnModel::Run(uint8_t const *board, uint8_t game_phase, uint8_t next_move_stone_type,
+                         float *policy, float *value) {
+    NativeCnnModelInternal &m = *pimpl_;
+    unsigned num_positions = m.width * m.height;
+
+    // Builds the same feature planes as common_module.FeaturePlanesBuilder.
+    for (unsigned x = 0; x < m.width; ++x) {
+        for (unsigned y = 0; y < m.height; ++y) {
+            uint8_t stone = board[y + x * m.height];
+
+            float *plane = m.activations[0].data() + m.tower_grid.Index(x, y) * kNumInputPlanes;
+            std::fill(plane, plane + kNumInputPlanes, 0.0f);
+            plane[0] = stone == 1 ? 1.0f : 0.0f;
+            plane[1] = stone == 2 ? 1.0f : 0.0f;
+            plane[2 + game_phase] = 1.0f;
+            plane[2 + 5 + next_move_stone_type] = 1.0f;
+        }
+    }
+
+    for (unsigned i = 0; i < m.tower.size(); ++i) {
+        ConvLayer const &layer = m.tower[i];
+        float const *input = m.activations[i].data();
+        float *output = m.activations[i + 1].data();
+
+        if (m.precision == NCP_INT8) {
+            float scale = QuantizeActivations(input, m.tower_grid.NumCells() * layer.input_stride,
+                                              m.quantized_activations.data());
+            ConvolveInt8(layer, m.tower_grid, m.quantized_activations.data(), scale, m.tower_grid,
+                         output);
+        } else {
+            Convolve(layer, m.tower_grid, input, m.tower_grid, output);
+        }
+    }
+    float const *tower_output = m.activations.back().data();
+
+    // Policy head.
+    Convolve(m.policy_conv, m.tower_grid, tower_output, m.head_grid, m.head_features.data());
+    Flatten(m.head_features.data(), num_positions, m.policy_conv.output_stride,
+            m.policy_conv.num_outputs, m.policy_dense.input_stride, m.flattened.data());
+    Convolve(m.policy_dense, m.dense_grid, m.flattened.data(), m.dense_grid,
+             m.dense_outputs[0].data());
+
+    float const *logits = m.dense_outputs[0].data();
+    float max_logit = *std::max_element(logits, logits + m.policy_dense.num_outputs);
+    float sum = 0.0f;
+    for (unsigned i = 0; i < m.policy_dense.num_outputs; ++i) {
+        policy[i] = std::exp(logits[i] - max_logit);
+        sum += policy[i];
+    }
+    for (unsigned i = 0; i < m.policy_dense.num_outputs; ++i) {
+        policy[i] /= sum;
+    }
+
+    // Value head.
+    Convolve(m.value_conv, m.tower_grid, tower_output, m.head_grid, m.head_features.data());
+    Flatten(m.head_features.data(), num_positions, m.value_conv.output_stride,
+            m.value_conv.num_outputs, m.value_dense1.input_stride, m.flattened.data());
+    Convolve(m.value_dense1, m.dense_grid, m.flattened.data(), m.dense_grid,
+             m.dense_outputs[0].data());
+    Convolve(m.value_dense2, m.dense_grid, m.dense_outputs[0].data(), m.dense_grid,
+             m.dense_outputs[1].data());
+
+    *value = std::tanh(m.dense_outputs[1][0]);
+}
+
+unsigned NativeCnnModel::NumActions() const { return pimpl_->policy_dense.num_outputs; }
+
+unsigned NativeCnnModel::BoardWidth() const { return pimpl_->width; }
+
+unsigned NativeCnnModel::BoardHeight() const { return pimpl_->height; }
+
+char const *NativeCnnInstructionSet() { return kInstructionSet; }
+
+} // namespace e8
@@ -0,0 +1,116 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NATIVE_CNN_H
+#define NATIVE_CNN_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace e8 {
+
+/**
+ * @brief The NativeCnnTensor struct A dense float tensor as exported from the trained model. The
+ * values are laid out in row-major order of the dimensions.
+ */
+struct NativeCnnTensor {
+    std::vector<unsigned> dims;
+    std::vector<float> values;
+};
+
+/**
+ * @brief The NativeCnnWeights struct The trainable variables of the zero prior CNN, in the order
+ * listed by cnn_shared_model.TrainableVariables(). Convolution kernels are in HWIO layout and
+ * dense weights are [num_inputs, num_outputs], which is how tensorflow stores them.
+ */
+struct NativeCnnWeights {
+    unsigned board_width;
+    unsigned board_height;
+    std::vector<NativeCnnTensor> tensors;
+};
+
+/**
+ * @brief LoadNativeCnnWeights Reads the weight file written by export_native_model.py.
+ */
+NativeCnnWeights LoadNativeCnnWeights(std::string const &path);
+
+/**
+ * @brief SaveNativeCnnWeights Writes the weights in the format LoadNativeCnnWeights() reads.
+ */
+void SaveNativeCnnWeights(NativeCnnWeights const &weights, std::string const &path);
+
+/**
+ * @brief The NativeCnnPrecision enum The arithmetic the convolution tower runs in. The policy and
+ * value heads always run in float.
+ */
+enum NativeCnnPrecision {
+    NCP_FLOAT32,
+
+    // Convolution kernels are quantized per output channel to int8 at load time, and activations
+    // are quantized per board to int8 before every convolution. Products are accumulated in int32.
+    NCP_INT8,
+};
+
+/**
+ * @brief The NativeCnnModel class Runs the zero prior CNN directly on the CPU without going
+ * through tensorflow. The inner loops are vectorized with AVX-512 or AVX2 when the build targets
+ * them, and fall back to scalar code otherwise. Every board is evaluated on the calling thread, and
+ * an instance must not be used by more than one thread at a time.
+ */
+class NativeCnnModel {
+  public:
+    NativeCnnModel(NativeCnnWeights const &weights, NativeCnnPrecision precision);
+    NativeCnnModel(NativeCnnModel const &) = delete;
+    NativeCnnModel(NativeCnnModel &&) = delete;
+    ~NativeCnnModel();
+
+    /**
+     * @brief Run Evaluates one board.
+     *
+     * @param board Stones in x-major order, that is, the stone at (x, y) is at
+     * board[y + x*board_height]. Black stones are 1, white stones are 2 and empty cells are 0.
+     * @param game_phase The GomokuGamePhase of the board.
+     * @param next_move_stone_type The stone type of the player to move.
+     * @param policy Receives NumActions() probabilities, softmax normalized over all actions.
+     * @param value Receives the reward estimation of the player to move.
+     */
+    void Run(uint8_t const *board, uint8_t game_phase, uint8_t next_move_stone_type,
+             float *policy, float *value);
+
+    /**
+     * @brief NumActions The size of the policy output.
+     */
+    unsigned NumActions() const;
+
+    unsigned BoardWidth() const;
+    unsigned BoardHeight() const;
+
+  private:
+    struct NativeCnnModelInternal;
+    std::unique_ptr<NativeCnnModelInternal> pimpl_;
+};
+
+/**
+ * @brief NativeCnnInstructionSet Names the vector instruction set the kernels were compiled for.
+ */
+char const *NativeCnnInstructionSet();
+
+} // namespace e8
+
+#endif // NATIVE_CNN_H
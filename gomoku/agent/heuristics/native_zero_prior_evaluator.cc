@@ -0,0 +1,181 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gomoku/agent/heuristics/batch_inference_server.h"
+#include "gomoku/agent/heuristics/evaluation_cache.h"
+#include "gomoku/agent/heuristics/evaluator.h"
+#include "gomoku/agent/heuristics/native_cnn.h"
+#include "gomoku/agent/heuristics/native_zero_prior_evaluator.h"
+#include "gomoku/agent/search/mct_node.h"
+#include "gomoku/agent/search/policy.h"
+#include "gomoku/game/board_state.h"
+
+namespace e8 {
+namespace {
+
+struct EvaluationResult {
+    float reward;
+    GomokuPolicy policy;
+};
+
+EvaluationResult ToEvaluationResult(GomokuBoardState const &state,
+                                    GomokuInferenceResult const &inference) {
+    EvaluationResult evaluation;
+
+    auto [lo, hi] = state.ActionIdRange();
+    assert(inference.policy.size() == static_cast<unsigned>(hi - lo + 1));
+
+    // Re-normalizes the policy over the legal actions.
+    evaluation.policy.AssignLegal(state, inference.policy.data());
+
+    evaluation.reward = inference.value;
+
+    return evaluation;
+}
+
+class NativeZeroPriorModel : public GomokuInferenceModelInterface {
+  public:
+    NativeZeroPriorModel(std::string const &model_path, NativeCnnPrecision precision);
+    ~NativeZeroPriorModel() override = default;
+
+    void Infer(std::vector<GomokuInferenceRequest> const &batch,
+               std::vector<GomokuInferenceResult> *results) override;
+
+  private:
+    NativeCnnModel model_;
+    std::vector<uint8_t> board_;
+};
+
+NativeZeroPriorModel::NativeZeroPriorModel(std::string const &model_path,
+                                           NativeCnnPrecision precision)
+    : model_(LoadNativeCnnWeights(model_path), precision),
+      board_(model_.BoardWidth() * model_.BoardHeight()) {}
+
+void NativeZeroPriorModel::Infer(std::vector<GomokuInferenceRequest> const &batch,
+                                 std::vector<GomokuInferenceResult> *results) {
+    assert(!batch.empty());
+    assert(results->size() == batch.size());
+
+    for (unsigned i = 0; i < batch.size(); ++i) {
+        GomokuBoardState const &state = *batch[i].state;
+        assert(static_cast<unsigned>(state.Width()) == model_.BoardWidth());
+        assert(static_cast<unsigned>(state.Height()) == model_.BoardHeight());
+
+        state.WriteBoardPlane(board_.data());
+
+        GomokuInferenceResult &result = (*results)[i];
+        result.policy.resize(model_.NumActions());
+        model_.Run(board_.data(), state.CurrentGamePhase(),
+                   state.PlayerStoneType(state.CurrentPlayerSide()), result.policy.data(),
+                   &result.value);
+    }
+}
+
+} // namespace
+
+struct GomokuNativeZeroPriorEvaluator::NativeModelBasedEvaluatorInternal {
+    NativeModelBasedEvaluatorInternal(std::shared_ptr<GomokuBatchInferenceServer> const &server);
+
+    EvaluationResult Fetch(MctNodeId const state_id, GomokuBoardState const &state);
+
+    std::shared_ptr<GomokuBatchInferenceServer> server;
+
+    std::mutex cache_lock;
+    std::unordered_map<MctNodeId, EvaluationResult> cache;
+};
+
+GomokuNativeZeroPriorEvaluator::NativeModelBasedEvaluatorInternal::
+    NativeModelBasedEvaluatorInternal(std::shared_ptr<GomokuBatchInferenceServer> const &server)
+    : server(server) {}
+
+EvaluationResult GomokuNativeZeroPriorEvaluator::NativeModelBasedEvaluatorInternal::Fetch(
+    MctNodeId const state_id, GomokuBoardState const &state) {
+    {
+        std::lock_guard<std::mutex> guard(cache_lock);
+        auto it = cache.find(state_id);
+        if (it != cache.end()) {
+            return it->second;
+        }
+    }
+
+    EvaluationResult evaluation = ToEvaluationResult(state, server->Infer(state).get());
+
+    std::lock_guard<std::mutex> guard(cache_lock);
+    cache.insert(std::make_pair(state_id, evaluation));
+
+    return evaluation;
+}
+
+GomokuNativeZeroPriorEvaluator::GomokuNativeZeroPriorEvaluator(std::string const &model_path,
+                                                               NativeCnnPrecision precision)
+    : GomokuNativeZeroPriorEvaluator(std::make_shared<GomokuBatchInferenceServer>(
+          LoadNativeZeroPriorModel(model_path, precision), /*max_batch_size=*/1,
+          /*max_delay=*/std::chrono::microseconds(0), DefaultGomokuEvaluationCache(),
+          NativeZeroPriorModelVersion(model_path, precision))) {}
+
+GomokuNativeZeroPriorEvaluator::GomokuNativeZeroPriorEvaluator(
+    std::shared_ptr<GomokuBatchInferenceServer> const &inference_server)
+    : pimpl_(std::make_unique<NativeModelBasedEvaluatorInternal>(inference_server)) {}
+
+GomokuNativeZeroPriorEvaluator::~GomokuNativeZeroPriorEvaluator() {}
+
+float GomokuNativeZeroPriorEvaluator::EvaluateReward(GomokuBoardState const &state,
+                                                     std::optional<MctNodeId> /*parent_state_id*/,
+                                                     MctNodeId state_id) {
+    return pimpl_->Fetch(state_id, state).reward;
+}
+
+void GomokuNativeZeroPriorEvaluator::EvaluatePolicy(GomokuBoardState const &state,
+                                                    std::optional<MctNodeId> /*parent_state_id*/,
+                                                    MctNodeId state_id, GomokuPolicy *policy) {
+    *policy = pimpl_->Fetch(state_id, state).policy;
+}
+
+float GomokuNativeZeroPriorEvaluator::ExplorationFactor() const { return 4.0f; }
+
+unsigned GomokuNativeZeroPriorEvaluator::NumSimulations() const { return 2048; }
+
+void GomokuNativeZeroPriorEvaluator::ClearCache() {
+    std::lock_guard<std::mutex> guard(pimpl_->cache_lock);
+    pimpl_->cache.clear();
+}
+
+bool GomokuNativeZeroPriorEvaluator::ThreadSafe() const { return true; }
+
+std::unique_ptr<GomokuInferenceModelInterface>
+LoadNativeZeroPriorModel(std::string const &model_path, NativeCnnPrecision precision) {
+    return std::make_unique<NativeZeroPriorModel>(model_path, precision);
+}
+
+uint64_t NativeZeroPriorModelVersion(std::string const &model_path, NativeCnnPrecision precision) {
+    if (precision == NCP_INT8) {
+        return ModelVersionOf(model_path + ":int8");
+    }
+    return ModelVersionOf(model_path);
+}
+
+} // namespace e8
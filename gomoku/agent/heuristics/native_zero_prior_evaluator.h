@@ -0,0 +1,91 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NATIVE_ZERO_PRIOR_EVALUATOR_H
+#define NATIVE_ZERO_PRIOR_EVALUATOR_H
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "gomoku/agent/heuristics/batch_inference_server.h"
+#include "gomoku/agent/heuristics/evaluator.h"
+#include "gomoku/agent/heuristics/native_cnn.h"
+#include "gomoku/agent/search/mct_node.h"
+#include "gomoku/agent/search/policy.h"
+#include "gomoku/game/board_state.h"
+
+namespace e8 {
+
+/**
+ * @brief The GomokuNativeZeroPriorEvaluator class This evaluator runs the same model as
+ * GomokuTfZeroPriorEvaluator, but with the weights exported by export_native_model.py and the
+ * native CNN kernels instead of a tensorflow session. It avoids the session and tensor marshalling
+ * overhead which dominates at small batch sizes.
+ */
+class GomokuNativeZeroPriorEvaluator : public GomokuEvaluatorInterface {
+  public:
+    /**
+     * @brief GomokuNativeZeroPriorEvaluator Constructs an evaluator from a native weight file.
+     */
+    GomokuNativeZeroPriorEvaluator(std::string const &model_path,
+                                   NativeCnnPrecision precision = NCP_FLOAT32);
+
+    /**
+     * @brief GomokuNativeZeroPriorEvaluator Constructs an evaluator which batches its inference
+     * with the other users of the server. The server should be serving a model loaded by
+     * LoadNativeZeroPriorModel().
+     */
+    GomokuNativeZeroPriorEvaluator(
+        std::shared_ptr<GomokuBatchInferenceServer> const &inference_server);
+    ~GomokuNativeZeroPriorEvaluator() override;
+
+    float EvaluateReward(GomokuBoardState const &state, std::optional<MctNodeId> parent_state_id,
+                         MctNodeId state_id) override;
+
+    void EvaluatePolicy(GomokuBoardState const &state, std::optional<MctNodeId> parent_state_id,
+                        MctNodeId state_id, GomokuPolicy *policy) override;
+
+    float ExplorationFactor() const override;
+
+    unsigned NumSimulations() const override;
+
+    void ClearCache() override;
+
+    bool ThreadSafe() const override;
+
+  private:
+    struct NativeModelBasedEvaluatorInternal;
+    std::unique_ptr<NativeModelBasedEvaluatorInternal> pimpl_;
+};
+
+/**
+ * @brief LoadNativeZeroPriorModel Loads a native weight file for batched inference.
+ */
+std::unique_ptr<GomokuInferenceModelInterface>
+LoadNativeZeroPriorModel(std::string const &model_path, NativeCnnPrecision precision);
+
+/**
+ * @brief NativeZeroPriorModelVersion The evaluation cache version of the model loaded with the
+ * precision. Quantized and float outputs are kept apart.
+ */
+uint64_t NativeZeroPriorModelVersion(std::string const &model_path, NativeCnnPrecision precision);
+
+} // namespace e8
+
+#endif // NATIVE_ZERO_PRIOR_EVALUATOR_H
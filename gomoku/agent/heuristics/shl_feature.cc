@@ -24,13 +24,16 @@
 #include <optional>
 #include <tuple>
 #include <unordered_map>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
-#include "gomoku/agent/heuristics/contour.h"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
 #include "gomoku/agent/heuristics/shl_feature.h"
 #include "gomoku/agent/search/mct_node.h"
+#include "gomoku/game/bitboard.h"
 #include "gomoku/game/board_state.h"
 
 namespace e8 {
@@ -154,6 +157,176 @@ std::pair<float, float> ShlCount(int8_t x, int8_t y, StoneType compute_for_stone
     return std::make_pair(primary_shl_count, secondary_shl_count);
 }
 
+// Each cell of a half line takes 2 bits, the cell closest to the viewer position in the lowest.
+unsigned const kNumHalfLineCodes = 1 << (2 * kShlLinkRadius);
+
+// Cell value of the grid padding. Empty cells and stones take their StoneType value.
+uint8_t const kOffBoardCell = 3;
+
+/**
+ * @brief The HalfLinkTables struct LinkStats of every half line, from the perspective of black in
+ * the first table and white in the second one. An entry packs the raw count in bits 0-2, the holes
+ * in bits 3-4 and the blockage in bit 5.
+ */
+struct HalfLinkTables {
+    std::array<int32_t, kNumHalfLineCodes> links[2];
+};
+
+// Follows the same rules as LinkageCountsAtWithDirection().
+constexpr int32_t HalfLink(unsigned code, uint8_t stone_type) {
+    int32_t raw_count = 0;
+    int32_t holes = 0;
+    int32_t blocked = 0;
+
+    unsigned i = 1;
+    while (i <= kShlLinkRadius) {
+        uint8_t cell = (code >> 2 * (i - 1)) & 3;
+        if (cell == stone_type) {
+            ++raw_count;
+            ++i;
+            continue;
+        }
+        if (cell != ST_NONE) {
+            blocked = 1;
+            break;
+        }
+
+        ++i;
+        if (i > kShlLinkRadius || ((code >> 2 * (i - 1)) & 3) != stone_type) {
+            break;
+        }
+        ++holes;
+    }
+
+    return raw_count | holes << 3 | blocked << 5;
+}
+
+constexpr HalfLinkTables MakeHalfLinkTables() {
+    HalfLinkTables tables{};
+    for (unsigned code = 0; code < kNumHalfLineCodes; ++code) {
+        tables.links[0][code] = HalfLink(code, ST_BLACK);
+        tables.links[1][code] = HalfLink(code, ST_WHITE);
+    }
+    return tables;
+}
+
+constexpr HalfLinkTables kHalfLinkTables = MakeHalfLinkTables();
+
+// Same arithmetic as LinkageToAdjustedCount() on the link made of the two halves.
+float AdjustedCount(int32_t half_link1, int32_t half_link2) {
+    int32_t raw_count = (half_link1 & 7) + (half_link2 & 7);
+    int32_t holes = ((half_link1 >> 3) & 3) + ((half_link2 >> 3) & 3);
+    int32_t blockage = ((half_link1 | half_link2) >> 5) & 1;
+    return static_cast<float>(raw_count) - 0.5f * static_cast<float>(holes) -
+           static_cast<float>(blockage);
+}
+
+unsigned HalfLineCode(uint8_t const *cells, int offset, int step) {
+    unsigned code = 0;
+    for (unsigned i = 1; i <= kShlLinkRadius; ++i) {
+        code |= static_cast<unsigned>(cells[offset + static_cast<int>(i) * step]) << 2 * (i - 1);
+    }
+    return code;
+}
+
+// Steps between consecutive cells of the horizontal, vertical, diagnal and counter diagnal lines.
+std::array<int, 4> LineSteps(int stride) { return {1, stride, stride + 1, 1 - stride}; }
+
+ShlComponents ComputeShlCountsAt(uint8_t const *cells, int offset,
+                                 std::array<int, 4> const &steps) {
+    std::array<float, 4> adjusted_counts[2];
+    for (unsigned d = 0; d < 4; ++d) {
+        unsigned forward_code = HalfLineCode(cells, offset, steps[d]);
+        unsigned backward_code = HalfLineCode(cells, offset, -steps[d]);
+        for (unsigned plane = 0; plane < 2; ++plane) {
+            adjusted_counts[plane][d] = AdjustedCount(kHalfLinkTables.links[plane][forward_code],
+                                                      kHalfLinkTables.links[plane][backward_code]);
+        }
+    }
+
+    for (unsigned plane = 0; plane < 2; ++plane) {
+        std::partial_sort(adjusted_counts[plane].begin(), adjusted_counts[plane].begin() + 2,
+                          adjusted_counts[plane].end(), std::greater<float>());
+    }
+
+    return ShlComponents(adjusted_counts[0][0], adjusted_counts[0][1], adjusted_counts[1][0],
+                         adjusted_counts[1][1]);
+}
+
+#ifdef __AVX2__
+// Number of positions evaluated by one SIMD pass.
+unsigned const kShlLanes = 8;
+
+__m256i HalfLineCodes(uint8_t const *cells, __m256i offsets, int step) {
+    __m256i const cell_mask = _mm256_set1_epi32(0xFF);
+
+    __m256i codes = _mm256_setzero_si256();
+    for (unsigned i = 1; i <= kShlLinkRadius; ++i) {
+        __m256i cell_offsets = _mm256_add_epi32(offsets, _mm256_set1_epi32(i * step));
+        __m256i cell_values = _mm256_and_si256(
+            _mm256_i32gather_epi32(reinterpret_cast<int const *>(cells), cell_offsets, 1),
+            cell_mask);
+        codes = _mm256_or_si256(
+            codes, _mm256_sllv_epi32(cell_values, _mm256_set1_epi32(2 * (i - 1))));
+    }
+    return codes;
+}
+
+__m256 AdjustedCounts(__m256i half_links1, __m256i half_links2) {
+    __m256i const raw_count_mask = _mm256_set1_epi32(7);
+    __m256i const holes_mask = _mm256_set1_epi32(3);
+    __m256i const blockage_mask = _mm256_set1_epi32(1);
+
+    __m256i raw_counts = _mm256_add_epi32(_mm256_and_si256(half_links1, raw_count_mask),
+                                          _mm256_and_si256(half_links2, raw_count_mask));
+    __m256i holes =
+        _mm256_add_epi32(_mm256_and_si256(_mm256_srli_epi32(half_links1, 3), holes_mask),
+                         _mm256_and_si256(_mm256_srli_epi32(half_links2, 3), holes_mask));
+    __m256i blockages = _mm256_and_si256(
+        _mm256_srli_epi32(_mm256_or_si256(half_links1, half_links2), 5), blockage_mask);
+
+    return _mm256_sub_ps(_mm256_sub_ps(_mm256_cvtepi32_ps(raw_counts),
+                                       _mm256_mul_ps(_mm256_set1_ps(0.5f),
+                                                     _mm256_cvtepi32_ps(holes))),
+                         _mm256_cvtepi32_ps(blockages));
+}
+
+void ComputeShlCountsSimd(uint8_t const *cells, int32_t const *offsets,
+                          std::array<int, 4> const &steps, ShlComponents *counts) {
+    __m256i lane_offsets = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(offsets));
+
+    __m256 adjusted_counts[2][4];
+    for (unsigned d = 0; d < 4; ++d) {
+        __m256i forward_codes = HalfLineCodes(cells, lane_offsets, steps[d]);
+        __m256i backward_codes = HalfLineCodes(cells, lane_offsets, -steps[d]);
+        for (unsigned plane = 0; plane < 2; ++plane) {
+            int const *table = kHalfLinkTables.links[plane].data();
+            adjusted_counts[plane][d] =
+                AdjustedCounts(_mm256_i32gather_epi32(table, forward_codes, 4),
+                               _mm256_i32gather_epi32(table, backward_codes, 4));
+        }
+    }
+
+    // Top 2 out of the 4 directions.
+    alignas(32) float primary[2][kShlLanes];
+    alignas(32) float secondary[2][kShlLanes];
+    for (unsigned plane = 0; plane < 2; ++plane) {
+        __m256 const *c = adjusted_counts[plane];
+        __m256 hi01 = _mm256_max_ps(c[0], c[1]);
+        __m256 lo01 = _mm256_min_ps(c[0], c[1]);
+        __m256 hi23 = _mm256_max_ps(c[2], c[3]);
+        __m256 lo23 = _mm256_min_ps(c[2], c[3]);
+        _mm256_store_ps(primary[plane], _mm256_max_ps(hi01, hi23));
+        _mm256_store_ps(secondary[plane], _mm256_max_ps(_mm256_min_ps(hi01, hi23),
+                                                        _mm256_max_ps(lo01, lo23)));
+    }
+
+    for (unsigned i = 0; i < kShlLanes; ++i) {
+        counts[i] = ShlComponents(primary[0][i], secondary[0][i], primary[1][i], secondary[1][i]);
+    }
+}
+#endif
+
 struct PositionAndShlScore {
     PositionAndShlScore(MovePosition const &position, ShlComponents const &shl_components);
 
@@ -230,39 +403,141 @@ ShlComponents::ShlComponents(float primary_shl_count_black, float secondary_shl_
       primary_shl_count_white(primary_shl_count_white),
       secondary_shl_count_white(secondary_shl_count_white) {}
 
-ShlFeatureBuilder::ShlFeatureBuilder(GomokuBoardState const &board)
-    : width_(board.Width()), height_(board.Height()), double_contour_builder_(board, /*order=*/2) {
-    for (auto pos : double_contour_builder_.Contour()) {
-        this->UpdateShlFeaturesAt(pos, board);
+ShlLineGrid::ShlLineGrid(GomokuBoardState const &board) : stride_(board.Width() + kShlLinkRadius) {
+    // A line running off the right edge wraps into the padding at the beginning of the next row,
+    // hence the extra row. The trailing bytes let a SIMD gather read a whole word at the last cell.
+    assert(static_cast<unsigned>(stride_) * (board.Height() + 2 * kShlLinkRadius + 1) +
+               sizeof(int32_t) <=
+           kMaxShlLineGridCells);
+    cells_.fill(kOffBoardCell);
+
+    for (int8_t y = 0; y < board.Height(); ++y) {
+        for (int8_t x = 0; x < board.Width(); ++x) {
+            MovePosition pos(x, y);
+            cells_[this->Offset(pos)] = *board.ChessPieceStateAt(pos);
+        }
     }
 }
 
-void ShlFeatureBuilder::UpdateShlFeaturesAt(MovePosition candid_pos,
-                                            GomokuBoardState const &board) {
+void ShlLineGrid::PlaceStone(MovePosition const &pos, StoneType stone_type) {
+    cells_[this->Offset(pos)] = stone_type;
+}
+
+int ShlLineGrid::Stride() const { return stride_; }
+
+uint8_t const *ShlLineGrid::Cells() const { return cells_.data(); }
+
+void ComputeShlCounts(ShlLineGrid const &grid, std::vector<MovePosition> const &positions,
+                      std::vector<ShlComponents> *counts) {
+    counts->resize(positions.size());
+
+    std::array<int, 4> steps = LineSteps(grid.Stride());
+    unsigned i = 0;
+
+#ifdef __AVX2__
+    std::array<int32_t, kShlLanes> offsets;
+    for (; i + kShlLanes <= positions.size(); i += kShlLanes) {
+        for (unsigned j = 0; j < kShlLanes; ++j) {
+            offsets[j] = grid.Offset(positions[i + j]);
+        }
+        ComputeShlCountsSimd(grid.Cells(), offsets.data(), steps, counts->data() + i);
+    }
+#endif
+
+    for (; i < positions.size(); ++i) {
+        (*counts)[i] = ComputeShlCountsAt(grid.Cells(), grid.Offset(positions[i]), steps);
+    }
+}
+
+ShlComponents ReferenceShlCounts(MovePosition const &pos, GomokuBoardState const &board) {
     auto [primary_black, secondary_black] =
-        ShlCount(candid_pos.x, candid_pos.y, /*compute_for_stone_type=*/StoneType::ST_BLACK, board);
+        ShlCount(pos.x, pos.y, /*compute_for_stone_type=*/StoneType::ST_BLACK, board);
     auto [primary_white, secondary_white] =
-        ShlCount(candid_pos.x, candid_pos.y, /*compute_for_stone_type=*/StoneType::ST_WHITE, board);
+        ShlCount(pos.x, pos.y, /*compute_for_stone_type=*/StoneType::ST_WHITE, board);
+    return ShlComponents(primary_black, secondary_black, primary_white, secondary_white);
+}
 
-    if (primary_black == 0.0f && secondary_black == 0.0f && primary_white == 0.0f &&
-        secondary_white == 0.0f) {
-        raw_map_.erase(candid_pos);
-        return;
+ShlFeatureBuilder::ShlFeatureBuilder(GomokuBoardState const &board)
+    : width_(board.Width()), height_(board.Height()), grid_(board) {
+    assert(width_ * height_ <= kBitboardCapacity);
+
+    for (int8_t y = 0; y < board.Height(); ++y) {
+        for (int8_t x = 0; x < board.Width(); ++x) {
+            MovePosition pos(x, y);
+            if (*board.ChessPieceStateAt(pos) != StoneType::ST_NONE) {
+                this->AddToContour(pos);
+            }
+        }
     }
 
-    auto it = raw_map_.find(candid_pos);
-    if (it != raw_map_.end()) {
-        it->second = ShlComponents(primary_black, secondary_black, primary_white, secondary_white);
+    std::vector<MovePosition> candid_positions;
+    for (unsigned i = double_contour_.NextSetBit(0); i < kBitboardCapacity;
+         i = double_contour_.NextSetBit(i + 1)) {
+        candid_positions.push_back(MovePosition(i % width_, i / width_));
+    }
+    this->UpdateShlFeatures(candid_positions);
+}
+
+void ShlFeatureBuilder::AddToContour(MovePosition const &stone_pos) {
+    unsigned stone_index = stone_pos.x + stone_pos.y * width_;
+
+    double_contour_.Reset(stone_index);
+    covered_.Set(stone_index);
+
+    int8_t min_x = std::max(0, stone_pos.x - 2);
+    int8_t max_x = std::min(static_cast<int>(width_) - 1, stone_pos.x + 2);
+
+    int8_t min_y = std::max(0, stone_pos.y - 2);
+    int8_t max_y = std::min(static_cast<int>(height_) - 1, stone_pos.y + 2);
+
+    for (int8_t shifted_y = min_y; shifted_y <= max_y; ++shifted_y) {
+        for (int8_t shifted_x = min_x; shifted_x <= max_x; ++shifted_x) {
+            unsigned index = shifted_x + shifted_y * width_;
+            if (covered_.Test(index)) {
+                continue;
+            }
+
+            covered_.Set(index);
+            double_contour_.Set(index);
+        }
+    }
+}
+
+void ShlFeatureBuilder::SetRawComponents(unsigned index, ShlComponents const &components,
+                                         bool present) {
+    raw_map_[index] = components;
+    if (present) {
+        raw_positions_.Set(index);
     } else {
-        raw_map_.insert(std::make_pair(candid_pos, ShlComponents(primary_black, secondary_black,
-                                                                 primary_white, secondary_white)));
+        raw_positions_.Reset(index);
     }
 }
 
-void ShlFeatureBuilder::UpdateShlOverDirection(
-    int dx, int dy, MovePosition pos, std::unordered_set<MovePosition> const &double_contour,
-    GomokuBoardState const &board) {
-    unsigned max_i = 6;
+void ShlFeatureBuilder::UpdateShlFeatures(std::vector<MovePosition> const &candid_positions) {
+    std::vector<ShlComponents> counts;
+    ComputeShlCounts(grid_, candid_positions, &counts);
+
+    for (unsigned i = 0; i < candid_positions.size(); ++i) {
+        MovePosition const &candid_pos = candid_positions[i];
+        unsigned index = candid_pos.x + candid_pos.y * width_;
+        ShlComponents const &count = counts[i];
+
+        if (count.primary_shl_count_black == 0.0f && count.secondary_shl_count_black == 0.0f &&
+            count.primary_shl_count_white == 0.0f && count.secondary_shl_count_white == 0.0f) {
+            if (raw_positions_.Test(index)) {
+                this->SetRawComponents(index, ShlComponents(), /*present=*/false);
+            }
+            continue;
+        }
+
+        this->SetRawComponents(index, count, /*present=*/true);
+    }
+}
+
+void ShlFeatureBuilder::CollectCandidatesOverDirection(
+    int dx, int dy, MovePosition pos, GomokuBoardState const &board,
+    std::vector<MovePosition> *candid_positions) const {
+    unsigned max_i = kShlLinkRadius;
 
     if (dx < 0) {
         max_i = std::min(static_cast<unsigned>(-pos.x / dx), max_i);
@@ -280,40 +555,35 @@ void ShlFeatureBuilder::UpdateShlOverDirection(
         int8_t shifted_x = pos.x + i * dx;
         int8_t shifted_y = pos.y + i * dy;
 
-        MovePosition candid_pos(shifted_x, shifted_y);
-
-        if (*board.ChessPieceStateAt(candid_pos) != StoneType::ST_NONE ||
-            double_contour.find(candid_pos) == double_contour.end()) {
+        // The double contour holds empty positions only.
+        if (!double_contour_.Test(shifted_x + shifted_y * width_)) {
             continue;
         }
 
-        this->UpdateShlFeaturesAt(candid_pos, board);
+        candid_positions->push_back(MovePosition(shifted_x, shifted_y));
     }
 }
 
 void ShlFeatureBuilder::AddStone(GomokuBoardState const &board) {
-    assert(!board.History().empty());
-    GomokuAction const &action = board.LastAction()->action.second;
+    std::optional<GomokuActionRecord> action_record = board.LastAction();
+    assert(action_record.has_value());
+    GomokuAction const &action = action_record->action.second;
     assert(action.stone_pos.has_value());
 
-    double_contour_builder_.AddStone(*action.stone_pos);
-
-    this->UpdateShlOverDirection(/*dx=*/-1, /*dy=*/0, *action.stone_pos,
-                                 double_contour_builder_.Contour(), board);
-    this->UpdateShlOverDirection(/*dx=*/-1, /*dy=*/-1, *action.stone_pos,
-                                 double_contour_builder_.Contour(), board);
-    this->UpdateShlOverDirection(/*dx=*/0, /*dy=*/-1, *action.stone_pos,
-                                 double_contour_builder_.Contour(), board);
-    this->UpdateShlOverDirection(/*dx=*/1, /*dy=*/-1, *action.stone_pos,
-                                 double_contour_builder_.Contour(), board);
-    this->UpdateShlOverDirection(/*dx=*/1, /*dy=*/0, *action.stone_pos,
-                                 double_contour_builder_.Contour(), board);
-    this->UpdateShlOverDirection(/*dx=*/1, /*dy=*/1, *action.stone_pos,
-                                 double_contour_builder_.Contour(), board);
-    this->UpdateShlOverDirection(/*dx=*/0, /*dy=*/1, *action.stone_pos,
-                                 double_contour_builder_.Contour(), board);
-    this->UpdateShlOverDirection(/*dx=*/-1, /*dy=*/1, *action.stone_pos,
-                                 double_contour_builder_.Contour(), board);
+    this->AddToContour(*action.stone_pos);
+    grid_.PlaceStone(*action.stone_pos, *board.ChessPieceStateAt(*action.stone_pos));
+
+    // Only the positions sharing a line with the new stone, plus the new contour, are affected.
+    std::vector<MovePosition> candid_positions;
+    for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+            if (dx == 0 && dy == 0) {
+                continue;
+            }
+            this->CollectCandidatesOverDirection(dx, dy, *action.stone_pos, board,
+                                                 &candid_positions);
+        }
+    }
 
     std::array<MovePosition, 8> new_potential_contour{
         MovePosition(action.stone_pos->x - 2, action.stone_pos->y + 1),
@@ -329,14 +599,19 @@ void ShlFeatureBuilder::AddStone(GomokuBoardState const &board) {
         if (contour.x < 0 || contour.y < 0 || contour.x >= board.Width() ||
             contour.y >= board.Height() ||
             *board.ChessPieceStateAt(contour) != StoneType::ST_NONE ||
-            raw_map_.find(contour) != raw_map_.end()) {
+            raw_positions_.Test(contour.x + contour.y * width_)) {
             continue;
         }
 
-        this->UpdateShlFeaturesAt(contour, board);
+        candid_positions.push_back(contour);
     }
 
-    raw_map_.erase(*action.stone_pos);
+    this->UpdateShlFeatures(candid_positions);
+
+    unsigned stone_index = action.stone_pos->x + action.stone_pos->y * width_;
+    if (raw_positions_.Test(stone_index)) {
+        this->SetRawComponents(stone_index, ShlComponents(), /*present=*/false);
+    }
 }
 
 std::vector<std::pair<MovePosition, ShlComponents>>
@@ -344,7 +619,11 @@ ShlFeatureBuilder::TopKMapSparse(unsigned top_k, bool normalized,
                                  std::optional<StoneType> next_move_stone_type) const {
     std::vector<std::pair<MovePosition, ShlComponents>> adjusted_shl_map;
 
-    for (auto const &[pos, shl_components] : raw_map_) {
+    for (unsigned i = raw_positions_.NextSetBit(0); i < kBitboardCapacity;
+         i = raw_positions_.NextSetBit(i + 1)) {
+        MovePosition pos(i % width_, i / width_);
+        ShlComponents const &shl_components = raw_map_[i];
+
         float primary_shl_count_black;
         float secondary_shl_count_black;
         float primary_shl_count_white;
@@ -424,6 +703,23 @@ ShlFeatureBuilder::TopKMapDense(unsigned top_k, bool normalized,
     return dense_map;
 }
 
+void ShlFeatureBuilder::WriteTopKPlanes(unsigned top_k, bool normalized,
+                                        std::optional<StoneType> next_move_stone_type,
+                                        float *planes) const {
+    std::vector<std::pair<MovePosition, ShlComponents>> feature_map =
+        this->TopKMapSparse(top_k, normalized, next_move_stone_type);
+
+    std::fill(planes, planes + width_ * height_ * 4, 0.0f);
+
+    for (auto const &[pos, shl_components] : feature_map) {
+        float *dst = planes + (pos.y + pos.x * height_) * 4;
+        dst[0] = shl_components.primary_shl_count_black;
+        dst[1] = shl_components.secondary_shl_count_black;
+        dst[2] = shl_components.primary_shl_count_white;
+        dst[3] = shl_components.secondary_shl_count_white;
+    }
+}
+
 std::vector<float> ShlFeatureBuilder::TopKShlPositionlessFeatures(
     unsigned top_k, bool normalized, std::optional<StoneType> next_move_stone_type) const {
     std::vector<std::pair<MovePosition, ShlComponents>> feature_map =
@@ -446,7 +742,10 @@ ShlFeatureBuilder &ShlFeatureBuilder::operator=(ShlFeatureBuilder const &rhs) {
     assert(width_ == rhs.width_);
     assert(height_ == rhs.height_);
     raw_map_ = rhs.raw_map_;
-    double_contour_builder_ = rhs.double_contour_builder_;
+    raw_positions_ = rhs.raw_positions_;
+    double_contour_ = rhs.double_contour_;
+    covered_ = rhs.covered_;
+    grid_ = rhs.grid_;
     return *this;
 }
 
@@ -18,16 +18,15 @@
 #ifndef SHL_FEATURE_H
 #define SHL_FEATURE_H
 
+#include <array>
 #include <cstdint>
 #include <memory>
 #include <optional>
-#include <unordered_map>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
-#include "gomoku/agent/heuristics/contour.h"
 #include "gomoku/agent/search/mct_node.h"
+#include "gomoku/game/bitboard.h"
 #include "gomoku/game/board_state.h"
 
 namespace e8 {
@@ -67,6 +66,65 @@ struct ShlComponents {
     float secondary_shl_count_white;
 };
 
+// Number of cells a link can reach in each direction from the viewer position.
+static unsigned const kShlLinkRadius = 6;
+
+// Number of cells a ShlLineGrid can hold, padding included.
+static unsigned const kMaxShlLineGridCells = 1024;
+
+/**
+ * @brief The ShlLineGrid class A copy of the board, one byte per cell, padded with kShlLinkRadius
+ * off-board cells on each side. The 13-cell lines centered at any board position can then be read
+ * without bounds checking. Horizontally adjacent rows share their padding.
+ */
+class ShlLineGrid {
+  public:
+    explicit ShlLineGrid(GomokuBoardState const &board);
+
+    /**
+     * @brief PlaceStone Records a stone placed onto the board, or removed from the board if the
+     * stone type is ST_NONE.
+     */
+    void PlaceStone(MovePosition const &pos, StoneType stone_type);
+
+    /**
+     * @brief Offset Index of the board position in Cells().
+     */
+    int Offset(MovePosition const &pos) const {
+        return (pos.y + kShlLinkRadius) * stride_ + pos.x + kShlLinkRadius;
+    }
+
+    /**
+     * @brief Stride Distance between vertically adjacent cells.
+     */
+    int Stride() const;
+
+    /**
+     * @brief Cells The cells in row-major order. An empty cell is ST_NONE, a stone is its
+     * StoneType and the padding is 3.
+     */
+    uint8_t const *Cells() const;
+
+  private:
+    int stride_;
+    std::array<uint8_t, kMaxShlLineGridCells> cells_;
+};
+
+/**
+ * @brief ComputeShlCounts Computes, for both stone types, the top 2 adjusted link counts of each
+ * of the positions (See ShlFeatureBuilder for how they are defined). Each half of a line is packed
+ * into a 12-bit code whose LinkStats are looked up from precomputed tables, and several positions
+ * are evaluated at a time with SIMD when it's available.
+ */
+void ComputeShlCounts(ShlLineGrid const &grid, std::vector<MovePosition> const &positions,
+                      std::vector<ShlComponents> *counts);
+
+/**
+ * @brief ReferenceShlCounts Computes the same counts as ComputeShlCounts() for a single position
+ * by walking each link through the board state cell by cell.
+ */
+ShlComponents ReferenceShlCounts(MovePosition const &pos, GomokuBoardState const &board);
+
 /**
  * @brief The ShlFeatureBuilder class It helps extract the Suggestive Hotspot Links (SHL) features
  * from the Gomoku board and provies data strctures to allow effcient incremental update. The
@@ -90,6 +148,9 @@ struct ShlComponents {
  * Eventually, it ranks each position's adjusted count by the shl_score and selects the top K
  * positions. Other positions are erased. With the unsuppressed positions, the adjusted counts are
  * normalized by the sum of the remaining SHL scores. This gives the final SHL map.
+ *
+ * The builder is stored in fixed-size arrays, so copying it doesn't allocate. Rollouts fork it by
+ * copying.
  */
 class ShlFeatureBuilder {
   public:
@@ -97,6 +158,7 @@ class ShlFeatureBuilder {
      * @brief ShlFeatureBuilder Builds a brand new SHL feature map for the specified board state.
      */
     ShlFeatureBuilder(GomokuBoardState const &board);
+    ShlFeatureBuilder(ShlFeatureBuilder const &other) = default;
 
     /**
      * @brief AddStone Synchronizes the SHL feature map with board after a stone is placed  onto the
@@ -133,6 +195,16 @@ class ShlFeatureBuilder {
     std::vector<float> TopKMapDense(unsigned top_k, bool normalized,
                                     std::optional<StoneType> next_move_stone_type) const;
 
+    /**
+     * @brief WriteTopKPlanes Writes the same map as TopKMapDense() straight into the layout of the
+     * model SHL map inputs, where component i of cell (x, y) is at planes[(y + x*height)*4 + i].
+     * Cells outside of the top K are zeroed.
+     *
+     * @param planes Destination of width*height*4 floats.
+     */
+    void WriteTopKPlanes(unsigned top_k, bool normalized,
+                         std::optional<StoneType> next_move_stone_type, float *planes) const;
+
     /**
      * @brief TopKShlPositionlessFeatures Takes the top K SHL features then flattens them and strips
      * away position information.
@@ -150,20 +222,31 @@ class ShlFeatureBuilder {
     ShlFeatureBuilder &operator=(ShlFeatureBuilder const &rhs);
 
   private:
-    void UpdateShlFeaturesAt(MovePosition candid_pos, GomokuBoardState const &board);
+    void AddToContour(MovePosition const &stone_pos);
+    void SetRawComponents(unsigned index, ShlComponents const &components, bool present);
+
+    void UpdateShlFeatures(std::vector<MovePosition> const &candid_positions);
 
-    void UpdateShlOverDirection(int dx, int dy, MovePosition pos,
-                                std::unordered_set<MovePosition> const &double_contour,
-                                GomokuBoardState const &board);
+    void CollectCandidatesOverDirection(int dx, int dy, MovePosition pos,
+                                        GomokuBoardState const &board,
+                                        std::vector<MovePosition> *candid_positions) const;
 
     // Width and height of the feature map. Should be in the same size of the board.
     unsigned const width_;
     unsigned const height_;
 
-    // Sparse 2D map storing the raw SHL components.
-    std::unordered_map<MovePosition, ShlComponents> raw_map_;
+    // Dense 2D map storing the raw SHL components, indexed by x + y*width. Only the positions in
+    // raw_positions_ hold non-zero components.
+    std::array<ShlComponents, kBitboardCapacity> raw_map_;
+    Bitboard raw_positions_;
+
+    // Empty positions within a distance of 2 from any stone.
+    Bitboard double_contour_;
+
+    // The stones and the double contour.
+    Bitboard covered_;
 
-    ContourBuilder double_contour_builder_;
+    ShlLineGrid grid_;
 };
 
 /**
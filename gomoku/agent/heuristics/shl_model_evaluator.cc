@@ -16,21 +16,25 @@
  */
 
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <memory>
 #include <optional>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
+#include "gomoku/agent/heuristics/batch_inference_server.h"
+#include "gomoku/agent/heuristics/evaluation_cache.h"
 #include "gomoku/agent/heuristics/evaluator.h"
 #include "gomoku/agent/heuristics/shl_feature.h"
 #include "gomoku/agent/heuristics/shl_model_evaluator.h"
 #include "gomoku/agent/heuristics/shl_rollout_evaluator.h"
 #include "gomoku/agent/heuristics/tf_zero_prior_evaluator.h"
 #include "gomoku/agent/search/mct_node.h"
+#include "gomoku/agent/search/policy.h"
 #include "gomoku/game/board_state.h"
 #include "third_party/tensorflow/c/c_api.h"
 #include "third_party/tensorflow/c/tf_datatype.h"
@@ -40,219 +44,246 @@
 namespace e8 {
 namespace {
 
-void WriteBoard(GomokuBoardState const &state, TF_Tensor *board) {
+void WriteBoard(GomokuBoardState const &state, unsigned batch_index, TF_Tensor *board) {
     assert(TF_NumDims(board) == 3);
-    assert(TF_Dim(board, /*dim_index=*/0) == 1);
+    assert(TF_Dim(board, /*dim_index=*/0) > batch_index);
     assert(TF_Dim(board, /*dim_index=*/1) == state.Width());
     assert(TF_Dim(board, /*dim_index=*/2) == state.Height());
 
-    uint8_t *tensor_memory = static_cast<uint8_t *>(TF_TensorData(board));
+    uint8_t *tensor_memory = static_cast<uint8_t *>(TF_TensorData(board)) +
+                             batch_index * state.Width() * state.Height();
 
-    for (int16_t y = 0; y < state.Height(); ++y) {
-        for (int16_t x = 0; x < state.Width(); ++x) {
-            tensor_memory[y + x * state.Height()] = *state.ChessPieceStateAt(MovePosition(x, y));
-        }
-    }
+    state.WriteBoardPlane(tensor_memory);
 }
 
-void WriteGamePhase(GomokuBoardState const &state, TF_Tensor *game_phase) {
+void WriteGamePhase(GomokuBoardState const &state, unsigned batch_index, TF_Tensor *game_phase) {
     assert(TF_NumDims(game_phase) == 1);
-    assert(TF_Dim(game_phase, /*dim_index=*/0) == 1);
+    assert(TF_Dim(game_phase, /*dim_index=*/0) > batch_index);
 
     uint8_t *tensor_memory = static_cast<uint8_t *>(TF_TensorData(game_phase));
-    *tensor_memory = state.CurrentGamePhase();
+    tensor_memory[batch_index] = state.CurrentGamePhase();
 }
 
-void WriteNextMoveStoneType(GomokuBoardState const &state, TF_Tensor *next_move_stone_type) {
+void WriteNextMoveStoneType(GomokuBoardState const &state, unsigned batch_index,
+                            TF_Tensor *next_move_stone_type) {
     assert(TF_NumDims(next_move_stone_type) == 1);
-    assert(TF_Dim(next_move_stone_type, /*dim_index=*/0) == 1);
+    assert(TF_Dim(next_move_stone_type, /*dim_index=*/0) > batch_index);
 
     uint8_t *tensor_memory = static_cast<uint8_t *>(TF_TensorData(next_move_stone_type));
-    *tensor_memory = state.PlayerStoneType(state.CurrentPlayerSide());
+    tensor_memory[batch_index] = state.PlayerStoneType(state.CurrentPlayerSide());
 }
 
 void WriteShlMap(GomokuBoardState const &state, std::vector<float> const &shl_map,
-                 TF_Tensor *shl_map_tensor) {
+                 unsigned batch_index, TF_Tensor *shl_map_tensor) {
     assert(TF_NumDims(shl_map_tensor) == 4);
-    assert(TF_Dim(shl_map_tensor, /*dim_index=*/0) == 1);
+    assert(TF_Dim(shl_map_tensor, /*dim_index=*/0) > batch_index);
     assert(TF_Dim(shl_map_tensor, /*dim_index=*/1) == state.Width());
     assert(TF_Dim(shl_map_tensor, /*dim_index=*/2) == state.Height());
     assert(TF_Dim(shl_map_tensor, /*dim_index=*/3) == 4);
 
-    float *tensor_memory = static_cast<float *>(TF_TensorData(shl_map_tensor));
+    assert(shl_map.size() == static_cast<unsigned>(state.Width() * state.Height() * 4));
 
-    for (int16_t y = 0; y < state.Height(); ++y) {
-        for (int16_t x = 0; x < state.Width(); ++x) {
-            for (int16_t i = 0; i < 4; ++i) {
-                tensor_memory[i + (y + x * state.Height()) * 4] =
-                    shl_map[i + (x + y * state.Width()) * 4];
-            }
-        }
-    }
+    // The map was built by ShlFeatureBuilder::WriteTopKPlanes() in the tensor's layout.
+    float *tensor_memory = static_cast<float *>(TF_TensorData(shl_map_tensor)) +
+                           batch_index * state.Width() * state.Height() * 4;
+    std::memcpy(tensor_memory, shl_map.data(), shl_map.size() * sizeof(float));
 }
 
-std::unordered_map<GomokuActionId, float> RenormalizePolicy(GomokuBoardState const &state,
-                                                            TF_Tensor const *policy_tensor) {
-    std::unordered_map<GomokuActionId, float> policy;
+TF_Output BindOutput(TF_Graph *graph, char const *oper_name, int index) {
+    TF_Operation *op = TF_GraphOperationByName(graph, oper_name);
+    assert(op != nullptr);
+    return TF_Output{op, index};
+}
 
-    assert(TF_NumDims(policy_tensor) == 2);
-    assert(TF_Dim(policy_tensor, /*dim_index=*/0) == 1);
+void RenormalizePolicy(GomokuBoardState const &state, std::vector<float> const &policy_output,
+                       GomokuPolicy *policy) {
     auto [lo, hi] = state.ActionIdRange();
-    assert(TF_Dim(policy_tensor, /*dim_index=*/1) == hi - lo + 1);
-
-    // Re-normalizes and stores the policy into the map.
-    float *policy_tensor_memory = static_cast<float *>(TF_TensorData(policy_tensor));
+    assert(policy_output.size() == static_cast<unsigned>(hi - lo + 1));
 
-    float norm_factor = 0;
-    for (auto const &[action_id, _] : state.LegalActions()) {
-        norm_factor += policy_tensor_memory[action_id];
-    }
-    for (auto const &[action_id, _] : state.LegalActions()) {
-        policy[action_id] = policy_tensor_memory[action_id] / norm_factor;
-    }
-
-    return policy;
+    // Re-normalizes the policy over the legal actions.
+    policy->AssignLegal(state, policy_output.data());
 }
 
-} // namespace
+class ShlModel : public GomokuInferenceModelInterface {
+  public:
+    ShlModel(std::string const &model_path);
+    ~ShlModel() override;
 
-struct GomokuShlModelEvaluator::GomokuShlModelEvaluatorInternal {
-    GomokuShlModelEvaluatorInternal(std::string const &model_path);
-    ~GomokuShlModelEvaluatorInternal();
+    void Infer(std::vector<GomokuInferenceRequest> const &batch,
+               std::vector<GomokuInferenceResult> *results) override;
 
-    std::unordered_map<GomokuActionId, float> ModelBasedPolicy(GomokuBoardState const &state,
-                                                               std::vector<float> const &shl_map);
+  private:
+    void AllocateInputs(GomokuBoardState const &state, unsigned batch_size);
+    void DeleteInputs();
 
-    TF_Session *session = nullptr;
-    TF_Graph *graph = nullptr;
-    TF_Buffer *graph_def = nullptr;
+    TF_Session *session_ = nullptr;
+    TF_Graph *graph_ = nullptr;
+    TF_Buffer *graph_def_ = nullptr;
 
-    TF_Tensor *board_input_value = nullptr;
-    TF_Tensor *game_phase_input_value = nullptr;
-    TF_Tensor *next_move_stone_type_input_value = nullptr;
-    TF_Tensor *shl_map_input_value = nullptr;
+    // Graph endpoints, resolved once when the model is loaded.
+    TF_Output inputs_[4];
+    TF_Output outputs_[2];
 
-    GomokuShlRolloutEvaluator shl_rollout_evaluator;
+    // Input tensors are kept for as long as the batch size doesn't change.
+    unsigned batch_size_ = 0;
+    TF_Tensor *board_input_value_ = nullptr;
+    TF_Tensor *game_phase_input_value_ = nullptr;
+    TF_Tensor *next_move_stone_type_input_value_ = nullptr;
+    TF_Tensor *shl_map_input_value_ = nullptr;
 };
 
-GomokuShlModelEvaluator::GomokuShlModelEvaluatorInternal::GomokuShlModelEvaluatorInternal(
-    std::string const &model_path) {
-    graph = TF_NewGraph();
-    graph_def = TF_NewBuffer();
+ShlModel::ShlModel(std::string const &model_path) {
+    graph_ = TF_NewGraph();
+    graph_def_ = TF_NewBuffer();
 
     TF_SessionOptions *session_options = TF_NewSessionOptions();
     TF_Status *status = TF_NewStatus();
     char const *tags[] = {"serve"};
-    session =
+    session_ =
         TF_LoadSessionFromSavedModel(session_options, /*run_options=*/nullptr, model_path.c_str(),
-                                     tags, /*tags_len=*/1, graph, graph_def, status);
+                                     tags, /*tags_len=*/1, graph_, graph_def_, status);
     assert(TF_GetCode(status) == TF_OK);
     TF_DeleteStatus(status);
     TF_DeleteSessionOptions(session_options);
+
+    inputs_[0] = BindOutput(graph_, /*oper_name=*/"inference_boards", /*index=*/0);
+    inputs_[1] = BindOutput(graph_, /*oper_name=*/"inference_game_phases", /*index=*/0);
+    inputs_[2] = BindOutput(graph_, /*oper_name=*/"inference_next_move_stone_types", /*index=*/0);
+    inputs_[3] = BindOutput(graph_, /*oper_name=*/"inference_shl_map", /*index=*/0);
+    outputs_[0] = BindOutput(graph_, /*oper_name=*/"StatefulPartitionedCall", /*index=*/0);
+    outputs_[1] = BindOutput(graph_, /*oper_name=*/"StatefulPartitionedCall", /*index=*/1);
 }
 
-GomokuShlModelEvaluator::GomokuShlModelEvaluatorInternal::~GomokuShlModelEvaluatorInternal() {
-    TF_DeleteTensor(board_input_value);
-    TF_DeleteTensor(game_phase_input_value);
-    TF_DeleteTensor(next_move_stone_type_input_value);
-    TF_DeleteTensor(shl_map_input_value);
+ShlModel::~ShlModel() {
+    this->DeleteInputs();
 
-    TF_DeleteGraph(graph);
-    TF_DeleteBuffer(graph_def);
+    TF_DeleteGraph(graph_);
+    TF_DeleteBuffer(graph_def_);
 
     TF_Status *status = TF_NewStatus();
-    TF_DeleteSession(session, status);
+    TF_DeleteSession(session_, status);
     assert(TF_GetCode(status) == TF_OK);
     TF_DeleteStatus(status);
 }
 
-std::unordered_map<GomokuActionId, float>
-GomokuShlModelEvaluator::GomokuShlModelEvaluatorInternal::ModelBasedPolicy(
-    GomokuBoardState const &state, std::vector<float> const &shl_map) {
-    if (board_input_value == nullptr) {
-        // Allocate tensors when it's the first time running inference.
-        int64_t board_dims[] = {1, state.Height(), state.Width()};
-        board_input_value =
-            TF_AllocateTensor(TF_UINT8, board_dims,
-                              /*num_dims=*/sizeof(board_dims) / sizeof(int64_t),
-                              /*len=*/board_dims[0] * board_dims[1] * board_dims[2]);
-
-        int64_t game_phase_dims[] = {1};
-        game_phase_input_value =
-            TF_AllocateTensor(TF_UINT8, game_phase_dims,
-                              /*num_dims=*/sizeof(game_phase_dims) / sizeof(int64_t),
-                              /*len=*/game_phase_dims[0]);
-
-        int64_t next_move_stone_type_dims[] = {1};
-        next_move_stone_type_input_value =
-            TF_AllocateTensor(TF_UINT8, next_move_stone_type_dims,
-                              /*num_dims=*/sizeof(next_move_stone_type_dims) / sizeof(int64_t),
-                              /*len=*/next_move_stone_type_dims[0]);
-
-        int64_t shl_map_dims[] = {1, state.Height(), state.Width(), 4};
-        shl_map_input_value =
-            TF_AllocateTensor(TF_FLOAT, shl_map_dims,
-                              /*num_dims=*/sizeof(shl_map_dims) / sizeof(int64_t),
-                              /*len=*/shl_map_dims[0] * shl_map_dims[1] * shl_map_dims[2] *
-                                  shl_map_dims[3] * sizeof(float));
-    }
+void ShlModel::AllocateInputs(GomokuBoardState const &state, unsigned batch_size) {
+    this->DeleteInputs();
+
+    int64_t board_dims[] = {batch_size, state.Height(), state.Width()};
+    board_input_value_ =
+        TF_AllocateTensor(TF_UINT8, board_dims,
+                          /*num_dims=*/sizeof(board_dims) / sizeof(int64_t),
+                          /*len=*/board_dims[0] * board_dims[1] * board_dims[2]);
+
+    int64_t game_phase_dims[] = {batch_size};
+    game_phase_input_value_ =
+        TF_AllocateTensor(TF_UINT8, game_phase_dims,
+                          /*num_dims=*/sizeof(game_phase_dims) / sizeof(int64_t),
+                          /*len=*/game_phase_dims[0]);
+
+    int64_t next_move_stone_type_dims[] = {batch_size};
+    next_move_stone_type_input_value_ =
+        TF_AllocateTensor(TF_UINT8, next_move_stone_type_dims,
+                          /*num_dims=*/sizeof(next_move_stone_type_dims) / sizeof(int64_t),
+                          /*len=*/next_move_stone_type_dims[0]);
+
+    int64_t shl_map_dims[] = {batch_size, state.Height(), state.Width(), 4};
+    shl_map_input_value_ =
+        TF_AllocateTensor(TF_FLOAT, shl_map_dims,
+                          /*num_dims=*/sizeof(shl_map_dims) / sizeof(int64_t),
+                          /*len=*/shl_map_dims[0] * shl_map_dims[1] * shl_map_dims[2] *
+                              shl_map_dims[3] * sizeof(float));
+
+    batch_size_ = batch_size;
+}
 
-    WriteBoard(state, board_input_value);
-    WriteGamePhase(state, game_phase_input_value);
-    WriteNextMoveStoneType(state, next_move_stone_type_input_value);
-    WriteShlMap(state, shl_map, shl_map_input_value);
+void ShlModel::DeleteInputs() {
+    if (batch_size_ == 0) {
+        return;
+    }
 
-    TF_Operation *board_input_op = TF_GraphOperationByName(graph, /*oper_name=*/"inference_boards");
-    assert(board_input_op != nullptr);
-    TF_Output board_input = TF_Output{board_input_op, 0};
+    TF_DeleteTensor(board_input_value_);
+    TF_DeleteTensor(game_phase_input_value_);
+    TF_DeleteTensor(next_move_stone_type_input_value_);
+    TF_DeleteTensor(shl_map_input_value_);
+    batch_size_ = 0;
+}
 
-    TF_Operation *game_phase_input_op =
-        TF_GraphOperationByName(graph, /*oper_name=*/"inference_game_phases");
-    assert(game_phase_input_op != nullptr);
-    TF_Output game_phase_input = TF_Output{game_phase_input_op, 0};
+void ShlModel::Infer(std::vector<GomokuInferenceRequest> const &batch,
+                     std::vector<GomokuInferenceResult> *results) {
+    assert(!batch.empty());
+    assert(results->size() == batch.size());
 
-    TF_Operation *next_move_stone_type_input_op =
-        TF_GraphOperationByName(graph, /*oper_name=*/"inference_next_move_stone_types");
-    assert(next_move_stone_type_input_op != nullptr);
-    TF_Output next_move_stone_type_input = TF_Output{next_move_stone_type_input_op, 0};
+    if (batch_size_ != batch.size()) {
+        this->AllocateInputs(*batch[0].state, batch.size());
+    }
 
-    TF_Operation *shl_map_input_op =
-        TF_GraphOperationByName(graph, /*oper_name=*/"inference_shl_map");
-    assert(shl_map_input_op != nullptr);
-    TF_Output shl_map_input = TF_Output{shl_map_input_op, 0};
+    for (unsigned i = 0; i < batch.size(); ++i) {
+        assert(batch[i].features != nullptr);
 
-    TF_Output inputs[] = {board_input, game_phase_input, next_move_stone_type_input, shl_map_input};
-    TF_Tensor *input_values[] = {board_input_value, game_phase_input_value,
-                                 next_move_stone_type_input_value, shl_map_input_value};
+        WriteBoard(*batch[i].state, i, board_input_value_);
+        WriteGamePhase(*batch[i].state, i, game_phase_input_value_);
+        WriteNextMoveStoneType(*batch[i].state, i, next_move_stone_type_input_value_);
+        WriteShlMap(*batch[i].state, *batch[i].features, i, shl_map_input_value_);
+    }
 
-    TF_Operation *output_op =
-        TF_GraphOperationByName(graph, /*oper_name=*/"StatefulPartitionedCall");
-    TF_Output policy_output = TF_Output{output_op, 0};
-    TF_Output value_output = TF_Output{output_op, 1};
+    TF_Tensor *input_values[] = {board_input_value_, game_phase_input_value_,
+                                 next_move_stone_type_input_value_, shl_map_input_value_};
+    static_assert(sizeof(input_values) / sizeof(TF_Tensor *) ==
+                  sizeof(inputs_) / sizeof(TF_Output));
 
-    TF_Output outputs[] = {policy_output, value_output};
     TF_Tensor *output_values[2];
 
     TF_Status *status = TF_NewStatus();
-    TF_SessionRun(session, nullptr, inputs, input_values,
-                  /*ninputs=*/sizeof(input_values) / sizeof(TF_Tensor *), outputs, output_values,
-                  /*noutputs=*/sizeof(outputs) / sizeof(TF_Output),
+    TF_SessionRun(session_, nullptr, inputs_, input_values,
+                  /*ninputs=*/sizeof(input_values) / sizeof(TF_Tensor *), outputs_, output_values,
+                  /*noutputs=*/sizeof(outputs_) / sizeof(TF_Output),
                   /*target_opers=*/nullptr, /*ntargets=*/0,
                   /*metadata=*/nullptr, status);
     assert(TF_GetCode(status) == TF_OK);
     TF_DeleteStatus(status);
 
-    std::unordered_map<GomokuActionId, float> policy =
-        RenormalizePolicy(state, /*policy_tensor=*/output_values[0]);
+    TF_Tensor const *policy_tensor = output_values[0];
+    TF_Tensor const *value_tensor = output_values[1];
+    assert(TF_NumDims(policy_tensor) == 2);
+    assert(TF_Dim(policy_tensor, /*dim_index=*/0) == static_cast<int64_t>(batch.size()));
+    assert(TF_NumDims(value_tensor) == 1);
+    assert(TF_Dim(value_tensor, /*dim_index=*/0) == static_cast<int64_t>(batch.size()));
+
+    unsigned num_actions = TF_Dim(policy_tensor, /*dim_index=*/1);
+    float const *policy = static_cast<float const *>(TF_TensorData(policy_tensor));
+    float const *values = static_cast<float const *>(TF_TensorData(value_tensor));
+    for (unsigned i = 0; i < batch.size(); ++i) {
+        (*results)[i].policy.assign(policy + i * num_actions, policy + (i + 1) * num_actions);
+        (*results)[i].value = values[i];
+    }
 
     TF_DeleteTensor(output_values[0]);
     TF_DeleteTensor(output_values[1]);
-
-    return policy;
 }
 
+} // namespace
+
+struct GomokuShlModelEvaluator::GomokuShlModelEvaluatorInternal {
+    GomokuShlModelEvaluatorInternal(std::shared_ptr<GomokuBatchInferenceServer> const &server);
+
+    std::shared_ptr<GomokuBatchInferenceServer> server;
+    GomokuShlRolloutEvaluator shl_rollout_evaluator;
+};
+
+GomokuShlModelEvaluator::GomokuShlModelEvaluatorInternal::GomokuShlModelEvaluatorInternal(
+    std::shared_ptr<GomokuBatchInferenceServer> const &server)
+    : server(server) {}
+
 GomokuShlModelEvaluator::GomokuShlModelEvaluator(std::string const &model_path)
-    : pimpl_(std::make_unique<GomokuShlModelEvaluatorInternal>(model_path)) {}
+    : GomokuShlModelEvaluator(std::make_shared<GomokuBatchInferenceServer>(
+          LoadShlModel(model_path), /*max_batch_size=*/1,
+          /*max_delay=*/std::chrono::microseconds(0), DefaultGomokuEvaluationCache(),
+          ModelVersionOf(model_path))) {}
+
+GomokuShlModelEvaluator::GomokuShlModelEvaluator(
+    std::shared_ptr<GomokuBatchInferenceServer> const &inference_server)
+    : pimpl_(std::make_unique<GomokuShlModelEvaluatorInternal>(inference_server)) {}
 
 GomokuShlModelEvaluator::~GomokuShlModelEvaluator() {}
 
@@ -262,15 +293,17 @@ float GomokuShlModelEvaluator::EvaluateReward(GomokuBoardState const &state,
     return pimpl_->shl_rollout_evaluator.EvaluateReward(state, parent_state_id, state_id);
 }
 
-std::unordered_map<GomokuActionId, float> GomokuShlModelEvaluator::EvaluatePolicy(
-    GomokuBoardState const &state, std::optional<MctNodeId> parent_state_id, MctNodeId state_id) {
+void GomokuShlModelEvaluator::EvaluatePolicy(GomokuBoardState const &state,
+                                             std::optional<MctNodeId> parent_state_id,
+                                             MctNodeId state_id, GomokuPolicy *policy) {
     ShlFeatureBuilder const &feature_builder =
         pimpl_->shl_rollout_evaluator.GetFeatureBuilderForState(state, parent_state_id, state_id);
-    std::vector<float> shl_map =
-        feature_builder.TopKMapDense(/*top_k=*/15, /*normalized=*/true,
-                                     /*next_move_stone_type=*/std::nullopt);
+    std::vector<float> shl_map(state.Width() * state.Height() * 4);
+    feature_builder.WriteTopKPlanes(/*top_k=*/15, /*normalized=*/true,
+                                    /*next_move_stone_type=*/std::nullopt, shl_map.data());
 
-    return pimpl_->ModelBasedPolicy(state, shl_map);
+    GomokuInferenceResult inference = pimpl_->server->Infer(state, &shl_map).get();
+    RenormalizePolicy(state, inference.policy, policy);
 }
 
 float GomokuShlModelEvaluator::ExplorationFactor() const { return 3.0f; }
@@ -279,4 +312,8 @@ unsigned GomokuShlModelEvaluator::NumSimulations() const { return 1500; }
 
 void GomokuShlModelEvaluator::ClearCache() { pimpl_->shl_rollout_evaluator.ClearCache(); }
 
+std::unique_ptr<GomokuInferenceModelInterface> LoadShlModel(std::string const &model_path) {
+    return std::make_unique<ShlModel>(model_path);
+}
+
 } // namespace e8
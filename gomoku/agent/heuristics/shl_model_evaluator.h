@@ -22,10 +22,11 @@
 #include <memory>
 #include <optional>
 #include <string>
-#include <unordered_map>
 
+#include "gomoku/agent/heuristics/batch_inference_server.h"
 #include "gomoku/agent/heuristics/evaluator.h"
 #include "gomoku/agent/search/mct_node.h"
+#include "gomoku/agent/search/policy.h"
 #include "gomoku/game/board_state.h"
 
 namespace e8 {
@@ -41,14 +42,20 @@ namespace e8 {
 class GomokuShlModelEvaluator : public GomokuEvaluatorInterface {
   public:
     GomokuShlModelEvaluator(std::string const &model_path);
+
+    /**
+     * @brief GomokuShlModelEvaluator Constructs an evaluator which batches the policy inference
+     * with the other users of the server. The server should be serving a model loaded by
+     * LoadShlModel().
+     */
+    GomokuShlModelEvaluator(std::shared_ptr<GomokuBatchInferenceServer> const &inference_server);
     ~GomokuShlModelEvaluator();
 
     float EvaluateReward(GomokuBoardState const &state, std::optional<MctNodeId> parent_state_id,
                          MctNodeId state_id) override;
 
-    std::unordered_map<GomokuActionId, float>
-    EvaluatePolicy(GomokuBoardState const &state, std::optional<MctNodeId> parent_state_id,
-                   MctNodeId state_id) override;
+    void EvaluatePolicy(GomokuBoardState const &state, std::optional<MctNodeId> parent_state_id,
+                        MctNodeId state_id, GomokuPolicy *policy) override;
 
     float ExplorationFactor() const override;
 
@@ -61,6 +68,12 @@ class GomokuShlModelEvaluator : public GomokuEvaluatorInterface {
     std::unique_ptr<GomokuShlModelEvaluatorInternal> pimpl_;
 };
 
+/**
+ * @brief LoadShlModel Loads the policy network of the SHL model evaluator for batched inference.
+ * Each inference request has to supply the state's dense SHL map as its features.
+ */
+std::unique_ptr<GomokuInferenceModelInterface> LoadShlModel(std::string const &model_path);
+
 } // namespace e8
 
 #endif // SHL_MODEL_ENSEMBLE_EVALUATOR_H
@@ -15,22 +15,26 @@
  * not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <memory>
 #include <optional>
-#include <unordered_map>
-#include <unordered_set>
+#include <thread>
 #include <utility>
 #include <vector>
 
 #include "common/random/random_distribution.h"
 #include "common/random/random_source.h"
+#include "common/random/sample.h"
+#include "common/thread/thread_pool.h"
 #include "gomoku/agent/heuristics/evaluator.h"
 #include "gomoku/agent/heuristics/shl_feature.h"
 #include "gomoku/agent/heuristics/shl_rollout_evaluator.h"
 #include "gomoku/agent/search/mct_node.h"
-#include "gomoku/agent/search/mct_search.h"
+#include "gomoku/agent/search/policy.h"
 #include "gomoku/game/board_state.h"
 
 namespace e8 {
@@ -38,78 +42,206 @@ namespace {
 
 unsigned kNumRollouts = 10;
 
-std::unordered_map<GomokuActionId, float>
-ShlPolicy(GomokuBoardState const &state,
-          std::vector<std::pair<MovePosition, ShlComponents>> const &shl_map,
-          RandomSource *random_source) {
-    std::unordered_map<GomokuActionId, float> policy;
+/**
+ * @brief The FlatPolicy struct A policy stored as parallel arrays of actions and their
+ * probabilities, so that it can be sampled without hashing.
+ */
+struct FlatPolicy {
+    std::vector<GomokuActionId> action_ids;
+    std::vector<float> probs;
+};
 
+void RandomPolicy(GomokuBoardState const &state, RandomSource *random_source,
+                  FlatPolicy *policy) {
+    policy->action_ids.clear();
+    for (auto const &[action_id, _] : state.LegalActions()) {
+        policy->action_ids.push_back(action_id);
+    }
+    policy->probs = RandomPmf(policy->action_ids.size(), random_source);
+}
+
+void ShlPolicy(GomokuBoardState const &state,
+               std::vector<std::pair<MovePosition, ShlComponents>> const &shl_map,
+               RandomSource *random_source, FlatPolicy *policy) {
     if (shl_map.empty()) {
-        std::vector<float> random_pmf = RandomPmf(state.LegalActions().size(), random_source);
-        unsigned selector = 0;
-        for (auto const &[action_id, _] : state.LegalActions()) {
-            policy[action_id] = random_pmf[selector++];
-        }
-        return policy;
+        RandomPolicy(state, random_source, policy);
+        return;
     }
 
+    policy->action_ids.clear();
+    policy->probs.clear();
+
     float cdf = 0.0f;
     for (auto const &[pos, shl_components] : shl_map) {
-        GomokuActionId action_id = state.MovePositionToActionId(pos);
         float shl_score = ToShlScore(shl_components);
         cdf += shl_score;
-        policy[action_id] = shl_score;
+        policy->action_ids.push_back(state.MovePositionToActionId(pos));
+        policy->probs.push_back(shl_score);
     }
 
     assert(std::abs(cdf - 1.0f) < 1e-1);
-
-    return policy;
 }
 
-std::unordered_map<GomokuActionId, float> RolloutPolicy(GomokuBoardState const &state,
-                                                        ShlFeatureBuilder const &feature_builder,
-                                                        unsigned top_k,
-                                                        RandomSource *random_source) {
-    std::unordered_map<GomokuActionId, float> policy;
-
+void RolloutPolicy(GomokuBoardState const &state, ShlFeatureBuilder const &feature_builder,
+                   unsigned top_k, RandomSource *random_source, FlatPolicy *policy) {
     switch (state.CurrentGamePhase()) {
     case GP_PLACE_3_STONES:
     case GP_SWAP2_DECISION:
     case GP_SWAP2_PLACE_2_STONES:
     case GP_STONE_TYPE_DECISION: {
-        std::vector<float> random_pmf = RandomPmf(state.LegalActions().size(), random_source);
-        unsigned selector = 0;
-        for (auto const &[action_id, _] : state.LegalActions()) {
-            policy[action_id] = random_pmf[selector++];
-        }
+        RandomPolicy(state, random_source, policy);
         break;
     }
     case GP_STANDARD_GOMOKU: {
         StoneType next_move_stone_type = state.PlayerStoneType(state.CurrentPlayerSide());
         std::vector<std::pair<MovePosition, ShlComponents>> const &shl_map =
             feature_builder.TopKMapSparse(top_k, /*normalized=*/true, next_move_stone_type);
-        policy = ShlPolicy(state, shl_map, random_source);
+        ShlPolicy(state, shl_map, random_source, policy);
         break;
     }
     }
+}
+
+/**
+ * @brief The RolloutData class A worker's own copy of the state to roll out from. Workers claim
+ * rollouts from a shared counter until all of them are taken, so that a worker finishing early
+ * picks up the remaining work. Each rollout draws from its own random stream, seeded by the
+ * rollout's index. The reward therefore doesn't depend on which worker plays which rollout.
+ */
+class RolloutData : public TaskStorageInterface {
+  public:
+    RolloutData(GomokuBoardState const &state, ShlFeatureBuilder const &feature_builder,
+                std::atomic<unsigned> *next_rollout, unsigned base_seed);
+
+    void Run();
+    float AccumulatedReward() const;
+
+  private:
+    float Rollout(RandomSource *random_source);
+
+    GomokuBoardState state_;
+
+    // Each rollout resets feature_builder_ to start_feature_builder_. Copying doesn't allocate.
+    ShlFeatureBuilder const start_feature_builder_;
+    ShlFeatureBuilder feature_builder_;
+
+    std::atomic<unsigned> *next_rollout_;
+    unsigned const base_seed_;
+    FlatPolicy policy_;
+    float acc_reward_;
+};
+
+RolloutData::RolloutData(GomokuBoardState const &state, ShlFeatureBuilder const &feature_builder,
+                         std::atomic<unsigned> *next_rollout, unsigned base_seed)
+    : state_(state), start_feature_builder_(feature_builder), feature_builder_(feature_builder),
+      next_rollout_(next_rollout), base_seed_(base_seed), acc_reward_(0.0f) {}
+
+void RolloutData::Run() {
+    for (unsigned i = next_rollout_->fetch_add(1); i < kNumRollouts;
+         i = next_rollout_->fetch_add(1)) {
+        RandomSource random_source(base_seed_ + 0x9E3779B9u * i);
+        acc_reward_ += this->Rollout(&random_source);
+    }
+}
+
+float RolloutData::Rollout(RandomSource *random_source) {
+    PlayerSide evaluate_for_player = state_.CurrentPlayerSide();
+    unsigned num_start_actions = state_.History().size();
+    feature_builder_ = start_feature_builder_;
+
+    unsigned j = 0;
+    GameResult game_result = state_.CurrentGameResult();
+    do {
+        unsigned top_k;
+        switch (j) {
+        case 0: {
+            top_k = 8;
+            break;
+        }
+        case 1:
+        case 2: {
+            top_k = 5;
+            break;
+        }
+        default: {
+            top_k = 3;
+            break;
+        }
+        }
+
+        RolloutPolicy(state_, feature_builder_, top_k, random_source, &policy_);
+
+        GomokuActionId action_id = policy_.action_ids[SampleIndex(policy_.probs, random_source)];
+        game_result = state_.ApplyAction(action_id, /*cached_game_result=*/std::nullopt);
+
+        GomokuAction const &last_action =
+            state_.History()[state_.History().size() - 1].action.second;
+        if (last_action.stone_pos.has_value()) {
+            feature_builder_.AddStone(state_);
+        }
+
+        ++j;
+    } while (game_result == GameResult::GR_UNDETERMINED);
+
+    // Forks the next rollout from the same state.
+    while (state_.History().size() > num_start_actions) {
+        state_.RetractAction();
+    }
+
+    switch (game_result) {
+    case GR_TIE: {
+        return 0.0f;
+    }
+    case GR_PLAYER_A_WIN: {
+        return evaluate_for_player == PlayerSide::PS_PLAYER_A ? 1.0f : -1.0f;
+    }
+    case GR_PLAYER_B_WIN: {
+        return evaluate_for_player == PlayerSide::PS_PLAYER_B ? 1.0f : -1.0f;
+    }
+    default: {
+        assert(false);
+        return 0.0f;
+    }
+    }
+}
+
+float RolloutData::AccumulatedReward() const { return acc_reward_; }
 
-    return policy;
+class RolloutTask : public TaskInterface {
+  public:
+    void Run(TaskStorageInterface *storage) const override;
+    bool DropResourceOnCompletion() const override;
+};
+
+void RolloutTask::Run(TaskStorageInterface *storage) const {
+    static_cast<RolloutData *>(storage)->Run();
 }
 
+bool RolloutTask::DropResourceOnCompletion() const { return false; }
+
 } // namespace
 
 struct GomokuShlRolloutEvaluator::GomokuShlRolloutEvaluatorInternal {
-    GomokuShlRolloutEvaluatorInternal();
+    GomokuShlRolloutEvaluatorInternal(unsigned num_workers, std::optional<unsigned> seed);
 
     ShlFeatureBuilderCache feature_builder_cache;
     RandomSource random_source;
+
+    // The calling thread rolls out alongside the pool's workers.
+    ThreadPool thread_pool;
 };
 
-GomokuShlRolloutEvaluator::GomokuShlRolloutEvaluatorInternal::GomokuShlRolloutEvaluatorInternal()
-    : random_source() {}
+GomokuShlRolloutEvaluator::GomokuShlRolloutEvaluatorInternal::GomokuShlRolloutEvaluatorInternal(
+    unsigned num_workers, std::optional<unsigned> seed)
+    : random_source(seed.has_value() ? RandomSource(*seed) : RandomSource()),
+      thread_pool(std::max(1U, num_workers) - 1) {}
 
 GomokuShlRolloutEvaluator::GomokuShlRolloutEvaluator()
-    : pimpl_(std::make_unique<GomokuShlRolloutEvaluatorInternal>()) {}
+    : GomokuShlRolloutEvaluator(std::thread::hardware_concurrency(), /*seed=*/std::nullopt) {}
+
+GomokuShlRolloutEvaluator::GomokuShlRolloutEvaluator(unsigned num_workers,
+                                                     std::optional<unsigned> seed)
+    : pimpl_(std::make_unique<GomokuShlRolloutEvaluatorInternal>(num_workers, seed)) {}
 
 GomokuShlRolloutEvaluator::~GomokuShlRolloutEvaluator() {}
 
@@ -119,96 +251,42 @@ float GomokuShlRolloutEvaluator::EvaluateReward(GomokuBoardState const &state,
     ShlFeatureBuilder const &feature_builder =
         this->GetFeatureBuilderForState(state, parent_state_id, state_id);
 
-    PlayerSide evaluate_for_player = state.CurrentPlayerSide();
-    float acc_reward = 0.0f;
-
-    for (unsigned i = 0; i < kNumRollouts; ++i) {
-        GomokuBoardState rollout_state = state;
-        ShlFeatureBuilder rollout_feature_builder = feature_builder;
-        unsigned j = 0;
-
-        GameResult game_result = rollout_state.CurrentGameResult();
-        do {
-            unsigned top_k;
-            switch (j) {
-            case 0: {
-                top_k = 8;
-                break;
-            }
-            case 1:
-            case 2: {
-                top_k = 5;
-                break;
-            }
-            default: {
-                top_k = 3;
-                break;
-            }
-            }
-
-            std::unordered_map<GomokuActionId, float> policy = RolloutPolicy(
-                rollout_state, rollout_feature_builder, top_k, &pimpl_->random_source);
-
-            GomokuActionId action_id = SampleAction(policy, &pimpl_->random_source);
-            game_result = rollout_state.ApplyAction(action_id, /*cached_game_result=*/std::nullopt);
-
-            GomokuAction const &last_action =
-                rollout_state.History()[rollout_state.History().size() - 1].action.second;
-            if (last_action.stone_pos.has_value()) {
-                rollout_feature_builder.AddStone(rollout_state);
-            }
-
-            ++j;
-        } while (game_result == GameResult::GR_UNDETERMINED);
-
-        switch (game_result) {
-        case GR_TIE: {
-            acc_reward += 0.0f;
-            break;
-        }
-        case GR_PLAYER_A_WIN: {
-            if (evaluate_for_player == PlayerSide::PS_PLAYER_A) {
-                acc_reward += 1.0f;
-            } else {
-                acc_reward -= 1.0f;
-            }
-            break;
-        }
-        case GR_PLAYER_B_WIN: {
-            if (evaluate_for_player == PlayerSide::PS_PLAYER_B) {
-                acc_reward += 1.0f;
-            } else {
-                acc_reward -= 1.0f;
-            }
-            break;
-        }
-        default: {
-            assert(false);
-        }
-        }
+    std::atomic<unsigned> next_rollout(0);
+    unsigned base_seed = static_cast<unsigned>(pimpl_->random_source.Draw() * UINT32_MAX);
+
+    auto task = std::make_shared<RolloutTask>();
+    unsigned num_jobs = std::min(pimpl_->thread_pool.NumWorkers(), kNumRollouts - 1);
+    for (unsigned i = 0; i < num_jobs; ++i) {
+        pimpl_->thread_pool.Schedule(
+            task, std::make_unique<RolloutData>(state, feature_builder, &next_rollout, base_seed));
+    }
+
+    RolloutData caller_rollouts(state, feature_builder, &next_rollout, base_seed);
+    task->Run(&caller_rollouts);
+
+    float acc_reward = caller_rollouts.AccumulatedReward();
+    for (unsigned i = 0; i < num_jobs; ++i) {
+        std::unique_ptr<TaskStorageInterface> rollouts = pimpl_->thread_pool.WaitForNextCompleted();
+        acc_reward += static_cast<RolloutData *>(rollouts.get())->AccumulatedReward();
     }
 
     return acc_reward / kNumRollouts;
 }
 
-std::unordered_map<GomokuActionId, float> GomokuShlRolloutEvaluator::EvaluatePolicy(
-    GomokuBoardState const &state, std::optional<MctNodeId> parent_state_id, MctNodeId state_id) {
+void GomokuShlRolloutEvaluator::EvaluatePolicy(GomokuBoardState const &state,
+                                               std::optional<MctNodeId> parent_state_id,
+                                               MctNodeId state_id, GomokuPolicy *policy) {
     ShlFeatureBuilder const &feature_builder =
         this->GetFeatureBuilderForState(state, parent_state_id, state_id);
 
-    std::unordered_map<GomokuActionId, float> policy;
+    FlatPolicy flat_policy;
 
     switch (state.CurrentGamePhase()) {
     case GP_PLACE_3_STONES:
     case GP_SWAP2_DECISION:
     case GP_SWAP2_PLACE_2_STONES:
     case GP_STONE_TYPE_DECISION: {
-        std::vector<float> random_pmf =
-            RandomPmf(state.LegalActions().size(), &pimpl_->random_source);
-        unsigned selector = 0;
-        for (auto const &[action_id, _] : state.LegalActions()) {
-            policy[action_id] = random_pmf[selector++];
-        }
+        RandomPolicy(state, &pimpl_->random_source, &flat_policy);
         break;
     }
     case GP_STANDARD_GOMOKU: {
@@ -217,12 +295,15 @@ std::unordered_map<GomokuActionId, float> GomokuShlRolloutEvaluator::EvaluatePol
         std::vector<std::pair<MovePosition, ShlComponents>> const &shl_map =
             feature_builder.TopKMapSparse(/*top_k=*/15, /*normalized=*/true, next_move_stone_type);
 
-        policy = ShlPolicy(state, shl_map, &pimpl_->random_source);
+        ShlPolicy(state, shl_map, &pimpl_->random_source, &flat_policy);
         break;
     }
     }
 
-    return policy;
+    policy->Reset(state);
+    for (unsigned i = 0; i < flat_policy.action_ids.size(); ++i) {
+        (*policy)[flat_policy.action_ids[i]] = flat_policy.probs[i];
+    }
 }
 
 float GomokuShlRolloutEvaluator::ExplorationFactor() const { return 3.0f; }
@@ -20,13 +20,12 @@
 
 #include <memory>
 #include <optional>
-#include <unordered_map>
 #include <unordered_set>
 
-#include "common/thread/thread_pool.h"
 #include "gomoku/agent/heuristics/evaluator.h"
 #include "gomoku/agent/heuristics/shl_feature.h"
 #include "gomoku/agent/search/mct_node.h"
+#include "gomoku/agent/search/policy.h"
 #include "gomoku/game/board_state.h"
 
 namespace e8 {
@@ -34,19 +33,28 @@ namespace e8 {
 /**
  * @brief The GomokuShlRolloutEvaluator class Evaluates the board state by conducting rollouts on a
  * policy. The policy is constructed simple by taking the top 10 normalized SHL scores during the
- * standard Gomoku game phase.
+ * standard Gomoku game phase. The rollouts of an evaluation are spread over a pool of workers.
  */
 class GomokuShlRolloutEvaluator : public GomokuEvaluatorInterface {
   public:
+    /**
+     * @brief GomokuShlRolloutEvaluator Rolls out with one worker per hardware thread, from a random
+     * seed.
+     */
     GomokuShlRolloutEvaluator();
+
+    /**
+     * @brief GomokuShlRolloutEvaluator Rolls out with num_workers workers, the calling thread
+     * included. A fixed seed makes the rewards reproducible regardless of the number of workers.
+     */
+    GomokuShlRolloutEvaluator(unsigned num_workers, std::optional<unsigned> seed);
     ~GomokuShlRolloutEvaluator();
 
     float EvaluateReward(GomokuBoardState const &state, std::optional<MctNodeId> parent_state_id,
                          MctNodeId state_id) override;
 
-    std::unordered_map<GomokuActionId, float>
-    EvaluatePolicy(GomokuBoardState const &state, std::optional<MctNodeId> parent_state_id,
-                   MctNodeId state_id) override;
+    void EvaluatePolicy(GomokuBoardState const &state, std::optional<MctNodeId> parent_state_id,
+                        MctNodeId state_id, GomokuPolicy *policy) override;
 
     float ExplorationFactor() const override;
 
@@ -16,16 +16,21 @@
  */
 
 #include <cassert>
+#include <chrono>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
-#include <thread>
 #include <unordered_map>
+#include <vector>
 
+#include "gomoku/agent/heuristics/batch_inference_server.h"
+#include "gomoku/agent/heuristics/evaluation_cache.h"
 #include "gomoku/agent/heuristics/evaluator.h"
 #include "gomoku/agent/heuristics/tf_zero_prior_evaluator.h"
 #include "gomoku/agent/search/mct_node.h"
+#include "gomoku/agent/search/policy.h"
 #include "gomoku/game/board_state.h"
 #include "third_party/tensorflow/c/c_api.h"
 #include "third_party/tensorflow/c/tf_datatype.h"
@@ -37,199 +42,257 @@ namespace {
 
 struct EvaluationResult {
     float reward;
-    std::unordered_map<GomokuActionId, float> policy;
+    GomokuPolicy policy;
 };
 
-void WriteBoard(GomokuBoardState const &state, TF_Tensor *board) {
+void WriteBoard(GomokuBoardState const &state, unsigned batch_index, TF_Tensor *board) {
     assert(TF_NumDims(board) == 3);
-    assert(TF_Dim(board, /*dim_index=*/0) == 1);
+    assert(TF_Dim(board, /*dim_index=*/0) > batch_index);
     assert(TF_Dim(board, /*dim_index=*/1) == state.Width());
     assert(TF_Dim(board, /*dim_index=*/2) == state.Height());
 
-    uint8_t *tensor_memory = static_cast<uint8_t *>(TF_TensorData(board));
+    uint8_t *tensor_memory = static_cast<uint8_t *>(TF_TensorData(board)) +
+                             batch_index * state.Width() * state.Height();
 
-    for (int16_t y = 0; y < state.Height(); ++y) {
-        for (int16_t x = 0; x < state.Width(); ++x) {
-            tensor_memory[y + x * state.Height()] = *state.ChessPieceStateAt(MovePosition(x, y));
-        }
-    }
+    state.WriteBoardPlane(tensor_memory);
 }
 
-void WriteGamePhase(GomokuBoardState const &state, TF_Tensor *game_phase) {
+void WriteGamePhase(GomokuBoardState const &state, unsigned batch_index, TF_Tensor *game_phase) {
     assert(TF_NumDims(game_phase) == 1);
-    assert(TF_Dim(game_phase, /*dim_index=*/0) == 1);
+    assert(TF_Dim(game_phase, /*dim_index=*/0) > batch_index);
 
     uint8_t *tensor_memory = static_cast<uint8_t *>(TF_TensorData(game_phase));
-    *tensor_memory = state.CurrentGamePhase();
+    tensor_memory[batch_index] = state.CurrentGamePhase();
 }
 
-void WriteNextMoveStoneType(GomokuBoardState const &state, TF_Tensor *next_move_stone_type) {
+void WriteNextMoveStoneType(GomokuBoardState const &state, unsigned batch_index,
+                            TF_Tensor *next_move_stone_type) {
     assert(TF_NumDims(next_move_stone_type) == 1);
-    assert(TF_Dim(next_move_stone_type, /*dim_index=*/0) == 1);
+    assert(TF_Dim(next_move_stone_type, /*dim_index=*/0) > batch_index);
 
     uint8_t *tensor_memory = static_cast<uint8_t *>(TF_TensorData(next_move_stone_type));
-    *tensor_memory = state.PlayerStoneType(state.CurrentPlayerSide());
+    tensor_memory[batch_index] = state.PlayerStoneType(state.CurrentPlayerSide());
 }
 
-EvaluationResult ToEvaluationResult(GomokuBoardState const &state, TF_Tensor const *policy_tensor,
-                                    TF_Tensor const *value_tensor) {
-    EvaluationResult evaluation;
-
+void ReadInferenceResults(TF_Tensor const *policy_tensor, TF_Tensor const *value_tensor,
+                          std::vector<GomokuInferenceResult> *results) {
     assert(TF_NumDims(policy_tensor) == 2);
-    assert(TF_Dim(policy_tensor, /*dim_index=*/0) == 1);
-    auto [lo, hi] = state.ActionIdRange();
-    assert(TF_Dim(policy_tensor, /*dim_index=*/1) == hi - lo + 1);
+    assert(TF_Dim(policy_tensor, /*dim_index=*/0) == static_cast<int64_t>(results->size()));
+    assert(TF_NumDims(value_tensor) == 1);
+    assert(TF_Dim(value_tensor, /*dim_index=*/0) == static_cast<int64_t>(results->size()));
 
-    // Re-normalizes and stores the policy into the map.
-    float *policy = static_cast<float *>(TF_TensorData(policy_tensor));
+    unsigned num_actions = TF_Dim(policy_tensor, /*dim_index=*/1);
+    float const *policy = static_cast<float const *>(TF_TensorData(policy_tensor));
+    float const *values = static_cast<float const *>(TF_TensorData(value_tensor));
 
-    float norm_factor = 0;
-    for (auto const &[action_id, _] : state.LegalActions()) {
-        norm_factor += policy[action_id];
-    }
-    for (auto const &[action_id, _] : state.LegalActions()) {
-        evaluation.policy[action_id] = policy[action_id] / norm_factor;
+    for (unsigned i = 0; i < results->size(); ++i) {
+        GomokuInferenceResult &result = (*results)[i];
+        result.policy.assign(policy + i * num_actions, policy + (i + 1) * num_actions);
+
+        // Value prediction can be treated as the expected reward.
+        result.value = values[i];
     }
+}
 
-    assert(TF_NumDims(value_tensor) == 1);
-    assert(TF_Dim(value_tensor, /*dim_index=*/0) == 1);
+TF_Output BindOutput(TF_Graph *graph, char const *oper_name, int index) {
+    TF_Operation *op = TF_GraphOperationByName(graph, oper_name);
+    assert(op != nullptr);
+    return TF_Output{op, index};
+}
+
+EvaluationResult ToEvaluationResult(GomokuBoardState const &state,
+                                    GomokuInferenceResult const &inference) {
+    EvaluationResult evaluation;
+
+    auto [lo, hi] = state.ActionIdRange();
+    assert(inference.policy.size() == static_cast<unsigned>(hi - lo + 1));
+
+    // Re-normalizes the policy over the legal actions.
+    evaluation.policy.AssignLegal(state, inference.policy.data());
 
-    // Value prediction can be treated as the expected reward.
-    float *values = static_cast<float *>(TF_TensorData(value_tensor));
-    evaluation.reward = values[0];
+    evaluation.reward = inference.value;
 
     return evaluation;
 }
 
-} // namespace
+class TfZeroPriorModel : public GomokuInferenceModelInterface {
+  public:
+    TfZeroPriorModel(std::string const &model_path);
+    ~TfZeroPriorModel() override;
 
-struct GomokuTfZeroPriorEvaluator::TfModelBasedEvaluatorInternal {
-    TfModelBasedEvaluatorInternal(std::string const &model_path);
-    ~TfModelBasedEvaluatorInternal();
+    void Infer(std::vector<GomokuInferenceRequest> const &batch,
+               std::vector<GomokuInferenceResult> *results) override;
 
-    EvaluationResult Fetch(MctNodeId const state_id, GomokuBoardState const &state);
+  private:
+    void AllocateInputs(GomokuBoardState const &state, unsigned batch_size);
+    void DeleteInputs();
 
-    TF_Session *session = nullptr;
-    TF_Graph *graph = nullptr;
-    TF_Buffer *graph_def = nullptr;
+    TF_Session *session_ = nullptr;
+    TF_Graph *graph_ = nullptr;
+    TF_Buffer *graph_def_ = nullptr;
 
-    TF_Tensor *board_input_value = nullptr;
-    TF_Tensor *game_phase_input_value = nullptr;
-    TF_Tensor *next_move_stone_type_input_value = nullptr;
+    // Graph endpoints, resolved once when the model is loaded.
+    TF_Output inputs_[3];
+    TF_Output outputs_[2];
 
-    std::unordered_map<MctNodeId, EvaluationResult> cache;
+    // Input tensors are kept for as long as the batch size doesn't change.
+    unsigned batch_size_ = 0;
+    TF_Tensor *board_input_value_ = nullptr;
+    TF_Tensor *game_phase_input_value_ = nullptr;
+    TF_Tensor *next_move_stone_type_input_value_ = nullptr;
 };
 
-GomokuTfZeroPriorEvaluator::TfModelBasedEvaluatorInternal::TfModelBasedEvaluatorInternal(
-    std::string const &model_path) {
-    graph = TF_NewGraph();
-    graph_def = TF_NewBuffer();
+TfZeroPriorModel::TfZeroPriorModel(std::string const &model_path) {
+    graph_ = TF_NewGraph();
+    graph_def_ = TF_NewBuffer();
 
     TF_SessionOptions *session_options = TF_NewSessionOptions();
     TF_Status *status = TF_NewStatus();
     char const *tags[] = {"serve"};
-    session =
+    session_ =
         TF_LoadSessionFromSavedModel(session_options, /*run_options=*/nullptr, model_path.c_str(),
-                                     tags, /*tags_len=*/1, graph, graph_def, status);
+                                     tags, /*tags_len=*/1, graph_, graph_def_, status);
     assert(TF_GetCode(status) == TF_OK);
     TF_DeleteStatus(status);
     TF_DeleteSessionOptions(session_options);
+
+    inputs_[0] = BindOutput(graph_, /*oper_name=*/"inference_boards", /*index=*/0);
+    inputs_[1] = BindOutput(graph_, /*oper_name=*/"inference_game_phases", /*index=*/0);
+    inputs_[2] = BindOutput(graph_, /*oper_name=*/"inference_next_move_stone_types", /*index=*/0);
+    outputs_[0] = BindOutput(graph_, /*oper_name=*/"StatefulPartitionedCall", /*index=*/0);
+    outputs_[1] = BindOutput(graph_, /*oper_name=*/"StatefulPartitionedCall", /*index=*/1);
 }
 
-GomokuTfZeroPriorEvaluator::TfModelBasedEvaluatorInternal::~TfModelBasedEvaluatorInternal() {
-    TF_DeleteTensor(board_input_value);
-    TF_DeleteTensor(game_phase_input_value);
-    TF_DeleteTensor(next_move_stone_type_input_value);
+TfZeroPriorModel::~TfZeroPriorModel() {
+    this->DeleteInputs();
 
-    TF_DeleteGraph(graph);
-    TF_DeleteBuffer(graph_def);
+    TF_DeleteGraph(graph_);
+    TF_DeleteBuffer(graph_def_);
 
     TF_Status *status = TF_NewStatus();
-    TF_DeleteSession(session, status);
+    TF_DeleteSession(session_, status);
     assert(TF_GetCode(status) == TF_OK);
     TF_DeleteStatus(status);
 }
 
-EvaluationResult
-GomokuTfZeroPriorEvaluator::TfModelBasedEvaluatorInternal::Fetch(MctNodeId const state_id,
-                                                                 GomokuBoardState const &state) {
-    auto it = cache.find(state_id);
-    if (it != cache.end()) {
-        return it->second;
-    }
+void TfZeroPriorModel::AllocateInputs(GomokuBoardState const &state, unsigned batch_size) {
+    this->DeleteInputs();
 
-    if (board_input_value == nullptr) {
-        // Allocate tensors when it's the first time running inference.
-        int64_t board_dims[] = {1, state.Height(), state.Width()};
-        board_input_value =
-            TF_AllocateTensor(TF_UINT8, board_dims,
-                              /*num_dims=*/sizeof(board_dims) / sizeof(int64_t),
-                              /*len=*/board_dims[0] * board_dims[1] * board_dims[2]);
-
-        int64_t game_phase_dims[] = {1};
-        game_phase_input_value =
-            TF_AllocateTensor(TF_UINT8, game_phase_dims,
-                              /*num_dims=*/sizeof(game_phase_dims) / sizeof(int64_t),
-                              /*len=*/game_phase_dims[0]);
-
-        int64_t next_move_stone_type_dims[] = {1};
-        next_move_stone_type_input_value =
-            TF_AllocateTensor(TF_UINT8, next_move_stone_type_dims,
-                              /*num_dims=*/sizeof(next_move_stone_type_dims) / sizeof(int64_t),
-                              /*len=*/next_move_stone_type_dims[0]);
-    }
+    int64_t board_dims[] = {batch_size, state.Height(), state.Width()};
+    board_input_value_ =
+        TF_AllocateTensor(TF_UINT8, board_dims,
+                          /*num_dims=*/sizeof(board_dims) / sizeof(int64_t),
+                          /*len=*/board_dims[0] * board_dims[1] * board_dims[2]);
+
+    int64_t game_phase_dims[] = {batch_size};
+    game_phase_input_value_ =
+        TF_AllocateTensor(TF_UINT8, game_phase_dims,
+                          /*num_dims=*/sizeof(game_phase_dims) / sizeof(int64_t),
+                          /*len=*/game_phase_dims[0]);
 
-    WriteBoard(state, board_input_value);
-    WriteGamePhase(state, game_phase_input_value);
-    WriteNextMoveStoneType(state, next_move_stone_type_input_value);
+    int64_t next_move_stone_type_dims[] = {batch_size};
+    next_move_stone_type_input_value_ =
+        TF_AllocateTensor(TF_UINT8, next_move_stone_type_dims,
+                          /*num_dims=*/sizeof(next_move_stone_type_dims) / sizeof(int64_t),
+                          /*len=*/next_move_stone_type_dims[0]);
 
-    TF_Operation *board_input_op = TF_GraphOperationByName(graph, /*oper_name=*/"inference_boards");
-    assert(board_input_op != nullptr);
-    TF_Output board_input = TF_Output{board_input_op, 0};
+    batch_size_ = batch_size;
+}
 
-    TF_Operation *game_phase_input_op =
-        TF_GraphOperationByName(graph, /*oper_name=*/"inference_game_phases");
-    assert(game_phase_input_op != nullptr);
-    TF_Output game_phase_input = TF_Output{game_phase_input_op, 0};
+void TfZeroPriorModel::DeleteInputs() {
+    if (batch_size_ == 0) {
+        return;
+    }
 
-    TF_Operation *next_move_stone_type_input_op =
-        TF_GraphOperationByName(graph, /*oper_name=*/"inference_next_move_stone_types");
-    assert(next_move_stone_type_input_op != nullptr);
-    TF_Output next_move_stone_type_input = TF_Output{next_move_stone_type_input_op, 0};
+    TF_DeleteTensor(board_input_value_);
+    TF_DeleteTensor(game_phase_input_value_);
+    TF_DeleteTensor(next_move_stone_type_input_value_);
+    batch_size_ = 0;
+}
 
-    TF_Output inputs[] = {board_input, game_phase_input, next_move_stone_type_input};
-    TF_Tensor *input_values[] = {board_input_value, game_phase_input_value,
-                                 next_move_stone_type_input_value};
+void TfZeroPriorModel::Infer(std::vector<GomokuInferenceRequest> const &batch,
+                             std::vector<GomokuInferenceResult> *results) {
+    assert(!batch.empty());
+    assert(results->size() == batch.size());
 
-    TF_Operation *output_op =
-        TF_GraphOperationByName(graph, /*oper_name=*/"StatefulPartitionedCall");
-    TF_Output policy_output = TF_Output{output_op, 0};
-    TF_Output value_output = TF_Output{output_op, 1};
+    if (batch_size_ != batch.size()) {
+        this->AllocateInputs(*batch[0].state, batch.size());
+    }
+
+    for (unsigned i = 0; i < batch.size(); ++i) {
+        WriteBoard(*batch[i].state, i, board_input_value_);
+        WriteGamePhase(*batch[i].state, i, game_phase_input_value_);
+        WriteNextMoveStoneType(*batch[i].state, i, next_move_stone_type_input_value_);
+    }
+
+    TF_Tensor *input_values[] = {board_input_value_, game_phase_input_value_,
+                                 next_move_stone_type_input_value_};
+    static_assert(sizeof(input_values) / sizeof(TF_Tensor *) ==
+                  sizeof(inputs_) / sizeof(TF_Output));
 
-    TF_Output outputs[] = {policy_output, value_output};
     TF_Tensor *output_values[2];
 
     TF_Status *status = TF_NewStatus();
-    TF_SessionRun(session, nullptr, inputs, input_values,
-                  /*ninputs=*/sizeof(input_values) / sizeof(TF_Tensor *), outputs, output_values,
-                  /*noutputs=*/sizeof(outputs) / sizeof(TF_Output),
+    TF_SessionRun(session_, nullptr, inputs_, input_values,
+                  /*ninputs=*/sizeof(input_values) / sizeof(TF_Tensor *), outputs_, output_values,
+                  /*noutputs=*/sizeof(outputs_) / sizeof(TF_Output),
                   /*target_opers=*/nullptr, /*ntargets=*/0,
                   /*metadata=*/nullptr, status);
     assert(TF_GetCode(status) == TF_OK);
     TF_DeleteStatus(status);
 
-    EvaluationResult evaluation = ToEvaluationResult(state, /*policy_tensor=*/output_values[0],
-                                                     /*policy_tensor=*/output_values[1]);
-    cache.insert(std::make_pair(state_id, evaluation));
+    ReadInferenceResults(/*policy_tensor=*/output_values[0], /*value_tensor=*/output_values[1],
+                         results);
 
     TF_DeleteTensor(output_values[0]);
     TF_DeleteTensor(output_values[1]);
+}
+
+} // namespace
+
+struct GomokuTfZeroPriorEvaluator::TfModelBasedEvaluatorInternal {
+    TfModelBasedEvaluatorInternal(std::shared_ptr<GomokuBatchInferenceServer> const &server);
+
+    EvaluationResult Fetch(MctNodeId const state_id, GomokuBoardState const &state);
+
+    std::shared_ptr<GomokuBatchInferenceServer> server;
+
+    std::mutex cache_lock;
+    std::unordered_map<MctNodeId, EvaluationResult> cache;
+};
+
+GomokuTfZeroPriorEvaluator::TfModelBasedEvaluatorInternal::TfModelBasedEvaluatorInternal(
+    std::shared_ptr<GomokuBatchInferenceServer> const &server)
+    : server(server) {}
+
+EvaluationResult
+GomokuTfZeroPriorEvaluator::TfModelBasedEvaluatorInternal::Fetch(MctNodeId const state_id,
+                                                                 GomokuBoardState const &state) {
+    {
+        std::lock_guard<std::mutex> guard(cache_lock);
+        auto it = cache.find(state_id);
+        if (it != cache.end()) {
+            return it->second;
+        }
+    }
+
+    EvaluationResult evaluation = ToEvaluationResult(state, server->Infer(state).get());
+
+    std::lock_guard<std::mutex> guard(cache_lock);
+    cache.insert(std::make_pair(state_id, evaluation));
 
     return evaluation;
 }
 
 GomokuTfZeroPriorEvaluator::GomokuTfZeroPriorEvaluator(std::string const &model_path)
-    : pimpl_(std::make_unique<TfModelBasedEvaluatorInternal>(model_path)) {}
+    : GomokuTfZeroPriorEvaluator(std::make_shared<GomokuBatchInferenceServer>(
+          LoadTfZeroPriorModel(model_path), /*max_batch_size=*/1,
+          /*max_delay=*/std::chrono::microseconds(0), DefaultGomokuEvaluationCache(),
+          ModelVersionOf(model_path))) {}
+
+GomokuTfZeroPriorEvaluator::GomokuTfZeroPriorEvaluator(
+    std::shared_ptr<GomokuBatchInferenceServer> const &inference_server)
+    : pimpl_(std::make_unique<TfModelBasedEvaluatorInternal>(inference_server)) {}
 
 GomokuTfZeroPriorEvaluator::~GomokuTfZeroPriorEvaluator() {}
 
@@ -239,17 +302,25 @@ float GomokuTfZeroPriorEvaluator::EvaluateReward(GomokuBoardState const &state,
     return pimpl_->Fetch(state_id, state).reward;
 }
 
-std::unordered_map<GomokuActionId, float>
-GomokuTfZeroPriorEvaluator::EvaluatePolicy(GomokuBoardState const &state,
-                                           std::optional<MctNodeId> /*parent_state_id*/,
-                                           MctNodeId state_id) {
-    return pimpl_->Fetch(state_id, state).policy;
+void GomokuTfZeroPriorEvaluator::EvaluatePolicy(GomokuBoardState const &state,
+                                                std::optional<MctNodeId> /*parent_state_id*/,
+                                                MctNodeId state_id, GomokuPolicy *policy) {
+    *policy = pimpl_->Fetch(state_id, state).policy;
 }
 
 float GomokuTfZeroPriorEvaluator::ExplorationFactor() const { return 4.0f; }
 
 unsigned GomokuTfZeroPriorEvaluator::NumSimulations() const { return 2048; }
 
-void GomokuTfZeroPriorEvaluator::ClearCache() { pimpl_->cache.clear(); }
+void GomokuTfZeroPriorEvaluator::ClearCache() {
+    std::lock_guard<std::mutex> guard(pimpl_->cache_lock);
+    pimpl_->cache.clear();
+}
+
+bool GomokuTfZeroPriorEvaluator::ThreadSafe() const { return true; }
+
+std::unique_ptr<GomokuInferenceModelInterface> LoadTfZeroPriorModel(std::string const &model_path) {
+    return std::make_unique<TfZeroPriorModel>(model_path);
+}
 
 } // namespace e8
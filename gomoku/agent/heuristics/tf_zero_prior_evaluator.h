@@ -22,10 +22,11 @@
 #include <memory>
 #include <optional>
 #include <string>
-#include <unordered_map>
 
+#include "gomoku/agent/heuristics/batch_inference_server.h"
 #include "gomoku/agent/heuristics/evaluator.h"
 #include "gomoku/agent/search/mct_node.h"
+#include "gomoku/agent/search/policy.h"
 #include "gomoku/game/board_state.h"
 
 namespace e8 {
@@ -41,14 +42,20 @@ class GomokuTfZeroPriorEvaluator : public GomokuEvaluatorInterface {
      * @brief GomokuTfZeroPriorEvaluator Constructs an evaluator from a tensorflow lite model file.
      */
     GomokuTfZeroPriorEvaluator(std::string const &model_path);
+
+    /**
+     * @brief GomokuTfZeroPriorEvaluator Constructs an evaluator which batches its inference with
+     * the other users of the server. The server should be serving a model loaded by
+     * LoadTfZeroPriorModel().
+     */
+    GomokuTfZeroPriorEvaluator(std::shared_ptr<GomokuBatchInferenceServer> const &inference_server);
     ~GomokuTfZeroPriorEvaluator() override;
 
     float EvaluateReward(GomokuBoardState const &state, std::optional<MctNodeId> parent_state_id,
                          MctNodeId state_id) override;
 
-    std::unordered_map<GomokuActionId, float>
-    EvaluatePolicy(GomokuBoardState const &state, std::optional<MctNodeId> parent_state_id,
-                   MctNodeId state_id) override;
+    void EvaluatePolicy(GomokuBoardState const &state, std::optional<MctNodeId> parent_state_id,
+                        MctNodeId state_id, GomokuPolicy *policy) override;
 
     float ExplorationFactor() const override;
 
@@ -56,11 +63,18 @@ class GomokuTfZeroPriorEvaluator : public GomokuEvaluatorInterface {
 
     void ClearCache() override;
 
+    bool ThreadSafe() const override;
+
   private:
     struct TfModelBasedEvaluatorInternal;
     std::unique_ptr<TfModelBasedEvaluatorInternal> pimpl_;
 };
 
+/**
+ * @brief LoadTfZeroPriorModel Loads a tensorflow saved model for batched inference.
+ */
+std::unique_ptr<GomokuInferenceModelInterface> LoadTfZeroPriorModel(std::string const &model_path);
+
 } // namespace e8
 
 #endif // TF_ZERO_PRIOR_EVALUATOR_H
@@ -16,16 +16,22 @@
  */
 
 #include <cassert>
+#include <chrono>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
+#include "gomoku/agent/heuristics/batch_inference_server.h"
+#include "gomoku/agent/heuristics/evaluation_cache.h"
 #include "gomoku/agent/heuristics/evaluator.h"
 #include "gomoku/agent/heuristics/tflite_zero_prior_evaluator.h"
 #include "gomoku/agent/search/mct_node.h"
+#include "gomoku/agent/search/policy.h"
 #include "gomoku/game/board_state.h"
 #include "third_party/tensorflow/lite/c/c_api.h"
 
@@ -34,67 +40,73 @@ namespace {
 
 struct EvaluationResult {
     float reward;
-    std::unordered_map<GomokuActionId, float> policy;
+    GomokuPolicy policy;
 };
 
-void WriteBoard(GomokuBoardState const &state, TfLiteTensor *board) {
+void WriteBoard(GomokuBoardState const &state, unsigned batch_index, TfLiteTensor *board) {
     assert(TfLiteTensorNumDims(board) == 3);
-    assert(TfLiteTensorDim(board, /*dim_index=*/0) == 1);
+    assert(TfLiteTensorDim(board, /*dim_index=*/0) > static_cast<int32_t>(batch_index));
     assert(TfLiteTensorDim(board, /*dim_index=*/1) == state.Width());
     assert(TfLiteTensorDim(board, /*dim_index=*/2) == state.Height());
 
-    uint8_t *tensor_memory = static_cast<uint8_t *>(TfLiteTensorData(board));
+    uint8_t *tensor_memory = static_cast<uint8_t *>(TfLiteTensorData(board)) +
+                             batch_index * state.Width() * state.Height();
 
-    for (int16_t y = 0; y < state.Height(); ++y) {
-        for (int16_t x = 0; x < state.Width(); ++x) {
-            tensor_memory[y + x * state.Height()] = *state.ChessPieceStateAt(MovePosition(x, y));
-        }
-    }
+    state.WriteBoardPlane(tensor_memory);
 }
 
-void WriteGamePhase(GomokuBoardState const &state, TfLiteTensor *game_phase) {
+void WriteGamePhase(GomokuBoardState const &state, unsigned batch_index,
+                    TfLiteTensor *game_phase) {
     assert(TfLiteTensorNumDims(game_phase) == 1);
-    assert(TfLiteTensorDim(game_phase, /*dim_index=*/0) == 1);
+    assert(TfLiteTensorDim(game_phase, /*dim_index=*/0) > static_cast<int32_t>(batch_index));
 
     uint8_t *tensor_memory = static_cast<uint8_t *>(TfLiteTensorData(game_phase));
-    *tensor_memory = state.CurrentGamePhase();
+    tensor_memory[batch_index] = state.CurrentGamePhase();
 }
 
-void WriteNextMoveStoneType(GomokuBoardState const &state, TfLiteTensor *next_move_stone_type) {
+void WriteNextMoveStoneType(GomokuBoardState const &state, unsigned batch_index,
+                            TfLiteTensor *next_move_stone_type) {
     assert(TfLiteTensorNumDims(next_move_stone_type) == 1);
-    assert(TfLiteTensorDim(next_move_stone_type, /*dim_index=*/0) == 1);
+    assert(TfLiteTensorDim(next_move_stone_type, /*dim_index=*/0) >
+           static_cast<int32_t>(batch_index));
 
     uint8_t *tensor_memory = static_cast<uint8_t *>(TfLiteTensorData(next_move_stone_type));
-    *tensor_memory = state.PlayerStoneType(state.CurrentPlayerSide());
+    tensor_memory[batch_index] = state.PlayerStoneType(state.CurrentPlayerSide());
 }
 
-EvaluationResult ToEvaluationResult(GomokuBoardState const &state,
-                                    TfLiteTensor const *policy_tensor,
-                                    TfLiteTensor const *value_tensor) {
-    EvaluationResult evaluation;
-
+void ReadInferenceResults(TfLiteTensor const *policy_tensor, TfLiteTensor const *value_tensor,
+                          std::vector<GomokuInferenceResult> *results) {
     assert(TfLiteTensorNumDims(policy_tensor) == 2);
-    assert(TfLiteTensorDim(policy_tensor, /*dim_index=*/0) == 1);
-    auto [lo, hi] = state.ActionIdRange();
-    assert(TfLiteTensorDim(policy_tensor, /*dim_index=*/1) == hi - lo + 1);
+    assert(TfLiteTensorDim(policy_tensor, /*dim_index=*/0) ==
+           static_cast<int32_t>(results->size()));
+    assert(TfLiteTensorNumDims(value_tensor) == 1);
+    assert(TfLiteTensorDim(value_tensor, /*dim_index=*/0) ==
+           static_cast<int32_t>(results->size()));
 
-    // Re-normalizes and stores the policy into the map.
-    float *policy = static_cast<float *>(TfLiteTensorData(policy_tensor));
+    unsigned num_actions = TfLiteTensorDim(policy_tensor, /*dim_index=*/1);
+    float const *policy = static_cast<float const *>(TfLiteTensorData(policy_tensor));
+    float const *values = static_cast<float const *>(TfLiteTensorData(value_tensor));
 
-    float norm_factor = 0;
-    for (auto const &[action_id, _] : state.LegalActions()) {
-        norm_factor += policy[action_id];
-    }
-    for (auto const &[action_id, _] : state.LegalActions()) {
-        evaluation.policy[action_id] = policy[action_id] / norm_factor;
+    for (unsigned i = 0; i < results->size(); ++i) {
+        GomokuInferenceResult &result = (*results)[i];
+        result.policy.assign(policy + i * num_actions, policy + (i + 1) * num_actions);
+
+        // Value prediction can be treated as the expected reward.
+        result.value = values[i];
     }
+}
 
-    assert(TfLiteTensorNumDims(value_tensor) == 1);
-    assert(TfLiteTensorDim(value_tensor, /*dim_index=*/0) == 1);
+EvaluationResult ToEvaluationResult(GomokuBoardState const &state,
+                                    GomokuInferenceResult const &inference) {
+    EvaluationResult evaluation;
+
+    auto [lo, hi] = state.ActionIdRange();
+    assert(inference.policy.size() == static_cast<unsigned>(hi - lo + 1));
+
+    // Re-normalizes the policy over the legal actions.
+    evaluation.policy.AssignLegal(state, inference.policy.data());
 
-    // Value prediction can be treated as the expected reward.
-    float *values = static_cast<float *>(TfLiteTensorData(value_tensor));
-    evaluation.reward = values[0];
+    evaluation.reward = inference.value;
 
     return evaluation;
 }
@@ -115,100 +127,181 @@ int FindTensorIndexByName(std::string const &name, bool input, TfLiteInterpreter
     return -1;
 }
 
-} // namespace
+void ResizeBatch(int tensor_idx, unsigned batch_size, TfLiteInterpreter *interpreter) {
+    TfLiteTensor const *tensor = TfLiteInterpreterGetInputTensor(interpreter, tensor_idx);
 
-struct GomokuTfliteZeroPriorEvaluator::ModelBasedEvaluatorInternal {
-    ModelBasedEvaluatorInternal(std::string const &model_path);
-    ~ModelBasedEvaluatorInternal();
+    std::vector<int> dims(TfLiteTensorNumDims(tensor));
+    for (unsigned i = 0; i < dims.size(); ++i) {
+        dims[i] = TfLiteTensorDim(tensor, i);
+    }
+    dims[0] = batch_size;
 
-    EvaluationResult Fetch(MctNodeId const state_id, GomokuBoardState const &state);
+    TfLiteStatus status =
+        TfLiteInterpreterResizeInputTensor(interpreter, tensor_idx, dims.data(), dims.size());
+    assert(status == TfLiteStatus::kTfLiteOk);
+}
 
-    TfLiteModel *model;
-    TfLiteInterpreterOptions *interpreter_options;
-    TfLiteInterpreter *interpreter;
+class TfliteZeroPriorModel : public GomokuInferenceModelInterface {
+  public:
+    TfliteZeroPriorModel(std::string const &model_path);
+    ~TfliteZeroPriorModel() override;
 
-    int board_idx;
-    int game_phase_idx;
-    int next_move_stone_type_idx;
+    void Infer(std::vector<GomokuInferenceRequest> const &batch,
+               std::vector<GomokuInferenceResult> *results) override;
 
-    int policy_idx;
-    int value_idx;
+  private:
+    void BindTensors();
 
-    std::unordered_map<MctNodeId, EvaluationResult> cache;
+    TfLiteModel *model_;
+    TfLiteInterpreterOptions *interpreter_options_;
+    TfLiteInterpreter *interpreter_;
+
+    int board_idx_;
+    int game_phase_idx_;
+    int next_move_stone_type_idx_;
+
+    int policy_idx_;
+    int value_idx_;
+
+    // Tensors stay valid until the interpreter reallocates them for another batch size.
+    TfLiteTensor *board_tensor_;
+    TfLiteTensor *game_phase_tensor_;
+    TfLiteTensor *next_move_stone_type_tensor_;
+    TfLiteTensor const *policy_tensor_;
+    TfLiteTensor const *value_tensor_;
+
+    unsigned batch_size_;
 };
 
-GomokuTfliteZeroPriorEvaluator::ModelBasedEvaluatorInternal::ModelBasedEvaluatorInternal(
-    std::string const &model_path) {
-    model = TfLiteModelCreateFromFile(model_path.c_str());
-    assert(model != nullptr);
+TfliteZeroPriorModel::TfliteZeroPriorModel(std::string const &model_path) {
+    model_ = TfLiteModelCreateFromFile(model_path.c_str());
+    assert(model_ != nullptr);
 
-    interpreter_options = TfLiteInterpreterOptionsCreate();
-    TfLiteInterpreterOptionsSetNumThreads(interpreter_options, std::thread::hardware_concurrency());
+    interpreter_options_ = TfLiteInterpreterOptionsCreate();
+    TfLiteInterpreterOptionsSetNumThreads(interpreter_options_,
+                                          std::thread::hardware_concurrency());
 
-    interpreter = TfLiteInterpreterCreate(model, interpreter_options);
-    assert(interpreter != nullptr);
+    interpreter_ = TfLiteInterpreterCreate(model_, interpreter_options_);
+    assert(interpreter_ != nullptr);
 
-    board_idx = FindTensorIndexByName(/*name=*/"inference_boards:0", /*input=*/true, interpreter);
-    assert(board_idx != -1);
+    board_idx_ =
+        FindTensorIndexByName(/*name=*/"inference_boards:0", /*input=*/true, interpreter_);
+    assert(board_idx_ != -1);
 
-    game_phase_idx = FindTensorIndexByName(
-        /*name=*/"inference_game_phases:0", /*input=*/true, interpreter);
-    assert(game_phase_idx != -1);
+    game_phase_idx_ = FindTensorIndexByName(
+        /*name=*/"inference_game_phases:0", /*input=*/true, interpreter_);
+    assert(game_phase_idx_ != -1);
 
-    next_move_stone_type_idx = FindTensorIndexByName(/*name=*/"inference_next_move_stone_types:0",
-                                                     /*input=*/true, interpreter);
-    assert(next_move_stone_type_idx != -1);
+    next_move_stone_type_idx_ = FindTensorIndexByName(
+        /*name=*/"inference_next_move_stone_types:0", /*input=*/true, interpreter_);
+    assert(next_move_stone_type_idx_ != -1);
 
-    policy_idx = FindTensorIndexByName(/*name=*/"StatefulPartitionedCall:0",
-                                       /*input=*/false, interpreter);
-    assert(policy_idx != -1);
+    policy_idx_ = FindTensorIndexByName(/*name=*/"StatefulPartitionedCall:0",
+                                        /*input=*/false, interpreter_);
+    assert(policy_idx_ != -1);
 
-    value_idx = FindTensorIndexByName(/*name=*/"StatefulPartitionedCall:1",
-                                      /*input=*/false, interpreter);
-    assert(value_idx != -1);
+    value_idx_ = FindTensorIndexByName(/*name=*/"StatefulPartitionedCall:1",
+                                       /*input=*/false, interpreter_);
+    assert(value_idx_ != -1);
 
-    TfLiteStatus status = TfLiteInterpreterAllocateTensors(interpreter);
+    TfLiteStatus status = TfLiteInterpreterAllocateTensors(interpreter_);
     assert(status == TfLiteStatus::kTfLiteOk);
+    this->BindTensors();
+
+    batch_size_ = TfLiteTensorDim(board_tensor_, /*dim_index=*/0);
 }
 
-GomokuTfliteZeroPriorEvaluator::ModelBasedEvaluatorInternal::~ModelBasedEvaluatorInternal() {
-    TfLiteInterpreterDelete(interpreter);
-    TfLiteModelDelete(model);
-    TfLiteInterpreterOptionsDelete(interpreter_options);
+TfliteZeroPriorModel::~TfliteZeroPriorModel() {
+    TfLiteInterpreterDelete(interpreter_);
+    TfLiteModelDelete(model_);
+    TfLiteInterpreterOptionsDelete(interpreter_options_);
 }
 
-EvaluationResult
-GomokuTfliteZeroPriorEvaluator::ModelBasedEvaluatorInternal::Fetch(MctNodeId const state_id,
-                                                                   GomokuBoardState const &state) {
-    auto it = cache.find(state_id);
-    if (it != cache.end()) {
-        return it->second;
-    }
+void TfliteZeroPriorModel::BindTensors() {
+    board_tensor_ = TfLiteInterpreterGetInputTensor(interpreter_, board_idx_);
+    game_phase_tensor_ = TfLiteInterpreterGetInputTensor(interpreter_, game_phase_idx_);
+    next_move_stone_type_tensor_ =
+        TfLiteInterpreterGetInputTensor(interpreter_, next_move_stone_type_idx_);
+    policy_tensor_ = TfLiteInterpreterGetOutputTensor(interpreter_, policy_idx_);
+    value_tensor_ = TfLiteInterpreterGetOutputTensor(interpreter_, value_idx_);
+}
+
+void TfliteZeroPriorModel::Infer(std::vector<GomokuInferenceRequest> const &batch,
+                                 std::vector<GomokuInferenceResult> *results) {
+    assert(!batch.empty());
+    assert(results->size() == batch.size());
+
+    if (batch_size_ != batch.size()) {
+        // Tensor allocation is expensive, so the interpreter keeps the batch size until a batch
+        // of a different size comes.
+        ResizeBatch(board_idx_, batch.size(), interpreter_);
+        ResizeBatch(game_phase_idx_, batch.size(), interpreter_);
+        ResizeBatch(next_move_stone_type_idx_, batch.size(), interpreter_);
 
-    TfLiteTensor *board_features = TfLiteInterpreterGetInputTensor(interpreter, board_idx);
-    WriteBoard(state, board_features);
+        TfLiteStatus status = TfLiteInterpreterAllocateTensors(interpreter_);
+        assert(status == TfLiteStatus::kTfLiteOk);
+        this->BindTensors();
 
-    TfLiteTensor *game_phase = TfLiteInterpreterGetInputTensor(interpreter, game_phase_idx);
-    WriteGamePhase(state, game_phase);
+        batch_size_ = batch.size();
+    }
 
-    TfLiteTensor *next_move_stone_type =
-        TfLiteInterpreterGetInputTensor(interpreter, next_move_stone_type_idx);
-    WriteNextMoveStoneType(state, next_move_stone_type);
+    for (unsigned i = 0; i < batch.size(); ++i) {
+        WriteBoard(*batch[i].state, i, board_tensor_);
+        WriteGamePhase(*batch[i].state, i, game_phase_tensor_);
+        WriteNextMoveStoneType(*batch[i].state, i, next_move_stone_type_tensor_);
+    }
 
-    TfLiteStatus status = TfLiteInterpreterInvoke(interpreter);
+    TfLiteStatus status = TfLiteInterpreterInvoke(interpreter_);
     assert(status == TfLiteStatus::kTfLiteOk);
 
-    TfLiteTensor const *policy = TfLiteInterpreterGetOutputTensor(interpreter, policy_idx);
-    TfLiteTensor const *value = TfLiteInterpreterGetOutputTensor(interpreter, value_idx);
+    ReadInferenceResults(policy_tensor_, value_tensor_, results);
+}
+
+} // namespace
+
+struct GomokuTfliteZeroPriorEvaluator::ModelBasedEvaluatorInternal {
+    ModelBasedEvaluatorInternal(std::shared_ptr<GomokuBatchInferenceServer> const &server);
+
+    EvaluationResult Fetch(MctNodeId const state_id, GomokuBoardState const &state);
+
+    std::shared_ptr<GomokuBatchInferenceServer> server;
 
-    EvaluationResult evaluation = ToEvaluationResult(state, policy, value);
+    std::mutex cache_lock;
+    std::unordered_map<MctNodeId, EvaluationResult> cache;
+};
+
+GomokuTfliteZeroPriorEvaluator::ModelBasedEvaluatorInternal::ModelBasedEvaluatorInternal(
+    std::shared_ptr<GomokuBatchInferenceServer> const &server)
+    : server(server) {}
+
+EvaluationResult
+GomokuTfliteZeroPriorEvaluator::ModelBasedEvaluatorInternal::Fetch(MctNodeId const state_id,
+                                                                   GomokuBoardState const &state) {
+    {
+        std::lock_guard<std::mutex> guard(cache_lock);
+        auto it = cache.find(state_id);
+        if (it != cache.end()) {
+            return it->second;
+        }
+    }
+
+    EvaluationResult evaluation = ToEvaluationResult(state, server->Infer(state).get());
+
+    std::lock_guard<std::mutex> guard(cache_lock);
     cache.insert(std::make_pair(state_id, evaluation));
 
     return evaluation;
 }
 
 GomokuTfliteZeroPriorEvaluator::GomokuTfliteZeroPriorEvaluator(std::string const &model_path)
-    : pimpl_(std::make_unique<ModelBasedEvaluatorInternal>(model_path)) {}
+    : GomokuTfliteZeroPriorEvaluator(std::make_shared<GomokuBatchInferenceServer>(
+          LoadTfliteZeroPriorModel(model_path), /*max_batch_size=*/1,
+          /*max_delay=*/std::chrono::microseconds(0), DefaultGomokuEvaluationCache(),
+          ModelVersionOf(model_path))) {}
+
+GomokuTfliteZeroPriorEvaluator::GomokuTfliteZeroPriorEvaluator(
+    std::shared_ptr<GomokuBatchInferenceServer> const &inference_server)
+    : pimpl_(std::make_unique<ModelBasedEvaluatorInternal>(inference_server)) {}
 
 GomokuTfliteZeroPriorEvaluator::~GomokuTfliteZeroPriorEvaluator() {}
 
@@ -218,17 +311,26 @@ float GomokuTfliteZeroPriorEvaluator::EvaluateReward(GomokuBoardState const &sta
     return pimpl_->Fetch(state_id, state).reward;
 }
 
-std::unordered_map<GomokuActionId, float>
-GomokuTfliteZeroPriorEvaluator::EvaluatePolicy(GomokuBoardState const &state,
-                                               std::optional<MctNodeId> /*parent_state_id*/,
-                                               MctNodeId state_id) {
-    return pimpl_->Fetch(state_id, state).policy;
+void GomokuTfliteZeroPriorEvaluator::EvaluatePolicy(GomokuBoardState const &state,
+                                                    std::optional<MctNodeId> /*parent_state_id*/,
+                                                    MctNodeId state_id, GomokuPolicy *policy) {
+    *policy = pimpl_->Fetch(state_id, state).policy;
 }
 
 float GomokuTfliteZeroPriorEvaluator::ExplorationFactor() const { return 5.0f; }
 
 unsigned GomokuTfliteZeroPriorEvaluator::NumSimulations() const { return 2000; }
 
-void GomokuTfliteZeroPriorEvaluator::ClearCache() { pimpl_->cache.clear(); }
+void GomokuTfliteZeroPriorEvaluator::ClearCache() {
+    std::lock_guard<std::mutex> guard(pimpl_->cache_lock);
+    pimpl_->cache.clear();
+}
+
+bool GomokuTfliteZeroPriorEvaluator::ThreadSafe() const { return true; }
+
+std::unique_ptr<GomokuInferenceModelInterface>
+LoadTfliteZeroPriorModel(std::string const &model_path) {
+    return std::make_unique<TfliteZeroPriorModel>(model_path);
+}
 
 } // namespace e8
@@ -22,10 +22,11 @@
 #include <memory>
 #include <optional>
 #include <string>
-#include <unordered_map>
 
+#include "gomoku/agent/heuristics/batch_inference_server.h"
 #include "gomoku/agent/heuristics/evaluator.h"
 #include "gomoku/agent/search/mct_node.h"
+#include "gomoku/agent/search/policy.h"
 #include "gomoku/game/board_state.h"
 
 namespace e8 {
@@ -41,14 +42,21 @@ class GomokuTfliteZeroPriorEvaluator : public GomokuEvaluatorInterface {
      * @brief GomokuModelBasedEvaluator Constructs an evaluator from a tensorflow lite model file.
      */
     GomokuTfliteZeroPriorEvaluator(std::string const &model_path);
+
+    /**
+     * @brief GomokuTfliteZeroPriorEvaluator Constructs an evaluator which batches its inference
+     * with the other users of the server. The server should be serving a model loaded by
+     * LoadTfliteZeroPriorModel().
+     */
+    GomokuTfliteZeroPriorEvaluator(
+        std::shared_ptr<GomokuBatchInferenceServer> const &inference_server);
     ~GomokuTfliteZeroPriorEvaluator() override;
 
     float EvaluateReward(GomokuBoardState const &state, std::optional<MctNodeId> parent_state_id,
                          MctNodeId state_id) override;
 
-    std::unordered_map<GomokuActionId, float>
-    EvaluatePolicy(GomokuBoardState const &state, std::optional<MctNodeId> parent_state_id,
-                   MctNodeId state_id) override;
+    void EvaluatePolicy(GomokuBoardState const &state, std::optional<MctNodeId> parent_state_id,
+                        MctNodeId state_id, GomokuPolicy *policy) override;
 
     float ExplorationFactor() const override;
 
@@ -56,11 +64,19 @@ class GomokuTfliteZeroPriorEvaluator : public GomokuEvaluatorInterface {
 
     void ClearCache() override;
 
+    bool ThreadSafe() const override;
+
   private:
     struct ModelBasedEvaluatorInternal;
     std::unique_ptr<ModelBasedEvaluatorInternal> pimpl_;
 };
 
+/**
+ * @brief LoadTfliteZeroPriorModel Loads a tensorflow lite model file for batched inference.
+ */
+std::unique_ptr<GomokuInferenceModelInterface>
+LoadTfliteZeroPriorModel(std::string const &model_path);
+
 } // namespace e8
 
 #endif // TFLITE_ZERO_PRIOR_EVALUATOR_H
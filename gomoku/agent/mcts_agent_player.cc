@@ -18,28 +18,46 @@
 #include <cassert>
 #include <memory>
 #include <optional>
-#include <unordered_map>
 
 #include "gomoku/agent/heuristics/evaluator.h"
 #include "gomoku/agent/mcts_agent_player.h"
 #include "gomoku/agent/search/mct_node.h"
 #include "gomoku/agent/search/mct_search.h"
+#include "gomoku/agent/search/policy.h"
 #include "gomoku/game/board_state.h"
 #include "gomoku/game/game.h"
 
 namespace e8 {
 
 MctsAgentPlayer::MctsAgentPlayer(PlayerSide const player_side,
-                                 std::shared_ptr<MctSearcher> const &searcher, bool shared_searcher)
-    : player_side_(player_side), searcher_(searcher), shared_searcher_(shared_searcher) {}
+                                 std::shared_ptr<MctSearcher> const &searcher, bool shared_searcher,
+                                 bool ponder)
+    : player_side_(player_side), searcher_(searcher), shared_searcher_(shared_searcher),
+      ponder_(ponder) {}
 
 void MctsAgentPlayer::OnGomokuGameBegin(GomokuBoardState const & /*board_state*/) {
     searcher_->Reset();
 }
 
 GomokuActionId MctsAgentPlayer::NextPlayerAction(GomokuBoardState const &board_state) {
-    std::unordered_map<GomokuActionId, float> optimal_policy =
-        searcher_->SearchFrom(board_state, /*temperature=*/1.0f);
+    GomokuPolicy optimal_policy;
+    if (!ponder_) {
+        searcher_->SearchFrom(board_state, /*temperature=*/1.0f, &optimal_policy);
+        return BestAction(optimal_policy);
+    }
+
+    searcher_->StopPondering();
+
+    // Only tops up what pondering on this state hasn't done yet. One simulation is always run so
+    // that the node is expanded.
+    unsigned const num_simulations = searcher_->NumSimulations();
+    unsigned const num_root_simulations = searcher_->NumRootSimulations();
+
+    MctSearchBudget budget;
+    budget.num_simulations =
+        num_root_simulations < num_simulations ? num_simulations - num_root_simulations : 1;
+    searcher_->Search(board_state, budget);
+    searcher_->ExtractPolicy(board_state, /*temperature=*/1.0f, &optimal_policy);
 
     return BestAction(optimal_policy);
 }
@@ -52,9 +70,16 @@ void MctsAgentPlayer::BeforeGomokuActionApplied(GomokuBoardState const &board_st
     }
 }
 
-void MctsAgentPlayer::AfterGomokuActionApplied(GomokuBoardState const & /*board_state*/) {}
+void MctsAgentPlayer::AfterGomokuActionApplied(GomokuBoardState const &board_state) {
+    if (ponder_ && board_state.CurrentPlayerSide() != player_side_ &&
+        board_state.CurrentGameResult() == GR_UNDETERMINED) {
+        searcher_->StartPondering(board_state);
+    }
+}
 
-void MctsAgentPlayer::OnGameEnded(GomokuBoardState const & /*board_state*/) {}
+void MctsAgentPlayer::OnGameEnded(GomokuBoardState const & /*board_state*/) {
+    searcher_->StopPondering();
+}
 
 bool MctsAgentPlayer::WantAnotherGame() { return true; }
 
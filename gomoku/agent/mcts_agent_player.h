@@ -42,9 +42,11 @@ class MctsAgentPlayer : public GomokuPlayerInterface {
      * @param searcher The search algorithm.
      * @param shared_searcher Whether the search algorithm states are shared by the oppponent as
      * well.
+     * @param ponder Whether to keep searching during the opponent's turn. The simulations which
+     * went into the opponent's actual move are then deducted from the agent's own search.
      */
     MctsAgentPlayer(PlayerSide const player_side, std::shared_ptr<MctSearcher> const &searcher,
-                    bool shared_searcher);
+                    bool shared_searcher, bool ponder = false);
     ~MctsAgentPlayer() override = default;
 
     GomokuActionId NextPlayerAction(GomokuBoardState const &board_state) override;
@@ -65,6 +67,7 @@ class MctsAgentPlayer : public GomokuPlayerInterface {
     PlayerSide const player_side_;
     std::shared_ptr<MctSearcher> searcher_;
     bool const shared_searcher_;
+    bool const ponder_;
 };
 
 } // namespace e8
@@ -15,40 +15,96 @@
  * not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <atomic>
+#include <cassert>
+#include <memory>
 #include <mutex>
 #include <optional>
+#include <thread>
 
-#include "common/container/mutable_priority_queue.h"
 #include "gomoku/agent/search/mct_node.h"
 #include "gomoku/game/board_state.h"
 
 namespace e8 {
 namespace {
 
-std::mutex gNextNodeIdLock;
-MctNodeId gNextNodeId = 1;
+std::atomic<MctNodeId> gNextArenaEpoch(1);
 
 } // namespace
 
-MctNode::MctNode() : id(0), game_result(GR_UNDETERMINED), heuristic_policy_weight(-1.0f) {}
+MctNodeArena::MctNodeArena() : epoch_(gNextArenaEpoch.fetch_add(1)) {}
 
-MctNode::MctNode(MctNodeId const id, std::optional<GomokuActionId> const arrived_thru_action_id,
-                 std::optional<PlayerSide> const action_performed_by, GameResult const game_result,
-                 float const heuristic_policy_weight)
-    : id(id), arrived_thru_action_id(arrived_thru_action_id),
-      action_performed_by(action_performed_by), game_result(game_result),
-      heuristic_policy_weight(heuristic_policy_weight) {}
+MctNodeArena::~MctNodeArena() {}
 
-bool MctNode::operator<(MctNode const &rhs) const {
-    return upper_confidence_bound < rhs.upper_confidence_bound;
+void MctNodeArena::Clear() {
+    size_ = 0;
+    epoch_ = gNextArenaEpoch.fetch_add(1);
 }
 
-MctNodeId AllocateMctNodeId() {
-    gNextNodeIdLock.lock();
-    MctNodeId allocation = gNextNodeId++;
-    gNextNodeIdLock.unlock();
+MctNodeIndex MctNodeArena::Allocate(unsigned const count) {
+    assert(count >= 1 && count <= kMaxMctNodeChildren);
 
-    return allocation;
+    std::lock_guard<std::mutex> guard(allocation_lock_);
+
+    // Keeps the nodes in one block so that they are contiguous.
+    if (BlockOffset(size_) + count > kMctNodeBlockSize) {
+        size_ = (size_ | (kMctNodeBlockSize - 1)) + 1;
+    }
+
+    unsigned const block_idx = size_ >> kMctNodeBlockBits;
+    assert(block_idx < kMaxMctNodeBlocks);
+    if (block_idx >= num_blocks_) {
+        blocks_[num_blocks_++] = std::make_unique<MctNodeBlock>();
+    }
+
+    MctNodeIndex const first = size_;
+    size_ += count;
+
+    MctNodeBlock *block = blocks_[block_idx].get();
+    for (unsigned i = BlockOffset(first); i < BlockOffset(first) + count; ++i) {
+        block->summed_rewards[i] = 0.0f;
+        block->num_visits[i] = 0;
+        block->virtual_losses[i] = 0;
+        block->priors[i] = 0.0f;
+        block->num_child_visits[i] = 0;
+        block->first_children[i] = kNullMctNodeIndex;
+        block->num_children[i] = 0;
+        block->num_active_children[i] = 0;
+        block->arrived_thru_actions[i] = -1;
+        block->action_performers[i] = 0;
+        block->game_results[i] = GR_UNDETERMINED;
+        block->locks[i].store(false, std::memory_order_relaxed);
+    }
+
+    return first;
+}
+
+unsigned MctNodeArena::Size() const { return size_; }
+
+uint64_t MctNodeArena::ReservedBytes() const {
+    return static_cast<uint64_t>(num_blocks_) * sizeof(MctNodeBlock);
+}
+
+MctNodeId MctNodeArena::Id(MctNodeIndex const index) const {
+    return epoch_ << 32 | static_cast<MctNodeId>(index);
+}
+
+std::optional<MctNodeIndex> MctNodeArena::IndexOf(MctNodeId const id) const {
+    if (id >> 32 != epoch_) {
+        return std::nullopt;
+    }
+    return static_cast<MctNodeIndex>(id & 0xFFFFFFFF);
+}
+
+void MctNodeArena::Lock(MctNodeIndex const index) {
+    std::atomic<bool> *lock = &this->Block(index).locks[BlockOffset(index)];
+    while (lock->exchange(true, std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+void MctNodeArena::Unlock(MctNodeIndex const index) {
+    this->Block(index).locks[BlockOffset(index)].store(false, std::memory_order_release);
 }
 
 } // namespace e8
@@ -18,10 +18,14 @@
 #ifndef MCT_NODE_H
 #define MCT_NODE_H
 
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include <optional>
 
-#include "common/container/mutable_priority_queue.h"
+#include "gomoku/game/bitboard.h"
 #include "gomoku/game/board_state.h"
 
 namespace e8 {
@@ -29,71 +33,136 @@ namespace e8 {
 // The number zero is reserved. Any valid ID should not be a zero value.
 using MctNodeId = int64_t;
 
+// Position of a node in an MctNodeArena.
+using MctNodeIndex = uint32_t;
+
+static MctNodeIndex const kNullMctNodeIndex = 0xFFFFFFFF;
+
+// The maximum number of children a node can have, which is bounded by the action ID range.
+static unsigned const kMaxMctNodeChildren = kBitboardCapacity;
+
+// Marks a child whose game result hasn't been determined. See MctNodeBlock::game_results.
+static uint8_t const kUnresolvedGameResult = 0xFF;
+
+static unsigned const kMctNodeBlockBits = 16;
+static unsigned const kMctNodeBlockSize = 1 << kMctNodeBlockBits;
+static unsigned const kMaxMctNodeBlocks = 1024;
+
 /**
- * @brief The MctNode struct An abstract game state which stores statistics and action information
- * during monte carlo tree search.
+ * @brief The MctNodeBlock struct A fixed-size chunk of MCTS nodes stored as structure of arrays.
+ * The statistics of sibling nodes are contiguous so that the selection is a linear scan.
  */
-struct MctNode {
-    // This id should be unique in the entire search tree.
-    MctNodeId const id;
+struct MctNodeBlock {
+    // Statistics used to calculate the Q value. Guarded by the parent's lock during a
+    // tree-parallel search.
+    std::array<float, kMctNodeBlockSize> summed_rewards;
+    std::array<uint32_t, kMctNodeBlockSize> num_visits;
+
+    // Number of in-flight simulations passing through the node. Each one counts as a lost visit so
+    // that concurrent workers spread out over different paths.
+    std::array<uint32_t, kMctNodeBlockSize> virtual_losses;
 
-    std::optional<GomokuActionId> const arrived_thru_action_id;
-    std::optional<PlayerSide> const action_performed_by;
+    // Policy weight given by the heuristics used to rank the action leading to the node.
+    std::array<float, kMctNodeBlockSize> priors;
 
-    // Game result at the current game state.
-    GameResult const game_result;
+    // Sum of the visits and virtual losses over the children. Guarded by the node's own lock.
+    std::array<uint32_t, kMctNodeBlockSize> num_child_visits;
 
-    // Policy weight given by the heuristics used to rank the action leading to the current
-    // state.
-    float const heuristic_policy_weight;
+    // The children are at [first_child, first_child + num_children). The first child is
+    // kNullMctNodeIndex when the node hasn't been expanded. Only the first num_active_children
+    // take part in the selection. Guarded by the node's own lock.
+    std::array<MctNodeIndex, kMctNodeBlockSize> first_children;
+    std::array<uint16_t, kMctNodeBlockSize> num_children;
+    std::array<uint16_t, kMctNodeBlockSize> num_active_children;
 
-    // The below values can be used to calculate the Q value.
-    float summed_reward = 0.0f;
-    unsigned num_bandit_pulls = 0;
+    std::array<GomokuActionId, kMctNodeBlockSize> arrived_thru_actions;
+    std::array<uint8_t, kMctNodeBlockSize> action_performers;
 
-    // Upper confidence bound on the Q value.
-    float upper_confidence_bound = 0.0f;
+    // Result of the game after the action. It's kUnresolvedGameResult until the child is first
+    // selected if the expansion is lazy. Guarded by the parent's lock.
+    std::array<uint8_t, kMctNodeBlockSize> game_results;
 
-    // Child states obtained by applying exactly one action from the current state.
-    MutablePriorityQueue<MctNode> children;
+    std::array<std::atomic<bool>, kMctNodeBlockSize> locks;
+};
+
+/**
+ * @brief The MctNodeArena class Allocates MCTS nodes in bulk. Nodes are never freed individually.
+ * Instead, the whole arena is released in constant time by Clear().
+ */
+class MctNodeArena {
+  public:
+    MctNodeArena();
+    MctNodeArena(MctNodeArena const &) = delete;
+    ~MctNodeArena();
 
     /**
-     * @brief MctNode Used by the container to fill up space. Otherwise, the node will be at an
-     * invalid state.
+     * @brief Clear Releases all the nodes in constant time. The memory blocks are kept for reuse.
+     * Node IDs handed out after the call never collide with the ones handed out before.
      */
-    MctNode();
+    void Clear();
 
     /**
-     * @brief MctNode The only valid constructor.
+     * @brief Allocate Allocates count contiguous nodes in their default state and returns the
+     * index of the first one. It's safe to call concurrently.
      *
-     * @param id Uhique identity in the entire search tree.
-     * @param arrived_thru_action_id How did the current state arrive from the parent state. Set
-     * this to nullopt if it's a the root state.
-     * @param action_performed_by Which player performed the action. Set this ot nullopt if it's the
-     * root state.
-     * @param game_result Game state at the current state.
-     * @param heuristic_policy_weight Policy weight given by the heuristics used to rank the action
-     * leading to the current state.
+     * @param count Must be in range [1, kMaxMctNodeChildren].
+     */
+    MctNodeIndex Allocate(unsigned count);
+
+    /**
+     * @brief Size The number of nodes allocated since the last Clear().
      */
-    MctNode(MctNodeId const id, std::optional<GomokuActionId> const arrived_thru_action_id,
-            std::optional<PlayerSide> const action_performed_by, GameResult const game_result,
-            float const heuristic_policy_weight);
+    unsigned Size() const;
 
-    MctNode(MctNode const &) = default;
-    MctNode(MctNode &&) = default;
-    ~MctNode() = default;
+    /**
+     * @brief ReservedBytes The memory held by the node blocks, including the ones kept for reuse.
+     */
+    uint64_t ReservedBytes() const;
 
     /**
-     * @brief operator < Orders the node by the upper confidence bound.
+     * @brief Id A unique node ID to identify the game state to the evaluators.
      */
-    bool operator<(MctNode const &rhs) const;
+    MctNodeId Id(MctNodeIndex index) const;
+
+    /**
+     * @brief IndexOf The inverse of Id(). It returns nullopt if the node was allocated before the
+     * last Clear() or by another arena.
+     */
+    std::optional<MctNodeIndex> IndexOf(MctNodeId id) const;
+
+    /**
+     * @brief Block The block which contains the node at the index.
+     */
+    MctNodeBlock &Block(MctNodeIndex index);
+    MctNodeBlock const &Block(MctNodeIndex index) const;
+
+    /**
+     * @brief Lock Acquires the node's spin lock. Locks are always acquired from the ancestor to
+     * the descendant.
+     */
+    void Lock(MctNodeIndex index);
+    void Unlock(MctNodeIndex index);
+
+  private:
+    std::array<std::unique_ptr<MctNodeBlock>, kMaxMctNodeBlocks> blocks_;
+    unsigned num_blocks_ = 0;
+    unsigned size_ = 0;
+    MctNodeId epoch_;
+    std::mutex allocation_lock_;
 };
 
 /**
- * @brief AllocateMctNodeId Allocate a node ID which will be unique over the lifetime of the
- * process.
+ * @brief BlockOffset The position of the node in its block.
  */
-MctNodeId AllocateMctNodeId();
+inline unsigned BlockOffset(MctNodeIndex const index) { return index & (kMctNodeBlockSize - 1); }
+
+inline MctNodeBlock &MctNodeArena::Block(MctNodeIndex const index) {
+    return *blocks_[index >> kMctNodeBlockBits];
+}
+
+inline MctNodeBlock const &MctNodeArena::Block(MctNodeIndex const index) const {
+    return *blocks_[index >> kMctNodeBlockBits];
+}
 
 } // namespace e8
 
@@ -17,75 +17,179 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <optional>
-#include <unordered_map>
+#include <thread>
+#include <utility>
 #include <vector>
 
-#include "common/container/mutable_priority_queue.h"
 #include "common/random/random_source.h"
-#include "common/random/sample.h"
+#include "common/thread/thread_pool.h"
 #include "gomoku/agent/heuristics/evaluator.h"
 #include "gomoku/agent/search/mct_node.h"
 #include "gomoku/agent/search/mct_search.h"
+#include "gomoku/agent/search/policy.h"
+#include "gomoku/agent/search/threat_solver.h"
+#include "gomoku/agent/search/transposition_table.h"
 #include "gomoku/game/board_state.h"
 
 namespace e8 {
 namespace {
 
+// Number of board states the transposition table can hold, 32 bytes each.
+unsigned const kTranspositionTableCapacity = 1 << 18;
+
+// Progressive widening schedule of the lazy expansion. A node whose children have been visited n
+// times lets the selection consider its kMinActiveChildren + kWideningFactor*sqrt(n) children of
+// the highest priors.
+unsigned const kMinActiveChildren = 2;
+float const kWideningFactor = 1.5f;
+
+// Pondering runs at most this many times the evaluator's number of simulations, so that the tree
+// doesn't outgrow the arena while the opponent takes long to think.
+unsigned const kPonderingSimulationFactor = 8;
+
 struct EvaluationResult {
     std::array<float, 2> reward_viewed_by_player;
 };
 
-float UpperConfidenceBound(float const exploration_factor, MctNode const &parent,
-                           MctNode const &node) {
-    float q_value;
-    float uncertainty;
+/**
+ * @brief The SearchContext struct Information shared by all the search workers.
+ */
+struct SearchContext {
+    MctNodeArena *arena;
 
-    if (node.num_bandit_pulls > 0) {
-        q_value = node.summed_reward / (node.num_bandit_pulls);
-        uncertainty = exploration_factor * std::sqrt(1.0f + parent.num_bandit_pulls) /
-                      (node.num_bandit_pulls);
-    } else {
-        q_value = 0.0f;
-        uncertainty = exploration_factor;
-    }
+    MctTranspositionTable *transposition_table;
+
+    GomokuEvaluatorInterface *evaluator;
+
+    // Set to nullptr if the evaluator is thread-safe.
+    std::mutex *evaluator_lock;
+
+    float exploration_factor;
+
+    bool lazy_expansion;
+
+    bool solve_threats;
 
-    assert(q_value < 1.05f && q_value > -1.05f);
-    assert(!std::isinf(q_value));
-    assert(!std::isnan(q_value));
-    assert(!std::isinf(uncertainty));
-    assert(!std::isnan(uncertainty));
+    // Ends the search early when set.
+    std::atomic<bool> const *stop_requested;
+    std::optional<std::chrono::steady_clock::time_point> deadline;
 
-    return q_value + node.heuristic_policy_weight * uncertainty;
+    // Nullable. Counts the simulations descending into each child of the search root, indexed by
+    // the child's position among its siblings. It's only touched under the root's lock.
+    std::vector<unsigned> *root_child_simulations;
+};
+
+/**
+ * @brief The PathStep struct A node on the selection path and the transposition table entry of its
+ * state, which is nullptr if the table has no room for it.
+ */
+struct PathStep {
+    MctNodeIndex node;
+    MctTranspositionTable::Entry *entry;
+};
+
+std::unique_lock<std::mutex> LockEvaluator(SearchContext const &context) {
+    if (context.evaluator_lock == nullptr) {
+        return std::unique_lock<std::mutex>();
+    }
+    return std::unique_lock<std::mutex>(*context.evaluator_lock);
 }
 
-void UpdateMctNode(EvaluationResult const &eval, float const exploration_factor, MctNode *parent,
-                   MctNode *node) {
-    assert(node->action_performed_by.has_value());
-    node->summed_reward += eval.reward_viewed_by_player[*node->action_performed_by];
-    node->num_bandit_pulls += 1;
-    node->upper_confidence_bound = UpperConfidenceBound(exploration_factor, *parent, *node);
+/**
+ * @brief UpperConfidenceBound The PUCT score of a child. In-flight simulations are counted as lost
+ * visits.
+ *
+ * @param parent_uncertainty The exploration factor scaled by sqrt(1 + the parent's visits).
+ */
+inline float UpperConfidenceBound(float const exploration_factor, float const parent_uncertainty,
+                                  float const summed_reward, uint32_t const num_visits,
+                                  uint32_t const virtual_loss, float const prior) {
+    float const num_pulls = num_visits + virtual_loss;
+    float const divisor = std::max(num_pulls, 1.0f);
+    float const q_value = (summed_reward - virtual_loss) / divisor;
+    float const uncertainty = num_pulls > 0 ? parent_uncertainty / divisor : exploration_factor;
+    return q_value + prior * uncertainty;
 }
 
-void BackPropagate(EvaluationResult const &eval, float const exploration_factor,
-                   std::vector<MutablePriorityQueue<MctNode>::iterator> *propagation_path) {
-    for (int i = propagation_path->size() - 1; i >= 1; --i) {
-        MctNode *parent = &(*(*propagation_path)[i - 1]);
-        MctNode *node = &(*(*propagation_path)[i]);
-        UpdateMctNode(eval, exploration_factor, parent, node);
+/**
+ * @brief SelectChild Finds the offset of the child with the highest upper confidence bound among
+ * the contiguous children starting at the block offset first.
+ */
+unsigned SelectChild(MctNodeBlock const &block, unsigned const first, unsigned const num_children,
+                     uint32_t const num_parent_visits, float const exploration_factor) {
+    assert(num_children > 0 && num_children <= kMaxMctNodeChildren);
+
+    float const parent_uncertainty = exploration_factor * std::sqrt(1.0f + num_parent_visits);
+
+    // Scores every child in a branchless pass so that it vectorizes, then picks the maximum.
+    std::array<float, kMaxMctNodeChildren> scores;
+    for (unsigned i = 0; i < num_children; ++i) {
+        scores[i] = UpperConfidenceBound(
+            exploration_factor, parent_uncertainty, block.summed_rewards[first + i],
+            block.num_visits[first + i], block.virtual_losses[first + i], block.priors[first + i]);
+    }
 
-        parent->children.reprioritize((*propagation_path)[i]);
+    unsigned best = 0;
+    for (unsigned i = 1; i < num_children; ++i) {
+        if (scores[i] > scores[best]) {
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+/**
+ * @brief NumActiveChildren The number of children the progressive widening admits to the
+ * selection.
+ */
+unsigned NumActiveChildren(uint32_t const num_child_visits, unsigned const num_children) {
+    unsigned const num_widened =
+        kMinActiveChildren + static_cast<unsigned>(kWideningFactor * std::sqrt(num_child_visits));
+    return std::min(num_widened, num_children);
+}
+
+void BackPropagate(EvaluationResult const &eval, std::vector<PathStep> const &propagation_path,
+                   MctNodeArena *arena) {
+    for (int i = propagation_path.size() - 1; i >= 1; --i) {
+        MctNodeIndex const parent = propagation_path[i - 1].node;
+        MctNodeIndex const node = propagation_path[i].node;
+
+        MctNodeBlock &block = arena->Block(node);
+        unsigned const offset = BlockOffset(node);
+
+        arena->Lock(parent);
+        assert(block.virtual_losses[offset] > 0);
+        block.virtual_losses[offset] -= 1;
+        block.num_visits[offset] += 1;
+        block.summed_rewards[offset] +=
+            eval.reward_viewed_by_player[block.action_performers[offset]];
+        arena->Unlock(parent);
+
+        if (propagation_path[i].entry != nullptr) {
+            MctTranspositionTable::AddVisit(eval.reward_viewed_by_player[PS_PLAYER_A],
+                                            propagation_path[i].entry);
+        }
     }
-    (*propagation_path)[0]->num_bandit_pulls += 1;
+
+    MctNodeIndex const root = propagation_path[0].node;
+    arena->Lock(root);
+    arena->Block(root).num_visits[BlockOffset(root)] += 1;
+    arena->Unlock(root);
 }
 
-EvaluationResult Evaluate(GomokuBoardState const &state, MctNode const *parent_mct_node,
-                          MctNode const &state_mct_node, GomokuEvaluatorInterface *evaluator) {
+EvaluationResult Evaluate(GomokuBoardState const &state, MctNodeIndex const parent,
+                          MctNodeIndex const node, MctTranspositionTable::Entry *entry,
+                          SearchContext const &context) {
 
     GameResult game_result = state.CurrentGameResult();
 
@@ -108,20 +212,34 @@ EvaluationResult Evaluate(GomokuBoardState const &state, MctNode const *parent_m
         break;
     }
     case GR_UNDETERMINED: {
-        float est_reward;
-        if (parent_mct_node != nullptr) {
-            est_reward = evaluator->EvaluateReward(state, parent_mct_node->id, state_mct_node.id);
-        } else {
-            est_reward = evaluator->EvaluateReward(state, /*parent_state_id=*/std::nullopt,
-                                                   state_mct_node.id);
+        std::optional<float> est_reward;
+        if (entry != nullptr) {
+            // A transposition of the state may have been evaluated already.
+            est_reward = MctTranspositionTable::Reward(*entry);
+        }
+
+        if (!est_reward.has_value()) {
+            std::unique_lock<std::mutex> evaluator_guard = LockEvaluator(context);
+            if (parent != kNullMctNodeIndex) {
+                est_reward = context.evaluator->EvaluateReward(state, context.arena->Id(parent),
+                                                               context.arena->Id(node));
+            } else {
+                est_reward = context.evaluator->EvaluateReward(
+                    state, /*parent_state_id=*/std::nullopt, context.arena->Id(node));
+            }
+            evaluator_guard = std::unique_lock<std::mutex>();
+
+            if (entry != nullptr) {
+                MctTranspositionTable::SetReward(*est_reward, entry);
+            }
         }
 
-        assert(est_reward < 1.05f && est_reward > -1.05f);
-        assert(!std::isinf(est_reward));
-        assert(!std::isnan(est_reward));
+        assert(*est_reward < 1.05f && *est_reward > -1.05f);
+        assert(!std::isinf(*est_reward));
+        assert(!std::isnan(*est_reward));
 
-        result.reward_viewed_by_player[state.CurrentPlayerSide()] = est_reward;
-        result.reward_viewed_by_player[(state.CurrentPlayerSide() + 1) & 1] = -est_reward;
+        result.reward_viewed_by_player[state.CurrentPlayerSide()] = *est_reward;
+        result.reward_viewed_by_player[(state.CurrentPlayerSide() + 1) & 1] = -*est_reward;
         break;
     }
     }
@@ -129,92 +247,359 @@ EvaluationResult Evaluate(GomokuBoardState const &state, MctNode const *parent_m
     return result;
 }
 
-void Expand(MctNode *parent, MctNode *node, GomokuBoardState *state,
-            GomokuEvaluatorInterface *evaluator) {
-    std::unordered_map<GomokuActionId, GomokuAction> actions = state->LegalActions();
+GameResult WinOf(PlayerSide const side) {
+    return side == PS_PLAYER_A ? GR_PLAYER_A_WIN : GR_PLAYER_B_WIN;
+}
+
+/**
+ * @brief Expand Allocates the children of the node in one contiguous range. The caller must hold
+ * the node's lock. The heuristics policy is taken from an expanded transposition of the node if
+ * there is one. In the eager mode, the children start with the statistics their states have
+ * accumulated in the transposition table. In the lazy mode, the children are ranked by their
+ * priors, and their game results and statistics are left to ResolveChild().
+ *
+ * When the threat solver proves the node, the proof replaces the heuristics policy and is recorded
+ * as the game results of the children, so that the search treats them as terminal. On a win, the
+ * winning child takes all of the prior, which keeps the selection away from its siblings. On a
+ * loss, every child which doesn't end the game is a win of the opponent.
+ *
+ * @return The threat solver's proof of the node in the perspective of the player to move.
+ */
+ThreatProof Expand(MctNodeIndex const parent, MctNodeIndex const node,
+                   MctTranspositionTable::Entry *entry, GomokuBoardState *state,
+                   SearchContext const &context) {
+    GomokuActionSet actions = state->LegalActions();
+    assert(!actions.empty());
+
+    ThreatSolution threats;
+    if (context.solve_threats) {
+        threats = SolveThreats(*state);
+    }
+
+    std::optional<MctNodeIndex> transposed_node;
+    if (entry != nullptr) {
+        MctNodeId const transposed_node_id = entry->expanded_node.load(std::memory_order_acquire);
+        if (transposed_node_id != 0) {
+            transposed_node = context.arena->IndexOf(transposed_node_id);
+        }
+        if (transposed_node.has_value() &&
+            context.arena->Block(*transposed_node).num_children[BlockOffset(*transposed_node)] !=
+                actions.size()) {
+            // Hash collision.
+            transposed_node.reset();
+        }
+    }
 
-    std::unordered_map<GomokuActionId, float> heuristics_policy;
-    if (parent != nullptr) {
-        heuristics_policy = evaluator->EvaluatePolicy(*state, parent->id, node->id);
+    // The actions and their priors in the order the children are laid out.
+    std::array<std::pair<GomokuActionId, float>, kMaxMctNodeChildren> ranked_actions;
+    if (threats.proof != TP_UNPROVEN) {
+        // The proof takes the place of the heuristics policy.
+        unsigned i = 0;
+        for (auto const &[action_id, _] : actions) {
+            float prior = 1.0f / actions.size();
+            if (threats.proof == TP_WIN) {
+                prior = action_id == *threats.winning_action ? 1.0f : 0.0f;
+            }
+            ranked_actions[i++] = std::make_pair(action_id, prior);
+        }
+
+        // Keeps the winning child among the active ones.
+        std::stable_sort(ranked_actions.begin(), ranked_actions.begin() + actions.size(),
+                         [](std::pair<GomokuActionId, float> const &a,
+                            std::pair<GomokuActionId, float> const &b) {
+                             return a.second > b.second;
+                         });
+    } else if (transposed_node.has_value()) {
+        MctNodeBlock const &block = context.arena->Block(*transposed_node);
+        MctNodeIndex const first_child = block.first_children[BlockOffset(*transposed_node)];
+        MctNodeBlock const &transposed_children = context.arena->Block(first_child);
+        for (unsigned i = 0; i < actions.size(); ++i) {
+            unsigned const offset = BlockOffset(first_child) + i;
+            ranked_actions[i] = std::make_pair(transposed_children.arrived_thru_actions[offset],
+                                               transposed_children.priors[offset]);
+        }
     } else {
-        heuristics_policy =
-            evaluator->EvaluatePolicy(*state, /*parent_state_id=*/std::nullopt, node->id);
+        GomokuPolicy heuristics_policy;
+        {
+            std::unique_lock<std::mutex> evaluator_guard = LockEvaluator(context);
+            if (parent != kNullMctNodeIndex) {
+                context.evaluator->EvaluatePolicy(*state, context.arena->Id(parent),
+                                                  context.arena->Id(node), &heuristics_policy);
+            } else {
+                context.evaluator->EvaluatePolicy(*state, /*parent_state_id=*/std::nullopt,
+                                                  context.arena->Id(node), &heuristics_policy);
+            }
+        }
+
+        unsigned i = 0;
+        for (auto const &[action_id, _] : actions) {
+            ranked_actions[i++] = std::make_pair(action_id, heuristics_policy[action_id]);
+        }
+
+        if (context.lazy_expansion) {
+            std::stable_sort(ranked_actions.begin(), ranked_actions.begin() + actions.size(),
+                             [](std::pair<GomokuActionId, float> const &a,
+                                std::pair<GomokuActionId, float> const &b) {
+                                 return a.second > b.second;
+                             });
+        }
     }
 
+    MctNodeIndex const first_child = context.arena->Allocate(actions.size());
+    MctNodeBlock &children = context.arena->Block(first_child);
+
     // Expand the node and assign the heuristics policy as the bandits' prior.
     PlayerSide const action_performer = state->CurrentPlayerSide();
-    for (auto const &[action_id, _] : actions) {
+    uint32_t num_seeded_visits = 0;
+    for (unsigned i = 0; i < actions.size(); ++i) {
+        auto const [action_id, policy_weight] = ranked_actions[i];
+        unsigned const offset = BlockOffset(first_child) + i;
+
+        children.arrived_thru_actions[offset] = action_id;
+        children.action_performers[offset] = action_performer;
+        children.priors[offset] = policy_weight;
+
+        if (context.lazy_expansion && threats.proof != TP_LOSS) {
+            children.game_results[offset] =
+                threats.proof == TP_WIN && action_id == *threats.winning_action
+                    ? static_cast<uint8_t>(WinOf(action_performer))
+                    : static_cast<uint8_t>(kUnresolvedGameResult);
+            continue;
+        }
+
         GameResult game_result = state->ApplyAction(action_id,
                                                     /*cached_game_result=*/std::nullopt);
+        MctTranspositionTable::Entry const *child_entry =
+            context.transposition_table->Find(state->Hash());
         state->RetractAction();
 
-        float policy_weight = 0.0f;
-        auto policy_weight_it = heuristics_policy.find(action_id);
-        if (policy_weight_it != heuristics_policy.end()) {
-            policy_weight = policy_weight_it->second;
+        if (game_result == GR_UNDETERMINED) {
+            if (threats.proof == TP_WIN && action_id == *threats.winning_action) {
+                game_result = WinOf(action_performer);
+            } else if (threats.proof == TP_LOSS) {
+                game_result = WinOf(static_cast<PlayerSide>((action_performer + 1) & 1));
+            }
         }
 
-        MctNodeId const node_id = AllocateMctNodeId();
-        MctNode child(node_id, action_id, action_performer, game_result, policy_weight);
-        child.upper_confidence_bound =
-            UpperConfidenceBound(evaluator->ExplorationFactor(), *node, child);
-        node->children.push(child);
+        children.game_results[offset] = game_result;
+
+        if (child_entry != nullptr) {
+            auto [num_visits, summed_reward] = MctTranspositionTable::Visits(*child_entry);
+            children.num_visits[offset] = num_visits;
+            children.summed_rewards[offset] =
+                action_performer == PS_PLAYER_A ? summed_reward : -summed_reward;
+            num_seeded_visits += num_visits;
+        }
+    }
+
+    MctNodeBlock &block = context.arena->Block(node);
+    block.first_children[BlockOffset(node)] = first_child;
+    block.num_children[BlockOffset(node)] = actions.size();
+    block.num_active_children[BlockOffset(node)] =
+        context.lazy_expansion ? NumActiveChildren(block.num_child_visits[BlockOffset(node)],
+                                                   actions.size())
+                               : actions.size();
+    block.num_child_visits[BlockOffset(node)] += num_seeded_visits;
+
+    if (entry != nullptr && !transposed_node.has_value()) {
+        entry->expanded_node.store(context.arena->Id(node), std::memory_order_release);
+    }
+
+    return threats.proof;
+}
+
+/**
+ * @brief ResolveChild Records the game result of a lazily expanded child upon its first selection
+ * and seeds its statistics from the transposition table. Concurrent workers may race to resolve
+ * the same child, in which case only the first one takes effect.
+ */
+void ResolveChild(MctNodeIndex const node, MctNodeIndex const child, GameResult const game_result,
+                  MctTranspositionTable::Entry const *child_entry, SearchContext const &context) {
+    MctNodeBlock &children = context.arena->Block(child);
+    unsigned const offset = BlockOffset(child);
+
+    context.arena->Lock(node);
+
+    if (children.game_results[offset] == kUnresolvedGameResult) {
+        children.game_results[offset] = game_result;
+
+        if (child_entry != nullptr) {
+            auto [num_visits, summed_reward] = MctTranspositionTable::Visits(*child_entry);
+            children.num_visits[offset] += num_visits;
+            children.summed_rewards[offset] +=
+                children.action_performers[offset] == PS_PLAYER_A ? summed_reward
+                                                                  : -summed_reward;
+            context.arena->Block(node).num_child_visits[BlockOffset(node)] += num_visits;
+        }
     }
+
+    context.arena->Unlock(node);
 }
 
-void SelectFrom(MctNode *parent, MctNode *node, GomokuBoardState *state,
-                GomokuEvaluatorInterface *evaluator,
-                std::vector<MutablePriorityQueue<MctNode>::iterator> *propagation_path) {
+void SelectFrom(MctNodeIndex const parent, MctNodeIndex const node, GomokuBoardState *state,
+                SearchContext const &context, std::vector<PathStep> *propagation_path) {
+    MctTranspositionTable::Entry *entry = propagation_path->back().entry;
+
     if (state->CurrentGameResult() != GR_UNDETERMINED) {
-        EvaluationResult eval = Evaluate(*state, parent, *node, evaluator);
-        BackPropagate(eval, evaluator->ExplorationFactor(), propagation_path);
+        EvaluationResult eval = Evaluate(*state, parent, node, entry, context);
+        BackPropagate(eval, *propagation_path, context.arena);
         return;
     }
 
-    if (node->children.empty()) {
-        Expand(parent, node, state, evaluator);
-        EvaluationResult eval = Evaluate(*state, parent, *node, evaluator);
-        BackPropagate(eval, evaluator->ExplorationFactor(), propagation_path);
+    MctNodeBlock &block = context.arena->Block(node);
+    unsigned const offset = BlockOffset(node);
+
+    context.arena->Lock(node);
+
+    if (block.first_children[offset] == kNullMctNodeIndex) {
+        // Concurrent workers reaching this node wait for the expansion then descend into the
+        // children, whereas the evaluation runs without holding any lock.
+        ThreatProof const proof = Expand(parent, node, entry, state, context);
+        context.arena->Unlock(node);
+
+        EvaluationResult eval;
+        if (proof == TP_UNPROVEN) {
+            eval = Evaluate(*state, parent, node, entry, context);
+        } else {
+            float const reward = proof == TP_WIN ? 1.0f : -1.0f;
+            eval.reward_viewed_by_player[state->CurrentPlayerSide()] = reward;
+            eval.reward_viewed_by_player[(state->CurrentPlayerSide() + 1) & 1] = -reward;
+        }
+        BackPropagate(eval, *propagation_path, context.arena);
         return;
     }
 
-    auto candidate_it = node->children.front();
-    state->ApplyAction(*candidate_it->arrived_thru_action_id, candidate_it->game_result);
-    propagation_path->push_back(candidate_it);
+    if (block.num_active_children[offset] < block.num_children[offset]) {
+        block.num_active_children[offset] =
+            std::max<unsigned>(block.num_active_children[offset],
+                               NumActiveChildren(block.num_child_visits[offset],
+                                                 block.num_children[offset]));
+    }
+
+    MctNodeIndex const first_child = block.first_children[offset];
+    MctNodeBlock &children = context.arena->Block(first_child);
+    unsigned const child_offset =
+        BlockOffset(first_child) + SelectChild(children, BlockOffset(first_child),
+                                               block.num_active_children[offset],
+                                               block.num_child_visits[offset],
+                                               context.exploration_factor);
+    children.virtual_losses[child_offset] += 1;
+    block.num_child_visits[offset] += 1;
+
+    if (parent == kNullMctNodeIndex && context.root_child_simulations != nullptr) {
+        unsigned const child_index = child_offset - BlockOffset(first_child);
+        if (context.root_child_simulations->size() <= child_index) {
+            context.root_child_simulations->resize(block.num_children[offset]);
+        }
+        ++(*context.root_child_simulations)[child_index];
+    }
+
+    GomokuActionId const action_id = children.arrived_thru_actions[child_offset];
+    uint8_t const cached_game_result = children.game_results[child_offset];
+
+    context.arena->Unlock(node);
+
+    MctNodeIndex const child = first_child + (child_offset - BlockOffset(first_child));
+
+    if (cached_game_result == kUnresolvedGameResult) {
+        GameResult const game_result =
+            state->ApplyAction(action_id, /*cached_game_result=*/std::nullopt);
+        propagation_path->push_back(
+            PathStep{child, context.transposition_table->FindOrInsert(state->Hash())});
+        ResolveChild(node, child, game_result, propagation_path->back().entry, context);
+    } else {
+        state->ApplyAction(action_id, static_cast<GameResult>(cached_game_result));
+        propagation_path->push_back(
+            PathStep{child, context.transposition_table->FindOrInsert(state->Hash())});
+    }
 
-    SelectFrom(node, &(*candidate_it), state, evaluator, propagation_path);
+    SelectFrom(node, child, state, context, propagation_path);
 
     propagation_path->pop_back();
     state->RetractAction();
 }
 
-std::unordered_map<GomokuActionId, float> ExtractStochasticPolicy(MctNode const &root,
-                                                                  float const temperature) {
-    std::unordered_map<GomokuActionId, float> policy(root.children.size());
-    unsigned total_num_bandit_pulls = 0;
-    for (auto const &child : root.children) {
-        assert(child.arrived_thru_action_id.has_value());
-        float exp_count = std::pow(child.num_bandit_pulls, 1 / temperature);
-        policy[*child.arrived_thru_action_id] = exp_count;
-        total_num_bandit_pulls += exp_count;
+void RunSimulations(MctNodeIndex const root, GomokuBoardState *state,
+                    SearchContext const &context, unsigned const num_simulations,
+                    std::atomic<unsigned> *num_simulations_started) {
+    std::vector<PathStep> propagation_path{
+        PathStep{root, context.transposition_table->FindOrInsert(state->Hash())}};
+    while (!context.stop_requested->load(std::memory_order_relaxed) &&
+           (!context.deadline.has_value() ||
+            std::chrono::steady_clock::now() < *context.deadline) &&
+           num_simulations_started->fetch_add(1, std::memory_order_relaxed) < num_simulations) {
+        SelectFrom(/*parent=*/kNullMctNodeIndex, root, state, context, &propagation_path);
     }
+}
+
+class SearchWorkerData : public TaskStorageInterface {
+  public:
+    SearchWorkerData(MctNodeIndex const root, GomokuBoardState const &state,
+                     SearchContext const &context, unsigned const num_simulations,
+                     std::atomic<unsigned> *num_simulations_started);
+
+    MctNodeIndex const root;
+    GomokuBoardState state;
+    SearchContext const context;
+    unsigned const num_simulations;
+    std::atomic<unsigned> *num_simulations_started;
+};
 
-    assert(total_num_bandit_pulls > 0);
+SearchWorkerData::SearchWorkerData(MctNodeIndex const root, GomokuBoardState const &state,
+                                   SearchContext const &context, unsigned const num_simulations,
+                                   std::atomic<unsigned> *num_simulations_started)
+    : root(root), state(state), context(context), num_simulations(num_simulations),
+      num_simulations_started(num_simulations_started) {}
+
+class SearchTask : public TaskInterface {
+  public:
+    void Run(TaskStorageInterface *storage) const override;
+    bool DropResourceOnCompletion() const override;
+};
 
-    for (auto &[_, p] : policy) {
-        p /= total_num_bandit_pulls;
+void SearchTask::Run(TaskStorageInterface *storage) const {
+    SearchWorkerData *data = static_cast<SearchWorkerData *>(storage);
+    RunSimulations(data->root, &data->state, data->context, data->num_simulations,
+                   data->num_simulations_started);
+}
+
+bool SearchTask::DropResourceOnCompletion() const { return false; }
+
+void ExtractStochasticPolicy(MctNodeArena const &arena, MctNodeIndex const root,
+                             GomokuBoardState const &state, float const temperature,
+                             GomokuPolicy *policy) {
+    MctNodeBlock const &block = arena.Block(root);
+    MctNodeIndex const first_child = block.first_children[BlockOffset(root)];
+    unsigned const num_children = block.num_children[BlockOffset(root)];
+    assert(first_child != kNullMctNodeIndex);
+
+    MctNodeBlock const &children = arena.Block(first_child);
+
+    policy->Reset(state);
+    for (unsigned i = BlockOffset(first_child); i < BlockOffset(first_child) + num_children;
+         ++i) {
+        (*policy)[children.arrived_thru_actions[i]] =
+            std::pow(children.num_visits[i], 1 / temperature);
     }
 
-    return policy;
+    policy->Normalize();
 }
 
-void PrintMctsStats(MctNode const &root, GomokuBoardState const &state) {
+void PrintMctsStats(MctNodeArena const &arena, MctNodeIndex const root,
+                    GomokuBoardState const &state, float const exploration_factor) {
     std::cout << "--------------------------------" << std::endl;
 
-    for (auto const &child : root.children) {
-        if (child.num_bandit_pulls > 0) {
-            assert(child.arrived_thru_action_id.has_value());
-            GomokuAction const &action = state.LegalActions().at(*child.arrived_thru_action_id);
+    MctNodeBlock const &block = arena.Block(root);
+    MctNodeIndex const first_child = block.first_children[BlockOffset(root)];
+    unsigned const num_children = block.num_children[BlockOffset(root)];
+    float const parent_uncertainty =
+        exploration_factor * std::sqrt(1.0f + block.num_child_visits[BlockOffset(root)]);
+
+    MctNodeBlock const &children = arena.Block(first_child);
+    for (unsigned i = BlockOffset(first_child); i < BlockOffset(first_child) + num_children;
+         ++i) {
+        if (children.num_visits[i] > 0) {
+            GomokuAction const action = state.LegalActions().at(children.arrived_thru_actions[i]);
 
             if (action.stone_pos.has_value()) {
                 std::cout << "(" << static_cast<int>(action.stone_pos->x) << ","
@@ -251,111 +636,315 @@ void PrintMctsStats(MctNode const &root, GomokuBoardState const &state) {
                 }
             }
 
-            std::cout << "|reward=" << child.summed_reward / child.num_bandit_pulls
-                      << "|n=" << child.num_bandit_pulls << "|ucb=" << child.upper_confidence_bound
-                      << "|p=" << child.heuristic_policy_weight << std::endl;
+            std::cout << "|reward=" << children.summed_rewards[i] / children.num_visits[i]
+                      << "|n=" << children.num_visits[i] << "|ucb="
+                      << UpperConfidenceBound(exploration_factor, parent_uncertainty,
+                                              children.summed_rewards[i], children.num_visits[i],
+                                              children.virtual_losses[i], children.priors[i])
+                      << "|p=" << children.priors[i] << std::endl;
         }
     }
 
     std::cout << "--------------------------------" << std::endl;
 }
 
+void CopyNodeStats(MctNodeArena const &from, MctNodeIndex const source, MctNodeArena *to,
+                   MctNodeIndex const destination) {
+    MctNodeBlock const &src = from.Block(source);
+    MctNodeBlock &dst = to->Block(destination);
+    unsigned const i = BlockOffset(source);
+    unsigned const j = BlockOffset(destination);
+
+    dst.summed_rewards[j] = src.summed_rewards[i];
+    dst.num_visits[j] = src.num_visits[i];
+    dst.virtual_losses[j] = src.virtual_losses[i];
+    dst.priors[j] = src.priors[i];
+    dst.num_child_visits[j] = src.num_child_visits[i];
+    dst.num_active_children[j] = src.num_active_children[i];
+    dst.arrived_thru_actions[j] = src.arrived_thru_actions[i];
+    dst.action_performers[j] = src.action_performers[i];
+    dst.game_results[j] = src.game_results[i];
+}
+
 } // namespace
 
 MctSearcher::MctSearcher(std::shared_ptr<GomokuEvaluatorInterface> const &evaluator,
-                         bool const print_stats)
-    : evaluator_(evaluator), print_stats_(print_stats) {
+                         bool const print_stats, unsigned const num_workers,
+                         bool const lazy_expansion, bool const solve_threats)
+    : transposition_table_(kTranspositionTableCapacity), evaluator_(evaluator),
+      print_stats_(print_stats), num_workers_(num_workers), lazy_expansion_(lazy_expansion),
+      solve_threats_(solve_threats), stop_requested_(false) {
+    assert(num_workers_ >= 1);
+
+    if (num_workers_ > 1) {
+        worker_pool_ = std::make_unique<ThreadPool>(num_workers_);
+    }
+
     this->Reset();
 }
 
-std::unordered_map<GomokuActionId, float> MctSearcher::SearchFrom(GomokuBoardState state,
-                                                                  float const temperature) {
-    assert(current_node_it_.has_value());
-    evaluator_->ClearCache();
+MctSearcher::~MctSearcher() { this->StopPondering(); }
 
-    MutablePriorityQueue<MctNode>::iterator *root = &current_node_it_.value();
+void MctSearcher::SearchFrom(GomokuBoardState state, float const temperature,
+                             GomokuPolicy *policy) {
+    MctSearchBudget budget;
+    budget.num_simulations = evaluator_->NumSimulations();
+    this->Search(state, budget);
 
-    std::vector<MutablePriorityQueue<MctNode>::iterator> propagation_path{*root};
-    for (unsigned i = 0; i < evaluator_->NumSimulations(); ++i) {
-        SelectFrom(/*parent=*/nullptr, &(**root), &state, evaluator_.get(), &propagation_path);
+    if (print_stats_) {
+        PrintMctsStats(arenas_[active_arena_], current_node_, state,
+                       evaluator_->ExplorationFactor());
     }
 
-    if (print_stats_) {
-        PrintMctsStats(**root, state);
+    this->ExtractPolicy(state, temperature, policy);
+}
+
+void MctSearcher::Search(GomokuBoardState const &state, MctSearchBudget const &budget) {
+    assert(!pondering_thread_.joinable());
+
+    stop_requested_ = false;
+    this->RunSearch(state, budget);
+}
+
+void MctSearcher::Stop() { stop_requested_ = true; }
+
+void MctSearcher::ExtractPolicy(GomokuBoardState const &state, float const temperature,
+                                GomokuPolicy *policy) const {
+    ExtractStochasticPolicy(arenas_[active_arena_], current_node_, state, temperature, policy);
+}
+
+unsigned MctSearcher::NumRootVisits() const {
+    return arenas_[active_arena_].Block(current_node_).num_child_visits[BlockOffset(current_node_)];
+}
+
+unsigned MctSearcher::NumRootSimulations() const { return num_root_simulations_; }
+
+unsigned MctSearcher::NumSimulations() const { return evaluator_->NumSimulations(); }
+
+unsigned MctSearcher::NumTreeNodes() const { return arenas_[active_arena_].Size(); }
+
+uint64_t MctSearcher::TreeMemoryBytes() const {
+    return arenas_[0].ReservedBytes() + arenas_[1].ReservedBytes() +
+           static_cast<uint64_t>(transposition_table_.Capacity()) *
+               sizeof(MctTranspositionTable::Entry);
+}
+
+void MctSearcher::StartPondering(GomokuBoardState const &state) {
+    this->StopPondering();
+
+    MctSearchBudget budget;
+    budget.num_simulations = kPonderingSimulationFactor * evaluator_->NumSimulations();
+
+    // Cleared before the thread starts so that an immediate StopPondering() isn't lost.
+    stop_requested_ = false;
+    pondering_thread_ = std::thread(&MctSearcher::RunSearch, this, state, budget);
+}
+
+void MctSearcher::StopPondering() {
+    if (!pondering_thread_.joinable()) {
+        return;
     }
 
-    return ExtractStochasticPolicy(**root, temperature);
+    stop_requested_ = true;
+    pondering_thread_.join();
+}
+
+void MctSearcher::RunSearch(GomokuBoardState state, MctSearchBudget const &budget) {
+    assert(current_node_ != kNullMctNodeIndex);
+
+    if (has_garbage_) {
+        this->CompactTree();
+    }
+
+    if (evaluator_cache_stale_) {
+        evaluator_->ClearCache();
+        evaluator_cache_stale_ = false;
+    }
+
+    // Keeps the table sparse enough for the states of this search to find room.
+    if (transposition_table_.Size() > transposition_table_.Capacity() / 2) {
+        transposition_table_.Clear();
+    }
+
+    SearchContext context;
+    context.arena = &arenas_[active_arena_];
+    context.transposition_table = &transposition_table_;
+    context.evaluator = evaluator_.get();
+    context.evaluator_lock = evaluator_->ThreadSafe() ? nullptr : &evaluator_lock_;
+    context.exploration_factor = evaluator_->ExplorationFactor();
+    context.lazy_expansion = lazy_expansion_;
+    context.solve_threats = solve_threats_;
+    context.stop_requested = &stop_requested_;
+    context.deadline = budget.deadline;
+    context.root_child_simulations = &root_child_simulations_;
+
+    unsigned const num_simulations =
+        budget.num_simulations.value_or(std::numeric_limits<unsigned>::max());
+    std::atomic<unsigned> num_simulations_started(0);
+
+    if (worker_pool_ == nullptr) {
+        RunSimulations(current_node_, &state, context, num_simulations, &num_simulations_started);
+    } else {
+        auto task = std::make_shared<SearchTask>();
+        for (unsigned i = 0; i < num_workers_; ++i) {
+            worker_pool_->Schedule(
+                task, std::make_unique<SearchWorkerData>(current_node_, state, context,
+                                                         num_simulations,
+                                                         &num_simulations_started));
+        }
+        for (unsigned i = 0; i < num_workers_; ++i) {
+            worker_pool_->WaitForNextCompleted();
+        }
+    }
+
+    // Every worker's last increment overshoots the budget without running a simulation.
+    num_root_simulations_ += std::min(num_simulations_started.load(), num_simulations);
 }
 
 void MctSearcher::SelectAction(GomokuBoardState state, GomokuActionId const action_id) {
-    assert(current_node_it_.has_value());
+    this->StopPondering();
+
+    assert(current_node_ != kNullMctNodeIndex);
     assert(state.LegalActions().find(action_id) != state.LegalActions().end());
 
-    if (current_node_it_.value()->children.empty()) {
-        Expand(/*parent=*/nullptr, &(*current_node_it_.value()), &state, evaluator_.get());
+    MctNodeArena *arena = &arenas_[active_arena_];
+    MctNodeBlock const &block = arena->Block(current_node_);
+
+    if (block.first_children[BlockOffset(current_node_)] == kNullMctNodeIndex) {
+        SearchContext context;
+        context.arena = arena;
+        context.transposition_table = &transposition_table_;
+        context.evaluator = evaluator_.get();
+        context.evaluator_lock = nullptr;
+        context.exploration_factor = evaluator_->ExplorationFactor();
+        context.lazy_expansion = lazy_expansion_;
+        context.solve_threats = solve_threats_;
+        context.stop_requested = &stop_requested_;
+        context.root_child_simulations = nullptr;
+
+        Expand(/*parent=*/kNullMctNodeIndex, current_node_,
+               transposition_table_.FindOrInsert(state.Hash()), &state, context);
     }
 
-    MutablePriorityQueue<MctNode>::iterator next_node;
-    for (auto it = current_node_it_.value()->children.begin();
-         it != current_node_it_.value()->children.end(); ++it) {
-        assert(it->arrived_thru_action_id.has_value());
-        if (*it->arrived_thru_action_id == action_id) {
-            next_node = it;
-        } else {
-            it->children.clear();
+    MctNodeIndex const first_child = block.first_children[BlockOffset(current_node_)];
+    unsigned const num_children = block.num_children[BlockOffset(current_node_)];
+    MctNodeBlock const &children = arena->Block(first_child);
+
+    MctNodeIndex next_node = kNullMctNodeIndex;
+    for (unsigned i = 0; i < num_children; ++i) {
+        if (children.arrived_thru_actions[BlockOffset(first_child) + i] == action_id) {
+            next_node = first_child + i;
+            num_root_simulations_ =
+                i < root_child_simulations_.size() ? root_child_simulations_[i] : 0;
+            break;
         }
     }
+    assert(next_node != kNullMctNodeIndex);
+    root_child_simulations_.clear();
 
-    current_node_it_ = next_node;
+    // The siblings become garbage. They are dropped when the surviving subtree is compacted.
+    current_node_ = next_node;
+    has_garbage_ = true;
 }
 
 void MctSearcher::Reset() {
-    root_.clear();
+    this->StopPondering();
+
+    arenas_[0].Clear();
+    arenas_[1].Clear();
+    transposition_table_.Clear();
+
+    active_arena_ = 0;
+    current_node_ = arenas_[active_arena_].Allocate(/*count=*/1);
+    num_root_simulations_ = 0;
+    root_child_simulations_.clear();
+    has_garbage_ = false;
+    evaluator_cache_stale_ = true;
+}
 
-    MctNodeId const node_id = AllocateMctNodeId();
-    root_.push(MctNode(node_id,
-                       /*arrived_thru_action_id=*/std::nullopt,
-                       /*action_performed_by=*/std::nullopt,
-                       /*game_result=*/GameResult::GR_UNDETERMINED,
-                       /*heuristic_policy_weight=*/std::numeric_limits<float>::infinity()));
+void MctSearcher::CompactTree() {
+    MctNodeArena *from = &arenas_[active_arena_];
+    MctNodeArena *to = &arenas_[1 - active_arena_];
+    to->Clear();
 
-    current_node_it_ = root_.begin();
-}
+    MctNodeIndex const new_root = to->Allocate(/*count=*/1);
+    CopyNodeStats(*from, current_node_, to, new_root);
 
-GomokuActionId BestAction(std::unordered_map<GomokuActionId, float> const &policy) {
-    // Find the action.
-    auto it = std::max_element(
-        policy.begin(), policy.end(),
-        [](std::pair<GomokuActionId, float> const &a, std::pair<GomokuActionId, float> const &b) {
-            return a.second < b.second;
-        });
-    assert(it != policy.end());
-
-    // Constructs the selection.
-    GomokuActionId selected_action_id = it->first;
-    return selected_action_id;
+    // Copies the subtree sibling group by sibling group so that children stay contiguous.
+    std::vector<std::pair<MctNodeIndex, MctNodeIndex>> pending{{current_node_, new_root}};
+    while (!pending.empty()) {
+        auto [source, destination] = pending.back();
+        pending.pop_back();
+
+        MctNodeBlock const &src = from->Block(source);
+        MctNodeIndex const first_child = src.first_children[BlockOffset(source)];
+        if (first_child == kNullMctNodeIndex) {
+            continue;
+        }
+
+        unsigned const num_children = src.num_children[BlockOffset(source)];
+        MctNodeIndex const new_first_child = to->Allocate(num_children);
+
+        MctNodeBlock &dst = to->Block(destination);
+        dst.first_children[BlockOffset(destination)] = new_first_child;
+        dst.num_children[BlockOffset(destination)] = num_children;
+
+        for (unsigned i = 0; i < num_children; ++i) {
+            CopyNodeStats(*from, first_child + i, to, new_first_child + i);
+            pending.push_back(std::make_pair(first_child + i, new_first_child + i));
+        }
+    }
+
+    from->Clear();
+    active_arena_ = 1 - active_arena_;
+    current_node_ = new_root;
+    has_garbage_ = false;
+    evaluator_cache_stale_ = true;
 }
 
-GomokuActionId SampleAction(std::unordered_map<GomokuActionId, float> const &policy,
-                            RandomSource *random_source) {
-    GomokuActionId selected_action_id = SampleFrom(policy, random_source);
+GomokuActionId BestAction(GomokuPolicy const &policy) {
+    assert(policy.NumActions() > 0);
+
+    GomokuActionId selected_action_id = 0;
+    for (unsigned i = 1; i < policy.NumActions(); ++i) {
+        if (policy[i] > policy[selected_action_id]) {
+            selected_action_id = i;
+        }
+    }
+
     return selected_action_id;
 }
 
-std::vector<float> FlattenPolicy(std::unordered_map<GomokuActionId, float> const &policy,
-                                 GomokuBoardState const &board) {
-    auto [min, max] = board.ActionIdRange();
+GomokuActionId SampleAction(GomokuPolicy const &policy, RandomSource *random_source) {
+    double q = random_source->Draw();
+    double cdf = 0;
 
-    std::vector<float> flattened_policy(max - min + 1);
-    for (unsigned i = 0; i < flattened_policy.size(); ++i) {
-        auto it = policy.find(i);
-        if (it != policy.end()) {
-            flattened_policy[i] = it->second;
-        } else {
-            flattened_policy[i] = 0.0f;
+    std::optional<GomokuActionId> last_action_id;
+    for (unsigned i = 0; i < policy.NumActions(); ++i) {
+        if (policy[i] == 0.0f) {
+            continue;
+        }
+
+        cdf += policy[i];
+        if (q < cdf) {
+            return i;
         }
+
+        last_action_id = i;
     }
 
+    assert(last_action_id.has_value());
+    assert(std::abs(cdf - 1.0f) < 1e-2f);
+
+    // Numerical glitch.
+    return *last_action_id;
+}
+
+std::vector<float> FlattenPolicy(GomokuPolicy const &policy) {
+    std::vector<float> flattened_policy(policy.NumActions());
+    for (unsigned i = 0; i < policy.NumActions(); ++i) {
+        flattened_policy[i] = policy[i];
+    }
     return flattened_policy;
 }
 
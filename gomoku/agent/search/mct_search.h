@@ -18,18 +18,35 @@
 #ifndef MCT_SEARCH_H
 #define MCT_SEARCH_H
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <optional>
-#include <unordered_map>
+#include <thread>
+#include <vector>
 
-#include "common/container/mutable_priority_queue.h"
 #include "common/random/random_source.h"
+#include "common/thread/thread_pool.h"
 #include "gomoku/agent/heuristics/evaluator.h"
 #include "gomoku/agent/search/mct_node.h"
+#include "gomoku/agent/search/policy.h"
+#include "gomoku/agent/search/transposition_table.h"
 #include "gomoku/game/board_state.h"
 
 namespace e8 {
 
+/**
+ * @brief The MctSearchBudget struct Bounds an anytime search, see MctSearcher::Search(). The search
+ * ends at whichever limit it reaches first. An empty budget is only ended by MctSearcher::Stop().
+ */
+struct MctSearchBudget {
+    std::optional<unsigned> num_simulations;
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+};
+
 /**
  * @brief The MctSearcher class Holds a Monte Carlo search tree for a sequence of tree search
  * operations.
@@ -42,21 +59,33 @@ class MctSearcher {
      *
      * @param evaluator Heuristics to help guide the tree search.
      * @param print_stats Whether to print the internal stats after each SearchFrom() call.
+     * @param num_workers Number of workers descending the tree concurrently. When it's greater
+     * than 1, the workers spread out with virtual loss and the evaluator is called concurrently if
+     * it is thread-safe.
+     * @param lazy_expansion Whether to expand the children progressively. When enabled, a node
+     * ranks its children by the heuristic prior and lets the selection consider more of them as
+     * its visit count grows. The game result of a child isn't determined until it's selected.
+     * @param solve_threats Whether to run the threat solver on the standard Gomoku states being
+     * expanded. A state it proves skips the evaluator, and its children are marked as terminal
+     * wins or losses, so that the simulations are spent on the uncertain states. See
+     * SolveThreats().
      */
-    MctSearcher(std::shared_ptr<GomokuEvaluatorInterface> const &evaluator, bool const print_stats);
+    MctSearcher(std::shared_ptr<GomokuEvaluatorInterface> const &evaluator, bool const print_stats,
+                unsigned const num_workers = 1, bool const lazy_expansion = false,
+                bool const solve_threats = true);
     MctSearcher(MctSearcher const &) = delete;
     MctSearcher(MctSearcher &&) = delete;
-    ~MctSearcher() = default;
+    ~MctSearcher();
 
     /**
-     * @brief Reset Clear the existing search tree if there is one. All the currently holding
-     * iterators will be invalidated. Then point the internal tree node iterator to the new root.
+     * @brief Reset Clear the existing search tree if there is one. Then point the internal tree
+     * node to the new root.
      */
     void Reset();
 
     /**
      * @brief SearchFrom Calculate a stochastically optimal policy for the specified board state
-     * with the help of the heuristics. The internal tree node tterator must correspond to the
+     * with the help of the heuristics. The internal tree node must correspond to the
      * internal board state. Synchronize the internal tree node by calling SelectAction() to
      * transition the tree node state through actions.
      *
@@ -64,50 +93,139 @@ class MctSearcher {
      * @param temperature Controls how "flat" the output policy distribution should be. The
      * resulting policy PMF is normalized as policy_pmf[action_id] =
      * visit_count[action_id]^(1/temperature) / sum(visit_count[action_id]^(1/temperature))
-     * @return A stochastic policy.
+     * @param policy Caller supplied buffer which receives the stochastic policy.
+     */
+    void SearchFrom(GomokuBoardState state, float const temperature, GomokuPolicy *policy);
+
+    /**
+     * @brief Search Runs simulations from the state until the budget runs out or Stop() is
+     * called. The statistics add up over consecutive calls on the same node, so that a search can
+     * be resumed. Read the result by ExtractPolicy().
+     */
+    void Search(GomokuBoardState const &state, MctSearchBudget const &budget);
+
+    /**
+     * @brief Stop Makes the running Search() return after its in-flight simulations. It may be
+     * called from any thread.
+     */
+    void Stop();
+
+    /**
+     * @brief ExtractPolicy Computes the policy of the state from the visit counts, like
+     * SearchFrom() does. The state must have been searched.
+     */
+    void ExtractPolicy(GomokuBoardState const &state, float const temperature,
+                       GomokuPolicy *policy) const;
+
+    /**
+     * @brief NumRootVisits The visit count of the internal tree node. Besides the simulations run
+     * through the node, it includes the visits seeded from transpositions.
+     */
+    unsigned NumRootVisits() const;
+
+    /**
+     * @brief NumRootSimulations The number of simulations this searcher has actually run through
+     * the internal tree node, including the ones run before SelectAction() moved to it.
+     */
+    unsigned NumRootSimulations() const;
+
+    /**
+     * @brief NumSimulations The number of simulations a SearchFrom() call runs.
+     */
+    unsigned NumSimulations() const;
+
+    /**
+     * @brief NumTreeNodes The number of nodes allocated in the search tree, including the released
+     * ones which are waiting for the next compaction.
      */
-    std::unordered_map<GomokuActionId, float> SearchFrom(GomokuBoardState state,
-                                                         float const temperature);
+    unsigned NumTreeNodes() const;
+
+    /**
+     * @brief TreeMemoryBytes The memory held by the node arenas and the transposition table.
+     */
+    uint64_t TreeMemoryBytes() const;
+
+    /**
+     * @brief StartPondering Keeps searching from the state on a background thread, typically
+     * while the opponent is thinking, until StopPondering() is called or the pondering budget
+     * is spent. The state's subtree is then reused by SelectAction().
+     */
+    void StartPondering(GomokuBoardState const &state);
+
+    /**
+     * @brief StopPondering Stops the background search, if there is one, and waits for it. Any
+     * other call which touches the tree has to be made after it.
+     */
+    void StopPondering();
 
     /**
      * @brief SelectAction Explicitly transition to a state. If the internal from_state_node has
      * not yet expanded by the MctSearcher's SearchFrom() call, this function will force an
      * expansion with policy evaluation even though the selection has nothing to do with the
-     * heuristic policy. The transition will free the memory allocated for the rest of the children.
+     * heuristic policy. The transition releases the rest of the children in constant time. Their
+     * memory is reclaimed by the next SearchFrom() call, which compacts the surviving subtree.
      *
      * @param from_state_node The parent node to transition from.
      */
     void SelectAction(GomokuBoardState state, GomokuActionId const action_id);
 
   private:
-    MutablePriorityQueue<MctNode> root_;
-    std::optional<MutablePriorityQueue<MctNode>::iterator> current_node_it_;
+    void CompactTree();
+    void RunSearch(GomokuBoardState state, MctSearchBudget const &budget);
+
+    // The tree lives in one of the arenas. The other arena is the destination of the next
+    // compaction.
+    std::array<MctNodeArena, 2> arenas_;
+    unsigned active_arena_ = 0;
+    MctNodeIndex current_node_ = kNullMctNodeIndex;
+    bool has_garbage_ = false;
+
+    // Simulations run through the current node, and through each of its children so that
+    // SelectAction() can carry the count over.
+    unsigned num_root_simulations_ = 0;
+    std::vector<unsigned> root_child_simulations_;
+
+    // Node IDs are reused after compactions and resets, which makes the evaluator's per-search
+    // cache stale.
+    bool evaluator_cache_stale_ = true;
+
+    // Shares statistics and evaluations among transpositions, across consecutive searches.
+    MctTranspositionTable transposition_table_;
+
     std::shared_ptr<GomokuEvaluatorInterface> evaluator_;
     bool const print_stats_;
+    unsigned const num_workers_;
+    bool const lazy_expansion_;
+    bool const solve_threats_;
+
+    // Serializes evaluator calls when the evaluator isn't thread-safe.
+    std::mutex evaluator_lock_;
+
+    // Runs the search workers. It's only created when there is more than one worker.
+    std::unique_ptr<ThreadPool> worker_pool_;
+
+    std::atomic<bool> stop_requested_;
+    std::thread pondering_thread_;
 };
 
 /**
  * @brief SelectBestAction Find the action that has the highest mass in the policy distribution.
  */
-GomokuActionId BestAction(std::unordered_map<GomokuActionId, float> const &policy);
+GomokuActionId BestAction(GomokuPolicy const &policy);
 
 /**
  * @brief SampleAction Samples an action from the policy PMF.
  */
-GomokuActionId SampleAction(std::unordered_map<GomokuActionId, float> const &policy,
-                            RandomSource *random_source);
+GomokuActionId SampleAction(GomokuPolicy const &policy, RandomSource *random_source);
 
 /**
- * @brief FlattenPolicy Transforms the policy map to a fixed length float array. The policy is coded
- * into the array such that the index of the float array is the action_id. If an action is not
- * present in the policy map, the value at that index position is set to zero.
+ * @brief FlattenPolicy Copies the policy to a float array of NumActions() elements, such that the
+ * index of the float array is the action_id.
  *
  * @param policy The policy to be transformed.
- * @param board The board state that the policy was calculated from.
  * @return A flat policy array.
  */
-std::vector<float> FlattenPolicy(std::unordered_map<GomokuActionId, float> const &policy,
-                                 GomokuBoardState const &board);
+std::vector<float> FlattenPolicy(GomokuPolicy const &policy);
 
 } // namespace e8
 
@@ -0,0 +1,66 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+
+#include "gomoku/agent/search/policy.h"
+#include "gomoku/game/bitboard.h"
+#include "gomoku/game/board_state.h"
+
+namespace e8 {
+
+GomokuPolicy::GomokuPolicy() : num_actions_(0) {}
+
+void GomokuPolicy::Reset(GomokuBoardState const &board) {
+    auto [min, max] = board.ActionIdRange();
+    assert(min == 0);
+
+    num_actions_ = max - min + 1;
+    assert(num_actions_ <= kMaxNumGomokuActions);
+
+    std::fill(probs_.begin(), probs_.begin() + num_actions_, 0.0f);
+}
+
+unsigned GomokuPolicy::NumActions() const { return num_actions_; }
+
+void GomokuPolicy::Normalize() {
+    float total = 0.0f;
+    for (unsigned i = 0; i < num_actions_; ++i) {
+        total += probs_[i];
+    }
+
+    assert(total > 0.0f);
+
+    for (unsigned i = 0; i < num_actions_; ++i) {
+        probs_[i] /= total;
+    }
+}
+
+void GomokuPolicy::AssignLegal(GomokuBoardState const &board, float const *probs) {
+    this->Reset(board);
+
+    Bitboard const &legal_ids = board.LegalActions().ActionIds();
+    for (unsigned action_id = legal_ids.NextSetBit(0); action_id < kBitboardCapacity;
+         action_id = legal_ids.NextSetBit(action_id + 1)) {
+        probs_[action_id] = probs[action_id];
+    }
+
+    this->Normalize();
+}
+
+} // namespace e8
@@ -0,0 +1,84 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POLICY_H
+#define POLICY_H
+
+#include <array>
+#include <cassert>
+
+#include "gomoku/game/board_state.h"
+
+namespace e8 {
+
+// Number of action IDs on the largest board. It covers the stone positions, the swap2 decisions and
+// the stone type decisions.
+static unsigned const kMaxNumGomokuActions = kMaxBoardSideLength * kMaxBoardSideLength + 3 + 2;
+
+/**
+ * @brief The GomokuPolicy class A PMF over the action IDs of a board, stored densely in a fixed
+ * size buffer indexed by action ID. Actions which aren't assigned a probability have a zero
+ * probability. The buffer is meant to be owned by the caller and reused across evaluations, so
+ * that producing a policy neither hashes nor allocates.
+ */
+class GomokuPolicy {
+  public:
+    GomokuPolicy();
+    ~GomokuPolicy() = default;
+
+    /**
+     * @brief Reset Sets the probability of every action ID of the board to zero.
+     */
+    void Reset(GomokuBoardState const &board);
+
+    /**
+     * @brief operator [] Probability of the action.
+     */
+    float &operator[](GomokuActionId const action_id) {
+        assert(action_id >= 0 && static_cast<unsigned>(action_id) < num_actions_);
+        return probs_[action_id];
+    }
+
+    float operator[](GomokuActionId const action_id) const {
+        assert(action_id >= 0 && static_cast<unsigned>(action_id) < num_actions_);
+        return probs_[action_id];
+    }
+
+    /**
+     * @brief NumActions Number of action IDs the policy covers, as of the last Reset().
+     */
+    unsigned NumActions() const;
+
+    /**
+     * @brief Normalize Scales the probabilities so that they sum up to 1. The sum must be positive.
+     */
+    void Normalize();
+
+    /**
+     * @brief AssignLegal Resets the policy to the board, copies the probabilities of its legal
+     * actions from a dense array indexed by action ID, then normalizes them.
+     */
+    void AssignLegal(GomokuBoardState const &board, float const *probs);
+
+  private:
+    std::array<float, kMaxNumGomokuActions> probs_;
+    unsigned num_actions_;
+};
+
+} // namespace e8
+
+#endif // POLICY_H
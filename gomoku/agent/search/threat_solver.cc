@@ -0,0 +1,395 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <optional>
+
+#include "gomoku/agent/search/threat_solver.h"
+#include "gomoku/game/board_state.h"
+
+namespace e8 {
+namespace {
+
+// Longest sequence of fours the attacker may play.
+unsigned const kMaxVcfDepth = 24;
+
+// Number of cells a line reaches on each side of a cell when it's scanned for threats.
+int const kThreatReach = 4;
+
+unsigned const kNumDirections = 4;
+
+// Steps along a row, a column, a diagonal and an anti-diagonal.
+std::array<std::pair<int, int>, kNumDirections> const kDirections = {
+    std::make_pair(1, 0),
+    std::make_pair(0, 1),
+    std::make_pair(1, 1),
+    std::make_pair(1, -1),
+};
+
+struct Cell {
+    int x;
+    int y;
+};
+
+/**
+ * @brief The CellList struct A short list of cells which doesn't allocate. Cells beyond the
+ * capacity are counted but not kept.
+ */
+struct CellList {
+    unsigned count = 0;
+    std::array<Cell, 2 * kThreatReach> cells;
+
+    void Add(Cell const &cell) {
+        if (count < cells.size()) {
+            cells[count] = cell;
+        }
+        ++count;
+    }
+};
+
+/**
+ * @brief The ThreatBoard class The stones of each color along every line of the board, laid out
+ * like GomokuBoardState's own lines: bit x of a row, diagonal or anti-diagonal and bit y of a
+ * column are set if cell (x, y) holds a stone. Colors are indexed by StoneType - ST_BLACK.
+ */
+class ThreatBoard {
+  public:
+    explicit ThreatBoard(GomokuBoardState const &state);
+
+    int Width() const { return width_; }
+    int Height() const { return height_; }
+    unsigned NumEmpty() const { return num_empty_; }
+
+    bool Empty(Cell const &cell) const {
+        return ((lines_[0].rows[cell.y] | lines_[1].rows[cell.y]) >> cell.x & 1) == 0;
+    }
+
+    bool OnBoard(Cell const &cell) const {
+        return cell.x >= 0 && cell.x < width_ && cell.y >= 0 && cell.y < height_;
+    }
+
+    void Flip(unsigned color, Cell const &cell);
+
+    /**
+     * @brief MaxRun The longest run of the color through the cell if a stone of the color is
+     * placed there.
+     */
+    unsigned MaxRun(unsigned color, Cell const &cell) const;
+
+    /**
+     * @brief MaxWindowCount The most stones of the color among the kThreatReach cells on each side
+     * of the cell along any of the directions.
+     */
+    unsigned MaxWindowCount(unsigned color, Cell const &cell) const;
+
+    /**
+     * @brief FiveCells The empty cells where the color would make exactly five.
+     */
+    CellList FiveCells(unsigned color) const;
+
+    /**
+     * @brief FiveCellsThrough The empty cells on the lines through the cell where the color would
+     * make exactly five.
+     */
+    CellList FiveCellsThrough(unsigned color, Cell const &cell) const;
+
+    /**
+     * @brief HasOverlineCell Whether the color has an empty cell where it would make more than
+     * five. Playing there ends the game in a tie, which gets the color out of any threat.
+     */
+    bool HasOverlineCell(unsigned color) const;
+
+  private:
+    struct Lines {
+        std::array<uint16_t, kMaxBoardSideLength> rows;
+        std::array<uint16_t, kMaxBoardSideLength> columns;
+        std::array<uint16_t, 2 * kMaxBoardSideLength - 1> diagonals;
+        std::array<uint16_t, 2 * kMaxBoardSideLength - 1> anti_diagonals;
+    };
+
+    /**
+     * @brief LineThrough The line of the color through the cell along the direction, and the bit
+     * the cell takes in it.
+     */
+    std::pair<uint32_t, unsigned> LineThrough(unsigned color, Cell const &cell,
+                                              unsigned direction) const;
+
+    int const width_;
+    int const height_;
+    unsigned num_empty_;
+    std::array<Lines, 2> lines_;
+};
+
+ThreatBoard::ThreatBoard(GomokuBoardState const &state)
+    : width_(state.Width()), height_(state.Height()), num_empty_(width_ * height_),
+      lines_{} {
+    for (StoneType stone_type : {ST_BLACK, ST_WHITE}) {
+        Bitboard const &plane = state.StonePlane(stone_type);
+        for (unsigned bit = plane.NextSetBit(0); bit < kBitboardCapacity;
+             bit = plane.NextSetBit(bit + 1)) {
+            Cell cell{static_cast<int>(bit % (width_ + 1)), static_cast<int>(bit / (width_ + 1))};
+            this->Flip(stone_type - ST_BLACK, cell);
+        }
+    }
+}
+
+void ThreatBoard::Flip(unsigned const color, Cell const &cell) {
+    if (this->Empty(cell)) {
+        --num_empty_;
+    } else {
+        ++num_empty_;
+    }
+
+    Lines &lines = lines_[color];
+    lines.rows[cell.y] ^= 1U << cell.x;
+    lines.columns[cell.x] ^= 1U << cell.y;
+    lines.diagonals[cell.x - cell.y + height_ - 1] ^= 1U << cell.x;
+    lines.anti_diagonals[cell.x + cell.y] ^= 1U << cell.x;
+}
+
+std::pair<uint32_t, unsigned> ThreatBoard::LineThrough(unsigned const color, Cell const &cell,
+                                                       unsigned const direction) const {
+    Lines const &lines = lines_[color];
+    switch (direction) {
+    case 0:
+        return std::make_pair(lines.rows[cell.y], cell.x);
+    case 1:
+        return std::make_pair(lines.columns[cell.x], cell.y);
+    case 2:
+        return std::make_pair(lines.diagonals[cell.x - cell.y + height_ - 1], cell.x);
+    default:
+        return std::make_pair(lines.anti_diagonals[cell.x + cell.y], cell.x);
+    }
+}
+
+unsigned ThreatBoard::MaxRun(unsigned const color, Cell const &cell) const {
+    unsigned max_run = 0;
+    for (unsigned d = 0; d < kNumDirections; ++d) {
+        auto [line, offset] = this->LineThrough(color, cell, d);
+        line |= 1U << offset;
+
+        // Same as GomokuBoardState::MaxConnectedStonesFrom().
+        unsigned num_from = __builtin_ctz(~(line >> offset));
+        unsigned num_before = __builtin_clz(~((line << 1) << (31 - offset)));
+        max_run = std::max(max_run, num_from + num_before);
+    }
+    return max_run;
+}
+
+unsigned ThreatBoard::MaxWindowCount(unsigned const color, Cell const &cell) const {
+    unsigned max_count = 0;
+    for (unsigned d = 0; d < kNumDirections; ++d) {
+        auto [line, offset] = this->LineThrough(color, cell, d);
+        uint32_t window = (line << kThreatReach) >> offset & ((1U << (2 * kThreatReach + 1)) - 1);
+        window &= ~(1U << kThreatReach);
+        max_count = std::max<unsigned>(max_count, __builtin_popcount(window));
+    }
+    return max_count;
+}
+
+CellList ThreatBoard::FiveCells(unsigned const color) const {
+    CellList fives;
+    for (int y = 0; y < height_; ++y) {
+        for (int x = 0; x < width_; ++x) {
+            Cell const cell{x, y};
+            if (this->Empty(cell) && this->MaxWindowCount(color, cell) >= 4 &&
+                this->MaxRun(color, cell) == 5) {
+                fives.Add(cell);
+            }
+        }
+    }
+    return fives;
+}
+
+CellList ThreatBoard::FiveCellsThrough(unsigned const color, Cell const &cell) const {
+    CellList fives;
+    for (auto const &[dx, dy] : kDirections) {
+        for (int k = -kThreatReach; k <= kThreatReach; ++k) {
+            Cell const other{cell.x + k * dx, cell.y + k * dy};
+            if (k != 0 && this->OnBoard(other) && this->Empty(other) &&
+                this->MaxRun(color, other) == 5) {
+                fives.Add(other);
+            }
+        }
+    }
+    return fives;
+}
+
+bool ThreatBoard::HasOverlineCell(unsigned const color) const {
+    for (int y = 0; y < height_; ++y) {
+        for (int x = 0; x < width_; ++x) {
+            Cell const cell{x, y};
+            if (this->Empty(cell) && this->MaxWindowCount(color, cell) >= 5 &&
+                this->MaxRun(color, cell) > 5) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief The VcfSearch class A depth-first search over the attacker's fours. The defender's reply
+ * to a four is forced, so it isn't branched on.
+ */
+class VcfSearch {
+  public:
+    VcfSearch(ThreatBoard *board, unsigned max_nodes) : board_(board), max_nodes_(max_nodes) {}
+
+    /**
+     * @brief AttackerWins Whether the attacker, who is to move, has a VCF. The first move of the
+     * sequence is written to first_move if it isn't nullptr.
+     */
+    bool AttackerWins(unsigned attacker, unsigned depth, std::optional<Cell> *first_move);
+
+  private:
+    bool FourWins(unsigned attacker, Cell const &four, unsigned depth);
+
+    ThreatBoard *board_;
+    unsigned const max_nodes_;
+    unsigned num_nodes_ = 0;
+};
+
+bool VcfSearch::AttackerWins(unsigned const attacker, unsigned const depth,
+                             std::optional<Cell> *first_move) {
+    CellList const own_fives = board_->FiveCells(attacker);
+    if (own_fives.count > 0) {
+        if (first_move != nullptr) {
+            *first_move = own_fives.cells[0];
+        }
+        return true;
+    }
+
+    if (depth == 0 || ++num_nodes_ > max_nodes_) {
+        return false;
+    }
+
+    CellList const defender_fives = board_->FiveCells(1 - attacker);
+    if (defender_fives.count >= 2) {
+        return false;
+    }
+
+    for (int y = 0; y < board_->Height(); ++y) {
+        for (int x = 0; x < board_->Width(); ++x) {
+            Cell const cell{x, y};
+
+            // The attacker has to block the defender's four, with a four.
+            if (defender_fives.count == 1 &&
+                (cell.x != defender_fives.cells[0].x || cell.y != defender_fives.cells[0].y)) {
+                continue;
+            }
+            if (!board_->Empty(cell) || board_->MaxWindowCount(attacker, cell) < 3 ||
+                board_->MaxRun(attacker, cell) > 5) {
+                continue;
+            }
+
+            if (this->FourWins(attacker, cell, depth)) {
+                if (first_move != nullptr) {
+                    *first_move = cell;
+                }
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool VcfSearch::FourWins(unsigned const attacker, Cell const &four, unsigned const depth) {
+    unsigned const defender = 1 - attacker;
+
+    board_->Flip(attacker, four);
+    CellList const threats = board_->FiveCellsThrough(attacker, four);
+
+    bool wins = false;
+    if (board_->HasOverlineCell(defender)) {
+        // The defender answers with an overline anywhere and ties the game.
+    } else if (threats.count >= 2 && threats.count <= threats.cells.size()) {
+        // The defender can only block one of the threats, unless blocking ends the game.
+        wins = true;
+        for (unsigned i = 0; i < threats.count; ++i) {
+            if (board_->MaxRun(defender, threats.cells[i]) >= 5) {
+                wins = false;
+            }
+        }
+    } else if (threats.count == 1 && board_->MaxRun(defender, threats.cells[0]) < 5) {
+        board_->Flip(defender, threats.cells[0]);
+        if (board_->NumEmpty() > 0) {
+            wins = this->AttackerWins(attacker, depth - 1, /*first_move=*/nullptr);
+        }
+        board_->Flip(defender, threats.cells[0]);
+    }
+
+    board_->Flip(attacker, four);
+    return wins;
+}
+
+} // namespace
+
+ThreatSolution SolveThreats(GomokuBoardState const &state, unsigned const max_nodes) {
+    ThreatSolution solution;
+    if (state.CurrentGamePhase() != GP_STANDARD_GOMOKU ||
+        state.CurrentGameResult() != GR_UNDETERMINED) {
+        return solution;
+    }
+
+    ThreatBoard board(state);
+    unsigned const mover = state.PlayerStoneType(state.CurrentPlayerSide()) - ST_BLACK;
+    unsigned const opponent = 1 - mover;
+
+    VcfSearch search(&board, max_nodes);
+
+    std::optional<Cell> first_move;
+    if (search.AttackerWins(mover, kMaxVcfDepth, &first_move)) {
+        solution.proof = TP_WIN;
+        solution.winning_action = state.MovePositionToActionId(MovePosition(
+            static_cast<int8_t>(first_move->x), static_cast<int8_t>(first_move->y)));
+        return solution;
+    }
+
+    // The mover can't make five at this point, but an overline still saves the game.
+    if (board.HasOverlineCell(mover)) {
+        return solution;
+    }
+
+    CellList const opponent_fives = board.FiveCells(opponent);
+    if (opponent_fives.count >= 2) {
+        solution.proof = TP_LOSS;
+        return solution;
+    }
+
+    if (opponent_fives.count == 1) {
+        Cell const block = opponent_fives.cells[0];
+        if (board.MaxRun(mover, block) > 5) {
+            // Blocking ends the game in a tie.
+            return solution;
+        }
+
+        board.Flip(mover, block);
+        if (board.NumEmpty() > 0 &&
+            search.AttackerWins(opponent, kMaxVcfDepth, /*first_move=*/nullptr)) {
+            solution.proof = TP_LOSS;
+        }
+        board.Flip(mover, block);
+    }
+
+    return solution;
+}
+
+} // namespace e8
@@ -0,0 +1,73 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef THREAT_SOLVER_H
+#define THREAT_SOLVER_H
+
+#include <optional>
+
+#include "gomoku/game/board_state.h"
+
+namespace e8 {
+
+// Number of attacker positions a SolveThreats() call may visit before it gives up.
+static unsigned const kDefaultThreatSolverBudget = 256;
+
+/**
+ * @brief The ThreatProof enum The outcome of the threat-space search in the perspective of the
+ * player to move.
+ */
+enum ThreatProof {
+    // Neither side has a forced win by a sequence of fours.
+    TP_UNPROVEN,
+
+    // The player to move wins by a sequence of fours, starting with ThreatSolution::winning_action.
+    TP_WIN,
+
+    // Every move of the player to move loses, unless the move itself ends the game.
+    TP_LOSS,
+};
+
+/**
+ * @brief The ThreatSolution struct What SolveThreats() proved about a state.
+ */
+struct ThreatSolution {
+    ThreatProof proof = TP_UNPROVEN;
+
+    // The first move of the winning sequence. It's only set when the proof is TP_WIN.
+    std::optional<GomokuActionId> winning_action;
+};
+
+/**
+ * @brief SolveThreats Searches for a victory by continuous fours (VCF) from a GP_STANDARD_GOMOKU
+ * state. A four leaves the defender a single cell to block, so the search only branches on the
+ * attacker's moves and stays small. The rules follow GomokuBoardState: exactly five stones in a
+ * row win and an overline ends the game in a tie.
+ *
+ * The player to move is proven to win if it has a VCF, which includes making five and open fours.
+ * It's proven to lose if it can't make five and the opponent either has two cells to make five,
+ * or has one and a VCF after it's blocked. States of other phases are left unproven.
+ *
+ * @param max_nodes Number of attacker positions the search may visit. When the budget runs out,
+ * the rest of the search space is taken as unproven.
+ */
+ThreatSolution SolveThreats(GomokuBoardState const &state,
+                            unsigned max_nodes = kDefaultThreatSolverBudget);
+
+} // namespace e8
+
+#endif // THREAT_SOLVER_H
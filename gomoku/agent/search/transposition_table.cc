@@ -0,0 +1,136 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+
+#include "gomoku/agent/search/mct_node.h"
+#include "gomoku/agent/search/transposition_table.h"
+
+namespace e8 {
+namespace {
+
+// Number of consecutive entries probed for a state.
+unsigned const kBucketSize = 8;
+
+uint32_t const kNoReward = 0xFFFFFFFF;
+
+uint32_t FloatBits(float const value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+float BitsToFloat(uint32_t const bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Zero is reserved for empty entries.
+uint64_t EntryKey(uint64_t const hash) { return hash != 0 ? hash : 1; }
+
+} // namespace
+
+MctTranspositionTable::MctTranspositionTable(unsigned const capacity)
+    : entries_(std::make_unique<Entry[]>(capacity)), capacity_(capacity), size_(0) {
+    assert(capacity_ >= kBucketSize && (capacity_ & (capacity_ - 1)) == 0);
+    this->Clear();
+}
+
+MctTranspositionTable::~MctTranspositionTable() {}
+
+MctTranspositionTable::Entry *MctTranspositionTable::Find(uint64_t const hash) {
+    uint64_t const key = EntryKey(hash);
+    for (unsigned i = 0; i < kBucketSize; ++i) {
+        Entry *entry = &entries_[(key + i) & (capacity_ - 1)];
+        uint64_t const entry_key = entry->key.load(std::memory_order_acquire);
+        if (entry_key == key) {
+            return entry;
+        }
+        if (entry_key == 0) {
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+MctTranspositionTable::Entry *MctTranspositionTable::FindOrInsert(uint64_t const hash) {
+    uint64_t const key = EntryKey(hash);
+    for (unsigned i = 0; i < kBucketSize; ++i) {
+        Entry *entry = &entries_[(key + i) & (capacity_ - 1)];
+        uint64_t entry_key = entry->key.load(std::memory_order_acquire);
+        if (entry_key == 0 && entry->key.compare_exchange_strong(entry_key, key,
+                                                                 std::memory_order_acq_rel)) {
+            size_.fetch_add(1, std::memory_order_relaxed);
+            return entry;
+        }
+        // Either the entry was occupied or another thread has just claimed it.
+        if (entry_key == key) {
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+void MctTranspositionTable::AddVisit(float const reward, Entry *entry) {
+    uint64_t stats = entry->stats.load(std::memory_order_relaxed);
+    uint64_t updated;
+    do {
+        uint32_t const num_visits = stats >> 32;
+        float const summed_reward = BitsToFloat(static_cast<uint32_t>(stats));
+        updated = static_cast<uint64_t>(num_visits + 1) << 32 | FloatBits(summed_reward + reward);
+    } while (!entry->stats.compare_exchange_weak(stats, updated, std::memory_order_relaxed));
+}
+
+std::pair<uint32_t, float> MctTranspositionTable::Visits(Entry const &entry) {
+    uint64_t const stats = entry.stats.load(std::memory_order_relaxed);
+    return std::make_pair(static_cast<uint32_t>(stats >> 32),
+                          BitsToFloat(static_cast<uint32_t>(stats)));
+}
+
+void MctTranspositionTable::SetReward(float const reward, Entry *entry) {
+    entry->reward.store(FloatBits(reward), std::memory_order_relaxed);
+}
+
+std::optional<float> MctTranspositionTable::Reward(Entry const &entry) {
+    uint32_t const bits = entry.reward.load(std::memory_order_relaxed);
+    if (bits == kNoReward) {
+        return std::nullopt;
+    }
+    return BitsToFloat(bits);
+}
+
+unsigned MctTranspositionTable::Size() const { return size_.load(std::memory_order_relaxed); }
+
+unsigned MctTranspositionTable::Capacity() const { return capacity_; }
+
+void MctTranspositionTable::Clear() {
+    for (unsigned i = 0; i < capacity_; ++i) {
+        entries_[i].key.store(0, std::memory_order_relaxed);
+        entries_[i].stats.store(FloatBits(0.0f), std::memory_order_relaxed);
+        entries_[i].reward.store(kNoReward, std::memory_order_relaxed);
+        entries_[i].expanded_node.store(0, std::memory_order_relaxed);
+    }
+    size_.store(0, std::memory_order_relaxed);
+}
+
+} // namespace e8
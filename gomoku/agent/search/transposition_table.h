@@ -0,0 +1,123 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+#include "gomoku/agent/search/mct_node.h"
+#include "gomoku/game/board_state.h"
+
+namespace e8 {
+
+/**
+ * @brief The MctTranspositionTable class A bounded, lock-free hash table keyed by the board state's
+ * Zobrist hash. It shares the search statistics and the evaluator results among the tree nodes
+ * which are transpositions of each other, including the nodes of earlier searches.
+ *
+ * Entries are claimed by a compare-and-swap on the key and are never evicted while a search is
+ * running, so a reader can't observe the fields of an entry being reused by another state. When a
+ * bucket is full, the state is simply not recorded.
+ */
+class MctTranspositionTable {
+  public:
+    /**
+     * @brief The Entry struct The statistics of a board state.
+     */
+    struct Entry {
+        // Zobrist hash of the board state. Zero marks an empty entry.
+        std::atomic<uint64_t> key;
+
+        // Visit count in the upper 32 bits and the float bits of the summed reward viewed by
+        // PS_PLAYER_A in the lower 32 bits, so that they are updated together.
+        std::atomic<uint64_t> stats;
+
+        // Float bits of the evaluator's reward estimate viewed by the player to move, or
+        // kNoReward.
+        std::atomic<uint32_t> reward;
+
+        // A node holding the evaluator's policy in its children, or zero.
+        std::atomic<MctNodeId> expanded_node;
+    };
+
+    /**
+     * @brief MctTranspositionTable Allocates a table of the specified number of entries.
+     *
+     * @param capacity Must be a power of 2.
+     */
+    explicit MctTranspositionTable(unsigned capacity);
+    ~MctTranspositionTable();
+
+    /**
+     * @brief Find Returns the entry of the state or nullptr if it's not in the table.
+     */
+    Entry *Find(uint64_t hash);
+
+    /**
+     * @brief FindOrInsert Returns the entry of the state. It returns nullptr if the state isn't
+     * in the table and the table has no room for it.
+     */
+    Entry *FindOrInsert(uint64_t hash);
+
+    /**
+     * @brief AddVisit Records a visit with the reward viewed by PS_PLAYER_A.
+     */
+    static void AddVisit(float reward, Entry *entry);
+
+    /**
+     * @brief Visits Loads the visit count and the summed reward viewed by PS_PLAYER_A.
+     */
+    static std::pair<uint32_t, float> Visits(Entry const &entry);
+
+    /**
+     * @brief SetReward Records the evaluator's reward estimate.
+     */
+    static void SetReward(float reward, Entry *entry);
+
+    /**
+     * @brief Reward Loads the evaluator's reward estimate if there is one.
+     */
+    static std::optional<float> Reward(Entry const &entry);
+
+    /**
+     * @brief Size The number of states in the table.
+     */
+    unsigned Size() const;
+
+    /**
+     * @brief Capacity The maximum number of states the table can hold.
+     */
+    unsigned Capacity() const;
+
+    /**
+     * @brief Clear Removes all the states. It must not run concurrently with other operations.
+     */
+    void Clear();
+
+  private:
+    std::unique_ptr<Entry[]> entries_;
+    unsigned const capacity_;
+    std::atomic<unsigned> size_;
+};
+
+} // namespace e8
+
+#endif // TRANSPOSITION_TABLE_H
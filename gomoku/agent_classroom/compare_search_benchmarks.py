@@ -0,0 +1,81 @@
+#!/bin/python3
+
+import argparse
+import json
+import logging
+
+# Metrics reported by search_benchmark_main, and whether a larger value is better.
+METRICS = [
+    ("simulations_per_sec", True),
+    ("reward_p50_us", False),
+    ("reward_p99_us", False),
+    ("policy_p50_us", False),
+    ("policy_p99_us", False),
+    ("bytes_per_node", False),
+    ("allocations_per_simulation", False),
+]
+
+def ReadResults(file_path: str) -> dict:
+    results = dict()
+    with open(file_path, "r") as f:
+        for line in f:
+            if not line.strip():
+                continue
+            result = json.loads(line)
+            key = (result["evaluator"], result["position"], result["num_workers"])
+            results[key] = result
+    return results
+
+def CompareResults(baseline: dict, candidate: dict, threshold: float) -> int:
+    num_regressions = 0
+    for key in sorted(baseline.keys() & candidate.keys()):
+        evaluator, position, num_workers = key
+        for metric, larger_is_better in METRICS:
+            base_value = baseline[key][metric]
+            new_value = candidate[key][metric]
+            if base_value == 0:
+                continue
+
+            ratio = new_value / base_value
+            regressed = ratio < 1 - threshold if larger_is_better else ratio > 1 + threshold
+            if regressed:
+                num_regressions += 1
+            print("{0} {1} num_workers={2} {3}: {4:.4g} -> {5:.4g} ({6:+.1f}%){7}".format(
+                evaluator, position, num_workers, metric, base_value, new_value,
+                100*(ratio - 1), " REGRESSION" if regressed else ""))
+
+    for key in sorted(baseline.keys() - candidate.keys()):
+        logging.warning("Missing from the candidate: {0}".format(key))
+    return num_regressions
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        description="Compares two result files written by search_benchmark_main's "
+                    "--output_file and flags the metrics which got worse.")
+    parser.add_argument("--baseline",
+        type=str,
+        help="Path to the result file of the baseline run.")
+    parser.add_argument("--candidate",
+        type=str,
+        help="Path to the result file of the run to compare against the baseline.")
+    parser.add_argument("--threshold",
+        type=float,
+        default=0.05,
+        help="Relative change beyond which a metric counts as a regression.")
+
+    logging.basicConfig(level=logging.INFO,
+                        format="%(asctime)s %(levelname)s %(message)s")
+
+    args = parser.parse_args()
+
+    if args.baseline is None or args.candidate is None:
+        logging.error("Arguments baseline and candidate are required.")
+        parser.print_help()
+        exit(-1)
+
+    num_regressions = CompareResults(
+        baseline=ReadResults(args.baseline),
+        candidate=ReadResults(args.candidate),
+        threshold=args.threshold)
+    logging.info("num_regressions={0}".format(num_regressions))
+    exit(1 if num_regressions > 0 else 0)
@@ -17,63 +17,96 @@
 
 #include <cassert>
 #include <chrono>
-#include <list>
+#include <cstdint>
+#include <functional>
+#include <iostream>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <thread>
-#include <unordered_map>
 #include <vector>
 
 #include "gomoku/agent/heuristics/shl_feature.h"
 #include "gomoku/agent/search/mct_node.h"
 #include "gomoku/agent/search/mct_search.h"
+#include "gomoku/agent/search/policy.h"
 #include "gomoku/agent_classroom/learning_material_generator.h"
 #include "gomoku/game/board_state.h"
+#include "gomoku/game/board_symmetry.h"
 #include "gomoku/game/game.h"
 #include "gomoku/game/game_instance_container.h"
 #include "gomoku/logging/common_types.h"
 #include "gomoku/logging/game_log_store.h"
+#include "gomoku/logging/self_play_record_store.h"
 #include "postgres/query_runner/connection/connection_factory.h"
 #include "postgres/query_runner/connection/pooled_connection_reservoir.h"
 
 namespace e8 {
 namespace {
 
+// About 50MB per shard on an 11x11 board.
+unsigned const kRecordsPerShard = 1 << 14;
+
+// How often the generation progress is reported.
+std::chrono::seconds const kStatsInterval(60);
+
 /**
- * @brief The LearningMaterialGeneratorSharedData struct Data shared between the two
- * LearningMaterialGenerator players so that only one copy of data is required to be maintained.
- * Both LearningMaterialGenerator players will share the Monte Carlo Searcher states during data
- * generation.
+ * @brief The LearningMaterialSession struct Data shared by all the games of a
+ * GenerateLearningMaterial() call. The games run concurrently.
  */
-struct LearningMaterialGeneratorSharedData {
-    LearningMaterialGeneratorSharedData(GameLogPurpose game_purpose,
-                                        std::optional<ModelId> model_id, unsigned target_num_games,
-                                        std::unique_ptr<MctSearcher> &&searcher,
-                                        bool early_termination, GameLogStore *log_store);
-
-    struct StepInfo {
-        StepInfo(GameStepNumber step_number, PlayerSide action_performer);
+struct LearningMaterialSession {
+    LearningMaterialSession(GameLogPurpose game_purpose, std::optional<ModelId> model_id,
+                            unsigned target_num_games, bool early_termination,
+                            bool symmetry_augmentation, GameLogStore *log_store,
+                            SelfPlayRecordWriter *record_writer);
 
-        GameStepNumber const step_number;
-        PlayerSide const action_performer;
-    };
+    /**
+     * @brief ClaimGame Reserves one of the target number of games. It returns false when all of
+     * them are claimed.
+     */
+    bool ClaimGame();
 
     GameLogPurpose const game_purpose;
     std::optional<ModelId> const model_id;
     unsigned const target_num_games;
-    std::unique_ptr<MctSearcher> searcher;
     bool const early_termination;
+    bool const symmetry_augmentation;
     GameLogStore *const log_store;
 
-    unsigned current_num_games;
+    // Guards the fields below.
+    std::mutex lock;
+    SelfPlayRecordWriter *const record_writer;
+    unsigned num_games_claimed;
+    unsigned num_games_ended;
+};
+
+/**
+ * @brief The LearningMaterialGeneratorSharedData struct Data shared between the two
+ * LearningMaterialGenerator players of a game so that only one copy of data is required to be
+ * maintained. Both LearningMaterialGenerator players will share the Monte Carlo Searcher states
+ * during data generation.
+ */
+struct LearningMaterialGeneratorSharedData {
+    LearningMaterialGeneratorSharedData(LearningMaterialSession *session,
+                                        std::unique_ptr<MctSearcher> &&searcher);
+
+    LearningMaterialSession *const session;
+    std::unique_ptr<MctSearcher> searcher;
+
     std::optional<GameId> current_game_id;
-    std::list<StepInfo> steps;
+
+    // Whether the game has claimed another game from the session after its current one.
+    bool another_game_claimed;
+
+    // Records of the current game. Their values are filled in when the game ends.
+    std::vector<SelfPlayRecord> records;
 };
 
 /**
  * @brief The LearningMaterialGenerator class A Gomoku game player that produces example game and
- * action data by self playing then store them into the specified log store.
+ * action data by self playing. The games are logged into the log store, whereas the actions are
+ * written to the self-play record shards.
  */
 class LearningMaterialGenerator : public GomokuPlayerInterface {
   public:
@@ -114,16 +147,68 @@ class LearningMaterialGenerator : public GomokuPlayerInterface {
     RandomSource random_source_;
 };
 
-LearningMaterialGeneratorSharedData::LearningMaterialGeneratorSharedData(
-    GameLogPurpose game_purpose, std::optional<ModelId> model_id, unsigned target_num_games,
-    std::unique_ptr<MctSearcher> &&searcher, bool early_termination, GameLogStore *log_store)
+LearningMaterialSession::LearningMaterialSession(GameLogPurpose game_purpose,
+                                                 std::optional<ModelId> model_id,
+                                                 unsigned target_num_games, bool early_termination,
+                                                 bool symmetry_augmentation,
+                                                 GameLogStore *log_store,
+                                                 SelfPlayRecordWriter *record_writer)
     : game_purpose(game_purpose), model_id(model_id), target_num_games(target_num_games),
-      searcher(std::move(searcher)), early_termination(early_termination), log_store(log_store),
-      current_num_games(0) {}
+      early_termination(early_termination), symmetry_augmentation(symmetry_augmentation),
+      log_store(log_store), record_writer(record_writer), num_games_claimed(0),
+      num_games_ended(0) {}
+
+bool LearningMaterialSession::ClaimGame() {
+    std::lock_guard<std::mutex> guard(lock);
+    if (num_games_claimed >= target_num_games) {
+        return false;
+    }
+    ++num_games_claimed;
+    return true;
+}
+
+LearningMaterialGeneratorSharedData::LearningMaterialGeneratorSharedData(
+    LearningMaterialSession *session, std::unique_ptr<MctSearcher> &&searcher)
+    : session(session), searcher(std::move(searcher)), another_game_claimed(false) {}
+
+/**
+ * @brief AppendSymmetricRecords Appends the record as well as its images under every symmetry the
+ * board has. Images that coincide with an earlier one, as it happens to symmetric positions, are
+ * dropped so that they don't get over-weighted.
+ */
+void AppendSymmetricRecords(SelfPlayRecord const &record, std::vector<SelfPlayRecord> *records) {
+    size_t const first = records->size();
+    records->push_back(record);
 
-LearningMaterialGeneratorSharedData::StepInfo::StepInfo(GameStepNumber step_number,
-                                                        PlayerSide action_performer)
-    : step_number(step_number), action_performer(action_performer) {}
+    int16_t const width = record.board_width;
+    int16_t const height = record.board_height;
+
+    for (unsigned i = 1; i < kNumBoardSymmetries; ++i) {
+        BoardSymmetry symmetry = static_cast<BoardSymmetry>(i);
+        if (!SymmetryApplies(symmetry, width, height)) {
+            continue;
+        }
+
+        SelfPlayRecord image = record;
+        image.symmetry = symmetry;
+        image.action_id = TransformActionId(record.action_id, symmetry, width, height);
+        TransformCellPlanes(record.board.data(), /*num_channels=*/1, symmetry, width, height,
+                            image.board.data());
+        TransformFlatPolicy(record.policy.data(), symmetry, width, height, image.policy.data());
+        TransformCellPlanes(record.shl_map.data(), /*num_channels=*/4, symmetry, width, height,
+                            image.shl_map.data());
+
+        bool duplicate = false;
+        for (size_t j = first; j < records->size() && !duplicate; ++j) {
+            SelfPlayRecord const &other = (*records)[j];
+            duplicate = other.board == image.board && other.policy == image.policy &&
+                        other.shl_map == image.shl_map;
+        }
+        if (!duplicate) {
+            records->push_back(std::move(image));
+        }
+    }
+}
 
 LearningMaterialGenerator::LearningMaterialGenerator(
     std::shared_ptr<LearningMaterialGeneratorSharedData> const &shared_data,
@@ -131,22 +216,23 @@ LearningMaterialGenerator::LearningMaterialGenerator(
     : shared_data_(shared_data), player_side_(player_side), random_source_() {}
 
 unsigned LearningMaterialGenerator::NumGamesProduced() const {
-    return shared_data_->current_num_games;
+    std::lock_guard<std::mutex> guard(shared_data_->session->lock);
+    return shared_data_->session->num_games_ended;
 }
 
 void LearningMaterialGenerator::OnGomokuGameBegin(GomokuBoardState const & /*board_state*/) {
     shared_data_->searcher->Reset();
 
     if (!shared_data_->current_game_id.has_value()) {
-        shared_data_->current_game_id = shared_data_->log_store->LogNewGeneratorGame(
-            shared_data_->game_purpose, shared_data_->model_id, shared_data_->model_id);
+        LearningMaterialSession *session = shared_data_->session;
+        shared_data_->current_game_id = session->log_store->LogNewGeneratorGame(
+            session->game_purpose, session->model_id, session->model_id);
     }
 }
 
-std::optional<std::unordered_map<GomokuActionId, float>>
-FindWinningPolicy(GomokuBoardState board_state) {
+bool FindWinningPolicy(GomokuBoardState board_state, GomokuPolicy *policy) {
     PlayerSide player_side = board_state.CurrentPlayerSide();
-    std::unordered_map<GomokuActionId, GomokuAction> actions = board_state.LegalActions();
+    GomokuActionSet actions = board_state.LegalActions();
 
     for (auto [action_id, _] : actions) {
         GameResult game_result =
@@ -157,24 +243,19 @@ FindWinningPolicy(GomokuBoardState board_state) {
              player_side == PlayerSide::PS_PLAYER_A) ||
             (game_result == GameResult::GR_PLAYER_B_WIN &&
              player_side == PlayerSide::PS_PLAYER_B)) {
-            return std::unordered_map<GomokuActionId, float>({std::make_pair(action_id, 1.0f)});
+            policy->Reset(board_state);
+            (*policy)[action_id] = 1.0f;
+            return true;
         }
     }
 
-    return std::nullopt;
+    return false;
 }
 
 GomokuActionId LearningMaterialGenerator::NextPlayerAction(GomokuBoardState const &board_state) {
-    std::optional<std::unordered_map<GomokuActionId, float>> winning_policy;
-    if (shared_data_->early_termination) {
-        winning_policy = FindWinningPolicy(board_state);
-    }
-
-    std::unordered_map<GomokuActionId, float> policy;
-    if (winning_policy.has_value()) {
-        policy = *winning_policy;
-    } else {
-        policy = shared_data_->searcher->SearchFrom(board_state, /*temperature=*/1.0f);
+    GomokuPolicy policy;
+    if (!shared_data_->session->early_termination || !FindWinningPolicy(board_state, &policy)) {
+        shared_data_->searcher->SearchFrom(board_state, /*temperature=*/1.0f, &policy);
     }
 
     // Selects the action based on the policy distribution in the first 30 moves so as to explore
@@ -186,26 +267,35 @@ GomokuActionId LearningMaterialGenerator::NextPlayerAction(GomokuBoardState cons
         action_id = BestAction(policy);
     }
 
-    // Extracts serializable SHL features.
-    ShlFeatureBuilder feature_builder(board_state);
-    std::vector<float> shl_map =
-        feature_builder.TopKMapDense(/*top_k=*/15, /*normalized=*/true,
-                                     /*next_move_stone_type=*/std::nullopt);
-    std::vector<float> top_shl_features = feature_builder.TopKShlPositionlessFeatures(
-        /*top_k=*/15, /*normalized=*/true, /*next_move_stone_type=*/std::nullopt);
+    SelfPlayRecord record;
+    record.game_id = *shared_data_->current_game_id;
+    record.step_number = board_state.History().size();
+    record.action_id = action_id;
+    record.action_performer = board_state.CurrentPlayerSide();
+    record.action_stone_type = board_state.PlayerStoneType(board_state.CurrentPlayerSide());
+    record.game_phase = board_state.CurrentGamePhase();
+    record.symmetry = BS_IDENTITY;
+
+    record.board_width = board_state.Width();
+    record.board_height = board_state.Height();
+    record.board.reserve(board_state.Width() * board_state.Height());
+    for (int16_t y = 0; y < board_state.Height(); ++y) {
+        for (int16_t x = 0; x < board_state.Width(); ++x) {
+            record.board.push_back(*board_state.ChessPieceStateAt(MovePosition(x, y)));
+        }
+    }
 
     // Extracts serializable policy.
-    auto flattened_policy = FlattenPolicy(policy, board_state);
-
-    GameStepNumber step_number = board_state.History().size();
+    record.policy = FlattenPolicy(policy);
 
-    shared_data_->log_store->LogGameAction(
-        *shared_data_->current_game_id, step_number, action_id, board_state.CurrentPlayerSide(),
-        board_state.PlayerStoneType(board_state.CurrentPlayerSide()), board_state,
-        board_state.CurrentGamePhase(), shl_map, top_shl_features, flattened_policy);
+    // Extracts serializable SHL features.
+    ShlFeatureBuilder feature_builder(board_state);
+    record.shl_map = feature_builder.TopKMapDense(/*top_k=*/15, /*normalized=*/true,
+                                                  /*next_move_stone_type=*/std::nullopt);
+    record.top_shl_features = feature_builder.TopKShlPositionlessFeatures(
+        /*top_k=*/15, /*normalized=*/true, /*next_move_stone_type=*/std::nullopt);
 
-    shared_data_->steps.push_back(LearningMaterialGeneratorSharedData::StepInfo(
-        step_number, board_state.CurrentPlayerSide()));
+    shared_data_->records.push_back(std::move(record));
 
     return action_id;
 }
@@ -226,36 +316,20 @@ void LearningMaterialGenerator::OnGameEnded(GomokuBoardState const &board_state)
         return;
     }
 
-    for (auto const &step : shared_data_->steps) {
+    for (SelfPlayRecord &record : shared_data_->records) {
+        record.num_game_steps = board_state.History().size();
+
         switch (board_state.CurrentGameResult()) {
         case GR_PLAYER_A_WIN: {
-            if (step.action_performer == PlayerSide::PS_PLAYER_A) {
-                shared_data_->log_store->LogGameActionValue(*shared_data_->current_game_id,
-                                                            step.step_number,
-                                                            /*final_value=*/1.0f);
-            } else {
-                shared_data_->log_store->LogGameActionValue(*shared_data_->current_game_id,
-                                                            step.step_number,
-                                                            /*final_value=*/-1.0f);
-            }
+            record.value = record.action_performer == PlayerSide::PS_PLAYER_A ? 1.0f : -1.0f;
             break;
         }
         case GR_PLAYER_B_WIN: {
-            if (step.action_performer == PlayerSide::PS_PLAYER_B) {
-                shared_data_->log_store->LogGameActionValue(*shared_data_->current_game_id,
-                                                            step.step_number,
-                                                            /*final_value=*/1.0f);
-            } else {
-                shared_data_->log_store->LogGameActionValue(*shared_data_->current_game_id,
-                                                            step.step_number,
-                                                            /*final_value=*/-1.0f);
-            }
+            record.value = record.action_performer == PlayerSide::PS_PLAYER_B ? 1.0f : -1.0f;
             break;
         }
         case GR_TIE: {
-            shared_data_->log_store->LogGameActionValue(*shared_data_->current_game_id,
-                                                        step.step_number,
-                                                        /*final_value=*/0.0f);
+            record.value = 0.0f;
             break;
         }
         case GR_UNDETERMINED: {
@@ -265,44 +339,108 @@ void LearningMaterialGenerator::OnGameEnded(GomokuBoardState const &board_state)
         }
     }
 
-    shared_data_->log_store->LogGameEnd(*shared_data_->current_game_id,
-                                        board_state.History().size(),
-                                        board_state.CurrentGameResult());
+    LearningMaterialSession *session = shared_data_->session;
+
+    std::vector<SelfPlayRecord> augmented_records;
+    if (session->symmetry_augmentation) {
+        augmented_records.reserve(shared_data_->records.size() * kNumBoardSymmetries);
+        for (SelfPlayRecord const &record : shared_data_->records) {
+            AppendSymmetricRecords(record, &augmented_records);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(session->lock);
+        session->record_writer->AppendGame(session->symmetry_augmentation ? augmented_records
+                                                                          : shared_data_->records);
+        ++session->num_games_ended;
+    }
+
+    session->log_store->LogGameEnd(*shared_data_->current_game_id, board_state.History().size(),
+                                   board_state.CurrentGameResult());
 
     shared_data_->current_game_id = std::nullopt;
-    ++shared_data_->current_num_games;
-    shared_data_->steps.clear();
+    shared_data_->records.clear();
+
+    // Both players are asked, so the claim is made once here.
+    shared_data_->another_game_claimed = session->ClaimGame();
 }
 
-bool LearningMaterialGenerator::WantAnotherGame() {
-    return shared_data_->current_num_games < shared_data_->target_num_games;
+bool LearningMaterialGenerator::WantAnotherGame() { return shared_data_->another_game_claimed; }
+
+/**
+ * @brief SelfPlayShardPrefix Keeps the shards of different purposes apart, so that generators of
+ * different purposes can run at the same time.
+ */
+std::string SelfPlayShardPrefix(GameLogPurpose log_purpose) {
+    switch (log_purpose) {
+    case GLP_REPRESENTATIVE_DATA: {
+        return "representative";
+    }
+    case GLP_LEARNING_DATA: {
+        return "learning";
+    }
+    case GLP_ACTUAL_RUN: {
+        return "actual_run";
+    }
+    }
+
+    assert(false);
+    return std::string();
 }
 
 } // namespace
 
-void GenerateLearningMaterial(GameLogPurpose log_purpose, std::optional<ModelId> model_id,
-                              std::shared_ptr<GomokuEvaluatorInterface> const &evaluator,
-                              bool early_termination, GameInstanceContainer::ScheduleId schedule_id,
-                              unsigned target_num_games, std::string const &db_host_name,
-                              std::string const &db_name, GameInstanceContainer *container) {
+void GenerateLearningMaterial(
+    GameLogPurpose log_purpose, std::optional<ModelId> model_id,
+    std::function<std::shared_ptr<GomokuEvaluatorInterface>()> const &evaluator_factory,
+    bool early_termination, bool symmetry_augmentation, unsigned num_concurrent_games,
+    GameInstanceContainer::ScheduleId schedule_id, unsigned target_num_games,
+    std::string const &db_host_name, std::string const &db_name, std::string const &record_path,
+    GameInstanceContainer *container) {
+    assert(num_concurrent_games > 0);
+
     PooledConnectionReservoir conns(
         ConnectionFactory(ConnectionFactory::PQ, db_host_name, db_name));
 
     GameLogStore log_store(&conns);
+    SelfPlayRecordWriter record_writer(record_path, SelfPlayShardPrefix(log_purpose),
+                                       kRecordsPerShard);
+    LearningMaterialSession session(log_purpose, model_id, target_num_games, early_termination,
+                                    symmetry_augmentation, &log_store, &record_writer);
+
+    // Every game claims its first game upfront, so no more than target_num_games are started.
+    for (unsigned i = 0; i < num_concurrent_games && session.ClaimGame(); ++i) {
+        auto searcher = std::make_unique<MctSearcher>(evaluator_factory(),
+                                                      /*print_stats=*/num_concurrent_games == 1);
+        auto generator_data =
+            std::make_shared<LearningMaterialGeneratorSharedData>(&session, std::move(searcher));
+
+        auto generator_game = std::make_unique<GomokuGame>(
+            std::make_shared<LearningMaterialGenerator>(generator_data, PlayerSide::PS_PLAYER_A),
+            std::make_shared<LearningMaterialGenerator>(generator_data, PlayerSide::PS_PLAYER_B));
+        container->ScheduleToRun(schedule_id, std::move(generator_game));
+    }
 
-    auto searcher = std::make_unique<MctSearcher>(evaluator, /*print_stats=*/true);
-    auto generator_data = std::make_shared<LearningMaterialGeneratorSharedData>(
-        log_purpose, model_id, target_num_games, std::move(searcher), early_termination,
-        &log_store);
-
-    auto generator_game = std::make_unique<GomokuGame>(
-        std::make_shared<LearningMaterialGenerator>(generator_data, PlayerSide::PS_PLAYER_A),
-        std::make_shared<LearningMaterialGenerator>(generator_data, PlayerSide::PS_PLAYER_B));
-    container->ScheduleToRun(schedule_id, std::move(generator_game));
-
+    auto last_report = std::chrono::steady_clock::now();
     while (container->ScheduledGame(schedule_id) != nullptr) {
-        // Wait for the generator to hit the target number games.
+        // Wait for the generators to hit the target number games.
         std::this_thread::sleep_for(std::chrono::seconds(1));
+
+        if (std::chrono::steady_clock::now() - last_report >= kStatsInterval) {
+            unsigned num_games_ended;
+            {
+                std::lock_guard<std::mutex> guard(session.lock);
+                num_games_ended = session.num_games_ended;
+            }
+
+            GameInstanceContainerStats stats = container->Stats();
+            std::cout << "games_ended=" << num_games_ended << "/" << target_num_games
+                      << " scheduled_games=" << stats.num_scheduled_games
+                      << " games_per_hour=" << stats.GamesPerHour()
+                      << " positions_per_second=" << stats.PositionsPerSecond() << std::endl;
+            last_report = std::chrono::steady_clock::now();
+        }
     }
 }
 
@@ -18,6 +18,7 @@
 #ifndef LEARNING_MATERIAL_GENERATOR_H
 #define LEARNING_MATERIAL_GENERATOR_H
 
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
@@ -33,25 +34,34 @@ namespace e8 {
  * @brief GenerateLearningMaterial Logs game action data generated from self playing. The actions
  * from the self playing is computed with a Monte Carlo tree searcher and an evaluator heuristics
  * supplied by the caller. The stochastic policy and final outcome of each action are logged, so
- * they can be used as the label for model training.
+ * they can be used as the label for model training. The games are logged to the database, while
+ * the actions are written to self-play record shards, see SelfPlayRecordWriter.
  *
  * @param log_purpose The purpose of the generated learning material.
  * @param model_id If the heuristics uses a model, the model ID can be stored in the logs.
- * @param evaluator The heuristics that aids the Monte Carlo tree searcher.
+ * @param evaluator_factory Creates the heuristics that aids the Monte Carlo tree searcher. Each
+ * concurrent game gets its own evaluator, though they may share a GomokuBatchInferenceServer.
  * @param early_termination Terminate the self play by making the winning move if there exists one
  * for any one of the players.
+ * @param symmetry_augmentation Also writes the rotations and reflections of every recorded
+ * position, which yields up to 8 records per searched move.
+ * @param num_concurrent_games Number of games to keep in the game instance container at a time.
+ * It may well exceed the number of container workers.
  * @param schedule_id An unused schedule slot in the game intance container for this function to
  * launch games in.
  * @param target_num_games Target number of games to generate.
  * @param db_host_name Host name of the database to log the game data towards.
  * @param db_name Name of the database to log game data towards.
+ * @param record_path Directory to write the self-play record shards to.
  * @param container A game instance container to for this function to launch game into.
  */
-void GenerateLearningMaterial(GameLogPurpose log_purpose, std::optional<ModelId> model_id,
-                              std::shared_ptr<GomokuEvaluatorInterface> const &evaluator,
-                              bool early_termination, GameInstanceContainer::ScheduleId schedule_id,
-                              unsigned target_num_games, std::string const &db_host_name,
-                              std::string const &db_name, GameInstanceContainer *container);
+void GenerateLearningMaterial(
+    GameLogPurpose log_purpose, std::optional<ModelId> model_id,
+    std::function<std::shared_ptr<GomokuEvaluatorInterface>()> const &evaluator_factory,
+    bool early_termination, bool symmetry_augmentation, unsigned num_concurrent_games,
+    GameInstanceContainer::ScheduleId schedule_id, unsigned target_num_games,
+    std::string const &db_host_name, std::string const &db_name, std::string const &record_path,
+    GameInstanceContainer *container);
 
 } // namespace e8
 
@@ -15,6 +15,8 @@
  * not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <filesystem>
 #include <iostream>
@@ -24,6 +26,8 @@
 #include <vector>
 
 #include "common/time_util/time_util.h"
+#include "gomoku/agent/heuristics/batch_inference_server.h"
+#include "gomoku/agent/heuristics/evaluation_cache.h"
 #include "gomoku/agent/heuristics/shl_model_evaluator.h"
 #include "gomoku/agent/heuristics/tf_zero_prior_evaluator.h"
 #include "gomoku/agent_classroom/learning_material_generator.h"
@@ -39,6 +43,13 @@ namespace {
 unsigned const kCheckPointInterval = 100;
 unsigned const kNumWarmUpGames = 1;
 
+// The self-play games share one inference server, so their policy evaluations are batched
+// together. A game only waits on an evaluation while one of the container's workers is stepping
+// it, so a batch can't hold more requests than there are workers.
+unsigned const kNumConcurrentGames = 64;
+unsigned const kMaxInferenceBatchSize = 16;
+std::chrono::microseconds const kInferenceMaxDelay(2000);
+
 std::string ModelFileName(std::string const &model_path) {
     std::filesystem::path p(model_path);
     std::filesystem::directory_iterator end_it;
@@ -66,7 +77,8 @@ void GenerateEmptyModel(std::string const &source_tree_root, std::string const &
 
 void TrainModel(bool heavy_training, std::string const &source_tree_root,
                 std::string const &model_input_path, std::string const &model_output_path,
-                std::string const &db_host_name, std::string const &db_name) {
+                std::string const &db_host_name, std::string const &db_name,
+                std::string const &record_path) {
     std::string train_model_executable;
     if (heavy_training) {
         train_model_executable =
@@ -79,7 +91,8 @@ void TrainModel(bool heavy_training, std::string const &source_tree_root,
     int rc = std::system((train_model_executable + " --model_input_path=" + model_input_path +
                           " --model_output_path=" + model_output_path +
                           " --db_host=" + db_host_name + " --db_name=" + db_name +
-                          " --db_user=postgres --db_pass=password --num_data_entries=1000000")
+                          " --db_user=postgres --db_pass=password --record_path=" + record_path +
+                          " --num_data_entries=1000000")
                              .c_str());
     assert(rc == 0);
 }
@@ -88,6 +101,7 @@ GomokuModelEntity InitializeFirstModel(std::string const &model_class,
                                        std::string const &source_tree_root,
                                        std::string const &model_storage_path,
                                        std::string const &db_host_name, std::string const &db_name,
+                                       std::string const &record_path,
                                        ModelLogStore *model_log_store) {
     TimestampMicros timestamp = CurrentTimestampMicros();
 
@@ -97,7 +111,7 @@ GomokuModelEntity InitializeFirstModel(std::string const &model_class,
 
     // Bootstrap the model from existing data if there is any.
     TrainModel(/*heavy_training=*/true, source_tree_root, model_output_path, model_output_path,
-               db_host_name, db_name);
+               db_host_name, db_name, record_path);
 
     std::string model_name = ModelFileName(model_output_path);
     return model_log_store->LogNewModel(model_name, model_output_path);
@@ -109,7 +123,8 @@ void IterateFromLastPolicy(GameInstanceContainer::ScheduleId schedule_id,
                            std::string const &model_class, unsigned num_iterations,
                            unsigned num_games_per_iteration, std::string const &source_tree_root,
                            std::string const &model_storage_path, std::string const &db_host_name,
-                           std::string const &db_name, GameInstanceContainer *container) {
+                           std::string const &db_name, std::string const &record_path,
+                           GameInstanceContainer *container) {
     ConnectionFactory conn_fact(ConnectionFactory::PQ, db_host_name, db_name);
     PooledConnectionReservoir conns(conn_fact);
     ModelLogStore model_log_store(&conns);
@@ -118,20 +133,33 @@ void IterateFromLastPolicy(GameInstanceContainer::ScheduleId schedule_id,
     std::optional<GomokuModelEntity> last_model = model_log_store.LastModel();
     if (!last_model.has_value()) {
         last_model = InitializeFirstModel(model_class, source_tree_root, model_storage_path,
-                                          db_host_name, db_name, &model_log_store);
+                                          db_host_name, db_name, record_path, &model_log_store);
     }
 
+    unsigned const inference_batch_size = std::min(kMaxInferenceBatchSize, container->NumWorkers());
+
     for (unsigned i = 0; i < num_iterations; ++i) {
         std::string model_name = ModelFileName(*last_model->model_path.Value());
-        auto evaluator = std::make_shared<GomokuShlModelEvaluator>(*last_model->model_path.Value() +
-                                                                   "/" + model_name);
+        std::string model_file_path = *last_model->model_path.Value() + "/" + model_name;
+        auto inference_server = std::make_shared<GomokuBatchInferenceServer>(
+            LoadShlModel(model_file_path), inference_batch_size, kInferenceMaxDelay,
+            DefaultGomokuEvaluationCache(), ModelVersionOf(model_file_path));
+        auto evaluator_factory = [&inference_server] {
+            return std::make_shared<GomokuShlModelEvaluator>(inference_server);
+        };
 
         std::cout << "iteration=" << i << " games_played=" << i * num_games_per_iteration
                   << " model_name=" << model_name << std::endl;
 
         GenerateLearningMaterial(GameLogPurpose::GLP_LEARNING_DATA, *last_model->id.Value(),
-                                 evaluator, /*early_termination=*/false, schedule_id,
-                                 num_games_per_iteration, db_host_name, db_name, container);
+                                 evaluator_factory, /*early_termination=*/false,
+                                 /*symmetry_augmentation=*/true, kNumConcurrentGames, schedule_id,
+                                 num_games_per_iteration, db_host_name, db_name, record_path,
+                                 container);
+
+        GomokuEvaluationCacheStats cache_stats = DefaultGomokuEvaluationCache()->Stats();
+        std::cout << "evaluation_cache_hit_rate=" << cache_stats.HitRate()
+                  << " evaluation_cache_evictions=" << cache_stats.num_evictions << std::endl;
 
         if ((i + 1) * num_games_per_iteration < kNumWarmUpGames) {
             std::cout << "Skip training during warming up phase." << std::endl;
@@ -145,7 +173,7 @@ void IterateFromLastPolicy(GameInstanceContainer::ScheduleId schedule_id,
             std::string new_model_path = model_storage_path + "/" + std::to_string(timestamp);
 
             TrainModel(/*heavy_training=*/false, source_tree_root, *last_model->model_path.Value(),
-                       new_model_path, db_host_name, db_name);
+                       new_model_path, db_host_name, db_name, record_path);
 
             model_name = ModelFileName(new_model_path);
             GomokuModelEntity new_model = model_log_store.LogNewModel(model_name, new_model_path);
@@ -154,7 +182,7 @@ void IterateFromLastPolicy(GameInstanceContainer::ScheduleId schedule_id,
         } else {
             // Simply updates the latest model.
             TrainModel(/*heavy_training=*/false, source_tree_root, *last_model->model_path.Value(),
-                       *last_model->model_path.Value(), db_host_name, db_name);
+                       *last_model->model_path.Value(), db_host_name, db_name, record_path);
         }
     }
 }
@@ -45,13 +45,16 @@ namespace e8 {
  * @param db_host_name Host name of the database to log the model metadata and learning material
  * towards.
  * @param db_name Name of the database to log the model metadata and learning material towards.
+ * @param record_path Directory to write the self-play record shards to, where the model trainer
+ * reads the learning material from.
  * @param container A game instance container to for this function to launch game into.
  */
 void IterateFromLastPolicy(GameInstanceContainer::ScheduleId schedule_id,
                            std::string const &model_name, unsigned num_iterations,
                            unsigned num_games_per_iteration, std::string const &source_tree_root,
                            std::string const &model_storage_path, std::string const &db_host_name,
-                           std::string const &db_name, GameInstanceContainer *container);
+                           std::string const &db_name, std::string const &record_path,
+                           GameInstanceContainer *container);
 
 } // namespace e8
 
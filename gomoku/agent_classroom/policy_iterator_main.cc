@@ -30,6 +30,7 @@ static char const kNumIterationsFlag[] = "num_iterations";
 static char const kNumGamesPerIterationFlag[] = "num_games_per_iteration";
 static char const kSourceTreeRootFlag[] = "source_tree_root";
 static char const kModelStoragePathFlag[] = "model_storage_path";
+static char const kRecordPathFlag[] = "record_path";
 
 int main(int argc, char *argv[]) {
     setenv("TF_NUM_INTEROP_THREADS", "1", /*overwrite=*/1);
@@ -51,6 +52,8 @@ int main(int argc, char *argv[]) {
         e8::ReadFlag(kSourceTreeRootFlag, std::string(), e8::FromString<std::string>);
     std::string model_storage_path =
         e8::ReadFlag(kModelStoragePathFlag, std::string(), e8::FromString<std::string>);
+    std::string record_path =
+        e8::ReadFlag(kRecordPathFlag, std::string(), e8::FromString<std::string>);
 
     assert(!model_class.empty());
     assert(!db_host_name.empty());
@@ -59,12 +62,13 @@ int main(int argc, char *argv[]) {
     assert(num_games_per_iteration > 0);
     assert(!source_tree_root.empty());
     assert(!model_storage_path.empty());
+    assert(!record_path.empty());
 
     e8::GameInstanceContainer::ScheduleId schedule_id =
         e8::AllocateGameInstanceContainerScheduleId();
     e8::IterateFromLastPolicy(schedule_id, model_class, num_iterations, num_games_per_iteration,
                               source_tree_root, model_storage_path, db_host_name, db_name,
-                              e8::DefaultGameInstanceContainer());
+                              record_path, e8::DefaultGameInstanceContainer());
 
     return 0;
 }
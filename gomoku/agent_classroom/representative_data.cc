@@ -16,6 +16,7 @@
  */
 
 #include <memory>
+#include <optional>
 #include <string>
 
 #include "gomoku/agent/heuristics/shl_rollout_evaluator.h"
@@ -24,14 +25,25 @@
 #include "gomoku/game/game_instance_container.h"
 
 namespace e8 {
+namespace {
+
+unsigned const kNumConcurrentGames = 16;
+
+} // namespace
 
 void GenerateRepresentativeData(GameInstanceContainer::ScheduleId schedule_id,
                                 unsigned target_num_games, std::string const &db_host_name,
-                                std::string const &db_name, GameInstanceContainer *container) {
-    auto evaluator = std::make_shared<GomokuShlRolloutEvaluator>();
+                                std::string const &db_name, std::string const &record_path,
+                                GameInstanceContainer *container) {
+    // Games already run on every container worker, so each rollout runs on its game's thread.
+    auto evaluator_factory = [] {
+        return std::make_shared<GomokuShlRolloutEvaluator>(/*num_workers=*/1,
+                                                           /*seed=*/std::nullopt);
+    };
     GenerateLearningMaterial(GameLogPurpose::GLP_REPRESENTATIVE_DATA, /*model_id=*/std::nullopt,
-                             evaluator, /*early_termination=*/false, schedule_id, target_num_games,
-                             db_host_name, db_name, container);
+                             evaluator_factory, /*early_termination=*/false,
+                             /*symmetry_augmentation=*/false, kNumConcurrentGames, schedule_id,
+                             target_num_games, db_host_name, db_name, record_path, container);
 }
 
 } // namespace e8
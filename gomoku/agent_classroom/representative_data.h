@@ -33,11 +33,13 @@ namespace e8 {
  * @param target_num_games Target number of games to generate.
  * @param db_host_name Host name of the database to log the game data towards.
  * @param db_name Name of the database to log game data towards.
+ * @param record_path Directory to write the self-play record shards to.
  * @param container An game instance container to for this function to launch game into.
  */
 void GenerateRepresentativeData(GameInstanceContainer::ScheduleId schedule_id,
                                 unsigned target_num_games, std::string const &db_host_name,
-                                std::string const &db_name, GameInstanceContainer *container);
+                                std::string const &db_name, std::string const &record_path,
+                                GameInstanceContainer *container);
 
 } // namespace e8
 
@@ -25,6 +25,7 @@
 static char const kDbHostNameFlag[] = "db_host_name";
 static char const kDbNameFlag[] = "db_name";
 static char const kTargetNumGamesFlag[] = "target_num_games";
+static char const kRecordPathFlag[] = "record_path";
 
 int main(int argc, char *argv[]) {
     e8::Argv(argc, argv);
@@ -34,15 +35,18 @@ int main(int argc, char *argv[]) {
     std::string db_name = e8::ReadFlag(kDbNameFlag, std::string(), e8::FromString<std::string>);
     unsigned target_num_games =
         e8::ReadFlag(kTargetNumGamesFlag, unsigned(0), e8::FromString<unsigned>);
+    std::string record_path =
+        e8::ReadFlag(kRecordPathFlag, std::string(), e8::FromString<std::string>);
 
     assert(!db_host_name.empty());
     assert(!db_name.empty());
     assert(target_num_games > 0);
+    assert(!record_path.empty());
 
     e8::GameInstanceContainer::ScheduleId schedule_id =
         e8::AllocateGameInstanceContainerScheduleId();
     e8::GenerateRepresentativeData(schedule_id, target_num_games, db_host_name, db_name,
-                                   e8::DefaultGameInstanceContainer());
+                                   record_path, e8::DefaultGameInstanceContainer());
 
     return 0;
 }
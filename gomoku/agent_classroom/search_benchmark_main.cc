@@ -0,0 +1,438 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/flags/parse_flags.h"
+#include "gomoku/agent/heuristics/evaluator.h"
+#include "gomoku/agent/heuristics/light_rollout_evaluator.h"
+#include "gomoku/agent/heuristics/native_zero_prior_evaluator.h"
+#include "gomoku/agent/heuristics/shl_model_evaluator.h"
+#include "gomoku/agent/heuristics/shl_rollout_evaluator.h"
+#include "gomoku/agent/heuristics/tf_zero_prior_evaluator.h"
+#include "gomoku/agent/heuristics/tflite_zero_prior_evaluator.h"
+#include "gomoku/agent/search/mct_node.h"
+#include "gomoku/agent/search/mct_search.h"
+#include "gomoku/game/board_state.h"
+
+static char const kEvaluatorsFlag[] = "evaluators";
+static char const kNumSimulationsFlag[] = "num_simulations";
+static char const kNumWorkersFlag[] = "num_workers";
+static char const kSolveThreatsFlag[] = "solve_threats";
+static char const kOutputFileFlag[] = "output_file";
+static char const kShlModelPathFlag[] = "shl_model_path";
+static char const kTfModelPathFlag[] = "tf_model_path";
+static char const kTfliteModelPathFlag[] = "tflite_model_path";
+static char const kNativeModelPathFlag[] = "native_model_path";
+
+// Counts the heap allocations of the whole process, so that the allocations made by a search can
+// be told from the difference of two readings.
+static std::atomic<uint64_t> gNumAllocations(0);
+static std::atomic<uint64_t> gNumAllocatedBytes(0);
+
+void *operator new(std::size_t size) {
+    gNumAllocations.fetch_add(1, std::memory_order_relaxed);
+    gNumAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    void *p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, std::size_t /*size*/) noexcept { std::free(p); }
+
+namespace e8 {
+namespace {
+
+// Seeds the rollout evaluators which accept one.
+unsigned const kRolloutSeed = 13;
+
+/**
+ * @brief The CanonicalPosition struct A fixed position to search from, reached by playing the
+ * actions on an 11x11 board.
+ */
+struct CanonicalPosition {
+    char const *name;
+    std::vector<GomokuAction> actions;
+};
+
+std::vector<CanonicalPosition> CanonicalPositions() {
+    std::vector<GomokuAction> opening{
+        GomokuAction(MovePosition(/*x=*/3, /*y=*/6)),
+        GomokuAction(MovePosition(/*x=*/4, /*y=*/3)),
+        GomokuAction(MovePosition(/*x=*/9, /*y=*/7)),
+    };
+
+    std::vector<GomokuAction> threat = opening;
+    threat.push_back(GomokuAction(Swap2Decision::SW2D_CHOOSE_WHITE));
+    threat.push_back(GomokuAction(MovePosition(/*x=*/9, /*y=*/6)));
+
+    std::vector<GomokuAction> midgame = threat;
+    for (MovePosition const &pos :
+         {MovePosition(/*x=*/9, /*y=*/5), MovePosition(/*x=*/5, /*y=*/5),
+          MovePosition(/*x=*/4, /*y=*/5), MovePosition(/*x=*/6, /*y=*/4),
+          MovePosition(/*x=*/3, /*y=*/5), MovePosition(/*x=*/5, /*y=*/4),
+          MovePosition(/*x=*/6, /*y=*/5)}) {
+        midgame.push_back(GomokuAction(pos));
+    }
+
+    // Both sides have an open four, and the player to move wins immediately.
+    std::vector<GomokuAction> open_four = threat;
+    for (MovePosition const &pos :
+         {MovePosition(/*x=*/3, /*y=*/1), MovePosition(/*x=*/9, /*y=*/5),
+          MovePosition(/*x=*/4, /*y=*/1), MovePosition(/*x=*/9, /*y=*/8),
+          MovePosition(/*x=*/5, /*y=*/1), MovePosition(/*x=*/0, /*y=*/10),
+          MovePosition(/*x=*/6, /*y=*/1)}) {
+        open_four.push_back(GomokuAction(pos));
+    }
+
+    return std::vector<CanonicalPosition>{
+        CanonicalPosition{"swap2_decision", opening},
+        CanonicalPosition{"threat_opening", threat},
+        CanonicalPosition{"midgame", midgame},
+        CanonicalPosition{"open_four", open_four},
+    };
+}
+
+GomokuActionId ActionIdOf(GomokuAction const &action, GomokuBoardState const &board) {
+    if (action.stone_pos.has_value()) {
+        return board.MovePositionToActionId(*action.stone_pos);
+    }
+    if (action.swap2_decision.has_value()) {
+        return board.Swap2DecisionToActionId(*action.swap2_decision);
+    }
+    return board.StoneTypeDecisionToActionId(*action.stone_type_decision);
+}
+
+/**
+ * @brief The TimedEvaluator class Forwards to an evaluator while recording the latency of every
+ * call.
+ */
+class TimedEvaluator : public GomokuEvaluatorInterface {
+  public:
+    explicit TimedEvaluator(std::unique_ptr<GomokuEvaluatorInterface> &&base)
+        : base_(std::move(base)) {}
+
+    float EvaluateReward(GomokuBoardState const &state, std::optional<MctNodeId> parent_state_id,
+                         MctNodeId state_id) override {
+        auto start = std::chrono::steady_clock::now();
+        float reward = base_->EvaluateReward(state, parent_state_id, state_id);
+        this->Record(start, &reward_latencies_);
+        return reward;
+    }
+
+    void EvaluatePolicy(GomokuBoardState const &state, std::optional<MctNodeId> parent_state_id,
+                        MctNodeId state_id, GomokuPolicy *policy) override {
+        auto start = std::chrono::steady_clock::now();
+        base_->EvaluatePolicy(state, parent_state_id, state_id, policy);
+        this->Record(start, &policy_latencies_);
+    }
+
+    float ExplorationFactor() const override { return base_->ExplorationFactor(); }
+
+    unsigned NumSimulations() const override { return base_->NumSimulations(); }
+
+    void ClearCache() override { base_->ClearCache(); }
+
+    bool ThreadSafe() const override { return base_->ThreadSafe(); }
+
+    /**
+     * @brief ResetLatencies Drops the recorded latencies. The buffers are sized up front so that
+     * the recording doesn't show up in the allocation counts.
+     */
+    void ResetLatencies(unsigned expected_num_calls) {
+        std::lock_guard<std::mutex> guard(lock_);
+        reward_latencies_.clear();
+        policy_latencies_.clear();
+        reward_latencies_.reserve(expected_num_calls);
+        policy_latencies_.reserve(expected_num_calls);
+    }
+
+    std::vector<float> RewardLatencies() const { return reward_latencies_; }
+    std::vector<float> PolicyLatencies() const { return policy_latencies_; }
+
+  private:
+    void Record(std::chrono::steady_clock::time_point start, std::vector<float> *latencies) {
+        auto end = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> guard(lock_);
+        latencies->push_back(std::chrono::duration<float, std::micro>(end - start).count());
+    }
+
+    std::unique_ptr<GomokuEvaluatorInterface> base_;
+    std::vector<float> reward_latencies_;
+    std::vector<float> policy_latencies_;
+    std::mutex lock_;
+};
+
+/**
+ * @brief CreateEvaluator Creates the named evaluator. It returns nullptr when the evaluator needs a
+ * model which isn't supplied.
+ */
+std::unique_ptr<GomokuEvaluatorInterface>
+CreateEvaluator(std::string const &name, std::string const &shl_model_path,
+                std::string const &tf_model_path, std::string const &tflite_model_path,
+                std::string const &native_model_path) {
+    if (name == "light_rollout") {
+        return std::make_unique<GomokuLightRolloutEvaluator>(std::thread::hardware_concurrency(),
+                                                             kRolloutSeed);
+    }
+    if (name == "shl_rollout") {
+        return std::make_unique<GomokuShlRolloutEvaluator>(std::thread::hardware_concurrency(),
+                                                           kRolloutSeed);
+    }
+    if (name == "shl_model" && !shl_model_path.empty()) {
+        return std::make_unique<GomokuShlModelEvaluator>(shl_model_path);
+    }
+    if (name == "tf" && !tf_model_path.empty()) {
+        return std::make_unique<GomokuTfZeroPriorEvaluator>(tf_model_path);
+    }
+    if (name == "tflite" && !tflite_model_path.empty()) {
+        return std::make_unique<GomokuTfliteZeroPriorEvaluator>(tflite_model_path);
+    }
+    if (name == "native" && !native_model_path.empty()) {
+        return std::make_unique<GomokuNativeZeroPriorEvaluator>(native_model_path, NCP_FLOAT32);
+    }
+    if (name == "native_int8" && !native_model_path.empty()) {
+        return std::make_unique<GomokuNativeZeroPriorEvaluator>(native_model_path, NCP_INT8);
+    }
+    return nullptr;
+}
+
+std::vector<std::string> SplitList(std::string const &list) {
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+/**
+ * @brief The LatencyStats struct Percentiles of the evaluator call latency in microseconds.
+ */
+struct LatencyStats {
+    unsigned num_calls = 0;
+    float p50 = 0;
+    float p90 = 0;
+    float p99 = 0;
+    float max = 0;
+};
+
+LatencyStats ComputeLatencyStats(std::vector<float> latencies) {
+    LatencyStats stats;
+    stats.num_calls = latencies.size();
+    if (latencies.empty()) {
+        return stats;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](float q) {
+        return latencies[static_cast<unsigned>(q * (latencies.size() - 1))];
+    };
+    stats.p50 = percentile(0.50f);
+    stats.p90 = percentile(0.90f);
+    stats.p99 = percentile(0.99f);
+    stats.max = latencies.back();
+    return stats;
+}
+
+/**
+ * @brief The SearchResult struct Measurements of one search.
+ */
+struct SearchResult {
+    std::string evaluator;
+    std::string position;
+    unsigned num_workers;
+    unsigned num_simulations;
+    double secs;
+    LatencyStats reward_latency;
+    LatencyStats policy_latency;
+    unsigned num_tree_nodes;
+    uint64_t tree_memory_bytes;
+    uint64_t num_allocations;
+    uint64_t num_allocated_bytes;
+};
+
+SearchResult RunSearch(std::string const &evaluator_name, TimedEvaluator *evaluator,
+                       std::shared_ptr<GomokuEvaluatorInterface> const &shared_evaluator,
+                       CanonicalPosition const &position, unsigned num_simulations,
+                       unsigned num_workers, bool solve_threats) {
+    evaluator->ClearCache();
+    MctSearcher searcher(shared_evaluator, /*print_stats=*/false, num_workers,
+                         /*lazy_expansion=*/false, solve_threats);
+
+    GomokuBoardState board(/*width=*/11, /*height=*/11);
+    for (GomokuAction const &action : position.actions) {
+        GomokuActionId action_id = ActionIdOf(action, board);
+        searcher.SelectAction(board, action_id);
+        GameResult result = board.ApplyAction(action_id, /*cached_game_result=*/std::nullopt);
+        assert(result == GR_UNDETERMINED);
+    }
+
+    // Each simulation calls the evaluator at most twice.
+    evaluator->ResetLatencies(2 * num_simulations + num_workers);
+
+    MctSearchBudget budget;
+    budget.num_simulations = num_simulations;
+
+    uint64_t num_allocations = gNumAllocations.load();
+    uint64_t num_allocated_bytes = gNumAllocatedBytes.load();
+    auto start = std::chrono::steady_clock::now();
+    searcher.Search(board, budget);
+    auto end = std::chrono::steady_clock::now();
+
+    SearchResult result;
+    result.evaluator = evaluator_name;
+    result.position = position.name;
+    result.num_workers = num_workers;
+    result.num_simulations = searcher.NumRootSimulations();
+    result.secs = std::chrono::duration<double>(end - start).count();
+    result.num_allocations = gNumAllocations.load() - num_allocations;
+    result.num_allocated_bytes = gNumAllocatedBytes.load() - num_allocated_bytes;
+    result.reward_latency = ComputeLatencyStats(evaluator->RewardLatencies());
+    result.policy_latency = ComputeLatencyStats(evaluator->PolicyLatencies());
+    result.num_tree_nodes = searcher.NumTreeNodes();
+    result.tree_memory_bytes = searcher.TreeMemoryBytes();
+    return result;
+}
+
+void PrintLatencyStats(std::ostream &os, char const *prefix, char const *separator,
+                       char const *assignment, LatencyStats const &stats) {
+    os << separator << prefix << "_calls" << assignment << stats.num_calls << separator << prefix
+       << "_p50_us" << assignment << stats.p50 << separator << prefix << "_p90_us" << assignment
+       << stats.p90 << separator << prefix << "_p99_us" << assignment << stats.p99 << separator
+       << prefix << "_max_us" << assignment << stats.max;
+}
+
+/**
+ * @brief PrintResult Prints the result as a line of key=value pairs when json is false, or as a
+ * JSON object otherwise.
+ */
+void PrintResult(SearchResult const &result, bool json, std::ostream &os) {
+    char const *separator = json ? ", \"" : " ";
+    char const *assignment = json ? "\": " : "=";
+    char const *quote = json ? "\"" : "";
+
+    double simulations_per_sec = result.num_simulations / result.secs;
+    double bytes_per_node =
+        result.num_tree_nodes == 0 ? 0 : double(result.tree_memory_bytes) / result.num_tree_nodes;
+    double allocations_per_simulation =
+        result.num_simulations == 0 ? 0 : double(result.num_allocations) / result.num_simulations;
+
+    os << (json ? "{\"" : "SearchBenchmark: ") << "evaluator" << assignment << quote
+       << result.evaluator << quote << separator << "position" << assignment << quote
+       << result.position << quote << separator << "num_workers" << assignment
+       << result.num_workers << separator << "num_simulations" << assignment
+       << result.num_simulations << separator << "secs" << assignment << result.secs << separator
+       << "simulations_per_sec" << assignment << simulations_per_sec;
+    PrintLatencyStats(os, "reward", separator, assignment, result.reward_latency);
+    PrintLatencyStats(os, "policy", separator, assignment, result.policy_latency);
+    os << separator << "tree_nodes" << assignment << result.num_tree_nodes << separator
+       << "tree_memory_bytes" << assignment << result.tree_memory_bytes << separator
+       << "bytes_per_node" << assignment << bytes_per_node << separator << "allocations"
+       << assignment << result.num_allocations << separator << "allocated_bytes" << assignment
+       << result.num_allocated_bytes << separator << "allocations_per_simulation" << assignment
+       << allocations_per_simulation << (json ? "}" : "") << std::endl;
+}
+
+} // namespace
+} // namespace e8
+
+int main(int argc, char *argv[]) {
+    setenv("TF_NUM_INTEROP_THREADS", "1", /*overwrite=*/1);
+    setenv("TF_NUM_INTRAOP_THREADS", "1", /*overwrite=*/1);
+    setenv("OMP_NUM_THREADS", "1", /*overwrite=*/1);
+
+    e8::Argv(argc, argv);
+
+    std::string evaluators =
+        e8::ReadFlag(kEvaluatorsFlag, std::string("light_rollout,shl_rollout"),
+                     e8::FromString<std::string>);
+    unsigned num_simulations =
+        e8::ReadFlag(kNumSimulationsFlag, unsigned(2000), e8::FromString<unsigned>);
+    unsigned num_workers = e8::ReadFlag(kNumWorkersFlag, unsigned(1), e8::FromString<unsigned>);
+    bool solve_threats = e8::ReadFlag(kSolveThreatsFlag, true, e8::FromString<bool>);
+    std::string output_file =
+        e8::ReadFlag(kOutputFileFlag, std::string(), e8::FromString<std::string>);
+    std::string shl_model_path =
+        e8::ReadFlag(kShlModelPathFlag, std::string(), e8::FromString<std::string>);
+    std::string tf_model_path =
+        e8::ReadFlag(kTfModelPathFlag, std::string(), e8::FromString<std::string>);
+    std::string tflite_model_path =
+        e8::ReadFlag(kTfliteModelPathFlag, std::string(), e8::FromString<std::string>);
+    std::string native_model_path =
+        e8::ReadFlag(kNativeModelPathFlag, std::string(), e8::FromString<std::string>);
+
+    assert(num_simulations > 0);
+    assert(num_workers > 0);
+
+    std::ofstream output;
+    if (!output_file.empty()) {
+        output.open(output_file, std::ios::out | std::ios::trunc);
+        assert(output.is_open());
+    }
+
+    std::vector<e8::CanonicalPosition> positions = e8::CanonicalPositions();
+    std::cout << "SearchBenchmark: node_bytes=" << sizeof(e8::MctNodeBlock) / e8::kMctNodeBlockSize
+              << std::endl;
+
+    for (std::string const &evaluator_name : e8::SplitList(evaluators)) {
+        std::unique_ptr<e8::GomokuEvaluatorInterface> base = e8::CreateEvaluator(
+            evaluator_name, shl_model_path, tf_model_path, tflite_model_path, native_model_path);
+        if (base == nullptr) {
+            std::cout << "SearchBenchmark: evaluator=" << evaluator_name
+                      << " skipped, unknown or missing model path" << std::endl;
+            continue;
+        }
+
+        auto evaluator = std::make_shared<e8::TimedEvaluator>(std::move(base));
+        for (e8::CanonicalPosition const &position : positions) {
+            e8::SearchResult result = e8::RunSearch(
+                evaluator_name, evaluator.get(),
+                std::static_pointer_cast<e8::GomokuEvaluatorInterface>(evaluator), position,
+                num_simulations, num_workers, solve_threats);
+
+            e8::PrintResult(result, /*json=*/false, std::cout);
+            if (output.is_open()) {
+                e8::PrintResult(result, /*json=*/true, output);
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+#!/bin/python3
+
+# This script exports the weights of a zero prior model to the file format
+# the native CNN inference engine (gomoku/agent/heuristics/native_cnn.h)
+# loads.
+#
+# File layout, all little endian:
+#   char[4]  magic "E8NN"
+#   uint32   version
+#   uint32   board width
+#   uint32   board height
+#   uint32   number of tensors
+#   For each tensor, in the order of cnn_shared_model.TrainableVariables():
+#     uint32           number of dimensions
+#     uint32[num_dims] dimensions
+#     float32[...]     values in row-major order
+import argparse
+import logging
+import struct
+import numpy as np
+
+from poly_functions import LoadModel
+from poly_functions import ReadBoardSize
+from poly_functions import RequireShlFeatures
+from poly_functions import TrainableVariables
+
+NATIVE_MODEL_MAGIC = b"E8NN"
+NATIVE_MODEL_VERSION = 1
+
+def ExportNativeModel(model_import_path: str, output_file: str) -> None:
+    logging.info("Loading model from {0}...".format(model_import_path))
+    model = LoadModel(model_import_path=model_import_path)
+
+    model_name = model.Name().numpy().decode("UTF-8")
+    if "gomoku_cnn_shared_tower" in model_name or \
+            RequireShlFeatures(model_name=model_name):
+        raise ValueError(
+            "Only the zero prior model is supported, model_name=" + model_name)
+
+    board_size = ReadBoardSize(model_name=model_name)
+    variables = TrainableVariables(model=model)
+
+    with open(file=output_file, mode="wb") as f:
+        f.write(NATIVE_MODEL_MAGIC)
+        f.write(struct.pack("<IIII",
+                            NATIVE_MODEL_VERSION,
+                            board_size,
+                            board_size,
+                            len(variables)))
+
+        for variable in variables:
+            values = variable.numpy().astype("<f4")
+            f.write(struct.pack("<I", len(values.shape)))
+            f.write(struct.pack("<{0}I".format(len(values.shape)),
+                                *values.shape))
+            f.write(np.ascontiguousarray(values).tobytes())
+
+            logging.info("Exported {0} {1}".format(
+                variable.name, values.shape))
+
+    logging.info("Wrote {0}".format(output_file))
+
+if __name__ == "__main__":
+    logging.basicConfig(level=logging.INFO, 
+                        format="%(asctime)s %(levelname)s %(message)s")
+
+    parser = argparse.ArgumentParser(
+        description="Export a Gomoku model for native inference")
+    parser.add_argument("--model_import_path",
+        type=str,
+        help="The path the model was saved to. Do not specify the model name.")
+    parser.add_argument("--output_file",
+        type=str,
+        help="The native weight file to write.")
+
+    args = parser.parse_args()
+
+    if args.model_import_path is None:
+        logging.error("Argument model_import_path is required.")
+        parser.print_help()
+        exit(-1)
+
+    if args.output_file is None:
+        logging.error("Argument output_file is required.")
+        parser.print_help()
+        exit(-1)
+
+    ExportNativeModel(model_import_path=args.model_import_path,
+                      output_file=args.output_file)
@@ -0,0 +1,215 @@
+import os
+from typing import List
+from typing import Tuple
+import numpy as np
+
+# Mirrors gomoku/logging/self_play_record_store.h.
+SHARD_MAGIC = b"E8SP"
+SHARD_VERSION = 1
+SHARD_EXTENSION = ".e8sp"
+
+SHARD_HEADER_DTYPE = np.dtype([
+    ("magic", "S4"),
+    ("version", "=u4"),
+    ("board_width", "=u4"),
+    ("board_height", "=u4"),
+    ("policy_size", "=u4"),
+    ("shl_map_size", "=u4"),
+    ("top_shl_features_size", "=u4"),
+    ("record_size", "=u4"),
+    ("num_records", "=u8"),
+    ("reserved", "u1", 24),
+])
+
+def RecordDtype(header: np.ndarray) -> np.dtype:
+    num_cells = int(header["board_width"]) * int(header["board_height"])
+    board_bytes = (num_cells + 3) & ~3
+
+    return np.dtype([
+        ("game_id", "=i8"),
+        ("step_number", "=u4"),
+        ("num_game_steps", "=u4"),
+        ("action_id", "=i4"),
+        ("action_performer", "u1"),
+        ("action_stone_type", "u1"),
+        ("game_phase", "u1"),
+        ("symmetry", "u1"),
+        ("value", "=f4"),
+        ("reserved", "=u4"),
+        ("board", "u1", board_bytes),
+        ("policy", "=f4", int(header["policy_size"])),
+        ("shl_map", "=f4", int(header["shl_map_size"])),
+        ("top_shl_features", "=f4", int(header["top_shl_features_size"])),
+    ])
+
+def OpenShard(shard_path: str) -> Tuple[np.ndarray, np.ndarray]:
+    """Memory maps the complete records of a shard file."""
+    header = np.fromfile(shard_path, dtype=SHARD_HEADER_DTYPE, count=1)[0]
+    assert header["magic"] == SHARD_MAGIC
+    assert header["version"] == SHARD_VERSION
+
+    record_dtype = RecordDtype(header)
+    assert record_dtype.itemsize == header["record_size"]
+
+    file_size = os.path.getsize(shard_path)
+    num_records = min(
+        int(header["num_records"]),
+        (file_size - SHARD_HEADER_DTYPE.itemsize) // record_dtype.itemsize)
+    if num_records == 0:
+        return header, np.zeros(shape=(0), dtype=record_dtype)
+
+    records = np.memmap(shard_path,
+                        dtype=record_dtype,
+                        mode="r",
+                        offset=SHARD_HEADER_DTYPE.itemsize,
+                        shape=(num_records))
+    return header, records
+
+def ListShards(record_path: str) -> List[str]:
+    """Lists the shard files from the oldest to the newest."""
+    shard_paths = [os.path.join(record_path, file_name)
+                   for file_name in os.listdir(record_path)
+                   if file_name.endswith(SHARD_EXTENSION)]
+    shard_paths.sort(key=lambda path: (os.path.getmtime(path), path))
+    return shard_paths
+
+class RecordBatchGenerator:
+    """Samples learning material from the self-play record shards rather than
+    the database. It has the same interface as BatchGenerator."""
+
+    def __init__(self,
+                 board_size: int,
+                 num_data_entries: int,
+                 record_path: str):
+        self.board_size_ = board_size
+        self.shards_ = list()
+
+        shard_indices = list()
+        record_indices = list()
+        for shard_path in ListShards(record_path=record_path):
+            header, records = OpenShard(shard_path=shard_path)
+            if header["board_width"] != board_size or \
+               header["board_height"] != board_size:
+                continue
+
+            shard_indices.append(
+                np.full(shape=(records.shape[0]),
+                        fill_value=len(self.shards_),
+                        dtype=np.int32))
+            record_indices.append(
+                np.arange(records.shape[0], dtype=np.int64))
+            self.shards_.append(records)
+
+        if self.shards_:
+            self.shard_indices_ = np.concatenate(shard_indices)
+            self.record_indices_ = np.concatenate(record_indices)
+        else:
+            self.shard_indices_ = np.zeros(shape=(0), dtype=np.int32)
+            self.record_indices_ = np.zeros(shape=(0), dtype=np.int64)
+
+        # Keeps the most recent entries only.
+        if num_data_entries is not None:
+            num_data_entries = int(num_data_entries)
+            self.shard_indices_ = self.shard_indices_[-num_data_entries:]
+            self.record_indices_ = self.record_indices_[-num_data_entries:]
+
+        self.game_ids_ = self.Column_("game_id")
+        self.step_numbers_ = self.Column_("step_number")
+        self.num_game_steps_ = self.Column_("num_game_steps")
+
+    def Column_(self, field: str) -> np.ndarray:
+        column = np.zeros(shape=self.record_indices_.shape, dtype=np.int64)
+        for i in range(len(self.shards_)):
+            selected = self.shard_indices_ == i
+            column[selected] = \
+                self.shards_[i][field][self.record_indices_[selected]]
+        return column
+
+    def Eligible_(self, training_data: bool, last_k_steps: int) -> np.ndarray:
+        eligible = np.ones(shape=self.record_indices_.shape, dtype=np.bool_)
+        if training_data is not None:
+            if training_data:
+                eligible &= np.mod(self.game_ids_, 10) < 9
+            else:
+                eligible &= np.mod(self.game_ids_, 10) >= 9
+        if last_k_steps is not None:
+            eligible &= self.step_numbers_ > self.num_game_steps_ - last_k_steps
+        return np.flatnonzero(eligible)
+
+    def NumDataEntries(self,
+                       training_data: bool,
+                       last_k_steps: int = None) -> int:
+        return self.Eligible_(training_data=training_data,
+                              last_k_steps=last_k_steps).shape[0]
+
+    def NextBatch(self,
+                  batch_size: int,
+                  training_data: bool,
+                  last_k_steps: int = None) -> Tuple[np.ndarray,
+                                                     np.ndarray,
+                                                     np.ndarray,
+                                                     np.ndarray,
+                                                     np.ndarray,
+                                                     np.ndarray,
+                                                     np.ndarray]:
+        eligible = self.Eligible_(training_data=training_data,
+                                  last_k_steps=last_k_steps)
+        selected = np.random.choice(a=eligible,
+                                    size=min(batch_size, eligible.shape[0]),
+                                    replace=False)
+
+        board_size = self.board_size_
+        num_cells = board_size*board_size
+        actual_batch_size = selected.shape[0]
+
+        boards = np.zeros(
+            shape=(actual_batch_size, board_size, board_size), dtype=np.uint8)
+        game_phases = np.zeros(
+            shape=(actual_batch_size), dtype=np.uint8)
+        next_move_stone_types = np.zeros(
+            shape=(actual_batch_size), dtype=np.uint8)
+        shl_maps = np.zeros(
+            shape=(actual_batch_size, board_size, board_size, 4),
+            dtype=np.float32)
+        top_shl_features = np.zeros(
+            shape=(actual_batch_size, 60), dtype=np.float32)
+        policies = np.zeros(
+            shape=(actual_batch_size, num_cells + 5), dtype=np.float32)
+        values = np.zeros(
+            shape=(actual_batch_size), dtype=np.float32)
+
+        for i in range(actual_batch_size):
+            record = self.shards_[self.shard_indices_[selected[i]]]\
+                                 [self.record_indices_[selected[i]]]
+
+            # The records are row major whereas the batches are indexed by
+            # [x, y].
+            boards[i, :, :] = np.transpose(
+                record["board"][:num_cells].reshape((board_size, board_size)))
+            game_phases[i] = record["game_phase"]
+            next_move_stone_types[i] = record["action_stone_type"]
+            shl_maps[i, :, :, :] = np.transpose(
+                record["shl_map"].reshape((board_size, board_size, 4)),
+                axes=(1, 0, 2))
+            top_shl_features[i, :] = record["top_shl_features"]
+            policies[i, :] = record["policy"]
+            values[i] = record["value"]
+
+        return boards,\
+               game_phases,\
+               next_move_stone_types,\
+               shl_maps,\
+               top_shl_features,\
+               policies,\
+               values
+
+if __name__ == "__main__":
+    import sys
+
+    gen = RecordBatchGenerator(board_size=11,
+                               num_data_entries=None,
+                               record_path=sys.argv[1])
+
+    print("total=", gen.NumDataEntries(training_data=None))
+    print("training=", gen.NumDataEntries(training_data=True))
+    print("testing=", gen.NumDataEntries(training_data=False))
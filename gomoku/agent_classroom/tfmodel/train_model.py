@@ -16,6 +16,7 @@ from poly_functions import SaveModel
 from poly_functions import TrainableVariables
 from augmentation import AugmentData
 from batch_generator import BatchGenerator
+from record_batch_generator import RecordBatchGenerator
 
 def DataSetLoss(model: any,
                 training_data: bool,
@@ -225,6 +226,11 @@ if __name__ == "__main__":
         type=str,
         help="The number of the latest game data entries used to train the model. "
              "If this argument is absent, it will use all the data.")
+    parser.add_argument("--record_path",
+        type=str,
+        help="Directory of the self-play record shards to read the latest game "
+             "data from. If this argument is absent, it will read the game data "
+             "from the database.")
     parser.add_argument("--db_host",
         type=str,
         help="Host name pointing to the database storing the latest game data.")
@@ -242,6 +248,7 @@ if __name__ == "__main__":
     model_input_path = args.model_input_path
     model_output_path = args.model_output_path
     num_data_entries = args.num_data_entries
+    record_path = args.record_path
     db_host = args.db_host
     db_name = args.db_name
     db_user = args.db_user
@@ -255,19 +262,19 @@ if __name__ == "__main__":
         logging.error("Argument model_output_path is required.")
         parser.print_help()
         exit(-1)
-    if db_host is None:
+    if record_path is None and db_host is None:
         logging.error("Argument db_host is required.")
         parser.print_help()
         exit(-1)
-    if db_name is None:
+    if record_path is None and db_name is None:
         logging.error("Argument db_name is required.")
         parser.print_help()
         exit(-1)
-    if db_user is None:
+    if record_path is None and db_user is None:
         logging.error("Argument db_user is required.")
         parser.print_help()
         exit(-1)
-    if db_pass is None:
+    if record_path is None and db_pass is None:
         logging.error("Argument db_pass is required.")
         parser.print_help()
         exit(-1)
@@ -275,14 +282,20 @@ if __name__ == "__main__":
     model_name = ReadModelName(model_import_path=model_input_path)
     board_size = ReadBoardSize(model_name=model_name)
 
-    batch_gen = BatchGenerator(
-        board_size=board_size,
-        num_data_entries=num_data_entries,
-        db_name=db_name,
-        db_host=db_host,
-        db_port=5432,
-        db_user=db_user,
-        db_pass=db_pass)
+    if record_path is not None:
+        batch_gen = RecordBatchGenerator(
+            board_size=board_size,
+            num_data_entries=num_data_entries,
+            record_path=record_path)
+    else:
+        batch_gen = BatchGenerator(
+            board_size=board_size,
+            num_data_entries=num_data_entries,
+            db_name=db_name,
+            db_host=db_host,
+            db_port=5432,
+            db_user=db_user,
+            db_pass=db_pass)
 
     Train(model_import_path=model_input_path,
           batch_gen=batch_gen, 
@@ -0,0 +1,49 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <array>
+#include <cstdint>
+
+#include "gomoku/game/bitboard.h"
+
+namespace e8 {
+
+Bitboard::Bitboard() { words_.fill(0); }
+
+unsigned Bitboard::Count() const {
+    unsigned count = 0;
+    for (uint64_t word : words_) {
+        count += __builtin_popcountll(word);
+    }
+    return count;
+}
+
+bool Bitboard::Empty() const {
+    uint64_t any = 0;
+    for (uint64_t word : words_) {
+        any |= word;
+    }
+    return any == 0;
+}
+
+std::array<uint64_t, kBitboardWords> const &Bitboard::Words() const { return words_; }
+
+bool Bitboard::operator==(Bitboard const &other) const { return words_ == other.words_; }
+
+bool Bitboard::operator!=(Bitboard const &other) const { return words_ != other.words_; }
+
+} // namespace e8
@@ -0,0 +1,113 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+
+namespace e8 {
+
+// Number of 64-bit words a bitboard spans.
+static unsigned const kBitboardWords = 4;
+
+// Number of bit positions a bitboard can hold.
+static unsigned const kBitboardCapacity = 64 * kBitboardWords;
+
+/**
+ * @brief The Bitboard class A fixed capacity set of bit positions. Boards are laid out in row-major
+ * order so that stones in a line are a constant stride apart.
+ */
+class Bitboard {
+  public:
+    Bitboard();
+    ~Bitboard() = default;
+
+    /**
+     * @brief Test Checks if the bit at pos is set. Positions beyond the capacity are never set.
+     */
+    bool Test(unsigned pos) const {
+        if (pos >= kBitboardCapacity) {
+            return false;
+        }
+        return (words_[pos >> 6] >> (pos & 63)) & 1;
+    }
+
+    /**
+     * @brief Set Sets the bit at pos.
+     */
+    void Set(unsigned pos) {
+        assert(pos < kBitboardCapacity);
+        words_[pos >> 6] |= uint64_t(1) << (pos & 63);
+    }
+
+    /**
+     * @brief Reset Clears the bit at pos.
+     */
+    void Reset(unsigned pos) {
+        assert(pos < kBitboardCapacity);
+        words_[pos >> 6] &= ~(uint64_t(1) << (pos & 63));
+    }
+
+    /**
+     * @brief NextSetBit Position of the first set bit at or after from. It returns
+     * kBitboardCapacity if there isn't any.
+     */
+    unsigned NextSetBit(unsigned from) const {
+        unsigned word_index = from >> 6;
+        if (word_index >= kBitboardWords) {
+            return kBitboardCapacity;
+        }
+
+        uint64_t word = words_[word_index] & (~uint64_t(0) << (from & 63));
+        while (word == 0) {
+            ++word_index;
+            if (word_index == kBitboardWords) {
+                return kBitboardCapacity;
+            }
+            word = words_[word_index];
+        }
+        return (word_index << 6) + __builtin_ctzll(word);
+    }
+
+    /**
+     * @brief Count Number of set bits.
+     */
+    unsigned Count() const;
+
+    /**
+     * @brief Empty Checks if no bit is set.
+     */
+    bool Empty() const;
+
+    /**
+     * @brief Words Underlying storage, from the lowest bit positions to the highest.
+     */
+    std::array<uint64_t, kBitboardWords> const &Words() const;
+
+    bool operator==(Bitboard const &other) const;
+    bool operator!=(Bitboard const &other) const;
+
+  private:
+    std::array<uint64_t, kBitboardWords> words_;
+};
+
+} // namespace e8
+
+#endif // BITBOARD_H
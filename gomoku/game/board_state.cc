@@ -21,14 +21,64 @@
 #include <cstdint>
 #include <functional>
 #include <iostream>
-#include <memory>
 #include <optional>
-#include <unordered_map>
 #include <vector>
 
+#include "gomoku/game/bitboard.h"
 #include "gomoku/game/board_state.h"
 
 namespace e8 {
+namespace {
+
+// Maps a stone type to its bitboard.
+unsigned StonePlaneIndex(StoneType const stone_type) {
+    assert(stone_type != ST_NONE);
+    return stone_type - ST_BLACK;
+}
+
+/**
+ * @brief The ZobristKeys struct Random keys of the state components which are XORed together to
+ * form the hash.
+ */
+struct ZobristKeys {
+    std::array<std::array<uint64_t, kBitboardCapacity>, 2> stones;
+    std::array<uint64_t, GP_STANDARD_GOMOKU + 1> game_phases;
+    std::array<uint64_t, 2> player_sides;
+    std::array<std::array<uint64_t, ST_WHITE + 1>, 2> player_stone_types;
+};
+
+constexpr uint64_t SplitMix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr ZobristKeys MakeZobristKeys() {
+    ZobristKeys keys{};
+    uint64_t state = 0x5EED;
+    for (auto &plane : keys.stones) {
+        for (uint64_t &key : plane) {
+            key = SplitMix64(&state);
+        }
+    }
+    for (uint64_t &key : keys.game_phases) {
+        key = SplitMix64(&state);
+    }
+    for (uint64_t &key : keys.player_sides) {
+        key = SplitMix64(&state);
+    }
+    for (auto &stone_types : keys.player_stone_types) {
+        for (uint64_t &key : stone_types) {
+            key = SplitMix64(&state);
+        }
+    }
+    return keys;
+}
+
+constexpr ZobristKeys kZobristKeys = MakeZobristKeys();
+
+} // namespace
 
 PlayerSide OffensiveSide() { return PS_PLAYER_A; }
 
@@ -46,57 +96,82 @@ GomokuActionRecord::GomokuActionRecord(GamePhase const game_phase, PlayerSide co
                                        GomokuActionId const action_id, GomokuAction const &action)
     : game_phase(game_phase), side(side), action(std::make_pair(action_id, action)) {}
 
+GomokuActionSet::GomokuActionSet(int16_t const width, int16_t const height)
+    : width_(width), height_(height), size_(0) {
+    assert(width * height + 3 + 2 <= static_cast<int>(kBitboardCapacity));
+}
+
+GomokuAction GomokuActionSet::at(GomokuActionId const action_id) const {
+    assert(action_id >= 0 && action_ids_.Test(action_id));
+    return this->ToAction(action_id);
+}
+
+void GomokuActionSet::insert(GomokuActionId const action_id) {
+    assert(action_id >= 0);
+    if (!action_ids_.Test(action_id)) {
+        action_ids_.Set(action_id);
+        ++size_;
+    }
+}
+
+void GomokuActionSet::erase(GomokuActionId const action_id) {
+    assert(action_id >= 0);
+    if (action_ids_.Test(action_id)) {
+        action_ids_.Reset(action_id);
+        --size_;
+    }
+}
+
+GomokuAction GomokuActionSet::ToAction(GomokuActionId const action_id) const {
+    int16_t const num_cells = width_ * height_;
+    if (action_id < num_cells) {
+        return GomokuAction(MovePosition(action_id % width_, action_id / width_));
+    } else if (action_id < num_cells + 3) {
+        return GomokuAction(static_cast<Swap2Decision>(action_id - num_cells));
+    } else {
+        return GomokuAction(static_cast<StoneTypeDecision>(action_id - num_cells - 3));
+    }
+}
+
 GomokuBoardState::GomokuBoardState(int16_t const width, int16_t const height)
     : width_(width), height_(height), game_result_(GameResult::GR_UNDETERMINED),
       current_game_phase_(GP_PLACE_3_STONES), current_player_side_(OffensiveSide()),
-      board_(std::unique_ptr<StoneState[]>(new StoneState[width * height])),
-      player_stone_type_({StoneType::ST_BLACK, StoneType::ST_NONE}),
-      standard_gomoku_legal_actions_(2 * width * height) {
-    for (int16_t i = 0; i < this->Width() * this->Height(); ++i) {
-        board_[i] = StoneState();
+      player_stone_type_({StoneType::ST_BLACK, StoneType::ST_NONE}), stone_hash_(0),
+      swap2_decision_legal_actions_(width, height),
+      stone_type_decision_legal_actions_(width, height),
+      standard_gomoku_legal_actions_(width, height) {
+    assert(width <= kMaxBoardSideLength && height <= kMaxBoardSideLength);
+    // Leaves an empty guard column on the right so that lines don't wrap around rows.
+    assert((width + 1) * height <= static_cast<int>(kBitboardCapacity));
+
+    board_.fill(StoneState());
+    for (StoneLines &lines : stone_lines_) {
+        lines.rows.fill(0);
+        lines.columns.fill(0);
+        lines.diagonals.fill(0);
+        lines.anti_diagonals.fill(0);
     }
 
     for (int16_t y = 0; y < this->Height(); ++y) {
         for (int16_t x = 0; x < this->Width(); ++x) {
-            MovePosition pos(x, y);
-            GomokuActionId id = this->MovePositionToActionId(pos);
-            standard_gomoku_legal_actions_.insert(std::make_pair(id, GomokuAction(pos)));
+            standard_gomoku_legal_actions_.insert(this->MovePositionToActionId(MovePosition(x, y)));
         }
     }
 
     swap2_decision_legal_actions_.insert(
-        std::make_pair(this->Swap2DecisionToActionId(Swap2Decision::SW2D_CHOOSE_WHITE),
-                       GomokuAction(Swap2Decision::SW2D_CHOOSE_WHITE)));
+        this->Swap2DecisionToActionId(Swap2Decision::SW2D_CHOOSE_WHITE));
     swap2_decision_legal_actions_.insert(
-        std::make_pair(this->Swap2DecisionToActionId(Swap2Decision::SW2D_CHOOSE_BLACK),
-                       GomokuAction(Swap2Decision::SW2D_CHOOSE_BLACK)));
+        this->Swap2DecisionToActionId(Swap2Decision::SW2D_CHOOSE_BLACK));
     swap2_decision_legal_actions_.insert(
-        std::make_pair(this->Swap2DecisionToActionId(Swap2Decision::SW2D_PLACE_2_STONES),
-                       GomokuAction(Swap2Decision::SW2D_PLACE_2_STONES)));
+        this->Swap2DecisionToActionId(Swap2Decision::SW2D_PLACE_2_STONES));
 
     stone_type_decision_legal_actions_.insert(
-        std::make_pair(this->StoneTypeDecisionToActionId(StoneTypeDecision::STD_CHOOSE_WHITE),
-                       GomokuAction(StoneTypeDecision::STD_CHOOSE_WHITE)));
+        this->StoneTypeDecisionToActionId(StoneTypeDecision::STD_CHOOSE_WHITE));
     stone_type_decision_legal_actions_.insert(
-        std::make_pair(this->StoneTypeDecisionToActionId(StoneTypeDecision::STD_CHOOSE_BLACK),
-                       GomokuAction(StoneTypeDecision::STD_CHOOSE_BLACK)));
+        this->StoneTypeDecisionToActionId(StoneTypeDecision::STD_CHOOSE_BLACK));
 }
 
-GomokuBoardState::GomokuBoardState(GomokuBoardState const &other)
-    : width_(other.width_), height_(other.height_), game_result_(other.game_result_),
-      current_game_phase_(other.current_game_phase_),
-      current_player_side_(other.current_player_side_),
-      board_(std::unique_ptr<StoneState[]>(new StoneState[other.width_ * other.height_])),
-      player_stone_type_(other.player_stone_type_), history_(other.history_),
-      swap2_decision_legal_actions_(other.swap2_decision_legal_actions_),
-      stone_type_decision_legal_actions_(other.stone_type_decision_legal_actions_),
-      standard_gomoku_legal_actions_(other.standard_gomoku_legal_actions_) {
-    for (int16_t i = 0; i < this->Width() * this->Height(); ++i) {
-        board_[i] = other.board_[i];
-    }
-}
-
-std::unordered_map<GomokuActionId, GomokuAction> const &GomokuBoardState::LegalActions() const {
+GomokuActionSet const &GomokuBoardState::LegalActions() const {
     switch (this->CurrentGamePhase()) {
     case GP_PLACE_3_STONES:
     case GP_SWAP2_PLACE_2_STONES:
@@ -139,39 +214,16 @@ GameResult GomokuBoardState::ApplyAction(GomokuActionId const action_id,
                                          std::optional<GameResult> const cached_game_result) {
     assert(game_result_ == GameResult::GR_UNDETERMINED);
 
-    std::unordered_map<GomokuActionId, GomokuAction>::const_iterator action_it;
-    switch (this->CurrentGamePhase()) {
-    case GP_PLACE_3_STONES:
-    case GP_SWAP2_PLACE_2_STONES:
-    case GP_STANDARD_GOMOKU: {
-        action_it = standard_gomoku_legal_actions_.find(action_id);
-        assert(action_it != standard_gomoku_legal_actions_.end());
-        break;
-    }
-    case GP_SWAP2_DECISION: {
-        action_it = swap2_decision_legal_actions_.find(action_id);
-        assert(action_it != swap2_decision_legal_actions_.end());
-        break;
-    }
-    case GP_STONE_TYPE_DECISION: {
-        action_it = stone_type_decision_legal_actions_.find(action_id);
-        assert(action_it != stone_type_decision_legal_actions_.end());
-        break;
-    }
-    default:
-        assert(false);
-        break;
-    }
+    GomokuAction const action = this->LegalActions().at(action_id);
 
     history_.push_back(GomokuActionRecord(this->CurrentGamePhase(), this->CurrentPlayerSide(),
-                                          action_it->first, action_it->second));
+                                          action_id, action));
 
     switch (this->CurrentGamePhase()) {
     case GP_PLACE_3_STONES: {
         assert(player_stone_type_[this->CurrentPlayerSide()] != StoneType::ST_NONE);
-        assert(*this->ChessPieceStateAt(*action_it->second.stone_pos) == StoneType::ST_NONE);
-        *this->ChessPieceStateAt(*action_it->second.stone_pos) =
-            player_stone_type_[this->CurrentPlayerSide()];
+        assert(*this->ChessPieceStateAt(*action.stone_pos) == StoneType::ST_NONE);
+        this->PlaceStone(*action.stone_pos, player_stone_type_[this->CurrentPlayerSide()]);
 
         if (history_.size() == 2) {
             player_stone_type_[PlayerSide::PS_PLAYER_A] = StoneType::ST_WHITE;
@@ -181,11 +233,11 @@ GameResult GomokuBoardState::ApplyAction(GomokuActionId const action_id,
             current_player_side_ = PlayerSide::PS_PLAYER_B;
         }
 
-        standard_gomoku_legal_actions_.erase(action_it);
+        standard_gomoku_legal_actions_.erase(action_id);
         break;
     }
     case GP_SWAP2_DECISION: {
-        switch (*action_it->second.swap2_decision) {
+        switch (*action.swap2_decision) {
         case SW2D_CHOOSE_WHITE: {
             player_stone_type_[PlayerSide::PS_PLAYER_A] = StoneType::ST_BLACK;
             player_stone_type_[PlayerSide::PS_PLAYER_B] = StoneType::ST_WHITE;
@@ -213,9 +265,8 @@ GameResult GomokuBoardState::ApplyAction(GomokuActionId const action_id,
     }
     case GP_SWAP2_PLACE_2_STONES: {
         assert(player_stone_type_[this->CurrentPlayerSide()] != StoneType::ST_NONE);
-        assert(*this->ChessPieceStateAt(*action_it->second.stone_pos) == StoneType::ST_NONE);
-        *this->ChessPieceStateAt(*action_it->second.stone_pos) =
-            StoneState(player_stone_type_[this->CurrentPlayerSide()]);
+        assert(*this->ChessPieceStateAt(*action.stone_pos) == StoneType::ST_NONE);
+        this->PlaceStone(*action.stone_pos, player_stone_type_[this->CurrentPlayerSide()]);
 
         if (history_.size() == 5) {
             player_stone_type_[PlayerSide::PS_PLAYER_B] = StoneType::ST_BLACK;
@@ -225,11 +276,11 @@ GameResult GomokuBoardState::ApplyAction(GomokuActionId const action_id,
             current_player_side_ = PlayerSide::PS_PLAYER_A;
         }
 
-        standard_gomoku_legal_actions_.erase(action_it);
+        standard_gomoku_legal_actions_.erase(action_id);
         break;
     }
     case GP_STONE_TYPE_DECISION: {
-        switch (*action_it->second.stone_type_decision) {
+        switch (*action.stone_type_decision) {
         case STD_CHOOSE_WHITE: {
             player_stone_type_[PlayerSide::PS_PLAYER_A] = StoneType::ST_WHITE;
             player_stone_type_[PlayerSide::PS_PLAYER_B] = StoneType::ST_BLACK;
@@ -247,15 +298,14 @@ GameResult GomokuBoardState::ApplyAction(GomokuActionId const action_id,
     }
     case GP_STANDARD_GOMOKU: {
         assert(player_stone_type_[this->CurrentPlayerSide()] != StoneType::ST_NONE);
-        assert(*this->ChessPieceStateAt(*action_it->second.stone_pos) == StoneType::ST_NONE);
-        *this->ChessPieceStateAt(*action_it->second.stone_pos) =
-            StoneState(player_stone_type_[this->CurrentPlayerSide()]);
+        assert(*this->ChessPieceStateAt(*action.stone_pos) == StoneType::ST_NONE);
+        this->PlaceStone(*action.stone_pos, player_stone_type_[this->CurrentPlayerSide()]);
 
         if (cached_game_result.has_value()) {
             game_result_ = *cached_game_result;
         } else {
             unsigned max_connected_stones = this->MaxConnectedStonesFrom(
-                *action_it->second.stone_pos, player_stone_type_[this->CurrentPlayerSide()]);
+                *action.stone_pos, player_stone_type_[this->CurrentPlayerSide()]);
             if (max_connected_stones == 5) {
                 switch (current_player_side_) {
                 case PS_PLAYER_A:
@@ -273,7 +323,7 @@ GameResult GomokuBoardState::ApplyAction(GomokuActionId const action_id,
         current_player_side_ =
             static_cast<PlayerSide>((static_cast<unsigned>(current_player_side_) + 1) & 1);
 
-        standard_gomoku_legal_actions_.erase(action_it);
+        standard_gomoku_legal_actions_.erase(action_id);
         break;
     }
     }
@@ -294,8 +344,8 @@ std::optional<GomokuActionRecord> GomokuBoardState::RetractAction() {
     case GP_PLACE_3_STONES: {
         current_game_phase_ = GP_PLACE_3_STONES;
 
-        *this->ChessPieceStateAt(*record.action.second.stone_pos) = StoneState();
-        standard_gomoku_legal_actions_.insert(record.action);
+        this->RemoveStone(*record.action.second.stone_pos);
+        standard_gomoku_legal_actions_.insert(record.action.first);
 
         current_player_side_ = PlayerSide::PS_PLAYER_A;
 
@@ -319,8 +369,8 @@ std::optional<GomokuActionRecord> GomokuBoardState::RetractAction() {
     case GP_SWAP2_PLACE_2_STONES: {
         current_game_phase_ = GP_SWAP2_PLACE_2_STONES;
 
-        *this->ChessPieceStateAt(*record.action.second.stone_pos) = StoneState();
-        standard_gomoku_legal_actions_.insert(record.action);
+        this->RemoveStone(*record.action.second.stone_pos);
+        standard_gomoku_legal_actions_.insert(record.action.first);
 
         current_player_side_ = PlayerSide::PS_PLAYER_B;
 
@@ -344,8 +394,8 @@ std::optional<GomokuActionRecord> GomokuBoardState::RetractAction() {
     case GP_STANDARD_GOMOKU: {
         current_game_phase_ = GP_STANDARD_GOMOKU;
 
-        *this->ChessPieceStateAt(*record.action.second.stone_pos) = StoneState();
-        standard_gomoku_legal_actions_.insert(record.action);
+        this->RemoveStone(*record.action.second.stone_pos);
+        standard_gomoku_legal_actions_.insert(record.action.first);
 
         current_player_side_ =
             static_cast<PlayerSide>((static_cast<unsigned>(current_player_side_) + 1) & 1);
@@ -369,6 +419,13 @@ std::optional<GomokuActionRecord> GomokuBoardState::LastAction() const {
 
 GameResult GomokuBoardState::CurrentGameResult() const { return game_result_; }
 
+uint64_t GomokuBoardState::Hash() const {
+    return stone_hash_ ^ kZobristKeys.game_phases[current_game_phase_] ^
+           kZobristKeys.player_sides[current_player_side_] ^
+           kZobristKeys.player_stone_types[PS_PLAYER_A][player_stone_type_[PS_PLAYER_A]] ^
+           kZobristKeys.player_stone_types[PS_PLAYER_B][player_stone_type_[PS_PLAYER_B]];
+}
+
 std::vector<GomokuActionRecord> const &GomokuBoardState::History() const { return history_; }
 
 int16_t GomokuBoardState::Width() const { return width_; }
@@ -394,7 +451,8 @@ void GomokuBoardState::PrintBoard() const {
             default: {
                 std::cerr << std::endl
                           << "Impossible chess state at=(" << x << "," << y
-                          << "), value=" << *this->ChessPieceStateAt(MovePosition(x, y))
+                          << "), value="
+                          << static_cast<int>(*this->ChessPieceStateAt(MovePosition(x, y)))
                           << std::endl;
                 assert(false);
             }
@@ -415,7 +473,10 @@ GomokuBoardState &GomokuBoardState::operator=(GomokuBoardState rhs) {
     std::swap(current_game_phase_, rhs.current_game_phase_);
     std::swap(current_player_side_, rhs.current_player_side_);
     std::swap(board_, rhs.board_);
+    std::swap(stone_planes_, rhs.stone_planes_);
+    std::swap(stone_lines_, rhs.stone_lines_);
     std::swap(player_stone_type_, rhs.player_stone_type_);
+    std::swap(stone_hash_, rhs.stone_hash_);
     std::swap(history_, rhs.history_);
     std::swap(swap2_decision_legal_actions_, rhs.swap2_decision_legal_actions_);
     std::swap(stone_type_decision_legal_actions_, rhs.stone_type_decision_legal_actions_);
@@ -423,113 +484,77 @@ GomokuBoardState &GomokuBoardState::operator=(GomokuBoardState rhs) {
     return *this;
 }
 
-StoneState *GomokuBoardState::ChessPieceStateAt(MovePosition const &pos) {
-    return &board_[pos.x + pos.y * width_];
-}
-
 StoneState const *GomokuBoardState::ChessPieceStateAt(MovePosition const &pos) const {
     assert(pos.x >= 0 && pos.x < this->Width() && pos.y >= 0 && pos.y < this->Height());
     return &board_[pos.x + pos.y * width_];
 }
 
-uint8_t GomokuBoardState::MaxConnectedStonesFrom(MovePosition const &move_pos,
-                                                 StoneType const stone_type) const {
-    int8_t max_connected_stones = 0;
-
-    {
-        int8_t num_connected_stones;
-
-        // Counter clockwise 135 degrees.
-        MovePosition pos(move_pos.x - 1, move_pos.y - 1);
-        while (pos.x >= 0 && pos.y >= 0 && *this->ChessPieceStateAt(pos) == stone_type) {
-            --pos.x;
-            --pos.y;
-        }
-        num_connected_stones = move_pos.x - pos.x - 1;
-
-        // Counter clockwise -45 degrees.
-        pos.x = move_pos.x + 1;
-        pos.y = move_pos.y + 1;
-        while (pos.x < width_ && pos.y < height_ && *this->ChessPieceStateAt(pos) == stone_type) {
-            ++pos.x;
-            ++pos.y;
-        }
-        num_connected_stones += pos.x - move_pos.x;
-
-        if (num_connected_stones > max_connected_stones) {
-            max_connected_stones = num_connected_stones;
-        }
-    }
-    {
-        int8_t num_connected_stones;
-
-        // Counter clockwise 90 degrees.
-        MovePosition pos(move_pos.x, move_pos.y - 1);
-        while (pos.y >= 0 && *this->ChessPieceStateAt(pos) == stone_type) {
-            --pos.y;
-        }
-        num_connected_stones = move_pos.y - pos.y - 1;
+Bitboard const &GomokuBoardState::StonePlane(StoneType const stone_type) const {
+    return stone_planes_[StonePlaneIndex(stone_type)];
+}
 
-        // Counter clockwise -90 degrees.
-        pos.x = move_pos.x;
-        pos.y = move_pos.y + 1;
-        while (pos.y < height_ && *this->ChessPieceStateAt(pos) == stone_type) {
-            ++pos.y;
-        }
-        num_connected_stones += pos.y - move_pos.y;
+void GomokuBoardState::WriteBoardPlane(uint8_t *plane) const {
+    static_assert(sizeof(StoneState) == sizeof(uint8_t));
 
-        if (num_connected_stones > max_connected_stones) {
-            max_connected_stones = num_connected_stones;
+    // Walks the cells in the plane's order so that the stores stay contiguous.
+    for (int16_t x = 0; x < width_; ++x) {
+        StoneState const *column = board_.data() + x;
+        for (int16_t y = 0; y < height_; ++y) {
+            plane[y] = column[y * width_];
         }
+        plane += height_;
     }
-    {
-        int8_t num_connected_stones;
-
-        // Counter clockwise 45 degrees.
-        MovePosition pos(move_pos.x + 1, move_pos.y - 1);
-        while (pos.x < width_ && pos.y >= 0 && *this->ChessPieceStateAt(pos) == stone_type) {
-            ++pos.x;
-            --pos.y;
-        }
-        num_connected_stones = pos.x - move_pos.x - 1;
-
-        // Counter clockwise -135 degrees.
-        pos.x = move_pos.x - 1;
-        pos.y = move_pos.y + 1;
-        while (pos.x >= 0 && pos.y < height_ && *this->ChessPieceStateAt(pos) == stone_type) {
-            --pos.x;
-            ++pos.y;
-        }
-        num_connected_stones += move_pos.x - pos.x;
+}
 
-        if (num_connected_stones > max_connected_stones) {
-            max_connected_stones = num_connected_stones;
-        }
-    }
-    {
-        int8_t num_connected_stones;
+void GomokuBoardState::PlaceStone(MovePosition const &pos, StoneType const stone_type) {
+    StoneState *cell = &board_[pos.x + pos.y * width_];
+    assert(*cell == StoneType::ST_NONE);
+    *cell = stone_type;
+    stone_planes_[StonePlaneIndex(stone_type)].Set(pos.x + pos.y * (width_ + 1));
+    stone_hash_ ^= kZobristKeys.stones[StonePlaneIndex(stone_type)][pos.x + pos.y * width_];
+    this->FlipStoneLines(pos, stone_type);
+}
 
-        // Counter clockwise 180 degrees.
-        MovePosition pos(move_pos.x - 1, move_pos.y);
-        while (pos.x >= 0 && *this->ChessPieceStateAt(pos) == stone_type) {
-            --pos.x;
-        }
-        num_connected_stones = move_pos.x - pos.x - 1;
+void GomokuBoardState::RemoveStone(MovePosition const &pos) {
+    StoneState *cell = &board_[pos.x + pos.y * width_];
+    assert(*cell != StoneType::ST_NONE);
+    stone_planes_[StonePlaneIndex(*cell)].Reset(pos.x + pos.y * (width_ + 1));
+    stone_hash_ ^= kZobristKeys.stones[StonePlaneIndex(*cell)][pos.x + pos.y * width_];
+    this->FlipStoneLines(pos, *cell);
+    *cell = StoneType::ST_NONE;
+}
 
-        // Counter clockwise 0 degrees.
-        pos.x = move_pos.x + 1;
-        pos.y = move_pos.y;
-        while (pos.x < width_ && *this->ChessPieceStateAt(pos) == stone_type) {
-            ++pos.x;
-        }
-        num_connected_stones += pos.x - move_pos.x;
+void GomokuBoardState::FlipStoneLines(MovePosition const &pos, StoneType const stone_type) {
+    StoneLines &lines = stone_lines_[StonePlaneIndex(stone_type)];
+    lines.rows[pos.y] ^= 1U << pos.x;
+    lines.columns[pos.x] ^= 1U << pos.y;
+    lines.diagonals[pos.x - pos.y + height_ - 1] ^= 1U << pos.x;
+    lines.anti_diagonals[pos.x + pos.y] ^= 1U << pos.x;
+}
 
-        if (num_connected_stones > max_connected_stones) {
-            max_connected_stones = num_connected_stones;
-        }
+uint8_t GomokuBoardState::MaxConnectedStonesFrom(MovePosition const &move_pos,
+                                                 StoneType const stone_type) const {
+    StoneLines const &lines = stone_lines_[StonePlaneIndex(stone_type)];
+
+    // The lines through the move position and the bit the move position takes in each of them.
+    std::array<std::pair<uint32_t, unsigned>, 4> const lines_through = {
+        std::make_pair(lines.rows[move_pos.y], move_pos.x),
+        std::make_pair(lines.columns[move_pos.x], move_pos.y),
+        std::make_pair(lines.diagonals[move_pos.x - move_pos.y + height_ - 1], move_pos.x),
+        std::make_pair(lines.anti_diagonals[move_pos.x + move_pos.y], move_pos.x),
+    };
+
+    unsigned max_connected_stones = 0;
+    for (auto const &[line, offset] : lines_through) {
+        assert((line >> offset) & 1);
+
+        // Lengths of the run of stones starting at the move position and of the run right before
+        // it. Lines are at most 15 bits long, so both complements have a set bit.
+        unsigned num_from = __builtin_ctz(~(line >> offset));
+        unsigned num_before = __builtin_clz(~((line << 1) << (31 - offset)));
+        max_connected_stones = std::max(max_connected_stones, num_from + num_before);
     }
 
-    assert(max_connected_stones >= 0);
     return max_connected_stones;
 }
 
@@ -19,14 +19,16 @@
 #define BOARD_STATE_H
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
-#include <memory>
+#include <iterator>
 #include <optional>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "gomoku/game/bitboard.h"
+
 namespace e8 {
 
 enum GameResult {
@@ -38,7 +40,7 @@ enum GameResult {
 
 enum PlayerSide { PS_PLAYER_A, PS_PLAYER_B };
 
-enum StoneType { ST_NONE, ST_BLACK, ST_WHITE };
+enum StoneType : uint8_t { ST_NONE, ST_BLACK, ST_WHITE };
 
 enum GamePhase {
     GP_PLACE_3_STONES,
@@ -116,9 +118,122 @@ struct GomokuAction {
     GomokuAction &operator=(GomokuAction const &other);
 };
 
+// The longest board side supported by GomokuBoardState.
+static int const kMaxBoardSideLength = 15;
+
 // Zero-offset action ID allowing all actions in the game are densely numbered.
 using GomokuActionId = int16_t;
 
+/**
+ * @brief The GomokuActionSet class A set of actions stored as a bitset over the action IDs. It
+ * exposes the look-up and iteration interface of an unordered map from action ID to action, where
+ * the actions are decoded from their IDs on the fly. Actions are iterated in ascending ID order.
+ */
+class GomokuActionSet {
+  public:
+    using value_type = std::pair<GomokuActionId, GomokuAction>;
+
+    class const_iterator {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = GomokuActionSet::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = value_type;
+
+        struct pointer {
+            value_type const *operator->() const { return &value; }
+            value_type value;
+        };
+
+        const_iterator(GomokuActionSet const *set, unsigned action_id)
+            : set_(set), action_id_(action_id) {}
+
+        value_type operator*() const {
+            return value_type(action_id_, set_->ToAction(action_id_));
+        }
+
+        pointer operator->() const { return pointer{**this}; }
+
+        const_iterator &operator++() {
+            action_id_ = set_->action_ids_.NextSetBit(action_id_ + 1);
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const_iterator const &other) const {
+            return action_id_ == other.action_id_;
+        }
+
+        bool operator!=(const_iterator const &other) const {
+            return action_id_ != other.action_id_;
+        }
+
+      private:
+        GomokuActionSet const *set_;
+        unsigned action_id_;
+    };
+
+    using iterator = const_iterator;
+
+    /**
+     * @brief GomokuActionSet Constructs an empty action set for a board of the specified size.
+     */
+    GomokuActionSet(int16_t const width, int16_t const height);
+    ~GomokuActionSet() = default;
+
+    size_t size() const { return size_; }
+
+    bool empty() const { return size_ == 0; }
+
+    const_iterator begin() const { return const_iterator(this, action_ids_.NextSetBit(0)); }
+
+    const_iterator end() const { return const_iterator(this, kBitboardCapacity); }
+
+    /**
+     * @brief find Returns the iterator pointing to the action or end() if the action isn't in the
+     * set.
+     */
+    const_iterator find(GomokuActionId const action_id) const {
+        if (action_id < 0 || !action_ids_.Test(action_id)) {
+            return this->end();
+        }
+        return const_iterator(this, action_id);
+    }
+
+    /**
+     * @brief at Returns the action with the specified ID. The action has to be in the set.
+     */
+    GomokuAction at(GomokuActionId const action_id) const;
+
+    /**
+     * @brief insert Adds an action to the set. It does nothing if it's already in the set.
+     */
+    void insert(GomokuActionId const action_id);
+
+    /**
+     * @brief erase Removes an action from the set. It does nothing if it isn't in the set.
+     */
+    void erase(GomokuActionId const action_id);
+
+    /**
+     * @brief ActionIds Bitset of the action IDs in the set.
+     */
+    Bitboard const &ActionIds() const { return action_ids_; }
+
+  private:
+    GomokuAction ToAction(GomokuActionId const action_id) const;
+
+    Bitboard action_ids_;
+    int16_t width_;
+    int16_t height_;
+    uint16_t size_;
+};
+
 /**
  * @brief The GomokuActionRecord struct Stores the information about an action made so as to keep
  * track of the board history.
@@ -136,6 +251,8 @@ struct GomokuActionRecord {
  * @brief The GomokuBoardState class Represents the state of the chess board.
  *
  * The board state is defined by the tuple <ChessBoard, PlayerSide, GamePhase, GameResult>.
+ * Stones are kept in one bitboard per stone type and the legal actions in a bitset, so applying
+ * and retracting an action doesn't allocate. Sides can't be longer than kMaxBoardSideLength.
  * Thread-safety is not guaranteed.
  */
 class GomokuBoardState {
@@ -148,7 +265,7 @@ class GomokuBoardState {
      */
     GomokuBoardState(int16_t const width, int16_t const height);
 
-    GomokuBoardState(GomokuBoardState const &other);
+    GomokuBoardState(GomokuBoardState const &other) = default;
     GomokuBoardState(GomokuBoardState &&other) = default;
     ~GomokuBoardState() = default;
 
@@ -156,7 +273,7 @@ class GomokuBoardState {
      * @brief LegalActions The set of legal actions that can be made by the CurrentPlayerSide()
      * given the board state.
      */
-    std::unordered_map<GomokuActionId, GomokuAction> const &LegalActions() const;
+    GomokuActionSet const &LegalActions() const;
 
     /**
      * @brief ActionIdRange Since action IDs are compact. Knowing the range the action IDs this
@@ -234,12 +351,26 @@ class GomokuBoardState {
     /**
      * @brief ChessPieceStateAt Retrieve the state of the move position.
      */
-    StoneState *ChessPieceStateAt(MovePosition const &pos);
+    StoneState const *ChessPieceStateAt(MovePosition const &pos) const;
 
     /**
-     * @brief ChessPieceStateAt Constant version of the above function.
+     * @brief StonePlane The bitboard of the stones of the specified type. Cell (x, y) is at bit
+     * x + y*(Width() + 1). The extra column on the right is always empty.
      */
-    StoneState const *ChessPieceStateAt(MovePosition const &pos) const;
+    Bitboard const &StonePlane(StoneType const stone_type) const;
+
+    /**
+     * @brief WriteBoardPlane Packs the stone states into a Width() x Height() plane where cell
+     * (x, y) is at plane[y + x*Height()], the layout of the model board inputs.
+     */
+    void WriteBoardPlane(uint8_t *plane) const;
+
+    /**
+     * @brief Hash The Zobrist hash of the board state. Action sequences which transpose into the
+     * same state produce the same hash. It's maintained incrementally by ApplyAction() and
+     * RetractAction().
+     */
+    uint64_t Hash() const;
 
     /**
      * @brief History Returns a history of action records.
@@ -269,6 +400,18 @@ class GomokuBoardState {
     GomokuBoardState &operator=(GomokuBoardState rhs);
 
   private:
+    // Stones of one type along each row, column, diagonal and anti-diagonal. Bit x of a row,
+    // diagonal or anti-diagonal and bit y of a column are set if cell (x, y) holds a stone.
+    struct StoneLines {
+        std::array<uint16_t, kMaxBoardSideLength> rows;
+        std::array<uint16_t, kMaxBoardSideLength> columns;
+        std::array<uint16_t, 2 * kMaxBoardSideLength - 1> diagonals;
+        std::array<uint16_t, 2 * kMaxBoardSideLength - 1> anti_diagonals;
+    };
+
+    void PlaceStone(MovePosition const &pos, StoneType const stone_type);
+    void RemoveStone(MovePosition const &pos);
+    void FlipStoneLines(MovePosition const &pos, StoneType const stone_type);
     uint8_t MaxConnectedStonesFrom(MovePosition const &pos, StoneType const stone_type) const;
 
     int16_t const width_;
@@ -277,14 +420,19 @@ class GomokuBoardState {
     GamePhase current_game_phase_;
     PlayerSide current_player_side_;
 
-    std::unique_ptr<StoneState[]> board_;
+    std::array<StoneState, kBitboardCapacity> board_;
+    std::array<Bitboard, 2> stone_planes_;
+    std::array<StoneLines, 2> stone_lines_;
     std::array<StoneType, 2> player_stone_type_;
 
+    // Zobrist hash of the stones alone. Hash() mixes in the rest of the state.
+    uint64_t stone_hash_;
+
     std::vector<GomokuActionRecord> history_;
 
-    std::unordered_map<GomokuActionId, GomokuAction> swap2_decision_legal_actions_;
-    std::unordered_map<GomokuActionId, GomokuAction> stone_type_decision_legal_actions_;
-    std::unordered_map<GomokuActionId, GomokuAction> standard_gomoku_legal_actions_;
+    GomokuActionSet swap2_decision_legal_actions_;
+    GomokuActionSet stone_type_decision_legal_actions_;
+    GomokuActionSet standard_gomoku_legal_actions_;
 };
 
 } // namespace e8
@@ -0,0 +1,229 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <optional>
+
+#include "gomoku/game/bitboard.h"
+#include "gomoku/game/board_state.h"
+#include "gomoku/game/board_symmetry.h"
+
+namespace e8 {
+namespace {
+
+/**
+ * @brief The SymmetricZobristKeys struct Random keys of the state components for
+ * SymmetricHash(). The stone keys are indexed by x + y*kMaxBoardSideLength so that they don't
+ * depend on the board width.
+ */
+struct SymmetricZobristKeys {
+    std::array<std::array<uint64_t, kMaxBoardSideLength * kMaxBoardSideLength>, 2> stones;
+    std::array<uint64_t, GP_STANDARD_GOMOKU + 1> game_phases;
+    std::array<uint64_t, 2> player_sides;
+    std::array<std::array<uint64_t, ST_WHITE + 1>, 2> player_stone_types;
+};
+
+constexpr uint64_t SplitMix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr SymmetricZobristKeys MakeSymmetricZobristKeys() {
+    SymmetricZobristKeys keys{};
+    uint64_t state = 0xD14EDAL;
+    for (auto &plane : keys.stones) {
+        for (uint64_t &key : plane) {
+            key = SplitMix64(&state);
+        }
+    }
+    for (uint64_t &key : keys.game_phases) {
+        key = SplitMix64(&state);
+    }
+    for (uint64_t &key : keys.player_sides) {
+        key = SplitMix64(&state);
+    }
+    for (auto &stone_types : keys.player_stone_types) {
+        for (uint64_t &key : stone_types) {
+            key = SplitMix64(&state);
+        }
+    }
+    return keys;
+}
+
+constexpr SymmetricZobristKeys kSymmetricZobristKeys = MakeSymmetricZobristKeys();
+
+template <typename T>
+void TransformCellPlanesImpl(T const *source, unsigned const num_channels,
+                             BoardSymmetry const symmetry, int16_t const width,
+                             int16_t const height, T *destination) {
+    assert(SymmetryApplies(symmetry, width, height));
+
+    for (int16_t y = 0; y < height; ++y) {
+        for (int16_t x = 0; x < width; ++x) {
+            MovePosition const pos =
+                TransformMovePosition(MovePosition(x, y), symmetry, width, height);
+            T const *src = source + (x + y * width) * num_channels;
+            T *dst = destination + (pos.x + pos.y * width) * num_channels;
+            for (unsigned c = 0; c < num_channels; ++c) {
+                dst[c] = src[c];
+            }
+        }
+    }
+}
+
+} // namespace
+
+bool SymmetryApplies(BoardSymmetry const symmetry, int16_t const width, int16_t const height) {
+    return width == height || (symmetry & 1) == 0;
+}
+
+BoardSymmetry InverseSymmetry(BoardSymmetry const symmetry) {
+    if (symmetry >= BS_FLIP) {
+        // Mirroring then rotating is an involution.
+        return symmetry;
+    }
+    return static_cast<BoardSymmetry>((4 - symmetry) & 3);
+}
+
+MovePosition TransformMovePosition(MovePosition const &pos, BoardSymmetry const symmetry,
+                                   int16_t const width, int16_t const height) {
+    assert(SymmetryApplies(symmetry, width, height));
+
+    int8_t x = pos.x;
+    int8_t y = pos.y;
+    if (symmetry >= BS_FLIP) {
+        x = width - 1 - x;
+    }
+
+    switch (symmetry & 3) {
+    case 0: {
+        return MovePosition(x, y);
+    }
+    case 1: {
+        return MovePosition(width - 1 - y, x);
+    }
+    case 2: {
+        return MovePosition(width - 1 - x, height - 1 - y);
+    }
+    default: {
+        return MovePosition(y, width - 1 - x);
+    }
+    }
+}
+
+GomokuActionId TransformActionId(GomokuActionId const action_id, BoardSymmetry const symmetry,
+                                 int16_t const width, int16_t const height) {
+    if (action_id >= width * height) {
+        return action_id;
+    }
+
+    MovePosition const pos = TransformMovePosition(
+        MovePosition(action_id % width, action_id / width), symmetry, width, height);
+    return pos.x + pos.y * width;
+}
+
+GomokuBoardState TransformBoardState(GomokuBoardState const &board, BoardSymmetry const symmetry) {
+    GomokuBoardState transformed(board.Width(), board.Height());
+    for (GomokuActionRecord const &record : board.History()) {
+        GomokuActionId const action_id =
+            TransformActionId(record.action.first, symmetry, board.Width(), board.Height());
+
+        // Only the last action can end the game.
+        std::optional<GameResult> cached_game_result;
+        if (transformed.History().size() + 1 < board.History().size()) {
+            cached_game_result = GR_UNDETERMINED;
+        }
+        transformed.ApplyAction(action_id, cached_game_result);
+    }
+    return transformed;
+}
+
+void TransformCellPlanes(uint8_t const *source, unsigned const num_channels,
+                         BoardSymmetry const symmetry, int16_t const width, int16_t const height,
+                         uint8_t *destination) {
+    TransformCellPlanesImpl(source, num_channels, symmetry, width, height, destination);
+}
+
+void TransformCellPlanes(float const *source, unsigned const num_channels,
+                         BoardSymmetry const symmetry, int16_t const width, int16_t const height,
+                         float *destination) {
+    TransformCellPlanesImpl(source, num_channels, symmetry, width, height, destination);
+}
+
+void TransformFlatPolicy(float const *source, BoardSymmetry const symmetry, int16_t const width,
+                         int16_t const height, float *destination) {
+    TransformCellPlanes(source, /*num_channels=*/1, symmetry, width, height, destination);
+
+    int const num_cells = width * height;
+    for (int i = num_cells; i < num_cells + 5; ++i) {
+        destination[i] = source[i];
+    }
+}
+
+uint64_t SymmetricHash(GomokuBoardState const &board, BoardSymmetry const symmetry) {
+    int16_t const width = board.Width();
+    int16_t const height = board.Height();
+
+    uint64_t hash = kSymmetricZobristKeys.game_phases[board.CurrentGamePhase()] ^
+                    kSymmetricZobristKeys.player_sides[board.CurrentPlayerSide()];
+    for (PlayerSide side : {PS_PLAYER_A, PS_PLAYER_B}) {
+        hash ^= kSymmetricZobristKeys.player_stone_types[side][board.PlayerStoneType(side)];
+    }
+
+    for (StoneType stone_type : {ST_BLACK, ST_WHITE}) {
+        Bitboard const &plane = board.StonePlane(stone_type);
+        auto const &keys = kSymmetricZobristKeys.stones[stone_type - ST_BLACK];
+
+        for (unsigned bit = plane.NextSetBit(0); bit < kBitboardCapacity;
+             bit = plane.NextSetBit(bit + 1)) {
+            MovePosition const pos = TransformMovePosition(
+                MovePosition(bit % (width + 1), bit / (width + 1)), symmetry, width, height);
+            hash ^= keys[pos.x + pos.y * kMaxBoardSideLength];
+        }
+    }
+
+    return hash;
+}
+
+BoardSymmetry CanonicalSymmetry(GomokuBoardState const &board, uint64_t *canonical_hash) {
+    BoardSymmetry best_symmetry = BS_IDENTITY;
+    uint64_t best_hash = SymmetricHash(board, BS_IDENTITY);
+
+    for (unsigned i = 1; i < kNumBoardSymmetries; ++i) {
+        BoardSymmetry const symmetry = static_cast<BoardSymmetry>(i);
+        if (!SymmetryApplies(symmetry, board.Width(), board.Height())) {
+            continue;
+        }
+
+        uint64_t const hash = SymmetricHash(board, symmetry);
+        if (hash < best_hash) {
+            best_hash = hash;
+            best_symmetry = symmetry;
+        }
+    }
+
+    if (canonical_hash != nullptr) {
+        *canonical_hash = best_hash;
+    }
+    return best_symmetry;
+}
+
+} // namespace e8
@@ -0,0 +1,112 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BOARD_SYMMETRY_H
+#define BOARD_SYMMETRY_H
+
+#include <cstdint>
+
+#include "gomoku/game/board_state.h"
+
+namespace e8 {
+
+/**
+ * @brief The BoardSymmetry enum The dihedral symmetries of the board. BS_FLIP mirrors the x
+ * coordinate. The rotations turn the board by 90 degrees each, mapping (x, y) to (n - 1 - y, x),
+ * which matches numpy.rot90() on a board array indexed by [x, y]. The flipped rotations mirror
+ * first then rotate. The order agrees with the transform types 0 to 7 of the trainer's
+ * augmentation.py.
+ */
+enum BoardSymmetry : uint8_t {
+    BS_IDENTITY,
+    BS_ROTATE_90,
+    BS_ROTATE_180,
+    BS_ROTATE_270,
+    BS_FLIP,
+    BS_FLIP_ROTATE_90,
+    BS_FLIP_ROTATE_180,
+    BS_FLIP_ROTATE_270,
+};
+
+static unsigned const kNumBoardSymmetries = 8;
+
+/**
+ * @brief SymmetryApplies Whether the symmetry maps the board onto itself. The 90 and 270 degree
+ * rotations only apply to square boards.
+ */
+bool SymmetryApplies(BoardSymmetry symmetry, int16_t width, int16_t height);
+
+/**
+ * @brief InverseSymmetry The symmetry which undoes the specified one.
+ */
+BoardSymmetry InverseSymmetry(BoardSymmetry symmetry);
+
+/**
+ * @brief TransformMovePosition Maps a position on a board of the specified dimension.
+ */
+MovePosition TransformMovePosition(MovePosition const &pos, BoardSymmetry symmetry, int16_t width,
+                                   int16_t height);
+
+/**
+ * @brief TransformActionId Maps the action ID of a stone placement to the ID of the transformed
+ * placement. The swap2 and stone type decisions are left unchanged.
+ */
+GomokuActionId TransformActionId(GomokuActionId action_id, BoardSymmetry symmetry, int16_t width,
+                                 int16_t height);
+
+/**
+ * @brief TransformBoardState Replays the board's history with transformed actions. The resulting
+ * board has the same game phase, player side and game result.
+ */
+GomokuBoardState TransformBoardState(GomokuBoardState const &board, BoardSymmetry symmetry);
+
+/**
+ * @brief TransformCellPlanes Transforms per cell data laid out as source[(x + y*width)*num_channels
+ * + channel]. The source and the destination must not overlap.
+ */
+void TransformCellPlanes(uint8_t const *source, unsigned num_channels, BoardSymmetry symmetry,
+                         int16_t width, int16_t height, uint8_t *destination);
+void TransformCellPlanes(float const *source, unsigned num_channels, BoardSymmetry symmetry,
+                         int16_t width, int16_t height, float *destination);
+
+/**
+ * @brief TransformFlatPolicy Transforms a policy indexed by action ID, which has width*height + 5
+ * entries. The source and the destination must not overlap.
+ */
+void TransformFlatPolicy(float const *source, BoardSymmetry symmetry, int16_t width,
+                         int16_t height, float *destination);
+
+/**
+ * @brief SymmetricHash The hash of the board state as if it were transformed by the symmetry,
+ * computed without transforming the board. It lives in a different key space from
+ * GomokuBoardState::Hash().
+ */
+uint64_t SymmetricHash(GomokuBoardState const &board, BoardSymmetry symmetry);
+
+/**
+ * @brief CanonicalSymmetry Finds the symmetry which takes the board to its canonical orientation,
+ * the one with the lowest SymmetricHash(). Boards which are symmetric to one another share the
+ * same canonical hash, so that a cache keyed by it can serve all of them by transforming its
+ * entries back with the inverse symmetry.
+ *
+ * @param canonical_hash Optionally receives the hash of the canonical orientation.
+ */
+BoardSymmetry CanonicalSymmetry(GomokuBoardState const &board, uint64_t *canonical_hash);
+
+} // namespace e8
+
+#endif // BOARD_SYMMETRY_H
@@ -29,48 +29,60 @@ GomokuGame::GomokuGame(std::shared_ptr<GomokuPlayerInterface> const &player_a,
     : player_a_(std::move(player_a)), player_b_(std::move(player_b)) {}
 
 void GomokuGame::Start() {
-    do {
-        GomokuBoardState board(kWidth, kHeight);
+    while (this->Step() != GGS_ALL_GAMES_ENDED) {
+    }
+}
+
+GomokuGameStep GomokuGame::Step() {
+    if (!board_.has_value()) {
+        board_.emplace(kWidth, kHeight);
+
+        player_a_->OnGomokuGameBegin(*board_);
+        player_b_->OnGomokuGameBegin(*board_);
 
-        player_a_->OnGomokuGameBegin(board);
-        player_b_->OnGomokuGameBegin(board);
+        return GGS_GAME_BEGAN;
+    }
 
-        GameResult game_result;
+    GomokuPlayerInterface *current_player;
 
-        do {
-            GomokuPlayerInterface *current_player;
+    switch (board_->CurrentPlayerSide()) {
+    case PS_PLAYER_A: {
+        current_player = player_a_.get();
+        break;
+    }
+    case PS_PLAYER_B: {
+        current_player = player_b_.get();
+        break;
+    }
+    default: {
+        assert(false);
+        break;
+    }
+    }
 
-            switch (board.CurrentPlayerSide()) {
-            case PS_PLAYER_A: {
-                current_player = player_a_.get();
-                break;
-            }
-            case PS_PLAYER_B: {
-                current_player = player_b_.get();
-                break;
-            }
-            default: {
-                assert(false);
-                break;
-            }
-            }
+    GomokuActionId action_id = current_player->NextPlayerAction(*board_);
 
-            GomokuActionId action_id = current_player->NextPlayerAction(board);
+    player_a_->BeforeGomokuActionApplied(*board_, board_->CurrentPlayerSide(), action_id);
+    player_b_->BeforeGomokuActionApplied(*board_, board_->CurrentPlayerSide(), action_id);
 
-            player_a_->BeforeGomokuActionApplied(board, board.CurrentPlayerSide(), action_id);
-            player_b_->BeforeGomokuActionApplied(board, board.CurrentPlayerSide(), action_id);
+    GameResult game_result = board_->ApplyAction(action_id, /*cached_game_result=*/std::nullopt);
 
-            game_result = board.ApplyAction(action_id, /*cached_game_result=*/std::nullopt);
+    player_a_->AfterGomokuActionApplied(*board_);
+    player_b_->AfterGomokuActionApplied(*board_);
 
-            player_a_->AfterGomokuActionApplied(board);
-            player_b_->AfterGomokuActionApplied(board);
+    if (game_result == GameResult::GR_UNDETERMINED) {
+        return GGS_ACTION_APPLIED;
+    }
 
-        } while (game_result == GameResult::GR_UNDETERMINED);
+    player_a_->OnGameEnded(*board_);
+    player_b_->OnGameEnded(*board_);
 
-        player_a_->OnGameEnded(board);
-        player_b_->OnGameEnded(board);
+    board_ = std::nullopt;
 
-    } while (player_a_->WantAnotherGame() && player_b_->WantAnotherGame());
+    if (player_a_->WantAnotherGame() && player_b_->WantAnotherGame()) {
+        return GGS_GAME_ENDED;
+    }
+    return GGS_ALL_GAMES_ENDED;
 }
 
 } // namespace e8
@@ -19,6 +19,7 @@
 #define GAME_H
 
 #include <memory>
+#include <optional>
 
 #include "gomoku/game/board_state.h"
 
@@ -68,9 +69,27 @@ class GomokuPlayerInterface {
     virtual bool WantAnotherGame() = 0;
 };
 
+/**
+ * @brief The GomokuGameStep enum What a call to GomokuGame::Step() did.
+ */
+enum GomokuGameStep {
+    // A new game began. No action has been taken yet.
+    GGS_GAME_BEGAN,
+
+    // One action was applied, and the game goes on.
+    GGS_ACTION_APPLIED,
+
+    // One action was applied, and it ended the game. Players want another game.
+    GGS_GAME_ENDED,
+
+    // One action was applied, and it ended the last game the players want.
+    GGS_ALL_GAMES_ENDED,
+};
+
 /**
  * @brief The GomokuGame class The main class that lets players take turn and engage in Gomoku
- * games.
+ * games. The games can either be run to the end by Start(), or be advanced action by action
+ * through Step() so that a scheduler can interleave many games.
  */
 class GomokuGame {
   public:
@@ -88,12 +107,22 @@ class GomokuGame {
      */
     void Start();
 
+    /**
+     * @brief Step Advances the games by a single action, or begins a new game when there isn't
+     * one in progress. It must not be called again after it returns GGS_ALL_GAMES_ENDED, nor
+     * concurrently.
+     */
+    GomokuGameStep Step();
+
   private:
     unsigned const kWidth = 11;
     unsigned const kHeight = 11;
 
     std::shared_ptr<GomokuPlayerInterface> player_a_;
     std::shared_ptr<GomokuPlayerInterface> player_b_;
+
+    // The game in progress.
+    std::optional<GomokuBoardState> board_;
 };
 
 } // namespace e8
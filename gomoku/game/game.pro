@@ -15,13 +15,17 @@ DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs depr
 INCLUDEPATH += $$PWD/../../
 
 SOURCES += \
+    bitboard.cc \
     board_state.cc \
+    board_symmetry.cc \
     game.cc \
     game_instance_container.cc \
     mock_player.cc
 
 HEADERS += \
+    bitboard.h \
     board_state.h \
+    board_symmetry.h \
     game.h \
     game_instance_container.h \
     mock_player.h
@@ -15,18 +15,22 @@
  * not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <cassert>
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <memory>
 #include <mutex>
-#include <shared_mutex>
 #include <thread>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
-#include "common/thread/thread_pool.h"
 #include "common/time_util/time_util.h"
 #include "gomoku/game/game.h"
 #include "gomoku/game/game_instance_container.h"
-#include "postgres/query_runner/sql_runner.h"
 
 namespace e8 {
 namespace {
@@ -34,123 +38,177 @@ namespace {
 std::mutex gContainerPtrLock;
 std::unique_ptr<GameInstanceContainer> gGameContainer;
 
-struct GameRunnerStorage : public TaskStorageInterface {
-    GameRunnerStorage(GameInstanceContainer::ScheduleId schedule_id, GomokuGame *game);
-
-    GameInstanceContainer::ScheduleId const schedule_id;
-    GomokuGame *const game;
+/**
+ * @brief The RunnableGame struct A game instance waiting in the run queue.
+ */
+struct RunnableGame {
+    GameInstanceContainer::ScheduleId schedule_id;
+    std::shared_ptr<GomokuGame> game;
 };
 
-GameRunnerStorage::GameRunnerStorage(GameInstanceContainer::ScheduleId schedule_id,
-                                     GomokuGame *game)
-    : schedule_id(schedule_id), game(game) {}
+} // namespace
+
+struct GameInstanceContainer::GameInstanceContainerInternal {
+    GameInstanceContainerInternal(unsigned num_workers);
+    ~GameInstanceContainerInternal();
 
-class GameRunnerTask : public TaskInterface {
-  public:
-    GameRunnerTask() = default;
-    ~GameRunnerTask() override = default;
+    void RunWorker();
+    void Retire(RunnableGame const &runnable);
 
-    void Run(TaskStorageInterface *storage) const override;
+    std::unordered_map<ScheduleId, std::vector<std::shared_ptr<GomokuGame>>> scheduled_games;
+    std::deque<RunnableGame> run_queue;
+    bool stopping;
+    std::mutex lock;
+    std::condition_variable runnable_cv;
 
-    bool DropResourceOnCompletion() const override;
+    TimestampMicros const creation_time;
+    std::atomic<uint64_t> num_games_ended;
+    std::atomic<uint64_t> num_actions_applied;
+
+    std::vector<std::thread> workers;
 };
 
-void GameRunnerTask::Run(TaskStorageInterface *storage) const {
-    if (storage == nullptr) {
-        // Placeholder task.
-        return;
+GameInstanceContainer::GameInstanceContainerInternal::GameInstanceContainerInternal(
+    unsigned num_workers)
+    : stopping(false), creation_time(CurrentTimestampMicros()), num_games_ended(0),
+      num_actions_applied(0) {
+    assert(num_workers > 0);
+
+    workers.reserve(num_workers);
+    for (unsigned i = 0; i < num_workers; ++i) {
+        workers.emplace_back(&GameInstanceContainerInternal::RunWorker, this);
     }
-    static_cast<GameRunnerStorage *>(storage)->game->Start();
 }
 
-bool GameRunnerTask::DropResourceOnCompletion() const { return false; }
-
-void CleanUpCompletedGames(ThreadPool *thread_pool,
-                           std::unordered_map<GameInstanceContainer::ScheduleId,
-                                              std::shared_ptr<GomokuGame>> *scheduled_games,
-                           std::shared_mutex *lock, bool *cleanup_thread_running) {
-    while (*cleanup_thread_running) {
-        std::unique_ptr<TaskStorageInterface> storage = thread_pool->WaitForNextCompleted();
-
-        if (storage == nullptr) {
-            continue;
-        }
+GameInstanceContainer::GameInstanceContainerInternal::~GameInstanceContainerInternal() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    runnable_cv.notify_all();
 
-        lock->lock();
-        scheduled_games->erase(static_cast<GameRunnerStorage *>(storage.get())->schedule_id);
-        lock->unlock();
+    for (std::thread &worker : workers) {
+        worker.join();
     }
 }
 
-} // namespace
+void GameInstanceContainer::GameInstanceContainerInternal::RunWorker() {
+    while (true) {
+        RunnableGame runnable;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            runnable_cv.wait(guard, [this] { return stopping || !run_queue.empty(); });
+            if (stopping) {
+                return;
+            }
+
+            runnable = std::move(run_queue.front());
+            run_queue.pop_front();
+        }
 
-struct GameInstanceContainer::GameInstanceContainerInternal {
-    GameInstanceContainerInternal(unsigned max_concurrent_games);
-    ~GameInstanceContainerInternal();
+        // Only this worker holds the game until it's put back into the run queue.
+        GomokuGameStep step = runnable.game->Step();
 
-    ThreadPool thread_pool;
+        if (step != GGS_GAME_BEGAN) {
+            num_actions_applied.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (step == GGS_GAME_ENDED || step == GGS_ALL_GAMES_ENDED) {
+            num_games_ended.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (step == GGS_ALL_GAMES_ENDED) {
+            this->Retire(runnable);
+            continue;
+        }
 
-    std::unordered_map<ScheduleId, std::shared_ptr<GomokuGame>> scheduled_games;
-    std::shared_mutex lock;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            run_queue.push_back(std::move(runnable));
+        }
+        runnable_cv.notify_one();
+    }
+}
 
-    bool cleanup_thread_running;
-    std::thread cleanup_thread;
-};
+void GameInstanceContainer::GameInstanceContainerInternal::Retire(RunnableGame const &runnable) {
+    std::lock_guard<std::mutex> guard(lock);
 
-GameInstanceContainer::GameInstanceContainerInternal::GameInstanceContainerInternal(
-    unsigned max_concurrent_games)
-    : thread_pool(max_concurrent_games), cleanup_thread_running(true),
-      cleanup_thread(CleanUpCompletedGames, &thread_pool, &scheduled_games, &lock,
-                     &cleanup_thread_running) {}
+    auto it = scheduled_games.find(runnable.schedule_id);
+    assert(it != scheduled_games.end());
 
-GameInstanceContainer::GameInstanceContainerInternal::~GameInstanceContainerInternal() {
-    cleanup_thread_running = false;
+    std::vector<std::shared_ptr<GomokuGame>> &games = it->second;
+    games.erase(std::find(games.begin(), games.end(), runnable.game));
+    if (games.empty()) {
+        scheduled_games.erase(it);
+    }
+}
 
-    // Placeholder task to break out from the blacking wait.
-    thread_pool.Schedule(std::make_shared<GameRunnerTask>(), /*task_data=*/nullptr);
+float GameInstanceContainerStats::GamesPerHour() const {
+    if (elapsed_secs == 0.0f) {
+        return 0.0f;
+    }
+    return num_games_ended * 3600.0f / elapsed_secs;
+}
 
-    cleanup_thread.join();
+float GameInstanceContainerStats::PositionsPerSecond() const {
+    if (elapsed_secs == 0.0f) {
+        return 0.0f;
+    }
+    return num_actions_applied / elapsed_secs;
 }
 
-GameInstanceContainer::GameInstanceContainer(unsigned max_concurrent_games)
-    : pimpl_(std::make_unique<GameInstanceContainerInternal>(max_concurrent_games)) {}
+GameInstanceContainer::GameInstanceContainer(unsigned num_workers)
+    : pimpl_(std::make_unique<GameInstanceContainerInternal>(num_workers)) {}
+
+GameInstanceContainer::~GameInstanceContainer() {}
 
 void GameInstanceContainer::ScheduleToRun(ScheduleId schedule_id,
                                           std::unique_ptr<GomokuGame> &&game) {
-    pimpl_->lock.lock();
-
-    auto [_, game_ptr] =
-        *pimpl_->scheduled_games.insert(std::make_pair(schedule_id, std::move(game))).first;
+    std::shared_ptr<GomokuGame> game_ptr = std::move(game);
 
-    pimpl_->thread_pool.Schedule(std::make_shared<GameRunnerTask>(),
-                                 std::make_unique<GameRunnerStorage>(schedule_id, game_ptr.get()));
-
-    pimpl_->lock.unlock();
+    {
+        std::lock_guard<std::mutex> guard(pimpl_->lock);
+        pimpl_->scheduled_games[schedule_id].push_back(game_ptr);
+        pimpl_->run_queue.push_back(RunnableGame{schedule_id, game_ptr});
+    }
+    pimpl_->runnable_cv.notify_one();
 }
 
 std::shared_ptr<GomokuGame> GameInstanceContainer::ScheduledGame(ScheduleId id) {
-    std::shared_ptr<GomokuGame> result;
-
-    pimpl_->lock.lock_shared();
+    std::lock_guard<std::mutex> guard(pimpl_->lock);
 
     auto it = pimpl_->scheduled_games.find(id);
-    if (it != pimpl_->scheduled_games.end()) {
-        result = it->second;
-    } else {
-        result = nullptr;
+    if (it == pimpl_->scheduled_games.end()) {
+        return nullptr;
     }
+    return it->second.front();
+}
+
+unsigned GameInstanceContainer::NumWorkers() const { return pimpl_->workers.size(); }
 
-    pimpl_->lock.unlock_shared();
+GameInstanceContainerStats GameInstanceContainer::Stats() const {
+    GameInstanceContainerStats stats;
+    stats.num_games_ended = pimpl_->num_games_ended.load(std::memory_order_relaxed);
+    stats.num_actions_applied = pimpl_->num_actions_applied.load(std::memory_order_relaxed);
+    stats.elapsed_secs = (CurrentTimestampMicros() - pimpl_->creation_time) / 1e6f;
 
-    return result;
+    std::lock_guard<std::mutex> guard(pimpl_->lock);
+    stats.num_scheduled_games = 0;
+    for (auto const &[_, games] : pimpl_->scheduled_games) {
+        stats.num_scheduled_games += games.size();
+    }
+
+    return stats;
 }
 
-GameInstanceContainer::ScheduleId AllocateGameInstanceContainerScheduleId() { return TemporalId(); }
+GameInstanceContainer::ScheduleId AllocateGameInstanceContainerScheduleId() {
+    return UniqueId(/*host_id=*/0);
+}
 
 GameInstanceContainer *DefaultGameInstanceContainer() {
     gContainerPtrLock.lock();
     if (gGameContainer == nullptr) {
-        gGameContainer = std::make_unique<GameInstanceContainer>(/*max_concurrent_games=*/4);
+        unsigned num_workers = std::max(1U, std::thread::hardware_concurrency());
+        gGameContainer = std::make_unique<GameInstanceContainer>(num_workers);
     }
     gContainerPtrLock.unlock();
 
@@ -26,7 +26,30 @@
 namespace e8 {
 
 /**
- * @brief The GameInstanceContainer class Schedules and runs game instances.
+ * @brief The GameInstanceContainerStats struct Throughput of the games run by a container since
+ * its construction.
+ */
+struct GameInstanceContainerStats {
+    // Number of games played to the end.
+    uint64_t num_games_ended;
+
+    // Number of actions applied over all the games.
+    uint64_t num_actions_applied;
+
+    // Number of game instances scheduled but not yet finished.
+    uint64_t num_scheduled_games;
+
+    float elapsed_secs;
+
+    float GamesPerHour() const;
+    float PositionsPerSecond() const;
+};
+
+/**
+ * @brief The GameInstanceContainer class Schedules and runs game instances. The game instances
+ * share a fixed set of worker threads: a worker advances a game by one action, see
+ * GomokuGame::Step(), then puts it back to the end of the run queue. It's thus able to hold many
+ * more games than there are workers, and games don't starve one another.
  */
 class GameInstanceContainer {
   public:
@@ -35,26 +58,37 @@ class GameInstanceContainer {
     using ScheduleId = int64_t;
 
     /**
-     * @brief GameInstanceContainer Constructs a container that runs max_concurrent_games number of
-     * game instances at a time.
+     * @brief GameInstanceContainer Constructs a container that steps game instances on
+     * num_workers threads.
      */
-    GameInstanceContainer(unsigned max_concurrent_games);
+    GameInstanceContainer(unsigned num_workers);
     GameInstanceContainer(GameInstanceContainer const &) = delete;
     GameInstanceContainer(GameInstanceContainer &&) = delete;
+    ~GameInstanceContainer();
 
     /**
      * @brief ScheduleForRun Add a new game instance into the container and schedule to run whenever
-     * hardware resource is available. The hardware resource limit is set in the constructor by the
-     * argument max_concurrent_games.
+     * a worker is available. Many game instances can be scheduled under the same schedule ID.
      */
     void ScheduleToRun(ScheduleId schedule_id, std::unique_ptr<GomokuGame> &&game);
 
     /**
-     * @brief ScheduledGame Retrieve the game instance by the schedule ID. If the schedule ID is
-     * invalid or the game instance has finished running, it will return a nullptr.
+     * @brief ScheduledGame Retrieve a game instance by the schedule ID. If the schedule ID is
+     * invalid or all game instances under it have finished running, it will return a nullptr.
      */
     std::shared_ptr<GomokuGame> ScheduledGame(ScheduleId id);
 
+    /**
+     * @brief NumWorkers Number of threads the game instances are stepped on. It's also the most
+     * game instances that can be running at the same time.
+     */
+    unsigned NumWorkers() const;
+
+    /**
+     * @brief Stats Returns the throughput so far.
+     */
+    GameInstanceContainerStats Stats() const;
+
   private:
     std::unique_ptr<GameInstanceContainerInternal> pimpl_;
 };
@@ -29,8 +29,8 @@ namespace e8 {
 
 AgentGuiPlayer::AgentGuiPlayer(MainWindow *main_window, PlayerSide const player_side,
                                std::shared_ptr<MctSearcher> const &searcher,
-                               bool const shared_searcher)
-    : MctsAgentPlayer(player_side, searcher, shared_searcher), main_window_(main_window),
+                               bool const shared_searcher, bool const ponder)
+    : MctsAgentPlayer(player_side, searcher, shared_searcher, ponder), main_window_(main_window),
       player_side_(player_side) {}
 
 void AgentGuiPlayer::OnGomokuGameBegin(GomokuBoardState const &board_state) {
@@ -46,6 +46,11 @@ unix:!macx: LIBS += -L$$OUT_PWD/../game/ -lgomoku_game
 INCLUDEPATH += $$PWD/../game
 DEPENDPATH += $$PWD/../game
 
+unix:!macx: LIBS += -L$$OUT_PWD/../../common/flags/ -lflags
+
+INCLUDEPATH += $$PWD/../../common/flags
+DEPENDPATH += $$PWD/../../common/flags
+
 unix:!macx: LIBS += -L$$OUT_PWD/../../common/container/ -lcontainer
 
 INCLUDEPATH += $$PWD/../../common/container
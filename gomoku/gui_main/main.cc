@@ -19,6 +19,7 @@
 #include <memory>
 #include <thread>
 
+#include "common/flags/parse_flags.h"
 #include "gomoku/agent/heuristics/light_rollout_evaluator.h"
 #include "gomoku/agent/search/mct_search.h"
 #include "gomoku/game/board_state.h"
@@ -27,28 +28,45 @@
 #include "gomoku/gui_main/human_gui_player.h"
 #include "gomoku/gui_main/main_window.h"
 
-void RunGame(e8::MainWindow *player_a_window, e8::MainWindow *player_b_window) {
-    auto searcher =
-        std::make_shared<e8::MctSearcher>(std::make_shared<e8::GomokuLightRolloutEvaluator>(),
-                                          /*print_stats=*/true);
+static char const kHumanPlayerAFlag[] = "human_player_a";
+static char const kHumanPlayerBFlag[] = "human_player_b";
 
-    std::shared_ptr<e8::GomokuPlayerInterface> player_a =
-        std::static_pointer_cast<e8::GomokuPlayerInterface>(std::make_shared<e8::AgentGuiPlayer>(
-            player_a_window, e8::PlayerSide::PS_PLAYER_A, searcher, /*shared_searcher=*/true));
+std::shared_ptr<e8::MctSearcher> CreateSearcher() {
+    return std::make_shared<e8::MctSearcher>(std::make_shared<e8::GomokuLightRolloutEvaluator>(),
+                                             /*print_stats=*/true, /*num_workers=*/1,
+                                             /*lazy_expansion=*/true);
+}
 
-    std::shared_ptr<e8::GomokuPlayerInterface> player_b =
-        std::static_pointer_cast<e8::GomokuPlayerInterface>(std::make_shared<e8::AgentGuiPlayer>(
-            player_b_window, e8::PlayerSide::PS_PLAYER_B, searcher, /*shared_searcher=*/true));
+void RunGame(e8::MainWindow *player_a_window, e8::MainWindow *player_b_window, bool human_player_a,
+             bool human_player_b) {
+    // Two agents search on the same searcher, so one agent's move would stop the other's pondering
+    // right away. An agent playing against a human gets a searcher of its own and ponders during
+    // the human's turn instead.
+    bool const agents_share_searcher = !human_player_a && !human_player_b;
+    std::shared_ptr<e8::MctSearcher> shared_searcher =
+        agents_share_searcher ? CreateSearcher() : nullptr;
 
-    //    std::shared_ptr<e8::GomokuPlayerInterface> player_a =
-    //        std::static_pointer_cast<e8::GomokuPlayerInterface>(
-    //            std::make_shared<e8::HumanGuiPlayer>(player_a_window,
-    //            e8::PlayerSide::PS_PLAYER_A));
+    auto create_player = [agents_share_searcher, &shared_searcher](
+                             e8::MainWindow *window, e8::PlayerSide player_side,
+                             bool human) -> std::shared_ptr<e8::GomokuPlayerInterface> {
+        if (human) {
+            return std::static_pointer_cast<e8::GomokuPlayerInterface>(
+                std::make_shared<e8::HumanGuiPlayer>(window, player_side));
+        }
+        if (agents_share_searcher) {
+            return std::static_pointer_cast<e8::GomokuPlayerInterface>(
+                std::make_shared<e8::AgentGuiPlayer>(window, player_side, shared_searcher,
+                                                     /*shared_searcher=*/true, /*ponder=*/false));
+        }
+        return std::static_pointer_cast<e8::GomokuPlayerInterface>(
+            std::make_shared<e8::AgentGuiPlayer>(window, player_side, CreateSearcher(),
+                                                 /*shared_searcher=*/false, /*ponder=*/true));
+    };
 
-    //    std::shared_ptr<e8::GomokuPlayerInterface> player_b =
-    //        std::static_pointer_cast<e8::GomokuPlayerInterface>(
-    //            std::make_shared<e8::HumanGuiPlayer>(player_b_window,
-    //            e8::PlayerSide::PS_PLAYER_B));
+    std::shared_ptr<e8::GomokuPlayerInterface> player_a =
+        create_player(player_a_window, e8::PlayerSide::PS_PLAYER_A, human_player_a);
+    std::shared_ptr<e8::GomokuPlayerInterface> player_b =
+        create_player(player_b_window, e8::PlayerSide::PS_PLAYER_B, human_player_b);
 
     e8::GomokuGame game(player_a, player_b);
 
@@ -56,12 +74,17 @@ void RunGame(e8::MainWindow *player_a_window, e8::MainWindow *player_b_window) {
 }
 
 int main(int argc, char *argv[]) {
+    e8::Argv(argc, argv);
+    bool human_player_a = e8::ReadFlag(kHumanPlayerAFlag, false, e8::FromString<bool>);
+    bool human_player_b = e8::ReadFlag(kHumanPlayerBFlag, false, e8::FromString<bool>);
+
     QApplication app(argc, argv);
 
     e8::MainWindow player_a_window;
     e8::MainWindow player_b_window;
 
-    std::thread game_thread(RunGame, &player_a_window, &player_b_window);
+    std::thread game_thread(RunGame, &player_a_window, &player_b_window, human_player_a,
+                            human_player_b);
 
     player_a_window.show();
     player_b_window.show();
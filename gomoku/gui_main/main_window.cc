@@ -198,7 +198,7 @@ void MainWindow::RenderGameState(GomokuBoardState const &board_state) {
         return;
     }
 
-    GomokuAction const &sample_action = board_state.LegalActions().begin()->second;
+    GomokuAction const sample_action = board_state.LegalActions().begin()->second;
     if (sample_action.stone_pos.has_value()) {
         this->RenderBoard(board_state);
     } else if (sample_action.swap2_decision.has_value()) {
@@ -40,6 +40,9 @@ char const *kGomokuGameIdSeqTableName = "gomoku_game_id_seq";
 char const *kGomokuTableName = "gomoku_game";
 char const *kGomokuActionTableName = "gomoku_game_action";
 
+// Self-play generates games at a high rate. Reserves game IDs in batches to save round trips.
+unsigned const kGameIdReservationBatchSize = 64;
+
 struct GomokuGameEntity : public SqlEntityInterface {
     GomokuGameEntity()
         : SqlEntityInterface({&id, &game_purpose, &player_a_id, &player_b_id, &player_a_model_id,
@@ -188,13 +191,14 @@ std::string ExtractBoardFeatures(GomokuBoardState const &board) {
 
 } // namespace
 
-GameLogStore::GameLogStore(ConnectionReservoirInterface *conns) : conns_(conns) {}
+GameLogStore::GameLogStore(ConnectionReservoirInterface *conns)
+    : conns_(conns), game_ids_(kGomokuGameIdSeqTableName, kGameIdReservationBatchSize, conns) {}
 
 GameId GameLogStore::LogNewGeneratorGame(GameLogPurpose game_purpose,
                                          std::optional<ModelId> player_a_model_id,
                                          std::optional<ModelId> player_b_model_id) {
     GomokuGameEntity entity;
-    *entity.id.ValuePtr() = SeqId(kGomokuGameIdSeqTableName, conns_);
+    *entity.id.ValuePtr() = game_ids_.Next();
     *entity.game_purpose.ValuePtr() = game_purpose;
     *entity.player_a_model_id.ValuePtr() = player_a_model_id;
     *entity.player_b_model_id.ValuePtr() = player_b_model_id;
@@ -24,6 +24,7 @@
 #include "gomoku/game/board_state.h"
 #include "gomoku/logging/common_types.h"
 #include "postgres/query_runner/connection/connection_reservoir_interface.h"
+#include "postgres/query_runner/seq_id_pool.h"
 
 namespace e8 {
 
@@ -69,6 +70,7 @@ class GameLogStore {
 
   private:
     ConnectionReservoirInterface *const conns_;
+    SeqIdPool game_ids_;
 };
 
 } // namespace e8
@@ -0,0 +1,338 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "gomoku/logging/self_play_record_store.h"
+
+namespace e8 {
+namespace {
+
+unsigned BoardBytes(unsigned const board_width, unsigned const board_height) {
+    return (board_width * board_height + 3) & ~3U;
+}
+
+unsigned RecordSize(SelfPlayShardHeader const &header) {
+    return sizeof(SelfPlayRecordHead) + BoardBytes(header.board_width, header.board_height) +
+           sizeof(float) *
+               (header.policy_size + header.shl_map_size + header.top_shl_features_size);
+}
+
+std::string ShardPath(std::string const &directory, std::string const &shard_prefix,
+                      unsigned const shard_number) {
+    char shard_number_str[16];
+    std::snprintf(shard_number_str, sizeof(shard_number_str), "%06u", shard_number);
+    return (std::filesystem::path(directory) /
+            (shard_prefix + "-" + shard_number_str + kSelfPlayShardExtension))
+        .string();
+}
+
+/**
+ * @brief ShardNumber Parses the shard number out of a shard file name. It returns nullopt if the
+ * file isn't a shard under the prefix.
+ */
+std::optional<unsigned> ShardNumber(std::filesystem::path const &path,
+                                    std::string const &shard_prefix) {
+    if (path.extension() != kSelfPlayShardExtension) {
+        return std::nullopt;
+    }
+
+    std::string const stem = path.stem().string();
+    if (stem.size() <= shard_prefix.size() + 1 || stem.compare(0, shard_prefix.size(),
+                                                               shard_prefix) != 0 ||
+        stem[shard_prefix.size()] != '-') {
+        return std::nullopt;
+    }
+
+    std::string const number = stem.substr(shard_prefix.size() + 1);
+    if (!std::all_of(number.begin(), number.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+        return std::nullopt;
+    }
+
+    return std::stoul(number);
+}
+
+void WriteFully(int fd, void const *data, size_t size, off_t offset) {
+    uint8_t const *bytes = static_cast<uint8_t const *>(data);
+    while (size > 0) {
+        ssize_t written = pwrite(fd, bytes, size, offset);
+        assert(written > 0);
+        bytes += written;
+        size -= written;
+        offset += written;
+    }
+}
+
+/**
+ * @brief SerializeRecord Lays the record out in the shard format at the end of the buffer.
+ */
+void SerializeRecord(SelfPlayRecord const &record, SelfPlayShardHeader const &header,
+                     std::vector<uint8_t> *buffer) {
+    assert(record.board_width == header.board_width);
+    assert(record.board_height == header.board_height);
+    assert(record.board.size() == header.board_width * header.board_height);
+    assert(record.policy.size() == header.policy_size);
+    assert(record.shl_map.size() == header.shl_map_size);
+    assert(record.top_shl_features.size() == header.top_shl_features_size);
+
+    size_t const begin = buffer->size();
+    buffer->resize(begin + header.record_size, 0);
+    uint8_t *dst = buffer->data() + begin;
+
+    SelfPlayRecordHead head{};
+    head.game_id = record.game_id;
+    head.step_number = record.step_number;
+    head.num_game_steps = record.num_game_steps;
+    head.action_id = record.action_id;
+    head.action_performer = record.action_performer;
+    head.action_stone_type = record.action_stone_type;
+    head.game_phase = record.game_phase;
+    head.symmetry = record.symmetry;
+    head.value = record.value;
+    std::memcpy(dst, &head, sizeof(head));
+    dst += sizeof(head);
+
+    std::memcpy(dst, record.board.data(), record.board.size());
+    dst += BoardBytes(header.board_width, header.board_height);
+
+    std::memcpy(dst, record.policy.data(), sizeof(float) * record.policy.size());
+    dst += sizeof(float) * record.policy.size();
+
+    std::memcpy(dst, record.shl_map.data(), sizeof(float) * record.shl_map.size());
+    dst += sizeof(float) * record.shl_map.size();
+
+    std::memcpy(dst, record.top_shl_features.data(),
+                sizeof(float) * record.top_shl_features.size());
+}
+
+} // namespace
+
+struct SelfPlayRecordWriter::SelfPlayRecordWriterInternal {
+    SelfPlayRecordWriterInternal(std::string const &directory, std::string const &shard_prefix,
+                                 unsigned records_per_shard);
+    ~SelfPlayRecordWriterInternal();
+
+    void OpenNextShard(SelfPlayRecord const &first_record);
+    void CloseShard();
+
+    std::string const directory;
+    std::string const shard_prefix;
+    unsigned const records_per_shard;
+
+    unsigned next_shard_number;
+    std::string shard_path;
+    int fd;
+    SelfPlayShardHeader header;
+
+    // Reused across games to serialize the records into.
+    std::vector<uint8_t> buffer;
+};
+
+SelfPlayRecordWriter::SelfPlayRecordWriterInternal::SelfPlayRecordWriterInternal(
+    std::string const &directory, std::string const &shard_prefix,
+    unsigned const records_per_shard)
+    : directory(directory), shard_prefix(shard_prefix), records_per_shard(records_per_shard),
+      next_shard_number(0), fd(-1) {
+    assert(records_per_shard > 0);
+
+    std::filesystem::create_directories(directory);
+    for (auto const &entry : std::filesystem::directory_iterator(directory)) {
+        std::optional<unsigned> shard_number = ShardNumber(entry.path(), shard_prefix);
+        if (shard_number.has_value()) {
+            next_shard_number = std::max(next_shard_number, *shard_number + 1);
+        }
+    }
+}
+
+SelfPlayRecordWriter::SelfPlayRecordWriterInternal::~SelfPlayRecordWriterInternal() {
+    this->CloseShard();
+}
+
+void SelfPlayRecordWriter::SelfPlayRecordWriterInternal::OpenNextShard(
+    SelfPlayRecord const &first_record) {
+    this->CloseShard();
+
+    shard_path = ShardPath(directory, shard_prefix, next_shard_number++);
+    fd = open(shard_path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+    assert(fd >= 0);
+
+    header = SelfPlayShardHeader{};
+    std::memcpy(header.magic, kSelfPlayShardMagic, sizeof(header.magic));
+    header.version = kSelfPlayShardVersion;
+    header.board_width = first_record.board_width;
+    header.board_height = first_record.board_height;
+    header.policy_size = first_record.policy.size();
+    header.shl_map_size = first_record.shl_map.size();
+    header.top_shl_features_size = first_record.top_shl_features.size();
+    header.num_records = 0;
+    header.record_size = RecordSize(header);
+
+    WriteFully(fd, &header, sizeof(header), /*offset=*/0);
+}
+
+void SelfPlayRecordWriter::SelfPlayRecordWriterInternal::CloseShard() {
+    if (fd < 0) {
+        return;
+    }
+
+    fsync(fd);
+    close(fd);
+    fd = -1;
+}
+
+SelfPlayRecordWriter::SelfPlayRecordWriter(std::string const &directory,
+                                           std::string const &shard_prefix,
+                                           unsigned const records_per_shard)
+    : pimpl_(std::make_unique<SelfPlayRecordWriterInternal>(directory, shard_prefix,
+                                                             records_per_shard)) {}
+
+SelfPlayRecordWriter::~SelfPlayRecordWriter() {}
+
+void SelfPlayRecordWriter::AppendGame(std::vector<SelfPlayRecord> const &records) {
+    if (records.empty()) {
+        return;
+    }
+
+    if (pimpl_->fd < 0 || pimpl_->header.num_records >= pimpl_->records_per_shard ||
+        records.front().board_width != pimpl_->header.board_width ||
+        records.front().board_height != pimpl_->header.board_height) {
+        pimpl_->OpenNextShard(records.front());
+    }
+
+    pimpl_->buffer.clear();
+    for (SelfPlayRecord const &record : records) {
+        SerializeRecord(record, pimpl_->header, &pimpl_->buffer);
+    }
+
+    // Writes the records before publishing them through the header.
+    off_t const offset =
+        sizeof(SelfPlayShardHeader) + pimpl_->header.num_records * pimpl_->header.record_size;
+    WriteFully(pimpl_->fd, pimpl_->buffer.data(), pimpl_->buffer.size(), offset);
+
+    pimpl_->header.num_records += records.size();
+    WriteFully(pimpl_->fd, &pimpl_->header.num_records, sizeof(pimpl_->header.num_records),
+               offsetof(SelfPlayShardHeader, num_records));
+}
+
+std::string SelfPlayRecordWriter::CurrentShardPath() const {
+    return pimpl_->fd >= 0 ? pimpl_->shard_path : std::string();
+}
+
+struct SelfPlayShardReader::SelfPlayShardReaderInternal {
+    explicit SelfPlayShardReaderInternal(std::string const &shard_path);
+    ~SelfPlayShardReaderInternal();
+
+    uint8_t const *data;
+    size_t size;
+    SelfPlayShardHeader const *header;
+    uint64_t num_records;
+};
+
+SelfPlayShardReader::SelfPlayShardReaderInternal::SelfPlayShardReaderInternal(
+    std::string const &shard_path) {
+    int fd = open(shard_path.c_str(), O_RDONLY);
+    assert(fd >= 0);
+
+    struct stat file_stat;
+    int rc = fstat(fd, &file_stat);
+    assert(rc == 0);
+    size = file_stat.st_size;
+    assert(size >= sizeof(SelfPlayShardHeader));
+
+    void *mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, /*offset=*/0);
+    assert(mapped != MAP_FAILED);
+    close(fd);
+
+    data = static_cast<uint8_t const *>(mapped);
+    header = reinterpret_cast<SelfPlayShardHeader const *>(data);
+    assert(std::memcmp(header->magic, kSelfPlayShardMagic, sizeof(header->magic)) == 0);
+    assert(header->version == kSelfPlayShardVersion);
+    assert(header->record_size == RecordSize(*header));
+
+    // Only counts the records which were published when the file was mapped.
+    num_records = std::min<uint64_t>(header->num_records, (size - sizeof(SelfPlayShardHeader)) /
+                                                              header->record_size);
+}
+
+SelfPlayShardReader::SelfPlayShardReaderInternal::~SelfPlayShardReaderInternal() {
+    munmap(const_cast<uint8_t *>(data), size);
+}
+
+SelfPlayShardReader::SelfPlayShardReader(std::string const &shard_path)
+    : pimpl_(std::make_unique<SelfPlayShardReaderInternal>(shard_path)) {}
+
+SelfPlayShardReader::~SelfPlayShardReader() {}
+
+SelfPlayShardHeader const &SelfPlayShardReader::Header() const { return *pimpl_->header; }
+
+uint64_t SelfPlayShardReader::NumRecords() const { return pimpl_->num_records; }
+
+SelfPlayRecordView SelfPlayShardReader::Record(uint64_t const index) const {
+    assert(index < pimpl_->num_records);
+
+    SelfPlayShardHeader const &header = *pimpl_->header;
+    uint8_t const *base =
+        pimpl_->data + sizeof(SelfPlayShardHeader) + index * header.record_size;
+
+    SelfPlayRecordView view;
+    view.head = reinterpret_cast<SelfPlayRecordHead const *>(base);
+    base += sizeof(SelfPlayRecordHead);
+    view.board = base;
+    base += BoardBytes(header.board_width, header.board_height);
+    view.policy = reinterpret_cast<float const *>(base);
+    view.shl_map = view.policy + header.policy_size;
+    view.top_shl_features = view.shl_map + header.shl_map_size;
+    return view;
+}
+
+std::vector<std::string> ListSelfPlayShards(std::string const &directory,
+                                            std::string const &shard_prefix) {
+    std::vector<std::pair<unsigned, std::string>> shards;
+    if (std::filesystem::is_directory(directory)) {
+        for (auto const &entry : std::filesystem::directory_iterator(directory)) {
+            std::optional<unsigned> shard_number = ShardNumber(entry.path(), shard_prefix);
+            if (shard_number.has_value()) {
+                shards.push_back(std::make_pair(*shard_number, entry.path().string()));
+            }
+        }
+    }
+
+    std::sort(shards.begin(), shards.end());
+
+    std::vector<std::string> paths;
+    for (auto const &[_, path] : shards) {
+        paths.push_back(path);
+    }
+    return paths;
+}
+
+} // namespace e8
@@ -0,0 +1,207 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SELF_PLAY_RECORD_STORE_H
+#define SELF_PLAY_RECORD_STORE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gomoku/game/board_state.h"
+#include "gomoku/game/board_symmetry.h"
+#include "gomoku/logging/common_types.h"
+
+namespace e8 {
+
+/**
+ * @brief The SelfPlayRecord struct Learning material of one self-play move, as it's handed to the
+ * SelfPlayRecordWriter.
+ */
+struct SelfPlayRecord {
+    GameId game_id;
+    GameStepNumber step_number;
+
+    // Total number of steps of the game the move is from.
+    GameStepNumber num_game_steps;
+
+    GomokuActionId action_id;
+    PlayerSide action_performer;
+    StoneType action_stone_type;
+    GamePhase game_phase;
+
+    // The symmetry the record was transformed by from the position actually played. The board,
+    // policy, SHL map and action ID are all in the transformed orientation.
+    BoardSymmetry symmetry;
+
+    // Final outcome of the game viewed by the action performer.
+    float value;
+
+    // Row major stone states of the board before the move, one byte per cell.
+    unsigned board_width;
+    unsigned board_height;
+    std::vector<uint8_t> board;
+
+    // Stochastic policy indexed by action ID.
+    std::vector<float> policy;
+
+    std::vector<float> shl_map;
+    std::vector<float> top_shl_features;
+};
+
+/**
+ * @brief The SelfPlayShardHeader struct Leads every shard file. The records follow the header
+ * back to back, so that record i begins at byte sizeof(SelfPlayShardHeader) + i*record_size. All
+ * values are in the host's byte order.
+ */
+struct SelfPlayShardHeader {
+    // Always kSelfPlayShardMagic.
+    char magic[4];
+    uint32_t version;
+
+    uint32_t board_width;
+    uint32_t board_height;
+
+    // Number of floats in the respective arrays of every record.
+    uint32_t policy_size;
+    uint32_t shl_map_size;
+    uint32_t top_shl_features_size;
+
+    // Byte size of a record.
+    uint32_t record_size;
+
+    // Number of complete records in the shard. It's updated after the records of a game are
+    // written, so that readers never see a partial game.
+    uint64_t num_records;
+
+    uint8_t reserved[24];
+};
+
+static_assert(sizeof(SelfPlayShardHeader) == 64, "The shard header layout is part of the format.");
+
+static char const kSelfPlayShardMagic[4] = {'E', '8', 'S', 'P'};
+static uint32_t const kSelfPlayShardVersion = 1;
+static char const kSelfPlayShardExtension[] = ".e8sp";
+
+/**
+ * @brief The SelfPlayRecordHead struct The fixed part at the beginning of every record. It's
+ * followed by the board bytes padded to a multiple of 4, then the policy, the SHL map and the top
+ * SHL features as float arrays of the sizes given in the shard header.
+ */
+struct SelfPlayRecordHead {
+    int64_t game_id;
+    uint32_t step_number;
+    uint32_t num_game_steps;
+    int32_t action_id;
+    uint8_t action_performer;
+    uint8_t action_stone_type;
+    uint8_t game_phase;
+    uint8_t symmetry;
+    float value;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(SelfPlayRecordHead) == 32, "The record layout is part of the format.");
+
+/**
+ * @brief The SelfPlayRecordWriter class Appends self-play records to a sequence of shard files
+ * named <directory>/<shard_prefix>-<shard number><kSelfPlayShardExtension>. A shard is sealed and
+ * a new one is started once it holds at least records_per_shard records, or when the board
+ * dimension changes. The records of a game are never split over two shards. It's not
+ * thread-safe.
+ */
+class SelfPlayRecordWriter {
+  public:
+    /**
+     * @brief SelfPlayRecordWriter Shards which already exist under the prefix are left untouched.
+     * The writer continues from the next shard number.
+     */
+    SelfPlayRecordWriter(std::string const &directory, std::string const &shard_prefix,
+                         unsigned records_per_shard);
+    SelfPlayRecordWriter(SelfPlayRecordWriter const &) = delete;
+    ~SelfPlayRecordWriter();
+
+    /**
+     * @brief AppendGame Writes the records of a game to the current shard and makes them visible
+     * to readers. The records of a game must have the same board dimension and array sizes.
+     */
+    void AppendGame(std::vector<SelfPlayRecord> const &records);
+
+    /**
+     * @brief CurrentShardPath Path of the shard being written, or an empty string if no shard has
+     * been opened yet.
+     */
+    std::string CurrentShardPath() const;
+
+  private:
+    struct SelfPlayRecordWriterInternal;
+    std::unique_ptr<SelfPlayRecordWriterInternal> pimpl_;
+};
+
+/**
+ * @brief The SelfPlayRecordView struct Points into a memory mapped record. It's valid for the
+ * lifetime of the SelfPlayShardReader it's from.
+ */
+struct SelfPlayRecordView {
+    SelfPlayRecordHead const *head;
+    uint8_t const *board;
+    float const *policy;
+    float const *shl_map;
+    float const *top_shl_features;
+};
+
+/**
+ * @brief The SelfPlayShardReader class Memory maps a shard file for random access. The records
+ * appended after the shard is opened aren't visible to the reader.
+ */
+class SelfPlayShardReader {
+  public:
+    explicit SelfPlayShardReader(std::string const &shard_path);
+    SelfPlayShardReader(SelfPlayShardReader const &) = delete;
+    ~SelfPlayShardReader();
+
+    /**
+     * @brief Header The header of the shard.
+     */
+    SelfPlayShardHeader const &Header() const;
+
+    /**
+     * @brief NumRecords Number of complete records in the shard.
+     */
+    uint64_t NumRecords() const;
+
+    /**
+     * @brief Record Views the record at the index in constant time.
+     */
+    SelfPlayRecordView Record(uint64_t index) const;
+
+  private:
+    struct SelfPlayShardReaderInternal;
+    std::unique_ptr<SelfPlayShardReaderInternal> pimpl_;
+};
+
+/**
+ * @brief ListSelfPlayShards Paths to all the shards in the directory in the order they were
+ * written to, for a given shard prefix.
+ */
+std::vector<std::string> ListSelfPlayShards(std::string const &directory,
+                                            std::string const &shard_prefix);
+
+} // namespace e8
+
+#endif // SELF_PLAY_RECORD_STORE_H
@@ -16,6 +16,8 @@
  */
 
 #include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -26,6 +28,7 @@
 #include "postgres/query_runner/connection/connection_interface.h"
 #include "postgres/query_runner/reflection/sql_entity_interface.h"
 #include "postgres/query_runner/reflection/sql_primitives.h"
+#include "postgres/query_runner/seq_id_pool.h"
 #include "postgres/query_runner/sql_query_builder.h"
 #include "postgres/query_runner/sql_runner.h"
 
@@ -222,11 +225,97 @@ bool InsertThenExistsTest() {
     return true;
 }
 
+bool InsertSelectThenExecTest() {
+    e8::ConnectionFactory factory = CreateConnectionFactory();
+    e8::BasicConnectionReservoir reservoir(factory);
+    e8::ConnectionInterface *conn = reservoir.Take();
+
+    // Prepare schema.
+    DropSchema(conn);
+    CreateSchema(conn);
+
+    // Prepare test data.
+    User user;
+    *user.id.ValuePtr() = 1;
+    *user.user_name.ValuePtr() = "user0";
+    uint64_t num_rows_affected = e8::Update(user,
+                                            /*tableName=*/"QueryRunnerTestUser",
+                                            /*replace=*/true, &reservoir);
+    TEST_CONDITION(num_rows_affected == 1);
+
+    // Only inserts the card when the owner exists, and renames the owner in the same statement.
+    auto insert_card = [&reservoir](int32_t card_id, int32_t user_id) {
+        e8::SqlQueryBuilder query;
+        e8::SqlQueryBuilder::Placeholder<e8::SqlInt> card_id_ph;
+        e8::SqlQueryBuilder::Placeholder<e8::SqlInt> user_id_ph;
+        query.QueryPiece("WITH owner AS (SELECT u.id FROM QueryRunnerTestUser u WHERE u.id=")
+            .Holder(&user_id_ph)
+            .QueryPiece("), renamed AS (UPDATE QueryRunnerTestUser u SET user_name='card_owner' "
+                        "FROM owner WHERE u.id=owner.id) "
+                        "INSERT INTO QueryRunnerTestCard (id, user_id, card_number) SELECT ")
+            .Holder(&card_id_ph)
+            .QueryPiece("::INTEGER, owner.id, 'card' FROM owner");
+        query.SetValueToPlaceholder(card_id_ph, std::make_shared<e8::SqlInt>(card_id));
+        query.SetValueToPlaceholder(user_id_ph, std::make_shared<e8::SqlInt>(user_id));
+        return e8::Exec(query, &reservoir);
+    };
+
+    num_rows_affected = insert_card(/*card_id=*/1, /*user_id=*/2);
+    TEST_CONDITION(num_rows_affected == 0);
+
+    num_rows_affected = insert_card(/*card_id=*/1, /*user_id=*/1);
+    TEST_CONDITION(num_rows_affected == 1);
+
+    std::vector<std::tuple<User, CreditCard>> results = e8::Query<User, CreditCard>(
+        e8::SqlQueryBuilder().QueryPiece(
+            "QueryRunnerTestUser u JOIN QueryRunnerTestCard c ON c.user_id=u.id"),
+        {"u", "c"}, &reservoir);
+    TEST_CONDITION(results.size() == 1);
+    TEST_CONDITION(std::get<0>(results[0]).user_name.Value() ==
+                   std::optional<std::string>("card_owner"));
+    TEST_CONDITION(std::get<1>(results[0]).id.Value() == std::optional<int32_t>(1));
+
+    // Clean up.
+    DropSchema(conn);
+    reservoir.Put(conn);
+
+    return true;
+}
+
+bool ReserveSeqIdsTest() {
+    e8::ConnectionFactory factory = CreateConnectionFactory();
+    e8::BasicConnectionReservoir reservoir(factory);
+    e8::ConnectionInterface *conn = reservoir.Take();
+
+    conn->RunUpdate("DROP SEQUENCE IF EXISTS QueryRunnerTestSeq",
+                    e8::ConnectionInterface::QueryParams());
+    conn->RunUpdate("CREATE SEQUENCE QueryRunnerTestSeq START WITH 1 INCREMENT BY 1",
+                    e8::ConnectionInterface::QueryParams());
+
+    std::vector<int64_t> ids = e8::SeqIds("QueryRunnerTestSeq", /*count=*/3, &reservoir);
+    TEST_CONDITION((ids == std::vector<int64_t>{1, 2, 3}));
+
+    e8::SeqIdPool pool("QueryRunnerTestSeq", /*batch_size=*/2, &reservoir);
+    TEST_CONDITION(pool.Next() == 4);
+    TEST_CONDITION(pool.Next() == 5);
+    TEST_CONDITION(pool.Next() == 6);
+    TEST_CONDITION(e8::SeqId("QueryRunnerTestSeq", &reservoir) == 8);
+    TEST_CONDITION(pool.Next() == 7);
+
+    // Clean up.
+    conn->RunUpdate("DROP SEQUENCE QueryRunnerTestSeq", e8::ConnectionInterface::QueryParams());
+    reservoir.Put(conn);
+
+    return true;
+}
+
 int main() {
     e8::BeginTestSuite("sql_runner");
     e8::RunTest("InsertThenQueryTest", InsertThenQueryTest);
     e8::RunTest("InsertThenDeleteTest", InsertThenDeleteTest);
     e8::RunTest("InsertThenExistsTest", InsertThenExistsTest);
+    e8::RunTest("InsertSelectThenExecTest", InsertSelectThenExecTest);
+    e8::RunTest("ReserveSeqIdsTest", ReserveSeqIdsTest);
     e8::EndTestSuite();
     return 0;
 }
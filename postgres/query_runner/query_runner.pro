@@ -39,6 +39,7 @@ SOURCES += \
     resultset/mock_result_set.cc \
     resultset/pq_result_set.cc \
     resultset/result_set_interface.cc \
+    seq_id_pool.cc \
     sql_query_builder.cc \
     sql_runner.cc
 
@@ -58,6 +59,7 @@ HEADERS += \
     resultset/mock_result_set.h \
     resultset/pq_result_set.h \
     resultset/result_set_interface.h \
+    seq_id_pool.h \
     sql_query_builder.h \
     sql_runner.h
 
@@ -0,0 +1,49 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "postgres/query_runner/connection/connection_reservoir_interface.h"
+#include "postgres/query_runner/seq_id_pool.h"
+#include "postgres/query_runner/sql_runner.h"
+
+namespace e8 {
+
+SeqIdPool::SeqIdPool(std::string const &seq_table, unsigned batch_size,
+                     ConnectionReservoirInterface *reservoir)
+    : seq_table_(seq_table), batch_size_(batch_size), reservoir_(reservoir), next_id_index_(0) {
+    assert(batch_size_ > 0);
+}
+
+SeqIdPool::~SeqIdPool() {}
+
+int64_t SeqIdPool::Next() {
+    std::lock_guard<std::mutex> guard(mutex_);
+
+    if (next_id_index_ == reserved_ids_.size()) {
+        reserved_ids_ = SeqIds(seq_table_, batch_size_, reservoir_);
+        next_id_index_ = 0;
+    }
+
+    return reserved_ids_[next_id_index_++];
+}
+
+} // namespace e8
@@ -0,0 +1,68 @@
+/**
+ * e8yes demo web.
+ *
+ * <p>Copyright (C) 2020 Chifeng Wen {daviesx66@gmail.com}
+ *
+ * <p>This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * <p>This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * <p>You should have received a copy of the GNU General Public License along with this program. If
+ * not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SEQ_ID_POOL_H
+#define SEQ_ID_POOL_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "postgres/query_runner/connection/connection_reservoir_interface.h"
+
+namespace e8 {
+
+/**
+ * @brief The SeqIdPool class Hands out sequential IDs drawn from a sequence table. IDs are reserved
+ * in batches so that only one in batch_size calls pays a database round trip. IDs left in the pool
+ * are lost when the pool is destroyed, so the sequence may have gaps. This class guarantees thread
+ * safety.
+ */
+class SeqIdPool {
+  public:
+    /**
+     * @brief SeqIdPool Constructs an empty pool. No ID will be reserved until the first call to
+     * Next().
+     *
+     * @param seq_table Name of the sequence table to draw IDs from.
+     * @param batch_size Number of IDs to reserve per round trip.
+     * @param reservoir Connection reservoir to allocate database connections.
+     */
+    SeqIdPool(std::string const &seq_table, unsigned batch_size,
+              ConnectionReservoirInterface *reservoir);
+    SeqIdPool(SeqIdPool const &) = delete;
+    ~SeqIdPool();
+
+    /**
+     * @brief Next Takes an ID from the pool. The pool is refilled when it runs out.
+     */
+    int64_t Next();
+
+  private:
+    std::string const seq_table_;
+    unsigned const batch_size_;
+    ConnectionReservoirInterface *const reservoir_;
+
+    std::vector<int64_t> reserved_ids_;
+    unsigned next_id_index_;
+    std::mutex mutex_;
+};
+
+} // namespace e8
+
+#endif // SEQ_ID_POOL_H
@@ -22,6 +22,7 @@
 #include <memory>
 #include <string>
 #include <unordered_set>
+#include <vector>
 
 #include "common/time_util/time_util.h"
 #include "postgres/query_runner/connection/connection_interface.h"
@@ -131,6 +132,14 @@ uint64_t Delete(std::string const &table_name, SqlQueryBuilder const &query,
     return numRowsUpdated;
 }
 
+uint64_t Exec(SqlQueryBuilder const &query, ConnectionReservoirInterface *reservoir) {
+    ConnectionInterface *conn = reservoir->Take();
+    uint64_t numRowsUpdated = conn->RunUpdate(query.PsqlQuery(), query.QueryParams());
+    reservoir->Put(conn);
+
+    return numRowsUpdated;
+}
+
 bool Exists(SqlQueryBuilder const &query, ConnectionReservoirInterface *reservoir) {
     std::string exists_query = "SELECT TRUE FROM " + query.PsqlQuery();
 
@@ -205,8 +214,7 @@ bool SendHeartBeat(ConnectionInterface *conn) {
 }
 
 int64_t TimeId(unsigned host_id) {
-    int64_t timestamp = TemporalId();
-    int64_t unique_id = host_id * 0xFFFFFFFFFFFFF + timestamp;
+    int64_t unique_id = UniqueId(host_id);
     return sql_runner_internal::ReverseBytes(unique_id);
 }
 
@@ -226,6 +234,34 @@ int64_t SeqId(std::string const &seq_table, ConnectionReservoirInterface *reserv
     return id.Value().value();
 }
 
+std::vector<int64_t> SeqIds(std::string const &seq_table, unsigned count,
+                            ConnectionReservoirInterface *reservoir) {
+    ConnectionInterface::QueryParams params;
+    ConnectionInterface::QueryParams::SlotId count_slot = params.AllocateSlot();
+    params.SetParam(count_slot, std::make_shared<SqlInt>(static_cast<int32_t>(count)));
+
+    ConnectionInterface *conn = reservoir->Take();
+
+    std::unique_ptr<ResultSetInterface> rs = conn->RunQuery(
+        "SELECT nextval('" + seq_table + "') FROM generate_series(1,$" +
+            std::to_string(count_slot) + ") ORDER BY 1",
+        params);
+
+    std::vector<int64_t> ids;
+    ids.reserve(count);
+    SqlLong id("id");
+    for (; rs->HasNext(); rs->Next()) {
+        rs->SetField(0, &id);
+        assert(id.Value().has_value());
+        ids.push_back(id.Value().value());
+    }
+    assert(ids.size() == count);
+
+    reservoir->Put(conn);
+
+    return ids;
+}
+
 void ClearAllTables(ConnectionReservoirInterface *reservoir) {
     std::unordered_set<std::string> table_names = Tables(reservoir);
     SqlQueryBuilder constraint;
@@ -153,6 +153,16 @@ uint64_t Update(SqlEntityInterface const &entity, std::string const &table_name,
 uint64_t Delete(std::string const &table_name, SqlQueryBuilder const &query,
                 ConnectionReservoirInterface *reservoir);
 
+/**
+ * @brief Exec Runs a complete data modification query, e.g. an INSERT ... SELECT or a statement with
+ * data-modifying WITH clauses, in a single round trip.
+ *
+ * @param query The complete query. Example: WITH t AS (UPDATE ...) INSERT INTO ... SELECT ...
+ * @param reservoir Connection reservoir to allocate database connections.
+ * @return The number of rows affected by the main statement.
+ */
+uint64_t Exec(SqlQueryBuilder const &query, ConnectionReservoirInterface *reservoir);
+
 /**
  * @brief Exists Tells whethter the query returns at least one record.
  *
@@ -187,11 +197,11 @@ bool SendHeartBeat(ConnectionReservoirInterface *reservoir);
 bool SendHeartBeat(ConnectionInterface *conn);
 
 /**
- * @brief TimeId Generate approximately unique integer ID from time. It has a resolution of
- * microsecond.
+ * @brief TimeId Generate unique integer ID from time. It's a byte-reversed UniqueId() so that the
+ * IDs scatter over the key space.
  *
- * @param host_id zero-offset ID to scatter timestamps into different ranges to avoid ID collision
- * among different host machines.
+ * @param host_id zero-offset ID to avoid ID collision among different host machines. It must not
+ * exceed kUniqueIdMaxHostId.
  * @return Unique ID.
  */
 int64_t TimeId(unsigned host_id);
@@ -205,6 +215,16 @@ int64_t TimeId(unsigned host_id);
  */
 int64_t SeqId(std::string const &seq_table, ConnectionReservoirInterface *reservoir);
 
+/**
+ * @brief SeqIds Similar to SeqId(), but it reserves multiple IDs in a single round trip.
+ *
+ * @param count Number of IDs to reserve.
+ * @return Unique IDs in ascending order. They are contiguous unless other clients draw from the
+ * same sequence concurrently.
+ */
+std::vector<int64_t> SeqIds(std::string const &seq_table, unsigned count,
+                            ConnectionReservoirInterface *reservoir);
+
 /**
  * @brief ClearAllTables Delete data in all table but keeping the schema structure.
  *